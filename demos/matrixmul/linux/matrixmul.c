@@ -22,7 +22,8 @@ struct reconos_resource mmul_res[2];
 pthread_t ctrl_sort, ctrl_mmul;
 
 int matrix_data[3 * NUM_MATRICES][MATRIX_SIZE][MATRIX_SIZE];
-int *matrix_ptr[3 * NUM_MATRICES];
+// addresses of the matrices as seen by the hardware threads
+uint32_t matrix_ptr[3 * NUM_MATRICES];
 int matrix_control[MATRIX_SIZE][MATRIX_SIZE];
 
 void std_matrix_mul(int *i_matrix_a, int *i_matrix_b, int *o_matrix_c, int matrix_size) {
@@ -63,14 +64,14 @@ void *ctrl_mmul_thread(void *data) {
 
 	int n,k;
 
-	printf("address of first matrix: %x\n", &matrix_data[0][0][0]);
+	printf("address of first matrix: %x\n", reconos_addr_to_hwt(&matrix_data[0][0][0]));
 
 	for (i = 0; i < NUM_HWT; i++) {
-		printf("Putting matrix into mbox %x:\n", &matrix_ptr[3 * i]);
+		printf("Putting matrix into mbox %x:\n", reconos_addr_to_hwt(&matrix_ptr[3 * i]));
 		printf("at mbox addr + 0: %x\n", matrix_ptr[3 * i]);
 		printf("at mbox addr + 4: %x\n", matrix_ptr[3 * i + 1]);
 		printf("at mbox addr + 8: %x\n", matrix_ptr[3 * i + 2]);
-		mbox_put(&mbox_mmul_recv, (unsigned int)&matrix_ptr[3 * i]);
+		mbox_put(&mbox_mmul_recv, reconos_addr_to_hwt(&matrix_ptr[3 * i]));
 	}
 
 	i = 0;
@@ -85,13 +86,13 @@ void *ctrl_mmul_thread(void *data) {
 
 		printf("Matrixmul finished, setting up new matrix\n");
 		printf("HWT returned %x\n", m);
-		m = (m - (int)&matrix_data[0][0][0]) / (4 * MATRIX_SIZE * MATRIX_SIZE);
+		m = (m - reconos_addr_to_hwt(&matrix_data[0][0][0])) / (4 * MATRIX_SIZE * MATRIX_SIZE);
 		printf("This should be index %d\n", m);
-		printf("Putting matrix into mbox %x:\n", &matrix_ptr[m % 2]);
+		printf("Putting matrix into mbox %x:\n", reconos_addr_to_hwt(&matrix_ptr[m % 2]));
 		printf("at mbox addr + 0: %x\n", matrix_ptr[m % 2]);
 		printf("at mbox addr + 4: %x\n", matrix_ptr[m % 2 + 1]);
 		printf("at mbox addr + 8: %x\n", matrix_ptr[m % 2 + 2]);
-		mbox_put(&mbox_mmul_recv, (unsigned int)&matrix_ptr[m % 2]);
+		mbox_put(&mbox_mmul_recv, reconos_addr_to_hwt(&matrix_ptr[m % 2]));
 	}
 }
 
@@ -99,7 +100,7 @@ void init_mmul_data() {
 	int m, i, j;
 
 	for (m = 0; m < 3 * NUM_MATRICES; m++) {
-		matrix_ptr[m] = (int *)&matrix_data[m][0][0];
+		matrix_ptr[m] = reconos_addr_to_hwt(&matrix_data[m][0][0]);
 
 		for (i = 0; i < MATRIX_SIZE; i++) {
 			for (j = 0; j < MATRIX_SIZE; j++) {
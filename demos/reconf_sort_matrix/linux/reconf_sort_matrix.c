@@ -28,7 +28,7 @@ struct reconos_resource mmul_res[2];
 struct reconos_configuration sort_cfg[NUM_HWT];
 struct reconos_configuration mmul_cfg[NUM_HWT];
 
-pthread_t ctrl_sort, ctrl_mmul;
+pthread_t ctrl;
 pthread_t generate;
 pthread_t monitor;
 pthread_mutex_t sched_mutex;
@@ -39,7 +39,8 @@ int sort_thread_count;
 int sort_done_count;
 
 int matrix_data[3 * NUM_MATRICES][MATRIX_SIZE][MATRIX_SIZE];
-int *matrix_ptr[3 * NUM_MATRICES];
+// addresses of the matrices as seen by the hardware threads
+uint32_t matrix_ptr[3 * NUM_MATRICES];
 int matrix_done_count;
 
 struct reconos_configuration *schedule(struct reconos_hwt *hwt) {
@@ -67,40 +68,41 @@ struct reconos_configuration *schedule(struct reconos_hwt *hwt) {
 	}
 }
 
-void *ctrl_sort_thread(void *data) {
+void *ctrl_thread(void *data) {
+	struct mbox *mbox_send[2] = {&mbox_sort_send, &mbox_mmul_send};
 	int i;
 	int m;
 
 	for (i = 0; i < NUM_HWT; i++) {
-		printf("putting into sort mbox: %x\n", (unsigned int)&sort_data[i][0]);
-		mbox_put(&mbox_sort_recv, (unsigned int)&sort_data[i][0]);
+		printf("putting into sort mbox: %x\n", reconos_addr_to_hwt(&sort_data[i][0]));
+		mbox_put(&mbox_sort_recv, reconos_addr_to_hwt(&sort_data[i][0]));
 	}
 
-	while (1) {
-		m = mbox_get(&mbox_sort_send);
-		sort_request_count_active--;
-		sort_done_count++;
-		m = (m - (int)&sort_data) / (4 * SORT_SIZE);
-		//printf("putting into sort mbox: %x\n", (unsigned int)&sort_data[m][0]);
-		mbox_put(&mbox_sort_recv, (unsigned int)&sort_data[m][0]);
-	}
-}
-
-void *ctrl_mmul_thread(void *data) {
-	int i;
-	int m;
-
 	for (i = 0; i < NUM_HWT; i++) {
-		printf("putting into mmul mbox: %x\n", (unsigned int)&matrix_ptr[3 * i]);
-		mbox_put(&mbox_mmul_recv, (unsigned int)&matrix_ptr[3 * i]);
+		printf("putting into mmul mbox: %x\n", reconos_addr_to_hwt(&matrix_ptr[3 * i]));
+		mbox_put(&mbox_mmul_recv, reconos_addr_to_hwt(&matrix_ptr[3 * i]));
 	}
 
+	// a single thread handles the results of both kinds of threads
 	while (1) {
-		m = mbox_get(&mbox_mmul_send);
-		matrix_done_count++;
-		m = (m - (int)&matrix_data[0][0][0]) / (4 * MATRIX_SIZE * MATRIX_SIZE);
-		//printf("putting into mmul mbox: %x\n", (unsigned int)&matrix_ptr[m % 2]);
-		mbox_put(&mbox_mmul_recv, (unsigned int)&matrix_ptr[m % 2]);
+		switch (mbox_select(mbox_send, 2)) {
+			case 0:
+				m = mbox_get(&mbox_sort_send);
+				sort_request_count_active--;
+				sort_done_count++;
+				m = (m - reconos_addr_to_hwt(&sort_data)) / (4 * SORT_SIZE);
+				//printf("putting into sort mbox: %x\n", reconos_addr_to_hwt(&sort_data[m][0]));
+				mbox_put(&mbox_sort_recv, reconos_addr_to_hwt(&sort_data[m][0]));
+				break;
+
+			case 1:
+				m = mbox_get(&mbox_mmul_send);
+				matrix_done_count++;
+				m = (m - reconos_addr_to_hwt(&matrix_data[0][0][0])) / (4 * MATRIX_SIZE * MATRIX_SIZE);
+				//printf("putting into mmul mbox: %x\n", reconos_addr_to_hwt(&matrix_ptr[m % 2]));
+				mbox_put(&mbox_mmul_recv, reconos_addr_to_hwt(&matrix_ptr[m % 2]));
+				break;
+		}
 	}
 }
 
@@ -169,7 +171,7 @@ void init_mmul_data() {
 	matrix_done_count = 0;
 
 	for (m = 0; m < 3 * NUM_MATRICES; m++) {
-		matrix_ptr[m] = (int *)&matrix_data[m][0][0];
+		matrix_ptr[m] = reconos_addr_to_hwt(&matrix_data[m][0][0]);
 
 		for (i = 0; i < MATRIX_SIZE; i++) {
 			for (j = 0; j < MATRIX_SIZE; j++) {
@@ -181,6 +183,8 @@ void init_mmul_data() {
 
 int main(int argc, char **argv) {
 	int i;
+	int slot[NUM_HWT];
+	struct reconos_configuration *cfg[NUM_HWT];
 	char filename[256];
 
 	// initialize mboxes
@@ -190,6 +194,10 @@ int main(int argc, char **argv) {
 	mbox_init(&mbox_mmul_recv, 16);
 	mbox_init(&mbox_mmul_send, 16);
 
+	// enable mbox_select before the mboxes are used concurrently
+	mbox_get_eventfd(&mbox_sort_send);
+	mbox_get_eventfd(&mbox_mmul_send);
+
 	pthread_mutex_init(&sched_mutex, NULL);
 
 	init_sort_data();
@@ -221,16 +229,17 @@ int main(int argc, char **argv) {
 	reconos_init();
 	reconos_set_scheduler(schedule);
 
-	pthread_create(&ctrl_sort, NULL, ctrl_sort_thread, NULL);
-	pthread_create(&ctrl_mmul, NULL, ctrl_mmul_thread, NULL);
+	pthread_create(&ctrl, NULL, ctrl_thread, NULL);
 	pthread_create(&monitor, NULL, monitor_thread, NULL);
 	pthread_create(&generate, NULL, generate_thread, NULL);
 
 	for (i = 0; i < NUM_HWT; i++) {
-		reconos_hwt_create_reconf(&hwt[i], i, &mmul_cfg[i], NULL);
+		slot[i] = i;
+		cfg[i] = &mmul_cfg[i];
 		//reconos_hwt_setresources(&hwt[i], mmul_res, 2);
 		//reconos_hwt_create(&hwt[i], i, NULL);
 	}
+	reconos_hwt_create_many(hwt, slot, cfg, NUM_HWT, NULL);
 
 	while(1) {
 #if 0
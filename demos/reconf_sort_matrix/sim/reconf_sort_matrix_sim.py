@@ -0,0 +1,254 @@
+#!/usr/bin/env python
+# coding: utf8
+
+#                                                        ____  _____
+#                            ________  _________  ____  / __ \/ ___/
+#                           / ___/ _ \/ ___/ __ \/ __ \/ / / /\__ \
+#                          / /  /  __/ /__/ /_/ / / / / /_/ /___/ /
+#                         /_/   \___/\___/\____/_/ /_/\____//____/
+#
+# ======================================================================
+#
+#   project:      ReconOS
+#   description:  Model of linux/reconf_sort_matrix.c for the ReconOS
+#                 system simulator (tools/python/reconos_sim.py).
+#
+#                 Prints throughput and latency for every combination
+#                 of the given slot counts and reconfiguration latency
+#                 scales, e.g.
+#
+#                   reconf_sort_matrix_sim.py --slots 2,4,8,11,16 \
+#                       --reconf-scale 1,0.5,0.1 --scheduler sticky
+#
+#                 Without calibration the service times below are
+#                 used. With --calibrate the parameters are taken from
+#                 an OSIF recording of the real application. The two
+#                 service time clusters are assigned in the order of
+#                 the default service times (mmul before sort).
+#
+# ======================================================================
+
+from __future__ import print_function
+
+import argparse
+import collections
+import importlib
+import os
+import sys
+
+sys.path.append(os.path.join(os.environ.get("RECONOS", ""), "tools", "python"))
+sys.path.append(os.path.join(os.path.dirname(os.path.abspath(__file__)),
+                             "..", "..", "..", "tools", "python"))
+
+import reconos_sim
+
+NUM_HWT = 11
+MBOX_SIZE = 16
+
+# default parameters in microseconds
+DEFAULT_SERVICE = collections.OrderedDict([("mmul", 2500.0), ("sort", 4000.0)])
+DEFAULT_RECONF = 3000.0
+DEFAULT_DELEGATE = 20.0
+
+
+class Model:
+	"""
+The application consists of
+
+  - two mailbox pairs for sort and matrix multiplication jobs,
+  - a control thread returning every result as a new job,
+  - a generator adding 1 to 20 sort requests every 60 to 70 ms and
+  - a scheduler which loads the sort thread as long as sort requests
+    are pending and the matrix multiplication otherwise.
+	"""
+
+	def __init__(self, params, slots, reconf_scale, cores, scheduler, seed):
+		self.sim = reconos_sim.Simulator(seed)
+		sim = self.sim
+
+		reconf = reconos_sim.distribution(params["reconf"]).scaled(reconf_scale)
+		delegate = reconos_sim.distribution(params["delegate"])
+		self.system = reconos_sim.System(sim, cores, delegate, reconf,
+		                                 lambda system, slot: scheduler(self, slot))
+
+		self.sort_recv = reconos_sim.Mbox(sim, MBOX_SIZE)
+		self.sort_send = reconos_sim.Mbox(sim, MBOX_SIZE)
+		self.mmul_recv = reconos_sim.Mbox(sim, MBOX_SIZE)
+		self.mmul_send = reconos_sim.Mbox(sim, MBOX_SIZE)
+
+		self.sort_cfg = reconos_sim.Configuration(
+		    "sort", self.sort_recv, self.sort_send,
+		    reconos_sim.distribution(params["service"]["sort"]))
+		self.mmul_cfg = reconos_sim.Configuration(
+		    "mmul", self.mmul_recv, self.mmul_send,
+		    reconos_sim.distribution(params["service"]["mmul"]))
+
+		# pending sort requests and the request each slot is working on
+		self.requests = collections.deque()
+		self.serving = {}
+		self.latency = []
+
+		for i in range(NUM_HWT):
+			self.sort_recv.put(i, lambda: None)
+			self.mmul_recv.put(i, lambda: None)
+
+		sim.at(0, self._ctrl)
+		sim.at(0, self._generate)
+
+		for i in range(slots):
+			self.system.create(self.mmul_cfg)
+
+	def _ctrl(self):
+		mboxes = [self.sort_send, self.mmul_send]
+
+		def selected(i):
+			self.system.call(mboxes[i].get, got(i))
+
+		def got(i):
+			recv = [self.sort_recv, self.mmul_recv][i]
+			return lambda value: recv.put(value, self._ctrl)
+
+		reconos_sim.mbox_select(mboxes, selected)
+
+	def _generate(self):
+		rng = self.sim.random
+		for i in range(rng.randint(1, 20)):
+			self.requests.append(self.sim.now)
+		self.sim.at(rng.randint(60000, 70000), self._generate)
+
+	def take_request(self, slot):
+		self.serving[slot.num] = self.requests.popleft()
+
+	def finish_request(self, slot):
+		if slot.cfg is self.sort_cfg and slot.num in self.serving:
+			self.latency.append(self.sim.now - self.serving.pop(slot.num))
+
+	def run(self, duration):
+		self.sim.run(duration)
+
+		seconds = duration / 1000000.0
+		return [
+			self.system.jobs["sort"] / seconds,
+			self.system.jobs["mmul"] / seconds,
+			self.system.reconfs / seconds,
+			reconos_sim.mean(self.latency) / 1000.0,
+			reconos_sim.percentile(self.latency, 0.95) / 1000.0,
+			len(self.requests),
+			self.system.cpu.utilization(),
+			self.system.port.utilization()
+		]
+
+
+# == Schedulers ========================================================
+
+def schedule_demo(model, slot):
+	"""
+The scheduler of reconf_sort_matrix.c, always reconfigures the slot.
+	"""
+
+	model.finish_request(slot)
+
+	if model.requests:
+		model.take_request(slot)
+		return model.sort_cfg
+	else:
+		return model.mmul_cfg
+
+
+def schedule_sticky(model, slot):
+	"""
+Same decision as schedule_demo but keeps the slot if the thread is
+already loaded.
+	"""
+
+	cfg = schedule_demo(model, slot)
+	if cfg is slot.cfg:
+		return None
+	return cfg
+
+
+SCHEDULERS = {"demo": schedule_demo, "sticky": schedule_sticky}
+
+
+def load_scheduler(name):
+	"""
+Either one of SCHEDULERS or module:function of a custom scheduler
+taking the model and the slot.
+	"""
+
+	if name in SCHEDULERS:
+		return SCHEDULERS[name]
+
+	module, function = name.split(":")
+	return getattr(importlib.import_module(module), function)
+
+
+def default_params():
+	return {
+		"service": dict(DEFAULT_SERVICE),
+		"reconf": DEFAULT_RECONF,
+		"delegate": DEFAULT_DELEGATE
+	}
+
+
+def calibrated_params(filename):
+	params = default_params()
+	calibration = reconos_sim.calibrate(filename, len(DEFAULT_SERVICE))
+
+	if len(calibration["service"]) == len(DEFAULT_SERVICE):
+		params["service"] = dict(zip(DEFAULT_SERVICE.keys(), calibration["service"]))
+	else:
+		print("WARNING: unable to separate the service times, using defaults", file = sys.stderr)
+	if calibration["reconf"]:
+		params["reconf"] = calibration["reconf"]
+	if calibration["delegate"]:
+		params["delegate"] = calibration["delegate"]
+
+	return params
+
+
+def main():
+	parser = argparse.ArgumentParser(description = "Simulates reconf_sort_matrix.")
+	parser.add_argument("--slots", default = str(NUM_HWT),
+	                    help = "comma separated list of slot counts")
+	parser.add_argument("--reconf-scale", default = "1",
+	                    help = "comma separated list of reconfiguration latency factors")
+	parser.add_argument("--scheduler", default = "demo",
+	                    help = "demo, sticky or module:function")
+	parser.add_argument("--cores", type = int, default = 2,
+	                    help = "number of cores executing the delegates")
+	parser.add_argument("--time", type = float, default = 10.0,
+	                    help = "simulated time in seconds")
+	parser.add_argument("--seed", type = int, default = 0)
+	parser.add_argument("--calibrate", metavar = "RECORDING",
+	                    help = "take the parameters from an OSIF recording")
+	parser.add_argument("--params", metavar = "FILE",
+	                    help = "load parameters saved with --save-params")
+	parser.add_argument("--save-params", metavar = "FILE")
+	args = parser.parse_args()
+
+	if args.calibrate:
+		params = calibrated_params(args.calibrate)
+	elif args.params:
+		params = reconos_sim.load_calibration(args.params)
+	else:
+		params = default_params()
+
+	if args.save_params:
+		reconos_sim.save_calibration(params, args.save_params)
+
+	scheduler = load_scheduler(args.scheduler)
+
+	rows = []
+	for slots in [int(s) for s in args.slots.split(",")]:
+		for scale in [float(s) for s in args.reconf_scale.split(",")]:
+			model = Model(params, slots, scale, args.cores, scheduler, args.seed)
+			rows.append([slots, scale] + model.run(args.time * 1000000.0))
+
+	reconos_sim.print_table(["slots", "reconf_scale", "sort/s", "mmul/s", "reconf/s",
+	                         "sort_lat_ms", "sort_lat_p95_ms", "pending",
+	                         "cpu_util", "port_util"], rows)
+
+
+if __name__ == "__main__":
+	main()
@@ -0,0 +1,178 @@
+--
+-- bitonic_sorter.vhd
+-- Bitonic sort module. Sorts the contents of an attached single-port
+-- block RAM in place by executing the compare-exchange operations of a
+-- bitonic sorting network one after another. Has the same interface as
+-- bubble_sorter but needs O(n log^2 n) instead of O(n^2) compare
+-- operations. G_LEN must be a power of two and G_AWIDTH = log2(G_LEN).
+--
+-- This file is part of the ReconOS project <http://www.reconos.de>.
+-- University of Paderborn, Computer Engineering Group.
+--
+
+library IEEE;
+use IEEE.STD_LOGIC_1164.all;
+use IEEE.NUMERIC_STD.all;
+
+entity bitonic_sorter is
+
+  generic (
+    G_LEN    : integer := 2048;         -- number of words to sort
+    G_AWIDTH : integer := 11;           -- in bits
+    G_DWIDTH : integer := 32            -- in bits
+    );
+
+  port (
+    clk   : in std_logic;
+    reset : in std_logic;
+
+    -- local ram interface
+    o_RAMAddr : out std_logic_vector(0 to G_AWIDTH-1);
+    o_RAMData : out std_logic_vector(0 to G_DWIDTH-1);
+    i_RAMData : in  std_logic_vector(0 to G_DWIDTH-1);
+    o_RAMWE   : out std_logic;
+    start     : in  std_logic;
+    done      : out std_logic
+    );
+end bitonic_sorter;
+
+architecture Behavioral of bitonic_sorter is
+
+  type state_t is (STATE_IDLE, STATE_LOAD_WAIT_B, STATE_LOAD_A, STATE_LOAD_B, STATE_WRITE_A, STATE_WRITE_B);
+
+  signal state : state_t := STATE_IDLE;
+
+  -- the network consists of stages k = 2, 4, ..., G_LEN, each one merging
+  -- bitonic sequences of length k in the steps j = k/2, ..., 1. A step
+  -- compares every element i with bit j cleared to its partner i + j.
+  signal k         : unsigned(G_AWIDTH downto 0);
+  signal j         : unsigned(G_AWIDTH downto 0);
+  signal i         : unsigned(G_AWIDTH downto 0);
+  signal partner   : unsigned(G_AWIDTH downto 0);
+  signal ascending : boolean;
+
+  signal ptr       : unsigned(G_AWIDTH-1 downto 0);
+  signal a         : std_logic_vector(0 to G_DWIDTH-1);
+  signal swap      : boolean;
+
+begin
+
+  -- set RAM address
+  o_RAMAddr <= std_logic_vector(ptr);
+
+  -- concurrent signal assignments
+  partner   <= i or j;
+  ascending <= (i and k) = 0;           -- sort direction of the current block
+
+  -- should A and B (on the RAM outputs) be swapped?
+  swap <= unsigned(a) > unsigned(i_RAMData) when ascending else
+          unsigned(a) < unsigned(i_RAMData);
+
+  -- sorting state machine
+  sort_proc          : process(clk, reset)
+    variable next_i  : unsigned(G_AWIDTH downto 0);  -- next element with bit j cleared
+    variable advance : boolean;         -- proceed with next compare-exchange
+  begin
+
+    if reset = '1' then
+      state     <= STATE_IDLE;
+      k         <= to_unsigned(2, G_AWIDTH+1);
+      j         <= to_unsigned(1, G_AWIDTH+1);
+      i         <= (others => '0');
+      ptr       <= (others => '0');
+      o_RAMData <= (others => '0');
+      o_RAMWE   <= '0';
+      done      <= '0';
+      a         <= (others => '0');
+    elsif rising_edge(clk) then
+
+      o_RAMWE   <= '0';
+      o_RAMData <= (others => '0');
+      advance   := false;
+
+      next_i := i + 1;
+      if (next_i and j) /= 0 then
+        next_i := next_i + j;
+      end if;
+
+      case state is
+
+        when STATE_IDLE =>
+          done <= '0';
+          k    <= to_unsigned(2, G_AWIDTH+1);
+          j    <= to_unsigned(1, G_AWIDTH+1);
+          i    <= (others => '0');
+          ptr  <= (others => '0');
+          -- start sorting on 'start' signal
+          if start = '1' then
+            state <= STATE_LOAD_WAIT_B;
+          end if;
+
+          -- set address of B, wait for A to appear on RAM outputs
+        when STATE_LOAD_WAIT_B =>
+          ptr   <= partner(G_AWIDTH-1 downto 0);
+          state <= STATE_LOAD_A;
+
+          -- read A value from RAM
+        when STATE_LOAD_A =>
+          a     <= i_RAMData;
+          state <= STATE_LOAD_B;
+
+          -- compare A and B on the RAM outputs and act accordingly
+        when STATE_LOAD_B =>
+          if swap then
+            -- write B to the location of A
+            ptr       <= i(G_AWIDTH-1 downto 0);
+            o_RAMData <= i_RAMData;
+            o_RAMWE   <= '1';
+            state     <= STATE_WRITE_A;
+          else
+            advance := true;
+          end if;
+
+          -- write A to the location of B
+        when STATE_WRITE_A =>
+          ptr       <= partner(G_AWIDTH-1 downto 0);
+          o_RAMData <= a;
+          o_RAMWE   <= '1';
+          state     <= STATE_WRITE_B;
+
+          -- wait for the write of A to finish
+        when STATE_WRITE_B =>
+          advance := true;
+
+        when others =>
+          state <= STATE_IDLE;
+
+      end case;
+
+      if advance then
+        if next_i(G_AWIDTH) = '0' then
+          -- next element of this step
+          i     <= next_i;
+          ptr   <= next_i(G_AWIDTH-1 downto 0);
+          state <= STATE_LOAD_WAIT_B;
+        elsif j > 1 then
+          -- next step of this stage
+          j     <= shift_right(j, 1);
+          i     <= (others => '0');
+          ptr   <= (others => '0');
+          state <= STATE_LOAD_WAIT_B;
+        elsif k < G_LEN then
+          -- next stage
+          k     <= shift_left(k, 1);
+          j     <= k;
+          i     <= (others => '0');
+          ptr   <= (others => '0');
+          state <= STATE_LOAD_WAIT_B;
+        else
+          -- we're done
+          done  <= '1';
+          state <= STATE_IDLE;
+        end if;
+      end if;
+
+    end if;
+  end process;
+
+end Behavioral;
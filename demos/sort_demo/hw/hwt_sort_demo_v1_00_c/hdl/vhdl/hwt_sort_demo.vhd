@@ -10,6 +10,11 @@ library reconos_v3_01_a;
 use reconos_v3_01_a.reconos_pkg.all;
 
 entity hwt_sort_demo is
+	generic (
+		-- sort the local RAM with the bitonic sorter instead of the bubble sorter
+		C_USE_BITONIC_SORTER : boolean := true
+	);
+
 	port (
 		-- OSIF FIFO ports
 		OSIF_FIFO_Sw2Hw_Data    : in  std_logic_vector(31 downto 0);
@@ -74,6 +79,26 @@ architecture implementation of hwt_sort_demo is
 			done      : out std_logic
 		);
   	end component;
+
+	component bitonic_sorter is
+		generic (
+			G_LEN    : integer := 512;  -- number of words to sort, power of two
+			G_AWIDTH : integer := 9;  -- in bits
+			G_DWIDTH : integer := 32  -- in bits
+		);
+
+		port (
+			clk   : in std_logic;
+			reset : in std_logic;
+			-- local ram interface
+			o_RAMAddr : out std_logic_vector(0 to G_AWIDTH-1);
+			o_RAMData : out std_logic_vector(0 to G_DWIDTH-1);
+			i_RAMData : in  std_logic_vector(0 to G_DWIDTH-1);
+			o_RAMWE   : out std_logic;
+			start     : in  std_logic;
+			done      : out std_logic
+		);
+  	end component;
 	
 	-- The sorting application reads 'C_LOCAL_RAM_SIZE' 32-bit words into the local RAM,
 	-- from a given address (send in a message box), sorts them and writes them back into main memory.
@@ -153,23 +178,45 @@ begin
 	end process;
 	
 
+	-- instantiate bitonic_sorter module
+	bitonic_gen : if C_USE_BITONIC_SORTER generate
+		sorter_i : bitonic_sorter
+			generic map (
+				G_LEN     => C_LOCAL_RAM_SIZE,
+				G_AWIDTH  => C_LOCAL_RAM_ADDRESS_WIDTH,
+				G_DWIDTH  => 32
+			)
+			port map (
+				clk       => clk,
+				reset     => rst,
+				o_RAMAddr => o_RAMAddr_sorter,
+				o_RAMData => o_RAMData_sorter,
+				i_RAMData => i_RAMData_sorter,
+				o_RAMWE   => o_RAMWE_sorter,
+				start     => sort_start,
+				done      => sort_done
+		);
+	end generate;
+
 	-- instantiate bubble_sorter module
-	sorter_i : bubble_sorter
-		generic map (
-			G_LEN     => C_LOCAL_RAM_SIZE,
-			G_AWIDTH  => C_LOCAL_RAM_ADDRESS_WIDTH,
-			G_DWIDTH  => 32
-		)
-		port map (
-			clk       => clk,
-			reset     => rst,
-			o_RAMAddr => o_RAMAddr_sorter,
-			o_RAMData => o_RAMData_sorter,
-			i_RAMData => i_RAMData_sorter,
-			o_RAMWE   => o_RAMWE_sorter,
-			start     => sort_start,
-			done      => sort_done
-	);
+	bubble_gen : if not C_USE_BITONIC_SORTER generate
+		sorter_i : bubble_sorter
+			generic map (
+				G_LEN     => C_LOCAL_RAM_SIZE,
+				G_AWIDTH  => C_LOCAL_RAM_ADDRESS_WIDTH,
+				G_DWIDTH  => 32
+			)
+			port map (
+				clk       => clk,
+				reset     => rst,
+				o_RAMAddr => o_RAMAddr_sorter,
+				o_RAMData => o_RAMData_sorter,
+				i_RAMData => i_RAMData_sorter,
+				o_RAMWE   => o_RAMWE_sorter,
+				start     => sort_start,
+				done      => sort_done
+		);
+	end generate;
 
 	-- ReconOS initilization
 	osif_setup (
@@ -49,7 +49,7 @@ struct mbox mb_stop;
 unsigned int* malloc_page_aligned(unsigned int pages)
 {
 	unsigned int * temp = malloc ((pages+1)*PAGE_SIZE);
-	unsigned int * data = (unsigned int*)(((unsigned int)temp / PAGE_SIZE + 1) * PAGE_SIZE);
+	unsigned int * data = (unsigned int*)(((uintptr_t)temp / PAGE_SIZE + 1) * PAGE_SIZE);
 	return data;
 }
 
@@ -88,7 +88,7 @@ void *sort_thread(void* data)
 	}
 	else
 	{
-	  bubblesort( (unsigned int*) ret, N);
+	  bubblesort( (unsigned int*) reconos_addr_to_host(ret), N);
 	}
         
         mbox_put(mb_stop, dummy);
@@ -213,12 +213,12 @@ int main(int argc, char ** argv)
 	printf("Putting %i blocks into job queue: ", TO_BLOCKS(buffer_size));
 	fflush(stdout);
 
-	reconos_cache_flush();
+	reconos_cache_flush_range(data, buffer_size);
 
 	for (i=0; i<TO_BLOCKS(buffer_size); i++)
 	{
 	  printf(" %i",i); fflush(stdout);
-	  mbox_put(&mb_start,(unsigned int)data+(i*BLOCK_SIZE));
+	  mbox_put(&mb_start,reconos_addr_to_hwt(data)+(i*BLOCK_SIZE));
 	}
 	printf("\n");
 
@@ -235,7 +235,7 @@ int main(int argc, char ** argv)
 	t_stop = gettime();
 	t_sort = calc_timediff_ms(t_start,t_stop);
 
-	reconos_cache_flush();
+	reconos_cache_invalidate_range(data, buffer_size);
 
 
 	// merge data
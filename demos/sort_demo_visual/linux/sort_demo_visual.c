@@ -32,7 +32,7 @@ void *thread_control(void *arg) {
 		while (demo->num_hwts_running < demo->conf.num_hwts) {
 			//printf("[thread-control] generating new data for hardware thread\n");
 			data = generate_data();
-			mbox_put(&demo->mb_hwt_recv, (uint32_t)data);
+			mbox_put(&demo->mb_hwt_recv, reconos_addr_to_hwt(data));
 
 			sem_wait(&demo->num_hwts_running_sem);
 			demo->num_hwts_running++;
@@ -42,7 +42,7 @@ void *thread_control(void *arg) {
 		while (demo->num_swts_running < demo->conf.num_swts) {
 			//printf("[thread-control] generating new data for software thread\n");
 			data = generate_data();
-			mbox_put(&demo->mb_swt_recv, (uint32_t)data);
+			mbox_put(&demo->mb_swt_recv, reconos_addr_to_hwt(data));
 
 			sem_wait(&demo->num_swts_running_sem);
 			demo->num_swts_running++;
@@ -58,7 +58,7 @@ void *hwt_response(void *arg) {
 	demo = (struct sort_demo_visual *)arg;
 
 	while (1) {
-		data = (uint32_t *)mbox_get(&demo->mb_hwt_send);
+		data = reconos_addr_to_host(mbox_get(&demo->mb_hwt_send));
 		free(data);
 
 		sem_wait(&demo->num_hwts_running_sem);
@@ -80,7 +80,7 @@ void *swt_response(void *arg) {
 	demo = (struct sort_demo_visual *)arg;
 
 	while (1) {
-		data = (uint32_t *)mbox_get(&demo->mb_swt_send);
+		data = reconos_addr_to_host(mbox_get(&demo->mb_swt_send));
 		free(data);
 
 		sem_wait(&demo->num_swts_running_sem);
@@ -127,7 +127,7 @@ void *sort_thread(void *arg) {
 		if (ret == 0xFFFFFFFF)
 			pthread_exit(NULL);
 
-		bubblesort((uint32_t *)ret);
+		bubblesort(reconos_addr_to_host(ret));
 
 		mbox_put(res[1].ptr, ret);
 	}
@@ -24,15 +24,28 @@
 
 #include <stdint.h>
 
+struct reconos_perf_counters;
+
 
 /* == OSIF related functions ============================================ */
 
 extern int reconos_osif_open(int num);
 extern uint32_t reconos_osif_read(int fd);
 extern void reconos_osif_write(int fd, uint32_t data);
+extern void reconos_osif_read_data(int fd, uint32_t *data, unsigned int count);
+extern void reconos_osif_write_data(int fd, uint32_t *data, unsigned int count);
+extern void reconos_osif_set_poll_limit(int fd, int limit);
+extern int reconos_osif_set_coalescing(int threshold, int timeout);
 extern void reconos_osif_close(int fd);
 
 
+/* == OSIF recording (see osif_record.c) ================================ */
+
+extern void reconos_osif_record_open(int fd, int num);
+extern void reconos_osif_record(int fd, int dir, uint32_t *data, unsigned int count);
+extern void reconos_osif_record_reset(int num, int reset);
+
+
 /* == Proc control related functions ==================================== */
 
 extern int reconos_proc_control_open();
@@ -44,7 +57,14 @@ extern void reconos_proc_control_clear_page_fault(int fd);
 extern void reconos_proc_control_set_pgd(int fd);
 extern void reconos_proc_control_sys_reset(int fd);
 extern void reconos_proc_control_hwt_reset(int fd, int num, int reset);
+extern void reconos_proc_control_tlb_invalidate(int fd, uint32_t addr);
+extern void reconos_proc_control_tlb_invalidate_all(int fd);
+extern void reconos_proc_control_set_memif_qos(int fd, int num, int weight, int priority);
+extern uint32_t reconos_proc_control_get_memif_bytes(int fd, int num);
+extern void reconos_proc_control_get_hwt_perf(int fd, int num, struct reconos_perf_counters *counters);
 extern void reconos_proc_control_cache_flush(int fd);
+extern void reconos_proc_control_cache_flush_range(int fd, void *addr, size_t len);
+extern void reconos_proc_control_cache_invalidate_range(int fd, void *addr, size_t len);
 extern void reconos_proc_control_close(int fd);
 
 
@@ -0,0 +1,494 @@
+/*
+ *                                                        ____  _____
+ *                            ________  _________  ____  / __ \/ ___/
+ *                           / ___/ _ \/ ___/ __ \/ __ \/ / / /\__ \
+ *                          / /  /  __/ /__/ /_/ / / / / /_/ /___/ /
+ *                         /_/   \___/\___/\____/_/ /_/\____//____/
+ *
+ * ======================================================================
+ *
+ *   title:        Architecture specific code - Co-simulation, Linux
+ *
+ *   project:      ReconOS
+ *   description:  Runs the software runtime on a workstation against
+ *                 hardware threads simulated by GHDL. OSIF and MEMIF
+ *                 are replaced by rings in a shared memory segment
+ *                 (see cosim.h), memory requests of the hardware
+ *                 threads are served directly from host memory.
+ *
+ * ======================================================================
+ */
+
+
+#ifdef RECONOS_ARCH_cosim
+#ifdef RECONOS_OS_linux
+
+#include "arch.h"
+#include "cosim.h"
+#include "osif_record.h"
+
+#include "../reconos.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include "pthread.h"
+
+// number of polls of a ring before sleeping
+#define COSIM_POLL_COUNT   1024
+#define COSIM_SLEEP_US     50
+
+#define MEMIF_CMD_READ     0x00
+#define MEMIF_CMD_WRITE    0xF0
+
+// data cache of the MicroBlaze whose maintenance is counted
+#define COSIM_DCACHE_BYTE_SIZE (64 * 1024)
+#define COSIM_DCACHE_LINE_LEN  (4 * 4)
+
+static struct cosim_shm *cosim_shm;
+
+static void cosim_wait() {
+	usleep(COSIM_SLEEP_US);
+}
+
+static void cosim_unlink() {
+	shm_unlink(COSIM_SHM_NAME);
+}
+
+static void cosim_print_stats() {
+	struct cosim_slot *slot;
+	int i;
+
+	printf("[reconos-core] co-simulation statistics:\n");
+	for (i = 0; i < cosim_shm->num_slots; i++) {
+		slot = &cosim_shm->slot[i];
+		if (!slot->cycles)
+			continue;
+
+		printf("  slot %2d: %llu cycles, %llu osif wait, %llu memif stall\n", i,
+		       (unsigned long long)slot->cycles,
+		       (unsigned long long)slot->osif_wait_cycles,
+		       (unsigned long long)slot->memif_stall_cycles);
+	}
+
+	printf("  cache:   %llu full flushes, %llu lines flushed, %llu lines invalidated\n",
+	       (unsigned long long)cosim_shm->cache_flushes,
+	       (unsigned long long)cosim_shm->cache_lines_flushed,
+	       (unsigned long long)cosim_shm->cache_lines_invalidated);
+}
+
+
+/* == MEMIF server ====================================================== */
+
+#define MEMIF_STATE_CMD    0
+#define MEMIF_STATE_ADDR   1
+#define MEMIF_STATE_READ   2
+#define MEMIF_STATE_WRITE  3
+
+/*
+ * reset_req     - number of resets requested by the runtime
+ * reset_ack     - number of resets acknowledged by the server
+ * bytes_read    - bytes read from memory by the slot
+ * bytes_written - bytes written to memory by the slot
+ */
+struct memif_server {
+	int state;
+	uint32_t cmd;
+	uint32_t *addr;
+	unsigned int count;
+
+	volatile uint32_t reset_req;
+	volatile uint32_t reset_ack;
+
+	uint32_t bytes_read;
+	uint32_t bytes_written;
+};
+
+/*
+ * Advances the memif transaction of a single slot as far as the rings
+ * allow. Returns the number of words transferred.
+ */
+static int memif_serve(struct cosim_slot *slot, struct memif_server *srv) {
+	int done = 0;
+
+	// drop the transaction in flight and acknowledge the reset, the
+	// rings are emptied by the runtime and the simulator
+	if (slot->reset) {
+		srv->state = MEMIF_STATE_CMD;
+		srv->reset_ack = srv->reset_req;
+		return 0;
+	}
+
+	while (1) {
+		switch (srv->state) {
+			case MEMIF_STATE_CMD:
+				if (cosim_fifo_fill(&slot->hwt2mem) == 0)
+					return done;
+				srv->cmd = cosim_fifo_peek(&slot->hwt2mem);
+				cosim_fifo_pop(&slot->hwt2mem);
+				srv->state = MEMIF_STATE_ADDR;
+				break;
+
+			case MEMIF_STATE_ADDR:
+				if (cosim_fifo_fill(&slot->hwt2mem) == 0)
+					return done;
+				srv->addr = reconos_addr_to_host(cosim_fifo_peek(&slot->hwt2mem));
+				cosim_fifo_pop(&slot->hwt2mem);
+
+				srv->count = (srv->cmd & 0x00FFFFFF) / 4;
+				if (srv->count == 0)
+					srv->state = MEMIF_STATE_CMD;
+				else if ((srv->cmd >> 24) == MEMIF_CMD_WRITE)
+					srv->state = MEMIF_STATE_WRITE;
+				else
+					srv->state = MEMIF_STATE_READ;
+				break;
+
+			case MEMIF_STATE_READ:
+				if (cosim_fifo_rem(&slot->mem2hwt) == 0)
+					return done;
+				cosim_fifo_push(&slot->mem2hwt, *srv->addr++);
+				if (--srv->count == 0)
+					srv->state = MEMIF_STATE_CMD;
+				srv->bytes_read += 4;
+				done++;
+				break;
+
+			case MEMIF_STATE_WRITE:
+				if (cosim_fifo_fill(&slot->hwt2mem) == 0)
+					return done;
+				*srv->addr++ = cosim_fifo_peek(&slot->hwt2mem);
+				cosim_fifo_pop(&slot->hwt2mem);
+				if (--srv->count == 0)
+					srv->state = MEMIF_STATE_CMD;
+				srv->bytes_written += 4;
+				done++;
+				break;
+		}
+	}
+}
+
+// transaction state and statistics of each slot
+static struct memif_server memif_srv[COSIM_MAX_SLOTS];
+
+static void *memif_server_thread(void *arg) {
+	int i, idle = 0, done;
+
+	while (1) {
+		done = 0;
+		for (i = 0; i < cosim_shm->num_slots; i++)
+			done += memif_serve(&cosim_shm->slot[i], &memif_srv[i]);
+
+		if (done)
+			idle = 0;
+		else if (++idle > COSIM_POLL_COUNT)
+			cosim_wait();
+	}
+
+	return NULL;
+}
+
+
+/* == OSIF related functions ============================================ */
+
+int reconos_osif_open(int num) {
+	if (num < 0 || num >= cosim_shm->num_slots)
+		return -1;
+
+	reconos_osif_record_open(num, num);
+
+	// the slot number serves as file descriptor
+	return num;
+}
+
+uint32_t reconos_osif_read(int fd) {
+	struct cosim_fifo *fifo = &cosim_shm->slot[fd].hw2sw;
+	uint32_t data;
+	int i;
+
+	for (i = 0; cosim_fifo_fill(fifo) == 0; i++) {
+		if (i > COSIM_POLL_COUNT)
+			cosim_wait();
+	}
+
+	data = cosim_fifo_peek(fifo);
+	cosim_fifo_pop(fifo);
+
+	reconos_osif_record(fd, OSIF_RECORD_HW2SW, &data, 1);
+
+	return data;
+}
+
+void reconos_osif_write(int fd, uint32_t data) {
+	struct cosim_fifo *fifo = &cosim_shm->slot[fd].sw2hw;
+	int i;
+
+	for (i = 0; cosim_fifo_rem(fifo) == 0; i++) {
+		if (i > COSIM_POLL_COUNT)
+			cosim_wait();
+	}
+
+	cosim_fifo_push(fifo, data);
+
+	reconos_osif_record(fd, OSIF_RECORD_SW2HW, &data, 1);
+}
+
+void reconos_osif_read_data(int fd, uint32_t *data, unsigned int count) {
+	unsigned int i;
+
+	for (i = 0; i < count; i++)
+		data[i] = reconos_osif_read(fd);
+}
+
+void reconos_osif_write_data(int fd, uint32_t *data, unsigned int count) {
+	unsigned int i;
+
+	for (i = 0; i < count; i++)
+		reconos_osif_write(fd, data[i]);
+}
+
+void reconos_osif_set_poll_limit(int fd, int limit) {
+	// nothing to do here
+}
+
+int reconos_osif_set_coalescing(int threshold, int timeout) {
+	// nothing to do here
+	return 0;
+}
+
+void reconos_osif_close(int fd) {
+	// nothing to do here
+}
+
+
+/* == Proc control related functions ==================================== */
+
+int reconos_proc_control_open() {
+	return 0;
+}
+
+int reconos_proc_control_get_num_hwts(int fd) {
+	return cosim_shm->num_slots;
+}
+
+int reconos_proc_control_get_tlb_hits(int fd) {
+	return 0;
+}
+
+int reconos_proc_control_get_tlb_misses(int fd) {
+	return 0;
+}
+
+uint32_t reconos_proc_control_get_fault_addr(int fd) {
+	// memory is served from the host, there are no page faults
+	while (1)
+		pause();
+
+	return 0;
+}
+
+void reconos_proc_control_clear_page_fault(int fd) {
+	// nothing to do here
+}
+
+void reconos_proc_control_set_pgd(int fd) {
+	// nothing to do here
+}
+
+void reconos_proc_control_sys_reset(int fd) {
+	int i;
+
+	for (i = 0; i < cosim_shm->num_slots; i++)
+		reconos_proc_control_hwt_reset(fd, i, 1);
+}
+
+void reconos_proc_control_hwt_reset(int fd, int num, int reset) {
+	struct memif_server *srv;
+	struct cosim_slot *slot;
+	int i;
+
+	if (num < 0 || num >= cosim_shm->num_slots)
+		return;
+
+	slot = &cosim_shm->slot[num];
+	srv = &memif_srv[num];
+	slot->reset = reset;
+
+	if (reset) {
+		// the memif server must stop producing before the simulator
+		// empties mem2hwt
+		__sync_synchronize();
+		srv->reset_req++;
+		for (i = 0; srv->reset_ack != srv->reset_req; i++) {
+			if (i > COSIM_POLL_COUNT)
+				cosim_wait();
+		}
+
+		// the simulator empties sw2hw and mem2hwt and stops producing
+		slot->reset_seq++;
+		for (i = 0; slot->attached && slot->reset_ack != slot->reset_seq; i++) {
+			if (i > COSIM_POLL_COUNT)
+				cosim_wait();
+		}
+
+		// nobody produces anymore, so empty the rings consumed here
+		slot->hw2sw.rd = slot->hw2sw.wr;
+		slot->hwt2mem.rd = slot->hwt2mem.wr;
+	}
+
+	reconos_osif_record_reset(num, reset);
+}
+
+void reconos_proc_control_tlb_invalidate(int fd, uint32_t addr) {
+	// nothing to do here
+}
+
+void reconos_proc_control_tlb_invalidate_all(int fd) {
+	// nothing to do here
+}
+
+void reconos_proc_control_set_memif_qos(int fd, int num, int weight, int priority) {
+	// memory accesses are served in software without arbitration
+}
+
+uint32_t reconos_proc_control_get_memif_bytes(int fd, int num) {
+	if (num < 0 || num >= COSIM_MAX_SLOTS)
+		return 0;
+
+	return memif_srv[num].bytes_read + memif_srv[num].bytes_written;
+}
+
+void reconos_proc_control_get_hwt_perf(int fd, int num, struct reconos_perf_counters *counters) {
+	struct cosim_slot *slot;
+
+	memset(counters, 0, sizeof(struct reconos_perf_counters));
+	if (num < 0 || num >= cosim_shm->num_slots)
+		return;
+
+	// the simulator counts the cycles of the hardware thread
+	slot = &cosim_shm->slot[num];
+	counters->cycles = slot->cycles;
+	counters->osif_wait = slot->osif_wait_cycles;
+	counters->memif_wait = slot->memif_stall_cycles;
+	counters->bytes_read = memif_srv[num].bytes_read;
+	counters->bytes_written = memif_srv[num].bytes_written;
+}
+
+/*
+ * Counts the lines touched by a ranged cache operation, using the same
+ * range math and fallback as the MicroBlaze driver.
+ */
+static void cosim_cache_range(unsigned long addr, unsigned long len,
+                              volatile uint64_t *lines) {
+	// walking the whole cache is cheaper for large ranges
+	if (len >= COSIM_DCACHE_BYTE_SIZE) {
+		reconos_proc_control_cache_flush(0);
+		return;
+	}
+
+	len += addr & (COSIM_DCACHE_LINE_LEN - 1);
+
+	__sync_fetch_and_add(lines, (len + COSIM_DCACHE_LINE_LEN - 1) / COSIM_DCACHE_LINE_LEN);
+}
+
+void reconos_proc_control_cache_flush(int fd) {
+	// memory is shared with the simulator, so just count
+	__sync_fetch_and_add(&cosim_shm->cache_flushes, 1);
+	__sync_fetch_and_add(&cosim_shm->cache_lines_flushed,
+	                     COSIM_DCACHE_BYTE_SIZE / COSIM_DCACHE_LINE_LEN);
+}
+
+void reconos_proc_control_cache_flush_range(int fd, void *addr, size_t len) {
+	cosim_cache_range((unsigned long)addr, len, &cosim_shm->cache_lines_flushed);
+}
+
+void reconos_proc_control_cache_invalidate_range(int fd, void *addr, size_t len) {
+	unsigned long start, end;
+
+	if (len >= COSIM_DCACHE_BYTE_SIZE) {
+		reconos_proc_control_cache_flush(0);
+		return;
+	}
+
+	// like the MicroBlaze driver, partly covered lines are flushed and
+	// only the lines fully inside the range are invalidated
+	start = (unsigned long)addr;
+	end = start + len;
+	if (start & (COSIM_DCACHE_LINE_LEN - 1)) {
+		start = (start & ~(COSIM_DCACHE_LINE_LEN - 1)) + COSIM_DCACHE_LINE_LEN;
+		__sync_fetch_and_add(&cosim_shm->cache_lines_flushed, 1);
+	}
+	if ((end & (COSIM_DCACHE_LINE_LEN - 1)) && end > start) {
+		end &= ~(COSIM_DCACHE_LINE_LEN - 1);
+		__sync_fetch_and_add(&cosim_shm->cache_lines_flushed, 1);
+	}
+
+	if (end > start)
+		__sync_fetch_and_add(&cosim_shm->cache_lines_invalidated,
+		                     (end - start) / COSIM_DCACHE_LINE_LEN);
+}
+
+void reconos_proc_control_close(int fd) {
+	// nothing to do here
+}
+
+
+/* == Reconfiguration related functions ================================= */
+
+int load_partial_bitstream(uint32_t *bitstream, unsigned int bitstream_length) {
+	// the simulated hardware thread is fixed at elaboration time
+	return 0;
+}
+
+
+/* == Initialization function =========================================== */
+
+void reconos_drv_init() {
+	pthread_t thread;
+	char *env;
+	int fd, num_slots = 1;
+
+	if (cosim_shm)
+		return;
+
+	env = getenv("RECONOS_COSIM_SLOTS");
+	if (env)
+		num_slots = atoi(env);
+	if (num_slots < 1 || num_slots > COSIM_MAX_SLOTS)
+		panic("[reconos-core] invalid number of co-simulation slots\n");
+
+	// the simulator attaches to the segment created here, a segment left
+	// over by a crashed runtime is replaced
+	shm_unlink(COSIM_SHM_NAME);
+	fd = shm_open(COSIM_SHM_NAME, O_RDWR | O_CREAT | O_EXCL, 0600);
+	if (fd < 0)
+		panic("[reconos-core] unable to create co-simulation shared memory\n");
+
+	if (ftruncate(fd, sizeof(struct cosim_shm)) < 0)
+		panic("[reconos-core] unable to size co-simulation shared memory\n");
+
+	cosim_shm = mmap(NULL, sizeof(struct cosim_shm), PROT_READ | PROT_WRITE,
+	                 MAP_SHARED, fd, 0);
+	if (cosim_shm == MAP_FAILED)
+		panic("[reconos-core] unable to map co-simulation shared memory\n");
+	close(fd);
+
+	memset(cosim_shm, 0, sizeof(struct cosim_shm));
+	cosim_shm->pid = getpid();
+	cosim_shm->num_slots = num_slots;
+	__sync_synchronize();
+	cosim_shm->magic = COSIM_SHM_MAGIC;
+	atexit(cosim_unlink);
+
+	pthread_create(&thread, NULL, memif_server_thread, NULL);
+	pthread_detach(thread);
+
+	atexit(cosim_print_stats);
+}
+
+#endif
+#endif
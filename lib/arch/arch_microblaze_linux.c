@@ -22,10 +22,13 @@
 #ifdef RECONOS_OS_linux
 
 #include "arch.h"
+#include "osif_record.h"
 
 #include "../../linux/driver/include/reconos.h"
+#include "../reconos.h"
 
 #include <stdio.h>
+#include <string.h>
 #include <unistd.h>
 #include <fcntl.h>
 #include <sys/ioctl.h>
@@ -48,6 +51,8 @@ int reconos_osif_open(int num) {
 	if (fd < 0)
 		panic("[reconos_core] error while opening osif %d\n", num);
 
+	reconos_osif_record_open(fd, num);
+
 	return fd;
 }
 
@@ -59,17 +64,78 @@ uint32_t reconos_osif_read(int fd) {
 	if (ret < 0)
 		panic("[reconos-core] error reading from osif\n");
 
+	reconos_osif_record(fd, OSIF_RECORD_HW2SW, &data, 1);
+
 	return data;
 }
 
 void reconos_osif_write(int fd, uint32_t data) {
 	int ret;
 
+	reconos_osif_record(fd, OSIF_RECORD_SW2HW, &data, 1);
+
 	ret = write(fd, &data, sizeof(data));
 	if (ret < 0)
 		panic("[reconos-core] error writing to osif\n");
 }
 
+void reconos_osif_read_data(int fd, uint32_t *data, unsigned int count) {
+	int ret;
+	size_t done, len;
+
+	// the driver may return early if interrupted, so continue until done
+	len = count * sizeof(uint32_t);
+	for (done = 0; done < len; done += ret) {
+		ret = read(fd, (char *)data + done, len - done);
+		if (ret < 0)
+			panic("[reconos-core] error reading from osif\n");
+	}
+
+	reconos_osif_record(fd, OSIF_RECORD_HW2SW, data, count);
+}
+
+void reconos_osif_write_data(int fd, uint32_t *data, unsigned int count) {
+	int ret;
+	size_t done, len;
+
+	reconos_osif_record(fd, OSIF_RECORD_SW2HW, data, count);
+
+	len = count * sizeof(uint32_t);
+	for (done = 0; done < len; done += ret) {
+		ret = write(fd, (char *)data + done, len - done);
+		if (ret < 0)
+			panic("[reconos-core] error writing to osif\n");
+	}
+}
+
+void reconos_osif_set_poll_limit(int fd, int limit) {
+	if (ioctl(fd, RECONOS_OSIF_SET_POLL_LIMIT, &limit) < 0)
+		whine("[reconos-core] unable to set osif poll limit\n");
+}
+
+int reconos_osif_set_coalescing(int threshold, int timeout) {
+	struct reconos_osif_coalesce coalesce;
+	int fd, ret;
+
+	// the setting is shared by all OSIFs, so any of them will do
+	fd = open("/dev/reconos/osif-0", O_RDWR);
+	if (fd < 0) {
+		whine("[reconos-core] unable to open osif to set interrupt coalescing\n");
+		return -1;
+	}
+
+	coalesce.threshold = threshold;
+	coalesce.timeout = timeout;
+
+	ret = ioctl(fd, RECONOS_OSIF_SET_INTC_COALESCE, &coalesce);
+	if (ret < 0)
+		whine("[reconos-core] unable to set osif interrupt coalescing\n");
+
+	close(fd);
+
+	return ret < 0 ? -1 : 0;
+}
+
 void reconos_osif_close(int fd) {
 	close(fd);
 }
@@ -136,12 +202,84 @@ void reconos_proc_control_hwt_reset(int fd, int num, int reset) {
 		ioctl(fd, RECONOS_PROC_CONTROL_SET_HWT_RESET, &num);
 	else
 		ioctl(fd, RECONOS_PROC_CONTROL_CLEAR_HWT_RESET, &num);
+
+	reconos_osif_record_reset(num, reset);
+}
+
+void reconos_proc_control_tlb_invalidate(int fd, uint32_t addr) {
+	unsigned long page = addr;
+
+	ioctl(fd, RECONOS_PROC_CONTROL_TLB_INVALIDATE, &page);
+}
+
+void reconos_proc_control_tlb_invalidate_all(int fd) {
+	unsigned long page = RECONOS_TLB_INVALIDATE_ALL;
+
+	ioctl(fd, RECONOS_PROC_CONTROL_TLB_INVALIDATE, &page);
+}
+
+void reconos_proc_control_set_memif_qos(int fd, int num, int weight, int priority) {
+	struct reconos_memif_qos qos;
+
+	qos.slot = num;
+	qos.weight = weight;
+	qos.priority = priority;
+
+	ioctl(fd, RECONOS_PROC_CONTROL_SET_MEMIF_QOS, &qos);
+}
+
+uint32_t reconos_proc_control_get_memif_bytes(int fd, int num) {
+	struct reconos_memif_bytes bytes;
+
+	bytes.slot = num;
+	bytes.bytes = 0;
+
+	ioctl(fd, RECONOS_PROC_CONTROL_GET_MEMIF_BYTES, &bytes);
+
+	return bytes.bytes;
+}
+
+void reconos_proc_control_get_hwt_perf(int fd, int num, struct reconos_perf_counters *counters) {
+	struct reconos_hwt_perf perf;
+
+	memset(&perf, 0, sizeof(perf));
+	perf.slot = num;
+
+	if (ioctl(fd, RECONOS_PROC_CONTROL_GET_HWT_PERF, &perf) < 0) {
+		whine("[reconos-core] unable to read performance counters of slot %d\n", num);
+		memset(counters, 0, sizeof(struct reconos_perf_counters));
+		return;
+	}
+
+	counters->cycles = perf.cycles;
+	counters->osif_wait = perf.osif_wait;
+	counters->memif_wait = perf.memif_wait;
+	counters->bytes_read = perf.bytes_read;
+	counters->bytes_written = perf.bytes_written;
 }
 
 void reconos_proc_control_cache_flush(int fd) {
 	ioctl(fd, RECONOS_PROC_CONTROL_CACHE_FLUSH, NULL);
 }
 
+void reconos_proc_control_cache_flush_range(int fd, void *addr, size_t len) {
+	struct reconos_cache_range range;
+
+	range.addr = (unsigned long)addr;
+	range.len = len;
+
+	ioctl(fd, RECONOS_PROC_CONTROL_CACHE_FLUSH_RANGE, &range);
+}
+
+void reconos_proc_control_cache_invalidate_range(int fd, void *addr, size_t len) {
+	struct reconos_cache_range range;
+
+	range.addr = (unsigned long)addr;
+	range.len = len;
+
+	ioctl(fd, RECONOS_PROC_CONTROL_CACHE_INVALIDATE_RANGE, &range);
+}
+
 void reconos_proc_control_close(int fd) {
 	close(fd);
 }
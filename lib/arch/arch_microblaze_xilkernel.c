@@ -22,6 +22,7 @@
 #ifdef RECONOS_OS_xilkernel
 
 #include "arch.h"
+#include "../reconos.h"
 
 #include "xhwicap.h"
 
@@ -38,8 +39,14 @@ unsigned int NUM_HWTS = 0;
 #define OSIF_INTC_MEM_SIZE   0x10000
 #define OSIF_INTC_IRQ        3
 
+// the coalescing registers follow the single interrupt register
+#define OSIF_INTC_COALESCE_THRESHOLD_REG 1
+#define OSIF_INTC_COALESCE_TIMEOUT_REG   2
+
 #define OSIF_FIFO_BASE_ADDR       0x75A00000
-#define OSIF_FIFO_MEM_SIZE        0x10
+// distance of the registers of two fifos, must match OSIF_FIFO_STRIDE_LOG2
+// of mhsaddhwts.py for microblaze
+#define OSIF_FIFO_STRIDE          0x10
 #define OSIF_FIFO_RECV_REG        0
 #define OSIF_FIFO_SEND_REG        1
 #define OSIF_FIFO_RECV_STATUS_REG 2
@@ -51,12 +58,15 @@ unsigned int NUM_HWTS = 0;
 #define OSIF_FIFO_RECV_STATUS_FILL_MASK 0xFFFF
 #define OSIF_FIFO_SEND_STATUS_REM_MASK  0xFFFF
 
+#define OSIF_FIFO_POLL_LIMIT_MAX        65536
+
 struct osif_fifo_dev {
 	unsigned int index;
 
 	volatile uint32_t *ptr;
 
 	unsigned int fifo_fill;
+	unsigned int poll_limit, poll_budget;
 	sem_t wait;
 };
 
@@ -126,12 +136,36 @@ void osif_intc_interrupt(void *arg) {
 	}
 }
 
+// polls the recv fifo for a budget learned from recent response times
+// and returns if data arrived without the need to enable the interrupt
+static int osif_fifo_poll_fill(struct osif_fifo_dev *dev) {
+	unsigned int spin, budget;
+
+	for (spin = 0; spin < dev->poll_budget; spin++) {
+		dev->fifo_fill = osif_fifo_hw2sw_fill(dev);
+		if (dev->fifo_fill > 0) {
+			// moving average of twice the observed response time
+			budget = (dev->poll_budget * 7 + spin * 2) / 8 + 1;
+			dev->poll_budget = budget < dev->poll_limit ? budget : dev->poll_limit;
+			return 1;
+		}
+	}
+
+	// the hwt responds slowly, so spend less time polling next time
+	budget = dev->poll_budget / 2;
+	dev->poll_budget = budget > dev->poll_limit / 16 ? budget : dev->poll_limit / 16;
+	return 0;
+}
+
 uint32_t reconos_osif_read(int fd) {
 	struct osif_fifo_dev *dev = &osif_fifo_dev[fd];
 
 	if (dev->fifo_fill == 0) {
 		dev->fifo_fill = osif_fifo_hw2sw_fill(dev);
 
+		if (dev->fifo_fill == 0)
+			osif_fifo_poll_fill(dev);
+
 		while (dev->fifo_fill == 0) {
 			osif_intc_enable_interrupt(&osif_intc_dev, fd);
 			sem_wait(&dev->wait);
@@ -152,6 +186,45 @@ void reconos_osif_write(int fd, uint32_t data) {
 	osif_fifo_dev[fd].ptr[OSIF_FIFO_SEND_REG] = data;
 }
 
+void reconos_osif_read_data(int fd, uint32_t *data, unsigned int count) {
+	int i;
+
+	for (i = 0; i < count; i++)
+		data[i] = reconos_osif_read(fd);
+}
+
+void reconos_osif_write_data(int fd, uint32_t *data, unsigned int count) {
+	int i;
+
+	for (i = 0; i < count; i++)
+		reconos_osif_write(fd, data[i]);
+}
+
+void reconos_osif_set_poll_limit(int fd, int limit) {
+	if (limit < 0 || limit > OSIF_FIFO_POLL_LIMIT_MAX) {
+		whine("[reconos-core] invalid osif poll limit %d\n", limit);
+		return;
+	}
+
+	osif_fifo_dev[fd].poll_limit = limit;
+	osif_fifo_dev[fd].poll_budget = limit;
+}
+
+int reconos_osif_set_coalescing(int threshold, int timeout) {
+	// a threshold never reached would hold back the interrupt forever
+	if (threshold > 1 && (timeout == 0 || threshold > NUM_HWTS))
+		return -1;
+
+	pthread_mutex_lock(&osif_intc_dev.lock);
+
+	osif_intc_dev.ptr[OSIF_INTC_COALESCE_THRESHOLD_REG] = threshold;
+	osif_intc_dev.ptr[OSIF_INTC_COALESCE_TIMEOUT_REG] = timeout;
+
+	pthread_mutex_unlock(&osif_intc_dev.lock);
+
+	return 0;
+}
+
 void reconos_osif_close(int fd) {
 	// nothing to do here
 }
@@ -168,7 +241,19 @@ void reconos_osif_close(int fd) {
 #define PROC_CONTROL_TLB_HITS_REG        3
 #define PROC_CONTROL_TLB_MISSES_REG      4
 #define PROC_CONTROL_SYS_RESET_REG       5
-#define PROC_CONTROL_HWT_RESET_REG       6
+#define PROC_CONTROL_TLB_INVALIDATE_REG  6
+#define PROC_CONTROL_ARB_SLOT_REG        7
+#define PROC_CONTROL_ARB_QOS_REG         8
+#define PROC_CONTROL_ARB_BYTES_REG       9
+#define PROC_CONTROL_PERF_CYCLES_REG     10
+#define PROC_CONTROL_PERF_OSIF_WAIT_REG  11
+#define PROC_CONTROL_PERF_MEMIF_WAIT_REG 12
+#define PROC_CONTROL_PERF_BYTES_RD_REG   13
+#define PROC_CONTROL_PERF_BYTES_WR_REG   14
+
+// selects the upper halves of the performance counters latched before
+#define PROC_CONTROL_ARB_SLOT_PERF_HI    0x80000000
+#define PROC_CONTROL_HWT_RESET_REG       15
 
 struct proc_control_dev {
 	volatile uint32_t *ptr;
@@ -227,6 +312,47 @@ void reconos_proc_control_hwt_reset(int fd, int num, int reset) {
 	}
 }
 
+void reconos_proc_control_tlb_invalidate(int fd, uint32_t addr) {
+	// nothing to do here since no MMU present
+}
+
+void reconos_proc_control_tlb_invalidate_all(int fd) {
+	// nothing to do here since no MMU present
+}
+
+void reconos_proc_control_set_memif_qos(int fd, int num, int weight, int priority) {
+	if (num >= 0 && num < NUM_HWTS) {
+		proc_control_dev.ptr[PROC_CONTROL_ARB_SLOT_REG] = num;
+		proc_control_dev.ptr[PROC_CONTROL_ARB_QOS_REG] = (weight & 0xFF) | (priority & 0x3) << 8;
+	}
+}
+
+uint32_t reconos_proc_control_get_memif_bytes(int fd, int num) {
+	if (num < 0 || num >= NUM_HWTS)
+		return 0;
+
+	proc_control_dev.ptr[PROC_CONTROL_ARB_SLOT_REG] = num;
+	return proc_control_dev.ptr[PROC_CONTROL_ARB_BYTES_REG];
+}
+
+void reconos_proc_control_get_hwt_perf(int fd, int num, struct reconos_perf_counters *counters) {
+	if (num < 0 || num >= NUM_HWTS)
+		return;
+
+	// selecting the slot latches its counters
+	proc_control_dev.ptr[PROC_CONTROL_ARB_SLOT_REG] = num;
+	counters->cycles = proc_control_dev.ptr[PROC_CONTROL_PERF_CYCLES_REG];
+	counters->osif_wait = proc_control_dev.ptr[PROC_CONTROL_PERF_OSIF_WAIT_REG];
+	counters->memif_wait = proc_control_dev.ptr[PROC_CONTROL_PERF_MEMIF_WAIT_REG];
+	counters->bytes_read = proc_control_dev.ptr[PROC_CONTROL_PERF_BYTES_RD_REG];
+	counters->bytes_written = proc_control_dev.ptr[PROC_CONTROL_PERF_BYTES_WR_REG];
+
+	proc_control_dev.ptr[PROC_CONTROL_ARB_SLOT_REG] = num | PROC_CONTROL_ARB_SLOT_PERF_HI;
+	counters->cycles |= (uint64_t)proc_control_dev.ptr[PROC_CONTROL_PERF_CYCLES_REG] << 32;
+	counters->osif_wait |= (uint64_t)proc_control_dev.ptr[PROC_CONTROL_PERF_OSIF_WAIT_REG] << 32;
+	counters->memif_wait |= (uint64_t)proc_control_dev.ptr[PROC_CONTROL_PERF_MEMIF_WAIT_REG] << 32;
+}
+
 void reconos_proc_control_cache_flush(int fd) {
 	int i;
 	int baseaddr, bytesize,linelen;
@@ -243,6 +369,56 @@ void reconos_proc_control_cache_flush(int fd) {
 		asm volatile ("wdc.flush %0, %1;" :: "d" (baseaddr), "d" (i));
 }
 
+// these parameters need to be adjusted to the architecture
+// C_DCACHE_BYTE_SIZE
+#define DCACHE_BYTE_SIZE (64 * 1024)
+// C_DCACHE_LINE_LEN * 4
+#define DCACHE_LINE_LEN  (4 * 4)
+
+void reconos_proc_control_cache_flush_range(int fd, void *addr, size_t len) {
+	unsigned int i, base;
+
+	// walking the whole cache is cheaper for large ranges
+	if (len >= DCACHE_BYTE_SIZE) {
+		reconos_proc_control_cache_flush(fd);
+		return;
+	}
+
+	base = (unsigned int)addr & ~(DCACHE_LINE_LEN - 1);
+	len += (unsigned int)addr & (DCACHE_LINE_LEN - 1);
+
+	for (i = 0; i < len; i += DCACHE_LINE_LEN)
+		asm volatile ("wdc.flush %0, %1;" :: "d" (base), "d" (i));
+}
+
+void reconos_proc_control_cache_invalidate_range(int fd, void *addr, size_t len) {
+	unsigned int i, base, end;
+
+	// flushing also invalidates the lines
+	if (len >= DCACHE_BYTE_SIZE) {
+		reconos_proc_control_cache_flush(fd);
+		return;
+	}
+
+	base = (unsigned int)addr;
+	end = base + len;
+
+	// lines only partly covered by the range may hold dirty data of
+	// neighbours, so they are written back instead of dropped
+	if (base & (DCACHE_LINE_LEN - 1)) {
+		base &= ~(DCACHE_LINE_LEN - 1);
+		asm volatile ("wdc.flush %0, %1;" :: "d" (base), "d" (0));
+		base += DCACHE_LINE_LEN;
+	}
+	if ((end & (DCACHE_LINE_LEN - 1)) && end > base) {
+		end &= ~(DCACHE_LINE_LEN - 1);
+		asm volatile ("wdc.flush %0, %1;" :: "d" (end), "d" (0));
+	}
+
+	for (i = 0; base + i < end; i += DCACHE_LINE_LEN)
+		asm volatile ("wdc.clear %0, %1;" :: "d" (base), "d" (i));
+}
+
 void reconos_proc_control_close(int fd) {
 	// nothing to do here
 }
@@ -331,8 +507,10 @@ void reconos_drv_init() {
 
 	for (i = 0; i < NUM_HWTS; i++) {
 		osif_fifo_dev[i].index = i;
-		osif_fifo_dev[i].ptr = (uint32_t *)(OSIF_FIFO_BASE_ADDR + i * OSIF_FIFO_MEM_SIZE);
+		osif_fifo_dev[i].ptr = (uint32_t *)(OSIF_FIFO_BASE_ADDR + i * OSIF_FIFO_STRIDE);
 		osif_fifo_dev[i].fifo_fill = 0;
+		osif_fifo_dev[i].poll_limit = 0;
+		osif_fifo_dev[i].poll_budget = 0;
 		sem_init(&osif_fifo_dev[i].wait, 0, 0);
 	}
 }
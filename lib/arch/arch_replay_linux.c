@@ -0,0 +1,378 @@
+/*
+ *                                                        ____  _____
+ *                            ________  _________  ____  / __ \/ ___/
+ *                           / ___/ _ \/ ___/ __ \/ __ \/ / / /\__ \
+ *                          / /  /  __/ /__/ /_/ / / / / /_/ /___/ /
+ *                         /_/   \___/\___/\____/_/ /_/\____//____/
+ *
+ * ======================================================================
+ *
+ *   title:        Architecture specific code - OSIF replay, Linux
+ *
+ *   project:      ReconOS
+ *   description:  Replays an OSIF recording (see osif_record.c) named
+ *                 by RECONOS_OSIF_REPLAY without any hardware. Each
+ *                 slot is answered by a software stub returning the
+ *                 recorded words of the hardware thread. A word is
+ *                 delayed by the time the hardware thread needed for
+ *                 it in the recording, so the run time of the replay
+ *                 reflects the software side under the recorded load.
+ *
+ * ======================================================================
+ */
+
+
+#ifdef RECONOS_ARCH_replay
+#ifdef RECONOS_OS_linux
+
+#include "arch.h"
+#include "osif_record.h"
+
+#include "../reconos.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "pthread.h"
+
+struct replay_word {
+	uint32_t data;
+	uint32_t gap;
+};
+
+/*
+ * hw2sw      - recorded words of the hardware thread and their delay
+ *              relative to the previous transfer of the slot
+ * sw2hw      - recorded words of the runtime to compare against
+ * last       - time of the previous transfer during replay
+ * mismatches - words written by the runtime differing from the recording
+ */
+struct replay_slot {
+	pthread_mutex_t mutex;
+
+	struct replay_word *hw2sw;
+	unsigned int hw2sw_count, hw2sw_pos;
+
+	uint32_t *sw2hw;
+	unsigned int sw2hw_count, sw2hw_pos;
+
+	uint64_t last;
+	unsigned int mismatches;
+};
+
+static struct replay_slot replay_slot[OSIF_RECORD_MAX_SLOTS];
+static int replay_num_slots;
+static uint64_t replay_rec_time, replay_start;
+
+// time of the last transfer of any slot, shared by all delegates
+static pthread_mutex_t replay_end_mutex = PTHREAD_MUTEX_INITIALIZER;
+static uint64_t replay_end;
+
+static void replay_transfer(struct replay_slot *slot) {
+	slot->last = time_us();
+
+	pthread_mutex_lock(&replay_end_mutex);
+	if (slot->last > replay_end)
+		replay_end = slot->last;
+	pthread_mutex_unlock(&replay_end_mutex);
+}
+
+static void *replay_append(void *array, unsigned int count, unsigned int *size,
+                           size_t elem) {
+	if (count < *size)
+		return array;
+
+	*size = *size ? *size * 2 : 1024;
+	array = realloc(array, *size * elem);
+	if (!array)
+		panic("[reconos-core] unable to allocate replay buffer\n");
+
+	return array;
+}
+
+static void replay_load(char *name) {
+	struct osif_record_header header;
+	struct osif_record_entry entry;
+	struct replay_slot *slot;
+	unsigned int hw2sw_size[OSIF_RECORD_MAX_SLOTS] = {0};
+	unsigned int sw2hw_size[OSIF_RECORD_MAX_SLOTS] = {0};
+	uint64_t time = 0, last[OSIF_RECORD_MAX_SLOTS] = {0};
+	uint32_t data;
+	unsigned int i;
+	FILE *file;
+
+	file = fopen(name, "rb");
+	if (!file)
+		panic("[reconos-core] unable to open osif recording %s\n", name);
+
+	if (fread(&header, sizeof(header), 1, file) != 1
+	    || header.magic != OSIF_RECORD_MAGIC
+	    || header.version != OSIF_RECORD_VERSION)
+		panic("[reconos-core] %s is no osif recording\n", name);
+
+	while (fread(&entry, sizeof(entry), 1, file) == 1) {
+		if (entry.slot >= OSIF_RECORD_MAX_SLOTS)
+			panic("[reconos-core] invalid slot in osif recording\n");
+
+		slot = &replay_slot[entry.slot];
+		if (entry.slot >= replay_num_slots)
+			replay_num_slots = entry.slot + 1;
+
+		time += entry.delta;
+
+		for (i = 0; i < entry.count; i++) {
+			if (fread(&data, sizeof(data), 1, file) != 1)
+				panic("[reconos-core] truncated osif recording\n");
+
+			if (entry.dir == OSIF_RECORD_RESET) {
+				// resets are issued by the runtime itself
+				continue;
+			} else if (entry.dir == OSIF_RECORD_HW2SW) {
+				slot->hw2sw = replay_append(slot->hw2sw, slot->hw2sw_count,
+				                            &hw2sw_size[entry.slot],
+				                            sizeof(struct replay_word));
+				slot->hw2sw[slot->hw2sw_count].data = data;
+				slot->hw2sw[slot->hw2sw_count].gap = i == 0 ? time - last[entry.slot] : 0;
+				slot->hw2sw_count++;
+			} else {
+				slot->sw2hw = replay_append(slot->sw2hw, slot->sw2hw_count,
+				                            &sw2hw_size[entry.slot],
+				                            sizeof(uint32_t));
+				slot->sw2hw[slot->sw2hw_count] = data;
+				slot->sw2hw_count++;
+			}
+		}
+
+		last[entry.slot] = time;
+	}
+
+	fclose(file);
+
+	replay_rec_time = time;
+}
+
+static void replay_print_stats() {
+	struct replay_slot *slot;
+	int i;
+
+	printf("[reconos-core] osif replay statistics:\n");
+	pthread_mutex_lock(&replay_end_mutex);
+	printf("  recorded: %llu us, replayed: %llu us\n",
+	       (unsigned long long)replay_rec_time,
+	       (unsigned long long)(replay_end - replay_start));
+	pthread_mutex_unlock(&replay_end_mutex);
+
+	for (i = 0; i < replay_num_slots; i++) {
+		slot = &replay_slot[i];
+		if (!slot->hw2sw_count && !slot->sw2hw_count)
+			continue;
+
+		printf("  slot %2d: %u/%u words read, %u/%u words written, %u differ\n", i,
+		       slot->hw2sw_pos, slot->hw2sw_count,
+		       slot->sw2hw_pos, slot->sw2hw_count,
+		       slot->mismatches);
+	}
+}
+
+
+/* == OSIF related functions ============================================ */
+
+int reconos_osif_open(int num) {
+	if (num < 0 || num >= replay_num_slots)
+		return -1;
+
+	// the slot number serves as file descriptor
+	return num;
+}
+
+uint32_t reconos_osif_read(int fd) {
+	struct replay_slot *slot = &replay_slot[fd];
+	struct replay_word *word;
+	uint64_t now, due;
+
+	pthread_mutex_lock(&slot->mutex);
+
+	if (slot->hw2sw_pos >= slot->hw2sw_count) {
+		pthread_mutex_unlock(&slot->mutex);
+
+		// the recorded hardware thread does not answer anymore
+		while (1)
+			pause();
+	}
+
+	word = &slot->hw2sw[slot->hw2sw_pos++];
+	due = slot->last + word->gap;
+
+	pthread_mutex_unlock(&slot->mutex);
+
+	now = time_us();
+	if (now < due)
+		usleep(due - now);
+
+	pthread_mutex_lock(&slot->mutex);
+	replay_transfer(slot);
+	pthread_mutex_unlock(&slot->mutex);
+
+	return word->data;
+}
+
+void reconos_osif_write(int fd, uint32_t data) {
+	struct replay_slot *slot = &replay_slot[fd];
+
+	pthread_mutex_lock(&slot->mutex);
+
+	if (slot->sw2hw_pos >= slot->sw2hw_count
+	    || slot->sw2hw[slot->sw2hw_pos] != data)
+		slot->mismatches++;
+	slot->sw2hw_pos++;
+
+	replay_transfer(slot);
+
+	pthread_mutex_unlock(&slot->mutex);
+}
+
+void reconos_osif_read_data(int fd, uint32_t *data, unsigned int count) {
+	unsigned int i;
+
+	for (i = 0; i < count; i++)
+		data[i] = reconos_osif_read(fd);
+}
+
+void reconos_osif_write_data(int fd, uint32_t *data, unsigned int count) {
+	unsigned int i;
+
+	for (i = 0; i < count; i++)
+		reconos_osif_write(fd, data[i]);
+}
+
+void reconos_osif_set_poll_limit(int fd, int limit) {
+	// nothing to do here
+}
+
+int reconos_osif_set_coalescing(int threshold, int timeout) {
+	// nothing to do here
+	return 0;
+}
+
+void reconos_osif_close(int fd) {
+	// nothing to do here
+}
+
+
+/* == Proc control related functions ==================================== */
+
+int reconos_proc_control_open() {
+	return 0;
+}
+
+int reconos_proc_control_get_num_hwts(int fd) {
+	return replay_num_slots;
+}
+
+int reconos_proc_control_get_tlb_hits(int fd) {
+	return 0;
+}
+
+int reconos_proc_control_get_tlb_misses(int fd) {
+	return 0;
+}
+
+uint32_t reconos_proc_control_get_fault_addr(int fd) {
+	// page faults are not part of the recording
+	while (1)
+		pause();
+
+	return 0;
+}
+
+void reconos_proc_control_clear_page_fault(int fd) {
+	// nothing to do here
+}
+
+void reconos_proc_control_set_pgd(int fd) {
+	// nothing to do here
+}
+
+void reconos_proc_control_sys_reset(int fd) {
+	// nothing to do here
+}
+
+void reconos_proc_control_hwt_reset(int fd, int num, int reset) {
+	// nothing to do here
+}
+
+void reconos_proc_control_tlb_invalidate(int fd, uint32_t addr) {
+	// nothing to do here
+}
+
+void reconos_proc_control_tlb_invalidate_all(int fd) {
+	// nothing to do here
+}
+
+void reconos_proc_control_set_memif_qos(int fd, int num, int weight, int priority) {
+	// nothing to do here
+}
+
+uint32_t reconos_proc_control_get_memif_bytes(int fd, int num) {
+	// memory accesses are not part of the recording
+	return 0;
+}
+
+void reconos_proc_control_get_hwt_perf(int fd, int num, struct reconos_perf_counters *counters) {
+	// the hardware counters are not part of the recording
+	memset(counters, 0, sizeof(struct reconos_perf_counters));
+}
+
+void reconos_proc_control_cache_flush(int fd) {
+	// nothing to do here
+}
+
+void reconos_proc_control_cache_flush_range(int fd, void *addr, size_t len) {
+	// nothing to do here
+}
+
+void reconos_proc_control_cache_invalidate_range(int fd, void *addr, size_t len) {
+	// nothing to do here
+}
+
+void reconos_proc_control_close(int fd) {
+	// nothing to do here
+}
+
+
+/* == Reconfiguration related functions ================================= */
+
+int load_partial_bitstream(uint32_t *bitstream, unsigned int bitstream_length) {
+	// the recorded words already reflect the reconfiguration
+	return 0;
+}
+
+
+/* == Initialization function =========================================== */
+
+void reconos_drv_init() {
+	char *name;
+	int i;
+
+	if (replay_num_slots)
+		return;
+
+	name = getenv("RECONOS_OSIF_REPLAY");
+	if (!name)
+		panic("[reconos-core] RECONOS_OSIF_REPLAY not set\n");
+
+	replay_load(name);
+
+	replay_start = time_us();
+	for (i = 0; i < replay_num_slots; i++) {
+		pthread_mutex_init(&replay_slot[i].mutex, NULL);
+		replay_slot[i].last = replay_start;
+	}
+	replay_end = replay_start;
+
+	atexit(replay_print_stats);
+}
+
+#endif
+#endif
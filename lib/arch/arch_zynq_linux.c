@@ -22,13 +22,17 @@
 #ifdef RECONOS_OS_linux
 
 #include "arch.h"
+#include "osif_record.h"
 
 #include "../../linux/driver/include/reconos.h"
+#include "../reconos.h"
 
 #include <stdio.h>
+#include <string.h>
 #include <unistd.h>
 #include <fcntl.h>
 #include <sys/ioctl.h>
+#include <sys/mman.h>
 #include "pthread.h"
 
 #define PROC_CONTROL_DEV "/dev/reconos/proc-control"
@@ -36,6 +40,106 @@
 
 /* == OSIF related functions ============================================ */
 
+#define OSIF_FIFO_RECV_REG        0
+#define OSIF_FIFO_SEND_REG        1
+#define OSIF_FIFO_RECV_STATUS_REG 2
+#define OSIF_FIFO_SEND_STATUS_REG 3
+
+#define OSIF_FIFO_RECV_STATUS_EMPTY_MASK 0x1 << 31
+#define OSIF_FIFO_SEND_STATUS_FULL_MASK  0x1 << 31
+
+#define OSIF_MMAP_MAX_FD          256
+
+// the fifo registers are device memory, order the accesses explicitly
+#ifdef __arm__
+#define osif_mmap_mb() __asm__ __volatile__ ("dmb" : : : "memory")
+#else
+#define osif_mmap_mb() __sync_synchronize()
+#endif
+
+/*
+ * reg         - fifo registers mapped into user space or NULL
+ * poll_limit  - limit set by reconos_osif_set_poll_limit
+ * poll_budget - current number of polls adapted as in the driver
+ */
+struct osif_mmap {
+	volatile uint32_t *reg;
+	unsigned int poll_limit, poll_budget;
+};
+
+// indexed by file descriptor
+static struct osif_mmap osif_mmap[OSIF_MMAP_MAX_FD];
+
+static struct osif_mmap *osif_mmap_get(int fd) {
+	if (fd < 0 || fd >= OSIF_MMAP_MAX_FD || !osif_mmap[fd].reg)
+		return NULL;
+
+	return &osif_mmap[fd];
+}
+
+static void osif_mmap_open(int fd) {
+	void *page;
+	int offset, limit;
+
+	if (fd < 0 || fd >= OSIF_MMAP_MAX_FD)
+		return;
+
+	if (ioctl(fd, RECONOS_OSIF_GET_MMAP_OFFSET, &offset) < 0)
+		return;
+
+	if (ioctl(fd, RECONOS_OSIF_GET_POLL_LIMIT, &limit) < 0)
+		return;
+
+	// the driver refuses if the fifo does not have a page of its own
+	page = mmap(NULL, getpagesize(), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	if (page == MAP_FAILED)
+		return;
+
+	osif_mmap[fd].poll_limit = limit;
+	osif_mmap[fd].poll_budget = limit;
+	osif_mmap[fd].reg = (volatile uint32_t *)((char *)page + offset);
+}
+
+static void osif_mmap_close(int fd) {
+	struct osif_mmap *map = osif_mmap_get(fd);
+	uintptr_t page;
+
+	if (!map)
+		return;
+
+	page = (uintptr_t)map->reg & ~((uintptr_t)getpagesize() - 1);
+	munmap((void *)page, getpagesize());
+
+	map->reg = NULL;
+}
+
+/*
+ * Polls the mapped receive fifo. The budget is adapted to the observed
+ * latency of the hardware thread the same way the driver does it.
+ * Returns 1 if a word was read, 0 otherwise.
+ */
+static int osif_mmap_read(struct osif_mmap *map, uint32_t *data) {
+	unsigned int spin;
+
+	for (spin = 0; spin <= map->poll_budget; spin++) {
+		if (!(map->reg[OSIF_FIFO_RECV_STATUS_REG] & OSIF_FIFO_RECV_STATUS_EMPTY_MASK)) {
+			osif_mmap_mb();
+			*data = map->reg[OSIF_FIFO_RECV_REG];
+			osif_mmap_mb();
+
+			map->poll_budget = (map->poll_budget * 7 + spin * 2) / 8 + 1;
+			if (map->poll_budget > map->poll_limit)
+				map->poll_budget = map->poll_limit;
+			return 1;
+		}
+	}
+
+	map->poll_budget /= 2;
+	if (map->poll_budget < map->poll_limit / 16)
+		map->poll_budget = map->poll_limit / 16;
+	return 0;
+}
+
 int reconos_osif_open(int num) {
 	char dev[25];
 	int fd;
@@ -48,29 +152,120 @@ int reconos_osif_open(int num) {
 	if (fd < 0)
 		panic("[reconos_core] error while opening osif %d\n", num);
 
+	// syscall-free fast path if the driver supports it
+	osif_mmap_open(fd);
+
+	reconos_osif_record_open(fd, num);
+
 	return fd;
 }
 
 uint32_t reconos_osif_read(int fd) {
+	struct osif_mmap *map = osif_mmap_get(fd);
 	uint32_t data;
 	int ret;
 
+	if (map && osif_mmap_read(map, &data))
+		goto out;
+
+	// fifo stays empty, block in the driver until an interrupt occurs
 	ret = read(fd, &data, sizeof(data));
 	if (ret < 0)
 		panic("[reconos-core] error reading from osif\n");
 
+out:
+	reconos_osif_record(fd, OSIF_RECORD_HW2SW, &data, 1);
+
 	return data;
 }
 
 void reconos_osif_write(int fd, uint32_t data) {
+	struct osif_mmap *map = osif_mmap_get(fd);
 	int ret;
 
+	reconos_osif_record(fd, OSIF_RECORD_SW2HW, &data, 1);
+
+	if (map && !(map->reg[OSIF_FIFO_SEND_STATUS_REG] & OSIF_FIFO_SEND_STATUS_FULL_MASK)) {
+		osif_mmap_mb();
+		map->reg[OSIF_FIFO_SEND_REG] = data;
+		osif_mmap_mb();
+		return;
+	}
+
 	ret = write(fd, &data, sizeof(data));
 	if (ret < 0)
 		panic("[reconos-core] error writing to osif\n");
 }
 
+void reconos_osif_read_data(int fd, uint32_t *data, unsigned int count) {
+	int ret;
+	size_t done, len;
+
+	// the driver may return early if interrupted, so continue until done
+	len = count * sizeof(uint32_t);
+	for (done = 0; done < len; done += ret) {
+		ret = read(fd, (char *)data + done, len - done);
+		if (ret < 0)
+			panic("[reconos-core] error reading from osif\n");
+	}
+
+	reconos_osif_record(fd, OSIF_RECORD_HW2SW, data, count);
+}
+
+void reconos_osif_write_data(int fd, uint32_t *data, unsigned int count) {
+	int ret;
+	size_t done, len;
+
+	reconos_osif_record(fd, OSIF_RECORD_SW2HW, data, count);
+
+	len = count * sizeof(uint32_t);
+	for (done = 0; done < len; done += ret) {
+		ret = write(fd, (char *)data + done, len - done);
+		if (ret < 0)
+			panic("[reconos-core] error writing to osif\n");
+	}
+}
+
+void reconos_osif_set_poll_limit(int fd, int limit) {
+	struct osif_mmap *map = osif_mmap_get(fd);
+
+	if (ioctl(fd, RECONOS_OSIF_SET_POLL_LIMIT, &limit) < 0) {
+		whine("[reconos-core] unable to set osif poll limit\n");
+		return;
+	}
+
+	// the fast path polls with the same limit as the driver
+	if (map) {
+		map->poll_limit = limit;
+		map->poll_budget = limit;
+	}
+}
+
+int reconos_osif_set_coalescing(int threshold, int timeout) {
+	struct reconos_osif_coalesce coalesce;
+	int fd, ret;
+
+	// the setting is shared by all OSIFs, so any of them will do
+	fd = open("/dev/reconos/osif-0", O_RDWR);
+	if (fd < 0) {
+		whine("[reconos-core] unable to open osif to set interrupt coalescing\n");
+		return -1;
+	}
+
+	coalesce.threshold = threshold;
+	coalesce.timeout = timeout;
+
+	ret = ioctl(fd, RECONOS_OSIF_SET_INTC_COALESCE, &coalesce);
+	if (ret < 0)
+		whine("[reconos-core] unable to set osif interrupt coalescing\n");
+
+	close(fd);
+
+	return ret < 0 ? -1 : 0;
+}
+
 void reconos_osif_close(int fd) {
+	osif_mmap_close(fd);
 	close(fd);
 }
 
@@ -136,12 +331,84 @@ void reconos_proc_control_hwt_reset(int fd, int num, int reset) {
 		ioctl(fd, RECONOS_PROC_CONTROL_SET_HWT_RESET, &num);
 	else
 		ioctl(fd, RECONOS_PROC_CONTROL_CLEAR_HWT_RESET, &num);
+
+	reconos_osif_record_reset(num, reset);
+}
+
+void reconos_proc_control_tlb_invalidate(int fd, uint32_t addr) {
+	unsigned long page = addr;
+
+	ioctl(fd, RECONOS_PROC_CONTROL_TLB_INVALIDATE, &page);
+}
+
+void reconos_proc_control_tlb_invalidate_all(int fd) {
+	unsigned long page = RECONOS_TLB_INVALIDATE_ALL;
+
+	ioctl(fd, RECONOS_PROC_CONTROL_TLB_INVALIDATE, &page);
+}
+
+void reconos_proc_control_set_memif_qos(int fd, int num, int weight, int priority) {
+	struct reconos_memif_qos qos;
+
+	qos.slot = num;
+	qos.weight = weight;
+	qos.priority = priority;
+
+	ioctl(fd, RECONOS_PROC_CONTROL_SET_MEMIF_QOS, &qos);
+}
+
+uint32_t reconos_proc_control_get_memif_bytes(int fd, int num) {
+	struct reconos_memif_bytes bytes;
+
+	bytes.slot = num;
+	bytes.bytes = 0;
+
+	ioctl(fd, RECONOS_PROC_CONTROL_GET_MEMIF_BYTES, &bytes);
+
+	return bytes.bytes;
+}
+
+void reconos_proc_control_get_hwt_perf(int fd, int num, struct reconos_perf_counters *counters) {
+	struct reconos_hwt_perf perf;
+
+	memset(&perf, 0, sizeof(perf));
+	perf.slot = num;
+
+	if (ioctl(fd, RECONOS_PROC_CONTROL_GET_HWT_PERF, &perf) < 0) {
+		whine("[reconos-core] unable to read performance counters of slot %d\n", num);
+		memset(counters, 0, sizeof(struct reconos_perf_counters));
+		return;
+	}
+
+	counters->cycles = perf.cycles;
+	counters->osif_wait = perf.osif_wait;
+	counters->memif_wait = perf.memif_wait;
+	counters->bytes_read = perf.bytes_read;
+	counters->bytes_written = perf.bytes_written;
 }
 
 void reconos_proc_control_cache_flush(int fd) {
 	ioctl(fd, RECONOS_PROC_CONTROL_CACHE_FLUSH, NULL);
 }
 
+void reconos_proc_control_cache_flush_range(int fd, void *addr, size_t len) {
+	struct reconos_cache_range range;
+
+	range.addr = (unsigned long)addr;
+	range.len = len;
+
+	ioctl(fd, RECONOS_PROC_CONTROL_CACHE_FLUSH_RANGE, &range);
+}
+
+void reconos_proc_control_cache_invalidate_range(int fd, void *addr, size_t len) {
+	struct reconos_cache_range range;
+
+	range.addr = (unsigned long)addr;
+	range.len = len;
+
+	ioctl(fd, RECONOS_PROC_CONTROL_CACHE_INVALIDATE_RANGE, &range);
+}
+
 void reconos_proc_control_close(int fd) {
 	close(fd);
 }
@@ -149,26 +416,17 @@ void reconos_proc_control_close(int fd) {
 
 /* == Reconfiguration related functions ================================= */
 
-int is_configured = 0;
-pthread_mutex_t mutex;
-
-inline void init_xdevcfg() {
-	if (!is_configured) {
-		pthread_mutex_init(&mutex, NULL);
-		is_configured = 1;
-	}
-}
+// serializes programming, slots may be reconfigured concurrently
+static pthread_mutex_t xdevcfg_mutex = PTHREAD_MUTEX_INITIALIZER;
 
 int load_partial_bitstream(uint32_t *bitstream, unsigned int bitstream_length) {
 	int fd;
 	char d = '1';
 
-	init_xdevcfg();
-
 	//printf("... Programming FPGA with partial bitstream\n");
 	//printf("... Bitstream has size of %d bytes and begins with 0x%x 0x%x 0x%x\n", bitstream_length * 4, bitstream[0], bitstream[1], bitstream[2]);
 
-	pthread_mutex_lock(&mutex);
+	pthread_mutex_lock(&xdevcfg_mutex);
 
 	fd = open("/sys/class/xdevcfg/xdevcfg/device/is_partial_bitstream", O_WRONLY);
 	if (!fd) {
@@ -197,7 +455,7 @@ int load_partial_bitstream(uint32_t *bitstream, unsigned int bitstream_length) {
 	} while(d != '1');
 	close(fd);
 
-	pthread_mutex_unlock(&mutex);
+	pthread_mutex_unlock(&xdevcfg_mutex);
 
 	return 0;
 }
@@ -0,0 +1,119 @@
+/*
+ *                                                        ____  _____
+ *                            ________  _________  ____  / __ \/ ___/
+ *                           / ___/ _ \/ ___/ __ \/ __ \/ / / /\__ \
+ *                          / /  /  __/ /__/ /_/ / / / / /_/ /___/ /
+ *                         /_/   \___/\___/\____/_/ /_/\____//____/
+ *
+ * ======================================================================
+ *
+ *   title:        Co-simulation shared memory layout
+ *
+ *   project:      ReconOS
+ *   description:  Layout of the shared memory segment connecting the
+ *                 cosim architecture backend with a GHDL-simulated
+ *                 hardware thread (see tools/cosim). Each slot owns
+ *                 four single producer, single consumer rings which
+ *                 replace the OSIF and MEMIF FIFOs.
+ *
+ * ======================================================================
+ */
+
+#ifndef RECONOS_COSIM_H
+#define RECONOS_COSIM_H
+
+#include <stdint.h>
+
+#define COSIM_SHM_NAME    "/reconos_cosim"
+#define COSIM_SHM_MAGIC   0x52434f53
+#define COSIM_MAX_SLOTS   16
+#define COSIM_FIFO_DEPTH  128
+
+/*
+ * Single producer, single consumer ring. wr is only written by the
+ * producer and rd only by the consumer, both count words modulo 2^32.
+ */
+struct cosim_fifo {
+	volatile uint32_t wr;
+	volatile uint32_t rd;
+	uint32_t data[COSIM_FIFO_DEPTH];
+};
+
+/*
+ * One slot as seen by the simulated hardware thread.
+ *
+ *   sw2hw   - OSIF, runtime to hardware thread
+ *   hw2sw   - OSIF, hardware thread to runtime
+ *   hwt2mem - MEMIF, commands and write data of the hardware thread
+ *   mem2hwt - MEMIF, read data served from host memory
+ *
+ * Each assertion of reset increments reset_seq, so that the simulator
+ * cannot miss short reset pulses. The simulator empties the rings it
+ * consumes (sw2hw, mem2hwt) and acknowledges by copying reset_seq to
+ * reset_ack, the runtime empties the others itself afterwards. attached
+ * is set by the simulator, the runtime does not wait for it otherwise.
+ *
+ * The counters are maintained by the simulator and count clock cycles.
+ */
+struct cosim_slot {
+	struct cosim_fifo sw2hw;
+	struct cosim_fifo hw2sw;
+	struct cosim_fifo hwt2mem;
+	struct cosim_fifo mem2hwt;
+
+	volatile uint32_t reset;
+	volatile uint32_t reset_seq;
+	volatile uint32_t reset_ack;
+	volatile uint32_t attached;
+
+	volatile uint64_t cycles;
+	volatile uint64_t osif_wait_cycles;
+	volatile uint64_t memif_stall_cycles;
+};
+
+/*
+ * magic is set last by the runtime with the process id pid, so that the
+ * simulator can detect a segment left over by a crashed runtime.
+ *
+ * The cache counters are maintained by the runtime, which emulates the
+ * MicroBlaze data cache maintenance by counting the line operations.
+ *
+ *   cache_flushes           - flushes of the entire cache
+ *   cache_lines_flushed     - lines flushed, including entire flushes
+ *   cache_lines_invalidated - lines invalidated without flushing
+ */
+struct cosim_shm {
+	volatile uint32_t magic;
+	int32_t pid;
+	uint32_t num_slots;
+	struct cosim_slot slot[COSIM_MAX_SLOTS];
+
+	volatile uint64_t cache_flushes;
+	volatile uint64_t cache_lines_flushed;
+	volatile uint64_t cache_lines_invalidated;
+};
+
+static inline uint32_t cosim_fifo_fill(struct cosim_fifo *fifo) {
+	return fifo->wr - fifo->rd;
+}
+
+static inline uint32_t cosim_fifo_rem(struct cosim_fifo *fifo) {
+	return COSIM_FIFO_DEPTH - (fifo->wr - fifo->rd);
+}
+
+static inline uint32_t cosim_fifo_peek(struct cosim_fifo *fifo) {
+	return fifo->data[fifo->rd % COSIM_FIFO_DEPTH];
+}
+
+static inline void cosim_fifo_pop(struct cosim_fifo *fifo) {
+	__sync_synchronize();
+	fifo->rd++;
+}
+
+static inline void cosim_fifo_push(struct cosim_fifo *fifo, uint32_t data) {
+	fifo->data[fifo->wr % COSIM_FIFO_DEPTH] = data;
+	__sync_synchronize();
+	fifo->wr++;
+}
+
+#endif /* RECONOS_COSIM_H */
@@ -0,0 +1,174 @@
+/*
+ *                                                        ____  _____
+ *                            ________  _________  ____  / __ \/ ___/
+ *                           / ___/ _ \/ ___/ __ \/ __ \/ / / /\__ \
+ *                          / /  /  __/ /__/ /_/ / / / / /_/ /___/ /
+ *                         /_/   \___/\___/\____/_/ /_/\____//____/
+ *
+ * ======================================================================
+ *
+ *   title:        OSIF recording
+ *
+ *   project:      ReconOS
+ *   description:  Logs every word transferred over the OSIF together
+ *                 with a timestamp into the file named by the
+ *                 environment variable RECONOS_OSIF_RECORD. The
+ *                 recording can be replayed with RECONOS_ARCH=replay.
+ *
+ *                 Consecutive words of the same slot and direction
+ *                 are merged into a single entry as long as they
+ *                 follow its first word within OSIF_RECORD_COALESCE_US.
+ *
+ * ======================================================================
+ */
+
+
+#ifdef RECONOS_OS_linux
+
+#include "arch.h"
+#include "osif_record.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "pthread.h"
+
+#define OSIF_RECORD_MAX_FD  256
+
+// words of the pending entry at most
+#define OSIF_RECORD_PENDING_MAX  256
+
+static pthread_once_t record_once = PTHREAD_ONCE_INIT;
+static pthread_mutex_t record_mutex = PTHREAD_MUTEX_INITIALIZER;
+static FILE *record_file;
+static uint64_t record_last;
+
+// slot numbers indexed by file descriptor
+static int record_slot[OSIF_RECORD_MAX_FD];
+
+/*
+ * Entry collecting consecutive words of the same slot and direction,
+ * written out once a word does not fit anymore.
+ *
+ *   pending      - header of the entry (count 0 if none is pending)
+ *   pending_data - words of the entry
+ */
+static struct osif_record_entry pending;
+static uint32_t pending_data[OSIF_RECORD_PENDING_MAX];
+
+// must be called with the mutex held
+static void record_flush() {
+	if (!pending.count)
+		return;
+
+	fwrite(&pending, sizeof(pending), 1, record_file);
+	fwrite(pending_data, sizeof(uint32_t), pending.count, record_file);
+	pending.count = 0;
+}
+
+static void record_close() {
+	pthread_mutex_lock(&record_mutex);
+	record_flush();
+	fclose(record_file);
+	record_file = NULL;
+	pthread_mutex_unlock(&record_mutex);
+}
+
+static void record_init() {
+	struct osif_record_header header;
+	char *name;
+
+	name = getenv("RECONOS_OSIF_RECORD");
+	if (!name)
+		return;
+
+	record_file = fopen(name, "wb");
+	if (!record_file) {
+		whine("[reconos-core] unable to open osif recording %s\n", name);
+		return;
+	}
+
+	record_last = time_us();
+
+	header.magic = OSIF_RECORD_MAGIC;
+	header.version = OSIF_RECORD_VERSION;
+	header.start_us = record_last;
+	fwrite(&header, sizeof(header), 1, record_file);
+
+	// flushes the buffered entries on exit
+	atexit(record_close);
+}
+
+void reconos_osif_record_open(int fd, int num) {
+	pthread_once(&record_once, record_init);
+
+	if (fd >= 0 && fd < OSIF_RECORD_MAX_FD)
+		record_slot[fd] = num;
+}
+
+static void record_entry(int num, int dir, uint32_t *data, unsigned int count) {
+	struct osif_record_entry entry;
+	uint64_t now;
+
+	pthread_mutex_lock(&record_mutex);
+
+	if (!record_file)
+		goto out;
+
+	now = time_us();
+
+	// the words join the pending entry if they follow its first word
+	// closely enough to keep the timing of the replay
+	if (pending.count && (pending.slot != num || pending.dir != dir
+	                      || now - record_last > OSIF_RECORD_COALESCE_US
+	                      || pending.count + count > OSIF_RECORD_PENDING_MAX))
+		record_flush();
+
+	if (count <= OSIF_RECORD_PENDING_MAX) {
+		if (!pending.count) {
+			pending.delta = now - record_last;
+			pending.slot = num;
+			pending.dir = dir;
+			record_last = now;
+		}
+
+		memcpy(&pending_data[pending.count], data, count * sizeof(uint32_t));
+		pending.count += count;
+		goto out;
+	}
+
+	entry.slot = num;
+	entry.dir = dir;
+	while (count > 0) {
+		entry.delta = now - record_last;
+		entry.count = count > UINT16_MAX ? UINT16_MAX : count;
+
+		fwrite(&entry, sizeof(entry), 1, record_file);
+		fwrite(data, sizeof(uint32_t), entry.count, record_file);
+
+		data += entry.count;
+		count -= entry.count;
+		record_last = now;
+	}
+
+out:
+	pthread_mutex_unlock(&record_mutex);
+}
+
+void reconos_osif_record(int fd, int dir, uint32_t *data, unsigned int count) {
+	if (!record_file || fd < 0 || fd >= OSIF_RECORD_MAX_FD)
+		return;
+
+	record_entry(record_slot[fd], dir, data, count);
+}
+
+void reconos_osif_record_reset(int num, int reset) {
+	uint32_t data = reset;
+
+	if (!record_file)
+		return;
+
+	record_entry(num, OSIF_RECORD_RESET, &data, 1);
+}
+
+#endif
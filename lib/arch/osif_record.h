@@ -0,0 +1,66 @@
+/*
+ *                                                        ____  _____
+ *                            ________  _________  ____  / __ \/ ___/
+ *                           / ___/ _ \/ ___/ __ \/ __ \/ / / /\__ \
+ *                          / /  /  __/ /__/ /_/ / / / / /_/ /___/ /
+ *                         /_/   \___/\___/\____/_/ /_/\____//____/
+ *
+ * ======================================================================
+ *
+ *   title:        OSIF recording - file format
+ *
+ *   project:      ReconOS
+ *   description:  Binary format of OSIF recordings written by the arch
+ *                 layer if RECONOS_OSIF_RECORD is set and read by the
+ *                 replay architecture backend.
+ *
+ *                 The file starts with a header followed by entries,
+ *                 each one consisting of an entry header and count
+ *                 data words. All values are in host byte order.
+ *
+ * ======================================================================
+ */
+
+#ifndef RECONOS_OSIF_RECORD_H
+#define RECONOS_OSIF_RECORD_H
+
+#include <stdint.h>
+
+#define OSIF_RECORD_MAGIC    0x524f5352
+#define OSIF_RECORD_VERSION  1
+
+#define OSIF_RECORD_SW2HW    0
+#define OSIF_RECORD_HW2SW    1
+#define OSIF_RECORD_RESET    2
+
+#define OSIF_RECORD_MAX_SLOTS  32
+
+// words following the first word of an entry by at most this many
+// microseconds are merged into the entry and replayed without a gap
+#define OSIF_RECORD_COALESCE_US  10
+
+/*
+ * start_us - monotonic time the recording started in microseconds
+ */
+struct osif_record_header {
+	uint32_t magic;
+	uint32_t version;
+	uint64_t start_us;
+};
+
+/*
+ * delta - microseconds since the previous entry
+ * slot  - number of the slot
+ * dir   - OSIF_RECORD_SW2HW, OSIF_RECORD_HW2SW or OSIF_RECORD_RESET
+ * count - number of data words following the entry
+ *
+ * Reset entries carry a single word, the new state of the reset signal.
+ */
+struct osif_record_entry {
+	uint32_t delta;
+	uint8_t slot;
+	uint8_t dir;
+	uint16_t count;
+};
+
+#endif /* RECONOS_OSIF_RECORD_H */
@@ -33,17 +33,21 @@
 #include <pthread.h>
 
 #include <stdlib.h>
+#include <string.h>
+#include <time.h>
 #include <sys/types.h>
 
 // define all commands
 
 #define OSIF_CMD_THREAD_GET_INIT_DATA  0x000000A0
-#define OSIF_CMD_THREAD_DELAY          0x000000A1 // ToDo
+#define OSIF_CMD_THREAD_DELAY          0x000000A1
 #define OSIF_CMD_THREAD_EXIT           0x000000A2
-#define OSIF_CMD_THREAD_YIELD          0x000000A3 // ToDo
+#define OSIF_CMD_THREAD_YIELD          0x000000A3
 #define OSIF_CMD_THREAD_RESUME         0x000000A4 // ToDo
-#define OSIF_CMD_THREAD_LOAD_STATE     0x000000A5 // ToDo
-#define OSIF_CMD_THREAD_STORE_STATE    0x000000A6 // ToDo
+#define OSIF_CMD_THREAD_LOAD_STATE     0x000000A5
+#define OSIF_CMD_THREAD_STORE_STATE    0x000000A6
+#define OSIF_CMD_TAGGED_RESULT         0x000000A7
+#define OSIF_CMD_THREAD_GET_ERROR      0x000000A8
 
 #define OSIF_CMD_SEM_POST              0x000000B0
 #define OSIF_CMD_SEM_WAIT              0x000000B1
@@ -63,33 +67,321 @@
 #define OSIF_CMD_MBOX_PUT              0x000000F1
 #define OSIF_CMD_MBOX_TRYGET           0x000000F2 // ToDo
 #define OSIF_CMD_MBOX_TRYPUT           0x000000F3 // ToDo
+#define OSIF_CMD_MBOX_PUT_N            0x000000F4
+#define OSIF_CMD_MBOX_GET_N            0x000000F5
 
 #define OSIF_CMD_MASK                  0x000000FF
 #define OSIF_CMD_YIELD_MASK            0x80000000
 
-inline void resource_check_type(struct reconos_hwt *hwt,
-                                uint32_t handle, uint32_t type) {
-	if (handle >= hwt->cfg->resource_count)
-		panic("[reconos-core] resource out of range: %d\n", handle);
+// batched mbox calls transfer the words in chunks of this size
+#define MBOX_BATCH_SIZE                64
 
-	if (hwt->cfg->resource[handle].type != type)
-		panic("[reconos-core] wrong resource type: %x expected %x\n", hwt->cfg->resource[handle].type, type);
+// tagged calls are completed asynchronously and answered by tag and result
+#define OSIF_CMD_TAGGED_MASK           0x40000000
+#define OSIF_CMD_TAG_MASK              0x00FF0000
+#define OSIF_CMD_TAG_SHIFT             16
+
+// number of tags and thereby the maximum number of outstanding tagged calls
+#define TAGGED_CALLS                   256
+
+// number of workers per hardware thread completing blocking tagged calls
+#define TAGGED_WORKERS                 8
+
+/*
+ * Structure representing a tagged call to complete by a worker
+ *
+ *   cmd  - the command word including the tag
+ *   ptr  - pointer to the resource resolved at the time of the call
+ *   arg0 - first argument besides the handle
+ *   busy - set while a worker executes the call
+ *   next - next call issued later
+ */
+struct hwt_delegate_tagged_call {
+	uint32_t cmd;
+	void *ptr;
+	uint32_t arg0;
+	int busy;
+	struct hwt_delegate_tagged_call *next;
+};
+
+/*
+ * Structure holding the tagged calls of a hardware thread. Calls which
+ * would block are completed by a small pool of workers created on
+ * demand. Calls of the same command on the same resource are completed
+ * in the order of issue: a worker only takes a call if no earlier one
+ * of the same kind is queued or executed, and no such call is completed
+ * directly while earlier ones wait. Completed calls are queued and only
+ * written to the OSIF by the delegate when the hardware thread requests
+ * a result, so that they never interleave with replies to untagged
+ * calls.
+ *
+ *   mutex       - lock protecting the structure
+ *   call_cond   - signaled when a call is queued for the workers
+ *   done_cond   - signaled when a call completed
+ *   call_list   - calls waiting for or executed by a worker, in order
+ *   call_queued - number of calls waiting for a worker
+ *   done_tag    - tags of completed calls
+ *   done_result - results of completed calls
+ *   done_rd/wr  - read and write position of the completion queue
+ *   outstanding - calls issued but whose result was not yet requested
+ *   workers     - number of workers created
+ *   idle        - number of workers waiting for a call
+ *   refs        - references by the delegate and the workers
+ *   exit        - set when the hardware thread exits
+ */
+struct hwt_delegate_tagged {
+	pthread_mutex_t mutex;
+	pthread_cond_t call_cond;
+	pthread_cond_t done_cond;
+
+	struct hwt_delegate_tagged_call *call_list;
+	unsigned int call_queued;
+
+	uint32_t done_tag[TAGGED_CALLS];
+	uint32_t done_result[TAGGED_CALLS];
+	unsigned int done_rd, done_wr;
+
+	unsigned int outstanding;
+	unsigned int workers;
+	unsigned int idle;
+	unsigned int refs;
+	int exit;
+};
+
+/*
+ * Structure representing a pending delay of a hardware thread
+ *
+ *   hwt     - hardware thread which issued the delay
+ *   expires - monotonic time in microseconds the delay expires at
+ *   cmd     - the command word, possibly including a tag
+ *   next    - next delay expiring not earlier
+ */
+struct hwt_delegate_timer {
+	struct reconos_hwt *hwt;
+	uint64_t expires;
+	uint32_t cmd;
+	struct hwt_delegate_timer *next;
+};
+
+/*
+ * Pending delays of all hardware threads, serviced by a single timer
+ * thread so that no delegate has to sleep for a delay.
+ */
+static struct hwt_delegate_timer *timer_list;
+static pthread_mutex_t timer_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t timer_cond;
+static pthread_once_t timer_once = PTHREAD_ONCE_INIT;
+
+/*
+ * Index of each resource type in the resolved resource tables
+ */
+#define RESOURCE_MBOX                  0
+#define RESOURCE_SEM                   1
+#define RESOURCE_MUTEX                 2
+#define RESOURCE_COND                  3
+#define RESOURCE_RQ                    4
+#define RESOURCE_TYPES                 5
+
+// result returned to the hardware thread if a handle is invalid, calls
+// returning data instead report it by OSIF_CMD_THREAD_GET_ERROR
+#define OSIF_RESULT_BAD_HANDLE         0xFFFFFFFF
+
+// result returned to the hardware thread if its state cannot be stored
+#define OSIF_RESULT_NO_MEMORY          0xFFFFFFFE
+
+// errors reported by OSIF_CMD_THREAD_GET_ERROR if a tagged call is
+// refused, since TAGGED_CALLS are outstanding or it is not supported
+#define OSIF_RESULT_NO_TAG             0xFFFFFFFD
+#define OSIF_RESULT_BAD_CALL           0xFFFFFFFC
+
+// maximum length of the state of a hardware thread in 32bit-words
+#define STATE_MAX_LENGTH               (1 << 16)
+
+static pthread_mutex_t resolve_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+/*
+ * Resolves the resource array of the configuration into one table per
+ * resource type, holding NULL for handles of a different type. The
+ * tables are built once per configuration and reused whenever it is
+ * installed again. Must be called with resolve_mutex held.
+ */
+static void **resource_resolve(struct reconos_configuration *cfg) {
+	void **table;
+	size_t i;
+	int type;
+
+	if (cfg->resolved)
+		return cfg->resolved;
+
+	table = calloc(RESOURCE_TYPES * cfg->resource_count + 1, sizeof(void *));
+	if (!table)
+		panic("[reconos-core] failed to allocate memory for resources\n");
+
+	for (i = 0; i < cfg->resource_count; i++) {
+		switch (cfg->resource[i].type) {
+			case RECONOS_RESOURCE_TYPE_MBOX: type = RESOURCE_MBOX; break;
+			case RECONOS_RESOURCE_TYPE_SEM: type = RESOURCE_SEM; break;
+			case RECONOS_RESOURCE_TYPE_MUTEX: type = RESOURCE_MUTEX; break;
+			case RECONOS_RESOURCE_TYPE_COND: type = RESOURCE_COND; break;
+			case RECONOS_RESOURCE_TYPE_RQ: type = RESOURCE_RQ; break;
+			default:
+				whine("[reconos-core] unknown resource type: %x\n", cfg->resource[i].type);
+				continue;
+		}
+
+		table[type * cfg->resource_count + i] = cfg->resource[i].ptr;
+	}
+
+	cfg->resolved = table;
+
+	return table;
+}
+
+/*
+ * Installs the resources of the configuration in the hardware thread.
+ * Must be called whenever the configuration of the hardware thread
+ * changes and with NULL when the hardware thread exits, since the
+ * resolved resources must not be freed while installed.
+ */
+static void resource_install(struct reconos_hwt *hwt,
+                             struct reconos_configuration *cfg) {
+	pthread_mutex_lock(&resolve_mutex);
+
+	if (hwt->res_cfg)
+		hwt->res_cfg->installed--;
+
+	if (cfg) {
+		hwt->res_table = resource_resolve(cfg);
+		hwt->res_count = cfg->resource_count;
+		cfg->installed++;
+	} else {
+		hwt->res_table = NULL;
+		hwt->res_count = 0;
+	}
+	hwt->res_cfg = cfg;
+
+	pthread_mutex_unlock(&resolve_mutex);
+}
+
+int resource_unresolve(struct reconos_configuration *cfg) {
+	int ret = 0;
+
+	pthread_mutex_lock(&resolve_mutex);
+
+	if (cfg->installed) {
+		ret = -1;
+	} else {
+		free(cfg->resolved);
+		cfg->resolved = NULL;
+	}
+
+	pthread_mutex_unlock(&resolve_mutex);
+
+	return ret;
+}
+
+/*
+ * Looks up the resource of the given type.
+ *
+ *   returns the pointer to the resource or NULL if the handle is invalid
+ */
+static inline void *resource_get(struct reconos_hwt *hwt,
+                                 uint32_t handle, int type) {
+	void *ptr;
+
+	if (handle < hwt->res_count && (ptr = hwt->res_table[type * hwt->res_count + handle]))
+		return ptr;
+
+	whine("[reconos-core] invalid resource handle %d on slot %d\n", handle, hwt->slot);
+	hwt->error = OSIF_RESULT_BAD_HANDLE;
+	return NULL;
 }
 
 
 uint32_t hwt_delegate_get_init_data(struct reconos_hwt *hwt) {
-	return (uint32_t) hwt->init_data;
+	return reconos_addr_to_hwt(hwt->init_data);
+}
+
+uint32_t hwt_delegate_get_error(struct reconos_hwt *hwt) {
+	uint32_t error = hwt->error;
+
+	hwt->error = 0;
+
+	return error;
+}
+
+
+uint32_t hwt_delegate_store_state(struct reconos_hwt *hwt) {
+	struct reconos_hwt_state *state = &hwt->saved_state;
+	uint32_t length = reconos_osif_read(hwt->osif);
+	uint32_t *data, discard[MBOX_BATCH_SIZE];
+	unsigned int n;
+
+	if (length > STATE_MAX_LENGTH) {
+		whine("[reconos-core] state of %u words too long on slot %d\n", length, hwt->slot);
+		goto drop;
+	}
+
+	if (length > state->size) {
+		data = realloc(state->data, length * sizeof(uint32_t));
+		if (!data) {
+			whine("[reconos-core] failed to allocate memory for state\n");
+			goto drop;
+		}
+
+		state->data = data;
+		state->size = length;
+	}
+
+	reconos_osif_read_data(hwt->osif, state->data, length);
+	state->length = length;
+	state->cfg = hwt->cfg;
+
+	return 0;
+
+drop:
+	// the words must be read anyway to keep the OSIF in sync
+	while (length > 0) {
+		n = length < MBOX_BATCH_SIZE ? length : MBOX_BATCH_SIZE;
+		reconos_osif_read_data(hwt->osif, discard, n);
+		length -= n;
+	}
+
+	// a previously stored state is outdated now
+	state->length = 0;
+
+	return OSIF_RESULT_NO_MEMORY;
+}
+
+void hwt_delegate_load_state(struct reconos_hwt *hwt) {
+	struct reconos_hwt_state *state = &hwt->saved_state;
+	unsigned int length;
+
+	// another configuration must not pick up the state
+	length = state->cfg == hwt->cfg ? state->length : 0;
+
+	// the state is restored only once and consumed by loading it
+	pthread_mutex_lock(&hwt->osif_lock);
+	reconos_osif_write(hwt->osif, length);
+	reconos_osif_write_data(hwt->osif, state->data, length);
+	reconos_osif_write(hwt->osif, 0);
+	pthread_mutex_unlock(&hwt->osif_lock);
+
+	state->length = 0;
 }
 
 
 uint32_t hwt_delegate_sem_post(struct reconos_hwt *hwt) {
+	void *ptr;
 	uint32_t handle = reconos_osif_read(hwt->osif);
 
 	//printf("RECONOS DELEGATE THREAD %d: RES %d: SEM_POST\n", hwt->slot, handle);
 
-	resource_check_type(hwt, handle, RECONOS_RESOURCE_TYPE_SEM);
+	ptr = resource_get(hwt, handle, RESOURCE_SEM);
+	if (!ptr)
+		return OSIF_RESULT_BAD_HANDLE;
 
-	sem_post(hwt->cfg->resource[handle].ptr);
+	sem_post(ptr);
 
 	//printf("RECONOS DELEGATE THREAD %d: RES %d: SEM_POST DONE\n", hwt->slot, handle);
 
@@ -97,37 +389,46 @@ uint32_t hwt_delegate_sem_post(struct reconos_hwt *hwt) {
 }
 
 uint32_t hwt_delegate_sem_wait(struct reconos_hwt *hwt) {
+	void *ptr;
 	uint32_t handle = reconos_osif_read(hwt->osif);
 
 	//printf("RECONOS DELEGATE THREAD %d: RES %d: SEM_WAIT\n", hwt->slot, handle);
 
-	resource_check_type(hwt, handle, RECONOS_RESOURCE_TYPE_SEM);
+	ptr = resource_get(hwt, handle, RESOURCE_SEM);
+	if (!ptr)
+		return OSIF_RESULT_BAD_HANDLE;
 
 	//printf("RECONOS DELEGATE THREAD %d: RES %d: SEM_WAIT DONE\n", hwt->slot, handle);
 
-	return sem_wait(hwt->cfg->resource[handle].ptr);
+	return sem_wait(ptr);
 }
 
 uint32_t hwt_delegate_mutex_lock(struct reconos_hwt *hwt) {
+	void *ptr;
 	uint32_t handle = reconos_osif_read(hwt->osif);
 
 	//printf("RECONOS DELEGATE THREAD %d: RES %d: MUTEX_LOCK\n", hwt->slot, handle);
 
-	resource_check_type(hwt, handle, RECONOS_RESOURCE_TYPE_MUTEX);
+	ptr = resource_get(hwt, handle, RESOURCE_MUTEX);
+	if (!ptr)
+		return OSIF_RESULT_BAD_HANDLE;
 
 	//printf("RECONOS DELEGATE THREAD %d: RES %d: MUTEX_LOCK DONE\n", hwt->slot, handle);
 
-	return pthread_mutex_lock(hwt->cfg->resource[handle].ptr);
+	return pthread_mutex_lock(ptr);
 }
 
 uint32_t hwt_delegate_mutex_unlock(struct reconos_hwt *hwt) {
+	void *ptr;
 	uint32_t handle = reconos_osif_read(hwt->osif);
 
 	//printf("RECONOS DELEGATE THREAD %d: RES %d: MUTEX_UNLOCK\n", hwt->slot, handle);
 
-	resource_check_type(hwt, handle, RECONOS_RESOURCE_TYPE_MUTEX);
+	ptr = resource_get(hwt, handle, RESOURCE_MUTEX);
+	if (!ptr)
+		return OSIF_RESULT_BAD_HANDLE;
 
-	pthread_mutex_unlock(hwt->cfg->resource[handle].ptr);
+	pthread_mutex_unlock(ptr);
 
 	//printf("RECONOS DELEGATE THREAD %d: RES %d: MUTEX_UNLOCK DONE\n", hwt->slot, handle);
 
@@ -135,23 +436,28 @@ uint32_t hwt_delegate_mutex_unlock(struct reconos_hwt *hwt) {
 }
 
 uint32_t hwt_delegate_mutex_trylock(struct reconos_hwt *hwt) {
+	void *ptr;
 	uint32_t handle = reconos_osif_read(hwt->osif);
 
-	resource_check_type(hwt, handle, RECONOS_RESOURCE_TYPE_MUTEX);
+	ptr = resource_get(hwt, handle, RESOURCE_MUTEX);
+	if (!ptr)
+		return OSIF_RESULT_BAD_HANDLE;
 
-	return pthread_mutex_trylock(hwt->cfg->resource[handle].ptr);
+	return pthread_mutex_trylock(ptr);
 }
 
 uint32_t hwt_delegate_cond_wait(struct reconos_hwt *hwt) {
 #ifndef RECONOS_MINIMAL
+	void *ptr, *ptr2;
 	uint32_t handle = reconos_osif_read(hwt->osif);
 	uint32_t handle2 = reconos_osif_read(hwt->osif);
 
-	resource_check_type(hwt, handle, RECONOS_RESOURCE_TYPE_COND);
-	resource_check_type(hwt, handle2, RECONOS_RESOURCE_TYPE_MUTEX);
+	ptr = resource_get(hwt, handle, RESOURCE_COND);
+	ptr2 = resource_get(hwt, handle2, RESOURCE_MUTEX);
+	if (!ptr || !ptr2)
+		return OSIF_RESULT_BAD_HANDLE;
 
-	return pthread_cond_wait(hwt->cfg->resource[handle].ptr,
-	                         hwt->cfg->resource[handle2].ptr);
+	return pthread_cond_wait(ptr, ptr2);
 #else
 	return 0;
 #endif
@@ -159,11 +465,14 @@ uint32_t hwt_delegate_cond_wait(struct reconos_hwt *hwt) {
 
 uint32_t hwt_delegate_cond_signal(struct reconos_hwt *hwt) {
 #ifndef RECONOS_MINIMAL
+	void *ptr;
 	uint32_t handle = reconos_osif_read(hwt->osif);
 
-	resource_check_type(hwt, handle, RECONOS_RESOURCE_TYPE_COND);
+	ptr = resource_get(hwt, handle, RESOURCE_COND);
+	if (!ptr)
+		return OSIF_RESULT_BAD_HANDLE;
 
-	pthread_cond_signal(hwt->cfg->resource[handle].ptr);
+	pthread_cond_signal(ptr);
 
 	return 0;
 #else
@@ -173,11 +482,14 @@ uint32_t hwt_delegate_cond_signal(struct reconos_hwt *hwt) {
 
 uint32_t hwt_delegate_cond_broadcast(struct reconos_hwt *hwt) {
 #ifndef RECONOS_MINIMAL
+	void *ptr;
 	uint32_t handle = reconos_osif_read(hwt->osif);
 
-	resource_check_type(hwt, handle, RECONOS_RESOURCE_TYPE_COND);
+	ptr = resource_get(hwt, handle, RESOURCE_COND);
+	if (!ptr)
+		return OSIF_RESULT_BAD_HANDLE;
 
-	pthread_cond_broadcast(hwt->cfg->resource[handle].ptr);
+	pthread_cond_broadcast(ptr);
 
 	return 0;
 #else
@@ -185,15 +497,23 @@ uint32_t hwt_delegate_cond_broadcast(struct reconos_hwt *hwt) {
 #endif
 }
 
-uint32_t hwt_delegate_rq_receive(struct reconos_hwt *hwt) {
-	int i;
+void hwt_delegate_rq_receive(struct reconos_hwt *hwt) {
+	void *ptr;
 	ssize_t res;
-	uint32_t handle, arg0, msg_size, *msg;
+	uint32_t handle, arg0, msg_size, *msg, reply[2];
 
 	handle = reconos_osif_read(hwt->osif);
 	arg0 = reconos_osif_read(hwt->osif);
 
-	resource_check_type(hwt, handle, RECONOS_RESOURCE_TYPE_RQ);
+	// size and result if no data is transferred
+	reply[0] = 0;
+	reply[1] = 0;
+
+	ptr = resource_get(hwt, handle, RESOURCE_RQ);
+	if (!ptr) {
+		reply[1] = OSIF_RESULT_BAD_HANDLE;
+		goto reply;
+	}
 
 	msg_size = arg0;
 	msg = malloc(msg_size);
@@ -201,44 +521,53 @@ uint32_t hwt_delegate_rq_receive(struct reconos_hwt *hwt) {
 		panic("rq_receive malloc failed\n");
 
 	// read data from rq
-	res = rq_receive(hwt->cfg->resource[handle].ptr, msg, msg_size);
+	res = rq_receive(ptr, msg, msg_size);
 	if (res <= 0 || res > msg_size) {
 		whine("rq_receive screwed up: %zd\n", res);
-		reconos_osif_write(hwt->osif, 0);
-		goto out;
+		free(msg);
+		goto reply;
 	}
 
 	// write data to HWT
+	pthread_mutex_lock(&hwt->osif_lock);
 	reconos_osif_write(hwt->osif, (uint32_t) res);
-	for (i = 0; i < res / sizeof(uint32_t); i++)
-		reconos_osif_write(hwt->osif, msg[i]);
+	reconos_osif_write_data(hwt->osif, msg, res / sizeof(uint32_t));
+	reconos_osif_write(hwt->osif, 0);
+	pthread_mutex_unlock(&hwt->osif_lock);
 
-out:
 	free(msg);
+	return;
 
-	return 0;
+reply:
+	pthread_mutex_lock(&hwt->osif_lock);
+	reconos_osif_write_data(hwt->osif, reply, 2);
+	pthread_mutex_unlock(&hwt->osif_lock);
 }
 
 uint32_t hwt_delegate_rq_send(struct reconos_hwt *hwt) {
-	int i;
+	void *ptr;
 	uint32_t handle, arg0, msg_size, *msg;
 
 	handle = reconos_osif_read(hwt->osif);
 	arg0 = reconos_osif_read(hwt->osif);
 
-	resource_check_type(hwt, handle, RECONOS_RESOURCE_TYPE_RQ);
-
 	msg_size = arg0;
 	msg = malloc(msg_size);
 	if (!msg)
 		panic("rq_receive malloc failed\n");
 
 	// read data from HWT
-	for (i = 0; i < msg_size / sizeof(uint32_t); i++)
-		msg[i] = reconos_osif_read(hwt->osif);
+	reconos_osif_read_data(hwt->osif, msg, msg_size / sizeof(uint32_t));
+
+	// the data must be read anyway to keep the OSIF in sync
+	ptr = resource_get(hwt, handle, RESOURCE_RQ);
+	if (!ptr) {
+		free(msg);
+		return OSIF_RESULT_BAD_HANDLE;
+	}
 
 	// write data into rq
-	rq_send(hwt->cfg->resource[handle].ptr, msg, msg_size);
+	rq_send(ptr, msg, msg_size);
 
 	free(msg);
 
@@ -246,52 +575,670 @@ uint32_t hwt_delegate_rq_send(struct reconos_hwt *hwt) {
 }
 
 uint32_t hwt_delegate_mbox_get(struct reconos_hwt *hwt) {
+	void *ptr;
 	uint32_t handle = reconos_osif_read(hwt->osif);
 
 	//printf("RECONOS DELEGATE THREAD %d: RES %d: MBOX_GET\n", hwt->slot, handle);
 
-	resource_check_type(hwt, handle, RECONOS_RESOURCE_TYPE_MBOX);
+	// any word is valid data, the error is queried separately
+	ptr = resource_get(hwt, handle, RESOURCE_MBOX);
+	if (!ptr)
+		return 0;
 
 	//printf("RECONOS DELEGATE THREAD %d: RES %d: MBOX_GET DONE: %x\n", hwt->slot, handle, data);
 
-	return mbox_get(hwt->cfg->resource[handle].ptr);
+	return mbox_get(ptr);
 }
 
 uint32_t hwt_delegate_mbox_put(struct reconos_hwt *hwt) {
+	void *ptr;
 	uint32_t handle = reconos_osif_read(hwt->osif);
 	uint32_t arg0 = reconos_osif_read(hwt->osif);
 
 	//printf("RECONOS DELEGATE THREAD %d: RES %d: MBOX_PUT\n", hwt->slot, handle);
 
-	resource_check_type(hwt, handle, RECONOS_RESOURCE_TYPE_MBOX);
+	ptr = resource_get(hwt, handle, RESOURCE_MBOX);
+	if (!ptr)
+		return OSIF_RESULT_BAD_HANDLE;
 
-	mbox_put(hwt->cfg->resource[handle].ptr, arg0);
+	mbox_put(ptr, arg0);
 
 	//printf("RECONOS DELEGATE THREAD %d: RES %d: MBOX_PUT DONE: %x\n", hwt->slot, handle, arg0);
 
 	return 0;
 }
 
-uint32_t hwt_delegate_mbox_tryget(struct reconos_hwt *hwt) {
+void hwt_delegate_mbox_tryget(struct reconos_hwt *hwt) {
+	void *ptr;
 	uint32_t handle = reconos_osif_read(hwt->osif);
-	uint32_t data, ret;
+	uint32_t reply[2];
 
-	resource_check_type(hwt, handle, RECONOS_RESOURCE_TYPE_MBOX);
+	// the data word is followed by the result
+	reply[0] = 0;
 
-	data = 0;
-	ret = mbox_tryget(hwt->cfg->resource[handle].ptr, &data);
-	reconos_osif_write(hwt->osif, data);
+	ptr = resource_get(hwt, handle, RESOURCE_MBOX);
+	if (ptr)
+		reply[1] = mbox_tryget(ptr, &reply[0]);
+	else
+		reply[1] = OSIF_RESULT_BAD_HANDLE;
 
-	return ret;
+	pthread_mutex_lock(&hwt->osif_lock);
+	reconos_osif_write_data(hwt->osif, reply, 2);
+	pthread_mutex_unlock(&hwt->osif_lock);
 }
 
 uint32_t hwt_delegate_mbox_tryput(struct reconos_hwt *hwt) {
+	void *ptr;
 	uint32_t handle = reconos_osif_read(hwt->osif);
 	uint32_t arg0 = reconos_osif_read(hwt->osif);
 
-	resource_check_type(hwt, handle, RECONOS_RESOURCE_TYPE_MBOX);
+	ptr = resource_get(hwt, handle, RESOURCE_MBOX);
+	if (!ptr)
+		return OSIF_RESULT_BAD_HANDLE;
+
+	return mbox_tryput(ptr, arg0);
+}
+
+/*
+ * Queues the result of a completed tagged call until the hardware thread
+ * requests it. Must be called with the mutex of the tagged calls held.
+ */
+static void tagged_complete(struct hwt_delegate_tagged *tagged,
+                            uint32_t cmd, uint32_t result) {
+	tagged->done_tag[tagged->done_wr % TAGGED_CALLS] = (cmd & OSIF_CMD_TAG_MASK) >> OSIF_CMD_TAG_SHIFT;
+	tagged->done_result[tagged->done_wr % TAGGED_CALLS] = result;
+	tagged->done_wr++;
+
+	pthread_cond_signal(&tagged->done_cond);
+}
+
+void *hwt_delegate_timer_thread(void *arg) {
+	struct hwt_delegate_timer *timer;
+	struct reconos_hwt *hwt;
+	struct timespec ts;
+	uint32_t reply = 0;
+
+	pthread_mutex_lock(&timer_mutex);
+
+	while (1) {
+		if (!timer_list) {
+			pthread_cond_wait(&timer_cond, &timer_mutex);
+			continue;
+		}
+
+		timer = timer_list;
+		if (timer->expires > time_us()) {
+			ts.tv_sec = timer->expires / 1000000;
+			ts.tv_nsec = (timer->expires % 1000000) * 1000;
+			pthread_cond_timedwait(&timer_cond, &timer_mutex, &ts);
+			continue;
+		}
+
+		timer_list = timer->next;
+		hwt = timer->hwt;
+
+		if (timer->cmd & OSIF_CMD_TAGGED_MASK) {
+			// queued while holding the timer mutex, so that the timers
+			// of an exiting hardware thread can be cancelled reliably
+			pthread_mutex_lock(&hwt->tagged->mutex);
+			tagged_complete(hwt->tagged, timer->cmd, 0);
+			pthread_mutex_unlock(&hwt->tagged->mutex);
+
+			free(timer);
+			continue;
+		}
+
+		free(timer);
+
+		// the hardware thread waits for the reply of the untagged delay,
+		// so do not block the list while writing it
+		pthread_mutex_unlock(&timer_mutex);
+
+		pthread_mutex_lock(&hwt->osif_lock);
+		reconos_osif_write(hwt->osif, reply);
+		pthread_mutex_unlock(&hwt->osif_lock);
+
+		pthread_mutex_lock(&timer_mutex);
+	}
+
+	return NULL;
+}
+
+static void hwt_delegate_timer_init() {
+	pthread_condattr_t attr;
+	pthread_t thread;
+
+	pthread_condattr_init(&attr);
+	pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+	pthread_cond_init(&timer_cond, &attr);
+	pthread_condattr_destroy(&attr);
+
+	if (pthread_create(&thread, NULL, hwt_delegate_timer_thread, NULL))
+		panic("[reconos-core] failed to create timer thread\n");
+}
+
+/*
+ * Removes all pending delays of the hardware thread.
+ */
+static void hwt_delegate_timer_cancel(struct reconos_hwt *hwt) {
+	struct hwt_delegate_timer *timer, **pos;
+
+	pthread_mutex_lock(&timer_mutex);
+
+	pos = &timer_list;
+	while (*pos) {
+		timer = *pos;
+		if (timer->hwt == hwt) {
+			*pos = timer->next;
+			free(timer);
+		} else {
+			pos = &timer->next;
+		}
+	}
+
+	pthread_mutex_unlock(&timer_mutex);
+}
+
+/*
+ * Passes a delay of the given number of microseconds to the timer thread.
+ */
+static void timer_add(struct reconos_hwt *hwt, uint32_t cmd, uint32_t delay) {
+	struct hwt_delegate_timer *timer, **pos;
+
+	pthread_once(&timer_once, hwt_delegate_timer_init);
+
+	timer = malloc(sizeof(struct hwt_delegate_timer));
+	if (!timer)
+		panic("[reconos-core] failed to allocate memory for timer\n");
+
+	timer->hwt = hwt;
+	timer->expires = time_us() + delay;
+	timer->cmd = cmd;
+
+	pthread_mutex_lock(&timer_mutex);
+
+	pos = &timer_list;
+	while (*pos && (*pos)->expires <= timer->expires)
+		pos = &(*pos)->next;
+	timer->next = *pos;
+	*pos = timer;
+
+	// wake up the timer thread if the delay expires first
+	if (timer_list == timer)
+		pthread_cond_signal(&timer_cond);
+
+	pthread_mutex_unlock(&timer_mutex);
+}
+
+/*
+ * Delays the hardware thread for the number of microseconds read from
+ * the OSIF. Instead of sleeping, the delay is passed to the timer thread
+ * which writes the reply or completes the tagged call on expiration.
+ * Thereby, the delegate remains available for tagged calls issued in the
+ * meantime.
+ */
+void hwt_delegate_thread_delay(struct reconos_hwt *hwt, uint32_t cmd) {
+	timer_add(hwt, cmd, reconos_osif_read(hwt->osif));
+}
+
+uint32_t hwt_delegate_mbox_put_n(struct reconos_hwt *hwt) {
+	void *ptr;
+	uint32_t handle = reconos_osif_read(hwt->osif);
+	uint32_t count = reconos_osif_read(hwt->osif);
+	uint32_t msg[MBOX_BATCH_SIZE];
+	unsigned int n;
+
+	// the words must be read anyway to keep the OSIF in sync
+	ptr = resource_get(hwt, handle, RESOURCE_MBOX);
+
+	while (count > 0) {
+		n = count < MBOX_BATCH_SIZE ? count : MBOX_BATCH_SIZE;
+		reconos_osif_read_data(hwt->osif, msg, n);
+		if (ptr)
+			mbox_put_many(ptr, msg, n);
+		count -= n;
+	}
+
+	return ptr ? 0 : OSIF_RESULT_BAD_HANDLE;
+}
+
+void hwt_delegate_mbox_get_n(struct reconos_hwt *hwt) {
+	void *ptr;
+	uint32_t handle = reconos_osif_read(hwt->osif);
+	uint32_t count = reconos_osif_read(hwt->osif);
+	uint32_t msg[MBOX_BATCH_SIZE], ret;
+	unsigned int n;
+
+	// the words must be written anyway to keep the OSIF in sync
+	ptr = resource_get(hwt, handle, RESOURCE_MBOX);
+	if (!ptr)
+		memset(msg, 0, sizeof(msg));
+
+	// the reply is written in chunks, but must not be interleaved
+	pthread_mutex_lock(&hwt->osif_lock);
+
+	while (count > 0) {
+		n = count < MBOX_BATCH_SIZE ? count : MBOX_BATCH_SIZE;
+		if (ptr)
+			mbox_get_many(ptr, msg, n);
+		reconos_osif_write_data(hwt->osif, msg, n);
+		count -= n;
+	}
+
+	ret = ptr ? 0 : OSIF_RESULT_BAD_HANDLE;
+	reconos_osif_write(hwt->osif, ret);
+
+	pthread_mutex_unlock(&hwt->osif_lock);
+}
+
+static void tagged_put(struct hwt_delegate_tagged *tagged) {
+	int last;
 
-	return mbox_tryput(hwt->cfg->resource[handle].ptr, arg0);
+	pthread_mutex_lock(&tagged->mutex);
+	last = --tagged->refs == 0;
+	pthread_mutex_unlock(&tagged->mutex);
+
+	if (!last)
+		return;
+
+	pthread_cond_destroy(&tagged->call_cond);
+	pthread_cond_destroy(&tagged->done_cond);
+	pthread_mutex_destroy(&tagged->mutex);
+	free(tagged);
+}
+
+static struct hwt_delegate_tagged *tagged_get(struct reconos_hwt *hwt) {
+	struct hwt_delegate_tagged *tagged = hwt->tagged;
+
+	if (tagged)
+		return tagged;
+
+	tagged = calloc(1, sizeof(struct hwt_delegate_tagged));
+	if (!tagged)
+		panic("[reconos-core] failed to allocate memory for tagged calls\n");
+
+	pthread_mutex_init(&tagged->mutex, NULL);
+	pthread_cond_init(&tagged->call_cond, NULL);
+	pthread_cond_init(&tagged->done_cond, NULL);
+	tagged->refs = 1;
+
+	hwt->tagged = tagged;
+
+	return tagged;
+}
+
+/*
+ * Checks if two tagged calls must be completed in the order of issue,
+ * i.e. if they are the same command on the same resource.
+ */
+static inline int tagged_ordered(struct hwt_delegate_tagged_call *a,
+                                 uint32_t cmd, void *ptr) {
+	return a->ptr == ptr && (a->cmd & OSIF_CMD_MASK) == (cmd & OSIF_CMD_MASK);
+}
+
+/*
+ * Checks if a call of the command on the resource is queued or executed.
+ * Must be called with the mutex of the tagged calls held.
+ */
+static int tagged_pending(struct hwt_delegate_tagged *tagged,
+                          uint32_t cmd, void *ptr) {
+	struct hwt_delegate_tagged_call *call;
+
+	for (call = tagged->call_list; call; call = call->next) {
+		if (tagged_ordered(call, cmd, ptr))
+			return 1;
+	}
+
+	return 0;
+}
+
+/*
+ * Finds the first queued call which no earlier call of the same kind
+ * precedes. Must be called with the mutex of the tagged calls held.
+ *
+ *   returns the call or NULL if no call can be executed now
+ */
+static struct hwt_delegate_tagged_call *tagged_next(struct hwt_delegate_tagged *tagged) {
+	struct hwt_delegate_tagged_call *call, *prev;
+
+	for (call = tagged->call_list; call; call = call->next) {
+		if (call->busy)
+			continue;
+
+		for (prev = tagged->call_list; prev != call; prev = prev->next) {
+			if (tagged_ordered(prev, call->cmd, call->ptr))
+				break;
+		}
+
+		if (prev == call)
+			return call;
+	}
+
+	return NULL;
+}
+
+/*
+ * Removes the call from the list and frees it. Must be called with the
+ * mutex of the tagged calls held.
+ */
+static void tagged_remove(struct hwt_delegate_tagged *tagged,
+                          struct hwt_delegate_tagged_call *call) {
+	struct hwt_delegate_tagged_call **pos;
+
+	for (pos = &tagged->call_list; *pos != call; pos = &(*pos)->next);
+	*pos = call->next;
+
+	free(call);
+}
+
+void *hwt_delegate_tagged_worker(void *arg) {
+	struct hwt_delegate_tagged *tagged = arg;
+	struct hwt_delegate_tagged_call *call;
+	uint32_t result;
+
+	pthread_mutex_lock(&tagged->mutex);
+
+	while (!tagged->exit) {
+		call = tagged_next(tagged);
+		if (!call) {
+			tagged->idle++;
+			pthread_cond_wait(&tagged->call_cond, &tagged->mutex);
+			tagged->idle--;
+			continue;
+		}
+
+		// the call stays in the list to hold back later ones of its kind
+		call->busy = 1;
+		tagged->call_queued--;
+
+		pthread_mutex_unlock(&tagged->mutex);
+
+		result = 0;
+		switch (call->cmd & OSIF_CMD_MASK) {
+			case OSIF_CMD_MBOX_GET:
+				result = mbox_get(call->ptr);
+				break;
+			case OSIF_CMD_MBOX_PUT:
+				mbox_put(call->ptr, call->arg0);
+				break;
+			case OSIF_CMD_SEM_WAIT:
+				result = sem_wait(call->ptr);
+				break;
+		}
+
+		pthread_mutex_lock(&tagged->mutex);
+
+		// results of an exited hardware thread are dropped
+		if (!tagged->exit)
+			tagged_complete(tagged, call->cmd, result);
+
+		tagged_remove(tagged, call);
+	}
+
+	pthread_mutex_unlock(&tagged->mutex);
+
+	tagged_put(tagged);
+
+	return NULL;
+}
+
+/*
+ * Tries to complete the tagged call without blocking.
+ *
+ *   returns 1 if the call completed and 0 if it would block
+ */
+static int tagged_try(uint32_t cmd, void *ptr, uint32_t arg0, uint32_t *result) {
+	*result = 0;
+
+	switch (cmd & OSIF_CMD_MASK) {
+		case OSIF_CMD_MBOX_GET:
+			return mbox_tryget(ptr, result);
+		case OSIF_CMD_MBOX_PUT:
+			return mbox_tryput(ptr, arg0);
+		case OSIF_CMD_SEM_WAIT:
+			return sem_trywait(ptr) == 0;
+		case OSIF_CMD_SEM_POST:
+			sem_post(ptr);
+			return 1;
+	}
+
+	return 0;
+}
+
+void hwt_delegate_tagged(struct reconos_hwt *hwt, uint32_t cmd) {
+	struct hwt_delegate_tagged *tagged = tagged_get(hwt);
+	struct hwt_delegate_tagged_call *call, **pos;
+	uint32_t handle, arg0, result;
+	pthread_attr_t attr;
+	pthread_t worker;
+	void *ptr;
+	int type;
+
+	switch (cmd & OSIF_CMD_MASK) {
+		case OSIF_CMD_THREAD_DELAY:
+			type = -1;
+			break;
+		case OSIF_CMD_MBOX_GET:
+		case OSIF_CMD_MBOX_PUT:
+			type = RESOURCE_MBOX;
+			break;
+		case OSIF_CMD_SEM_WAIT:
+		case OSIF_CMD_SEM_POST:
+			type = RESOURCE_SEM;
+			break;
+		default:
+			// the number of arguments is unknown, so nothing can be read
+			whine("[reconos-core] command not supported as tagged call on slot %d: %x\n",
+			      hwt->slot, cmd);
+			hwt->error = OSIF_RESULT_BAD_CALL;
+			return;
+	}
+
+	// the arguments must be read anyway to keep the OSIF in sync
+	handle = 0;
+	arg0 = 0;
+	if (type >= 0)
+		handle = reconos_osif_read(hwt->osif);
+	if (type < 0 || (cmd & OSIF_CMD_MASK) == OSIF_CMD_MBOX_PUT)
+		arg0 = reconos_osif_read(hwt->osif);
+
+	// the tags and the completion queue only hold TAGGED_CALLS calls
+	pthread_mutex_lock(&tagged->mutex);
+	if (tagged->outstanding >= TAGGED_CALLS) {
+		pthread_mutex_unlock(&tagged->mutex);
+
+		whine("[reconos-core] too many tagged calls outstanding on slot %d\n", hwt->slot);
+		hwt->error = OSIF_RESULT_NO_TAG;
+		return;
+	}
+	tagged->outstanding++;
+	pthread_mutex_unlock(&tagged->mutex);
+
+	// delays have no handle and are completed by the timer thread
+	if (type < 0) {
+		timer_add(hwt, cmd, arg0);
+		return;
+	}
+
+	// the result of mbox_get is data, the error is queried separately
+	ptr = resource_get(hwt, handle, type);
+	if (!ptr) {
+		result = (cmd & OSIF_CMD_MASK) == OSIF_CMD_MBOX_GET ? 0 : OSIF_RESULT_BAD_HANDLE;
+
+		pthread_mutex_lock(&tagged->mutex);
+		tagged_complete(tagged, cmd, result);
+		pthread_mutex_unlock(&tagged->mutex);
+		return;
+	}
+
+	// only the delegate adds calls, so none can be queued in between
+	pthread_mutex_lock(&tagged->mutex);
+	if (!tagged_pending(tagged, cmd, ptr)) {
+		pthread_mutex_unlock(&tagged->mutex);
+
+		if (tagged_try(cmd, ptr, arg0, &result)) {
+			pthread_mutex_lock(&tagged->mutex);
+			tagged_complete(tagged, cmd, result);
+			pthread_mutex_unlock(&tagged->mutex);
+			return;
+		}
+
+		pthread_mutex_lock(&tagged->mutex);
+	}
+
+	// the call would block or must wait for earlier ones, so pass it to a
+	// worker to accept further calls of the hardware thread in the meantime
+	call = malloc(sizeof(struct hwt_delegate_tagged_call));
+	if (!call)
+		panic("[reconos-core] failed to allocate memory for tagged call\n");
+
+	call->cmd = cmd;
+	call->ptr = ptr;
+	call->arg0 = arg0;
+	call->busy = 0;
+	call->next = NULL;
+
+	for (pos = &tagged->call_list; *pos; pos = &(*pos)->next);
+	*pos = call;
+	tagged->call_queued++;
+
+	if (tagged->call_queued > tagged->idle
+	    && tagged->workers < TAGGED_WORKERS) {
+		pthread_attr_init(&attr);
+		pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED);
+		if (pthread_create(&worker, &attr, hwt_delegate_tagged_worker, tagged))
+			panic("[reconos-core] failed to create worker for tagged calls\n");
+		pthread_attr_destroy(&attr);
+
+		tagged->workers++;
+		tagged->refs++;
+	} else {
+		pthread_cond_signal(&tagged->call_cond);
+	}
+
+	pthread_mutex_unlock(&tagged->mutex);
+}
+
+/*
+ * Takes the next completed tagged call from the queue, waiting for a call
+ * to complete if necessary.
+ *
+ *   returns 0 if no tagged call is outstanding and 1 otherwise
+ */
+static int tagged_pop(struct hwt_delegate_tagged *tagged, uint32_t *reply) {
+	pthread_mutex_lock(&tagged->mutex);
+
+	if (tagged->outstanding == 0) {
+		pthread_mutex_unlock(&tagged->mutex);
+		return 0;
+	}
+
+	while (tagged->done_rd == tagged->done_wr)
+		pthread_cond_wait(&tagged->done_cond, &tagged->mutex);
+
+	reply[0] = tagged->done_tag[tagged->done_rd % TAGGED_CALLS];
+	reply[1] = tagged->done_result[tagged->done_rd % TAGGED_CALLS];
+	tagged->done_rd++;
+	tagged->outstanding--;
+
+	pthread_mutex_unlock(&tagged->mutex);
+
+	return 1;
+}
+
+/*
+ * Writes tag and result of the next completed tagged call on request of
+ * the hardware thread.
+ */
+void hwt_delegate_tagged_result(struct reconos_hwt *hwt) {
+	uint32_t reply[2];
+
+	if (!hwt->tagged || !tagged_pop(hwt->tagged, reply)) {
+		whine("[reconos-core] no tagged call outstanding on slot %d\n", hwt->slot);
+		hwt->error = OSIF_RESULT_BAD_HANDLE;
+		reply[0] = 0;
+		reply[1] = 0;
+	}
+
+	pthread_mutex_lock(&hwt->osif_lock);
+	reconos_osif_write_data(hwt->osif, reply, 2);
+	pthread_mutex_unlock(&hwt->osif_lock);
+}
+
+/*
+ * Returns the number of tagged calls whose result was not yet requested.
+ */
+static unsigned int tagged_outstanding(struct reconos_hwt *hwt) {
+	unsigned int outstanding;
+
+	if (!hwt->tagged)
+		return 0;
+
+	pthread_mutex_lock(&hwt->tagged->mutex);
+	outstanding = hwt->tagged->outstanding;
+	pthread_mutex_unlock(&hwt->tagged->mutex);
+
+	return outstanding;
+}
+
+/*
+ * Drops all tagged calls of an exiting hardware thread. Pending delays
+ * are cancelled and results of calls still executed by the workers are
+ * discarded. The workers terminate as soon as they are done.
+ */
+static void tagged_release(struct reconos_hwt *hwt) {
+	struct hwt_delegate_tagged *tagged = hwt->tagged;
+	struct hwt_delegate_tagged_call *call, **pos;
+
+	if (!tagged)
+		return;
+
+	hwt_delegate_timer_cancel(hwt);
+
+	pthread_mutex_lock(&tagged->mutex);
+	tagged->exit = 1;
+
+	// calls executed by a worker are removed by the worker
+	pos = &tagged->call_list;
+	while (*pos) {
+		call = *pos;
+		if (call->busy) {
+			pos = &call->next;
+		} else {
+			*pos = call->next;
+			free(call);
+		}
+	}
+	tagged->call_queued = 0;
+
+	pthread_cond_broadcast(&tagged->call_cond);
+	pthread_mutex_unlock(&tagged->mutex);
+
+	hwt->tagged = NULL;
+	tagged_put(tagged);
+}
+
+/*
+ * Loads the configuration into the slot of the hardware thread and
+ * restarts it.
+ */
+static void hwt_delegate_reconfigure(struct reconos_hwt *hwt,
+                                     struct reconos_configuration *cfg) {
+	uint64_t start;
+
+	hwt->state = RECONOS_HWT_STATE_RECONFIGURING;
+	start = time_us();
+
+	hwt->cfg = cfg;
+	resource_install(hwt, cfg);
+	reconos_slot_reset(hwt->slot, 1);
+
+	load_partial_bitstream(hwt->cfg->bitstream, hwt->cfg->bitstream_length);
+
+	hwt->state = RECONOS_HWT_STATE_RUNNING;
+	reconos_slot_reset(hwt->slot, 0);
+
+	vhwt_reconfigured(hwt, start);
 }
 
 void *reconos_hwt_delegate(void *arg) {
@@ -299,6 +1246,8 @@ void *reconos_hwt_delegate(void *arg) {
 	struct reconos_configuration *cfg;
 	uint32_t cmd, ret;
 
+	resource_install(hwt, hwt->cfg);
+
 	reconos_slot_reset(hwt->slot, 1);
 	reconos_slot_reset(hwt->slot, 0);
 	hwt->state = RECONOS_HWT_STATE_RUNNING;
@@ -311,6 +1260,23 @@ void *reconos_hwt_delegate(void *arg) {
 
 		//printf("... Received command %x on hwt %d\n", cmd, hwt->slot);
 
+		// tagged calls are answered asynchronously and do not yield
+		if (cmd & OSIF_CMD_TAGGED_MASK) {
+			hwt_delegate_tagged(hwt, cmd);
+			continue;
+		}
+
+		if ((cmd & OSIF_CMD_MASK) == OSIF_CMD_TAGGED_RESULT) {
+			hwt_delegate_tagged_result(hwt);
+			continue;
+		}
+
+		// delays are answered by the timer thread
+		if ((cmd & OSIF_CMD_MASK) == OSIF_CMD_THREAD_DELAY) {
+			hwt_delegate_thread_delay(hwt, cmd);
+			continue;
+		}
+
 		// perfom OSIF calls that should be executed independent from scheduling
 		switch (cmd & OSIF_CMD_MASK) {
 			case OSIF_CMD_MBOX_PUT:
@@ -319,6 +1285,9 @@ void *reconos_hwt_delegate(void *arg) {
 			case OSIF_CMD_MBOX_TRYPUT:
 				ret = hwt_delegate_mbox_tryput(hwt);
 				break;
+			case OSIF_CMD_MBOX_PUT_N:
+				ret = hwt_delegate_mbox_put_n(hwt);
+				break;
 			case OSIF_CMD_SEM_POST:
 				ret = hwt_delegate_sem_post(hwt);
 				break;
@@ -334,10 +1303,17 @@ void *reconos_hwt_delegate(void *arg) {
 			case OSIF_CMD_RQ_SEND:
 				ret = hwt_delegate_rq_send(hwt);
 				break;
+			case OSIF_CMD_THREAD_STORE_STATE:
+				ret = hwt_delegate_store_state(hwt);
+				break;
+			case OSIF_CMD_THREAD_GET_ERROR:
+				ret = hwt_delegate_get_error(hwt);
+				break;
 		}
 
-		// perfom scheduling
-		if (hwt->is_reconf && cmd & OSIF_CMD_YIELD_MASK ) {
+		// perfom scheduling, but not while tagged calls are outstanding
+		// since their results would be lost by the reconfiguration
+		if (hwt->is_reconf && cmd & OSIF_CMD_YIELD_MASK && !tagged_outstanding(hwt)) {
 			if (!reconos_runtime.scheduler)
 				panic("[reconos_core] No scheduler defined\n");
 
@@ -345,16 +1321,7 @@ void *reconos_hwt_delegate(void *arg) {
 			if (cfg) {
 				//printf("... Performing scheduling, loading configuration '%s' into slot %d\n", cfg->name, hwt->slot);
 
-				hwt->state = RECONOS_HWT_STATE_RECONFIGURING;
-
-				hwt->cfg = cfg;
-				reconos_slot_reset(hwt->slot, 1);
-
-				load_partial_bitstream(hwt->cfg->bitstream, hwt->cfg->bitstream_length);
-				
-				hwt->state = RECONOS_HWT_STATE_RUNNING;
-				reconos_slot_reset(hwt->slot, 0);
-
+				hwt_delegate_reconfigure(hwt, cfg);
 				continue;
 			}
 		}
@@ -365,8 +1332,11 @@ void *reconos_hwt_delegate(void *arg) {
 				ret = hwt_delegate_mbox_get(hwt);
 				break;
 			case OSIF_CMD_MBOX_TRYGET:
-				ret = hwt_delegate_mbox_tryget(hwt);
-				break;
+				hwt_delegate_mbox_tryget(hwt);
+				continue;
+			case OSIF_CMD_MBOX_GET_N:
+				hwt_delegate_mbox_get_n(hwt);
+				continue;
 			case OSIF_CMD_SEM_WAIT:
 				ret = hwt_delegate_sem_wait(hwt);
 				break;	
@@ -380,18 +1350,37 @@ void *reconos_hwt_delegate(void *arg) {
 				ret = hwt_delegate_cond_wait(hwt);
 				break;
 			case OSIF_CMD_RQ_RECEIVE:
-				ret = hwt_delegate_rq_receive(hwt);
-				break;
+				hwt_delegate_rq_receive(hwt);
+				continue;
 			case OSIF_CMD_THREAD_GET_INIT_DATA:
 				ret = hwt_delegate_get_init_data(hwt);
 				break;
+			case OSIF_CMD_THREAD_LOAD_STATE:
+				hwt_delegate_load_state(hwt);
+				continue;
+			case OSIF_CMD_THREAD_YIELD:
+				// not rescheduled, so simply continue
+				ret = 0;
+				break;
 			case OSIF_CMD_THREAD_EXIT:
+				tagged_release(hwt);
+
+				// the slot of a virtual thread is passed on to the next one
+				if (hwt->vhwt && (cfg = vhwt_exited(hwt))) {
+					hwt->error = 0;
+					hwt_delegate_reconfigure(hwt, cfg);
+					continue;
+				}
+
+				resource_install(hwt, NULL);
 				reconos_slot_reset(hwt->slot, 1);
 				return NULL;
 				break;
 		}
 
+		pthread_mutex_lock(&hwt->osif_lock);
 		reconos_osif_write(hwt->osif, ret);
+		pthread_mutex_unlock(&hwt->osif_lock);
 	}
 
 return NULL;
@@ -11,6 +11,37 @@
 #include "mbox.h"
 #include "../utils.h"
 
+#include <sched.h>
+
+#ifdef RECONOS_OS_linux
+#include <poll.h>
+#include <unistd.h>
+#include <sys/eventfd.h>
+#endif
+
+/*
+ * Keeps the eventfd in line with the number of messages. It must be
+ * incremented before posting sem_read, so that a reader always finds
+ * it incremented.
+ */
+static inline void mbox_event_add(struct mbox *mb, uint64_t count)
+{
+#ifdef RECONOS_OS_linux
+	if (mb->event_fd >= 0)
+		write(mb->event_fd, &count, sizeof(count));
+#endif
+}
+
+static inline void mbox_event_sub(struct mbox *mb)
+{
+#ifdef RECONOS_OS_linux
+	uint64_t count;
+
+	if (mb->event_fd >= 0)
+		read(mb->event_fd, &count, sizeof(count));
+#endif
+}
+
 int mbox_init(struct mbox *mb, size_t size)
 {
 	int ret;
@@ -18,6 +49,7 @@ int mbox_init(struct mbox *mb, size_t size)
 	mb->read_idx = 0;
 	mb->write_idx = 0;
 	mb->size = size;
+	mb->event_fd = -1;
 
 	ret = sem_init(&mb->sem_read, 0, 0);
 	if (ret)
@@ -45,6 +77,11 @@ void mbox_destroy(struct mbox *mb)
 {
 	free(mb->messages);
 
+#ifdef RECONOS_OS_linux
+	if (mb->event_fd >= 0)
+		close(mb->event_fd);
+#endif
+
 	sem_destroy(&mb->sem_write);
 	sem_destroy(&mb->sem_read);
 
@@ -60,6 +97,7 @@ void mbox_put(struct mbox *mb, uint32_t msg)
 	mb->messages[mb->write_idx] = msg;
 	mb->write_idx = (mb->write_idx + 1)  % mb->size;
 
+	mbox_event_add(mb, 1);
 	sem_post(&mb->sem_read);
 	pthread_mutex_unlock(&mb->mutex_write);
 }
@@ -73,6 +111,7 @@ uint32_t mbox_get(struct mbox *mb)
 
 	msg = mb->messages[mb->read_idx];
 	mb->read_idx = (mb->read_idx + 1) % mb->size;
+	mbox_event_sub(mb);
 
 	sem_post(&mb->sem_write);
 	pthread_mutex_unlock(&mb->mutex_read);
@@ -96,6 +135,7 @@ int mbox_tryget(struct mbox *mb, uint32_t *msg)
 
 		*msg = mb->messages[mb->read_idx];
 		mb->read_idx = (mb->read_idx + 1) % mb->size;
+		mbox_event_sub(mb);
 
 		sem_post(&mb->sem_write);
 	}
@@ -122,6 +162,7 @@ int mbox_tryput(struct mbox * mb, uint32_t msg)
 		mb->messages[mb->write_idx] = msg;
 		mb->write_idx = (mb->write_idx + 1)  % mb->size;
 
+		mbox_event_add(mb, 1);
 		sem_post(&mb->sem_read);
 	}
 
@@ -129,3 +170,120 @@ int mbox_tryput(struct mbox * mb, uint32_t msg)
 
 	return success;
 }
+
+void mbox_put_many(struct mbox *mb, const uint32_t *msg, size_t count)
+{
+	size_t i, n;
+
+	pthread_mutex_lock(&mb->mutex_write);
+
+	i = 0;
+	while (i < count) {
+		// wait for one free slot and take all others available
+		sem_wait(&mb->sem_write);
+		n = 1;
+		while (i + n < count && sem_trywait(&mb->sem_write) == 0)
+			n++;
+
+		mbox_event_add(mb, n);
+		for (; n > 0; n--, i++) {
+			mb->messages[mb->write_idx] = msg[i];
+			mb->write_idx = (mb->write_idx + 1) % mb->size;
+
+			sem_post(&mb->sem_read);
+		}
+	}
+
+	pthread_mutex_unlock(&mb->mutex_write);
+}
+
+void mbox_get_many(struct mbox *mb, uint32_t *msg, size_t count)
+{
+	size_t i, n;
+
+	pthread_mutex_lock(&mb->mutex_read);
+
+	i = 0;
+	while (i < count) {
+		// wait for one message and take all others available
+		sem_wait(&mb->sem_read);
+		n = 1;
+		while (i + n < count && sem_trywait(&mb->sem_read) == 0)
+			n++;
+
+		for (; n > 0; n--, i++) {
+			msg[i] = mb->messages[mb->read_idx];
+			mb->read_idx = (mb->read_idx + 1) % mb->size;
+			mbox_event_sub(mb);
+
+			sem_post(&mb->sem_write);
+		}
+	}
+
+	pthread_mutex_unlock(&mb->mutex_read);
+}
+
+int mbox_get_eventfd(struct mbox *mb)
+{
+#ifdef RECONOS_OS_linux
+	int fill;
+
+	if (mb->event_fd < 0) {
+		sem_getvalue(&mb->sem_read, &fill);
+		mb->event_fd = eventfd(fill, EFD_NONBLOCK | EFD_SEMAPHORE);
+	}
+
+	return mb->event_fd;
+#else
+	return -1;
+#endif
+}
+
+int mbox_select(struct mbox **mb, size_t count)
+{
+#ifdef RECONOS_OS_linux
+	struct pollfd *fds;
+	size_t i;
+	int ret = -1;
+
+	fds = malloc(count * sizeof(struct pollfd));
+	if (!fds)
+		return -1;
+
+	for (i = 0; i < count; i++) {
+		fds[i].fd = mbox_get_eventfd(mb[i]);
+		fds[i].events = POLLIN;
+		if (fds[i].fd < 0)
+			goto out;
+	}
+
+	while (poll(fds, count, -1) < 0) {
+		if (errno != EINTR)
+			goto out;
+	}
+
+	for (i = 0; i < count; i++) {
+		if (fds[i].revents & POLLIN) {
+			ret = i;
+			break;
+		}
+	}
+
+out:
+	free(fds);
+	return ret;
+#else
+	size_t i;
+	int fill;
+
+	while (1) {
+		for (i = 0; i < count; i++) {
+			sem_getvalue(&mb[i]->sem_read, &fill);
+			if (fill > 0)
+				return i;
+		}
+
+		sched_yield();
+	}
+#endif
+}
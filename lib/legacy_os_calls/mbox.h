@@ -22,6 +22,7 @@ struct mbox {
 	off_t read_idx;
 	off_t write_idx;
 	size_t size;
+	int event_fd;
 };
 
 /*
@@ -79,4 +80,52 @@ extern int mbox_tryget(struct mbox *mb, uint32_t *msg);
  */
 extern int mbox_tryput(struct mbox *mb, uint32_t msg);
 
+/*
+ * Puts several words into the mbox and blocks until all are stored.
+ * The words are stored at once as far as space is available, so that
+ * the mbox is locked only once for the whole batch.
+ *
+ *   mb    - pointer to the mbox
+ *   msg   - pointer to the messages to put into the mbox
+ *   count - number of messages
+ */
+extern void mbox_put_many(struct mbox *mb, const uint32_t *msg, size_t count);
+
+/*
+ * Gets several words out of the mbox and blocks until all are read.
+ * The words are read at once as far as available, so that the mbox
+ * is locked only once for the whole batch.
+ *
+ *   mb    - pointer to the mbox
+ *   msg   - pointer to store the messages in
+ *   count - number of messages
+ */
+extern void mbox_get_many(struct mbox *mb, uint32_t *msg, size_t count);
+
+/*
+ * Returns a file descriptor which is readable as long as messages are
+ * available in the mbox and can be used with poll, select or epoll. Do
+ * not read from the file descriptor, it is maintained by the mbox.
+ * The file descriptor is created on the first call, which must happen
+ * before the mbox is used concurrently. Keeping it up to date costs an
+ * additional system call per message.
+ *
+ *   mb - pointer to the mbox
+ *
+ *   returns the file descriptor or -1 if not supported
+ */
+extern int mbox_get_eventfd(struct mbox *mb);
+
+/*
+ * Waits until at least one of several mboxes contains a message. Only
+ * readiness is reported, so a following mbox_get might still block if
+ * other threads consume messages from the same mbox.
+ *
+ *   mb    - array of pointers to the mboxes
+ *   count - number of mboxes in the array
+ *
+ *   returns the index of a mbox containing a message or -1 on error
+ */
+extern int mbox_select(struct mbox **mb, size_t count);
+
 #endif /* MBOX_H */
@@ -22,8 +22,16 @@ void rq_close(rqueue *rq)
 	mbox_destroy((struct mbox *) rq);
 }
 
+/*
+ * The pointer to the message is passed through the mbox in as many words
+ * as needed, which are put and got at once to not interleave.
+ */
+#define RQ_PTR_WORDS (sizeof(uintptr_t) / sizeof(uint32_t))
+
 void rq_send(rqueue *rq, uint32_t *msg, size_t size)
 {
+	uint32_t ptr[RQ_PTR_WORDS];
+
 	/* XXX: Can we also avoid allocation + copy?! ---DB */
 	uint32_t *clone = malloc((size + 1) * sizeof(uint32_t));
 	if (!clone)
@@ -32,15 +40,18 @@ void rq_send(rqueue *rq, uint32_t *msg, size_t size)
 	clone[0] = (uint32_t) size;
 	__builtin_memcpy(&clone[1], msg, size);
 
-	mbox_put((struct mbox *) rq, (uint32_t) clone);
+	__builtin_memcpy(ptr, &clone, sizeof(clone));
+	mbox_put_many((struct mbox *) rq, ptr, RQ_PTR_WORDS);
 }
 
 ssize_t rq_receive(rqueue *rq, uint32_t *msg, size_t size)
 {
+	uint32_t ptr[RQ_PTR_WORDS];
 	uint32_t *clone;
 	ssize_t __size;
 
-	clone = (uint32_t *) mbox_get((struct mbox *) rq);
+	mbox_get_many((struct mbox *) rq, ptr, RQ_PTR_WORDS);
+	__builtin_memcpy(&clone, ptr, sizeof(clone));
 	__size = clone[0];
 
 	if (__size == 0 || __size > size)
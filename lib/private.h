@@ -21,6 +21,7 @@
 #define RECONOS_PRIVATE_H
 
 #include <pthread.h>
+#include <stdint.h>
 
 struct proc_control {
 	pthread_t page_fault_handler;
@@ -28,11 +29,63 @@ struct proc_control {
 	int page_faults;
 };
 
+struct vhwt_control {
+	pthread_mutex_t mutex;
+	unsigned int quantum;
+	struct reconos_vhwt *ready;
+};
+
+// maximum number of address windows
+#define RECONOS_ADDR_WINDOWS 8
+
+/*
+ * Structure representing an address window mapping host memory into the
+ * 32bit address space of the hardware threads
+ */
+struct addr_window {
+	uintptr_t host_addr;
+	uint32_t hwt_addr;
+	size_t size;
+};
+
 struct reconos_runtime {
 	struct proc_control proc_control;
+	struct addr_window addr_window[RECONOS_ADDR_WINDOWS];
+	int addr_window_count;
+	struct vhwt_control vhwt_control;
 	struct reconos_configuration* (*scheduler)(struct reconos_hwt *hwt);
+	struct reconos_delegate_attr delegate_attr;
 };
 
 extern struct reconos_runtime reconos_runtime;
 
+/*
+ * Hands the slot of an exited virtual hardware thread to the next ready
+ * virtual thread able to run in it.
+ *
+ *   hwt - pointer to the hardware thread the virtual thread exited in
+ *
+ *   returns the configuration to load or NULL if no virtual thread is ready
+ */
+struct reconos_configuration *vhwt_exited(struct reconos_hwt *hwt);
+
+/*
+ * Accounts the reconfiguration of a slot to the virtual hardware thread
+ * now running in it.
+ *
+ *   hwt   - pointer to the reconfigured hardware thread
+ *   start - time the reconfiguration started in microseconds
+ */
+void vhwt_reconfigured(struct reconos_hwt *hwt, uint64_t start);
+
+/*
+ * Drops the resources resolved for the configuration, so that they are
+ * resolved again when installed the next time.
+ *
+ *   cfg - pointer to the configuration
+ *
+ *   returns 0 on success or -1 if the resources are installed
+ */
+int resource_unresolve(struct reconos_configuration *cfg);
+
 #endif /* RECONOS_PRIVATE_H */
@@ -20,6 +20,10 @@
  * ======================================================================
  */
 
+#ifdef RECONOS_OS_linux
+#define _GNU_SOURCE
+#endif
+
 #include "reconos.h"
 
 #include "private.h"
@@ -28,7 +32,12 @@
 #include "arch/arch.h"
 
 #include <unistd.h>
+#include <string.h>
 #include <signal.h>
+#include <semaphore.h>
+#include <sched.h>
+#include <errno.h>
+#include <limits.h>
 
 struct reconos_runtime reconos_runtime;
 
@@ -45,13 +54,24 @@ void reconos_configuration_init(struct reconos_configuration *cfg, char *name, i
 	cfg->slot = slot;
 
 	cfg->name = name;
+
+	cfg->resolved = NULL;
+	cfg->installed = 0;
 }
 
-void reconos_configuration_setresources(struct reconos_configuration *cfg,
-                                        struct reconos_resource *resource,
-                                        size_t resource_count) {
+int reconos_configuration_setresources(struct reconos_configuration *cfg,
+                                       struct reconos_resource *resource,
+                                       size_t resource_count) {
+	// resources are resolved again when installed the next time
+	if (resource_unresolve(cfg) < 0) {
+		whine("[reconos-core] configuration %s is in use\n", cfg->name);
+		return -1;
+	}
+
 	cfg->resource = resource;
 	cfg->resource_count = resource_count;
+
+	return 0;
 }
 
 void reconos_configuration_setbitstream(struct reconos_configuration *cfg,
@@ -89,6 +109,109 @@ void reconos_configuration_loadbitstream(struct reconos_configuration *cfg,
 	fclose(file);
 }
 
+/* == Delegate attributes =============================================== */
+
+// stack size of pinned delegates, which only need little stack
+#define DELEGATE_STACK_SIZE (64 * 1024)
+
+void reconos_delegate_attr_init(struct reconos_delegate_attr *attr) {
+	attr->cpumask = RECONOS_DELEGATE_CPUMASK_ANY;
+	attr->priority = RECONOS_DELEGATE_PRIORITY_DEFAULT;
+	attr->stack_size = RECONOS_DELEGATE_STACK_SIZE_DEFAULT;
+}
+
+void reconos_set_delegate_attr(struct reconos_delegate_attr *attr) {
+	reconos_runtime.delegate_attr = *attr;
+}
+
+unsigned long reconos_delegate_pin_away(unsigned long compute_cpumask) {
+	unsigned long all, mask;
+	long cpus;
+
+	cpus = sysconf(_SC_NPROCESSORS_ONLN);
+	if (cpus < 1)
+		cpus = 1;
+	if (cpus >= (long)sizeof(unsigned long) * 8)
+		all = ~0UL;
+	else
+		all = (1UL << cpus) - 1;
+
+	mask = all & ~compute_cpumask;
+	if (!mask)
+		mask = 1UL << (cpus - 1);
+
+	reconos_runtime.delegate_attr.cpumask = mask;
+	reconos_runtime.delegate_attr.stack_size = DELEGATE_STACK_SIZE;
+
+	return mask;
+}
+
+#ifdef RECONOS_OS_linux
+// converts the CPU mask, where RECONOS_DELEGATE_CPUMASK_ANY allows all CPUs
+static void delegate_cpuset(unsigned long cpumask, cpu_set_t *cpuset) {
+	unsigned int cpu;
+
+	CPU_ZERO(cpuset);
+
+	if (cpumask == RECONOS_DELEGATE_CPUMASK_ANY) {
+		for (cpu = 0; cpu < CPU_SETSIZE; cpu++)
+			CPU_SET(cpu, cpuset);
+		return;
+	}
+
+	for (cpu = 0; cpu < sizeof(unsigned long) * 8; cpu++) {
+		if (cpumask & (1UL << cpu))
+			CPU_SET(cpu, cpuset);
+	}
+}
+#endif
+
+/*
+ * Creates the delegate thread of the hardware thread applying its
+ * delegate attributes. Falls back to the default scheduling policy if
+ * the process is not allowed to use SCHED_FIFO.
+ */
+static int hwt_create_thread(struct reconos_hwt *hwt,
+                             void *(*start)(void *), void *arg) {
+	struct reconos_delegate_attr *attr = &reconos_runtime.delegate_attr;
+	struct sched_param param;
+	pthread_attr_t pattr;
+	int ret;
+
+	pthread_attr_init(&pattr);
+
+	if (attr->stack_size && pthread_attr_setstacksize(&pattr, attr->stack_size))
+		whine("[reconos-core] invalid delegate stack size %zu\n", attr->stack_size);
+
+#ifdef RECONOS_OS_linux
+	if (attr->cpumask != RECONOS_DELEGATE_CPUMASK_ANY) {
+		cpu_set_t cpuset;
+
+		delegate_cpuset(attr->cpumask, &cpuset);
+		pthread_attr_setaffinity_np(&pattr, sizeof(cpuset), &cpuset);
+	}
+#endif
+
+	if (attr->priority != RECONOS_DELEGATE_PRIORITY_DEFAULT) {
+		param.sched_priority = attr->priority;
+		pthread_attr_setinheritsched(&pattr, PTHREAD_EXPLICIT_SCHED);
+		pthread_attr_setschedpolicy(&pattr, SCHED_FIFO);
+		pthread_attr_setschedparam(&pattr, &param);
+	}
+
+	ret = pthread_create(&hwt->delegate, &pattr, start, arg);
+	if (ret == EPERM && attr->priority != RECONOS_DELEGATE_PRIORITY_DEFAULT) {
+		whine("[reconos-core] not allowed to use SCHED_FIFO for delegate\n");
+		pthread_attr_setinheritsched(&pattr, PTHREAD_INHERIT_SCHED);
+		ret = pthread_create(&hwt->delegate, &pattr, start, arg);
+	}
+
+	pthread_attr_destroy(&pattr);
+
+	return ret;
+}
+
+
 /* == HWT functions ===================================================== */
 
 void reconos_hwt_setresources(struct reconos_hwt *hwt,
@@ -114,44 +237,111 @@ void reconos_hwt_setinitdata(struct reconos_hwt *hwt,
 	hwt->init_data = init_data;
 }
 
-void hwt_create_delegate(struct reconos_hwt *hwt,
-                                 void * arg) {
-	// open osif
+void reconos_hwt_setdelegateattr(struct reconos_hwt *hwt,
+                                 struct reconos_delegate_attr *attr) {
+	struct sched_param param;
+
+#ifdef RECONOS_OS_linux
+	cpu_set_t cpuset;
+
+	delegate_cpuset(attr->cpumask, &cpuset);
+	if (pthread_setaffinity_np(hwt->delegate, sizeof(cpuset), &cpuset))
+		whine("[reconos-core] failed to set affinity of delegate\n");
+#endif
+
+	if (attr->priority != RECONOS_DELEGATE_PRIORITY_DEFAULT) {
+		param.sched_priority = attr->priority;
+		if (pthread_setschedparam(hwt->delegate, SCHED_FIFO, &param))
+			whine("[reconos-core] not allowed to use SCHED_FIFO for delegate\n");
+	} else {
+		param.sched_priority = 0;
+		if (pthread_setschedparam(hwt->delegate, SCHED_OTHER, &param))
+			whine("[reconos-core] failed to set scheduling policy of delegate\n");
+	}
+}
+
+void reconos_hwt_setpolling(struct reconos_hwt *hwt, int limit) {
+	reconos_osif_set_poll_limit(hwt->osif, limit);
+}
+
+void reconos_hwt_perf(struct reconos_hwt *hwt, struct reconos_perf_counters *counters) {
+	reconos_proc_control_get_hwt_perf(reconos_runtime.proc_control.fd, hwt->slot, counters);
+}
+
+/*
+ * Opens the OSIF of the hardware thread and initializes the state used
+ * by its delegate.
+ */
+static void hwt_open(struct reconos_hwt *hwt) {
+	uint64_t t;
+
+	t = time_us();
 	hwt->osif = reconos_osif_open(hwt->slot);
 	if (hwt->osif < 0)
 		panic("[reconos-core] failed to open osif\n");
+	hwt->t_open = time_us() - t;
+
+	pthread_mutex_init(&hwt->osif_lock, NULL);
+	hwt->tagged = NULL;
+	hwt->res_cfg = NULL;
+	hwt->error = 0;
+	memset(&hwt->saved_state, 0, sizeof(struct reconos_hwt_state));
+}
+
+void hwt_create_delegate(struct reconos_hwt *hwt,
+                                 void * arg) {
+	hwt_open(hwt);
+	hwt->t_ready = time_us();
 
 	// create delegate thread
-	pthread_create(&hwt->delegate, NULL,
-	               reconos_hwt_delegate, hwt);
+	if (hwt_create_thread(hwt, reconos_hwt_delegate, hwt))
+		panic("[reconos-core] failed to create delegate\n");
 }
 
 void reconos_hwt_create(struct reconos_hwt *hwt,
                         int slot, void *arg) {
+	hwt->t_start = time_us();
+	hwt->t_program = 0;
+
 	hwt->is_reconf = 0;
 
 	hwt->slot = slot;
 
+	hwt->vhwt = NULL;
+
 	hwt->state = RECONOS_HWT_STATE_IDLE;
 
 	hwt_create_delegate(hwt, arg);
 }
 
-void reconos_hwt_create_reconf(struct reconos_hwt *hwt,
-                               int slot,
-                               struct reconos_configuration *cfg,
-                               void *arg) {
+/*
+ * Creates a reconfigurable hardware thread, which might run the given
+ * virtual hardware thread from the beginning.
+ */
+static void hwt_create_reconf(struct reconos_hwt *hwt,
+                              int slot,
+                              struct reconos_configuration *cfg,
+                              struct reconos_vhwt *vhwt,
+                              void *arg) {
 	//printf("... Creating reconfigurable HWT on slot %d with configuration %s\n", slot, cfg->name);
 
+	uint64_t t;
+
+	hwt->t_start = time_us();
+
 	hwt->is_reconf = 1;
 
 	hwt->slot = slot;
 
 	hwt->cfg = cfg;
 
+	hwt->vhwt = vhwt;
+
+	t = time_us();
 	reconos_slot_reset(hwt->slot, 1);
 	load_partial_bitstream(hwt->cfg->bitstream, hwt->cfg->bitstream_length);
 	reconos_slot_reset(hwt->slot, 0);
+	hwt->t_program = time_us() - t;
 
 	//printf("Hardware thread programmed into the slot and now creating delegate thread\n");
 
@@ -160,6 +350,356 @@ void reconos_hwt_create_reconf(struct reconos_hwt *hwt,
 	hwt_create_delegate(hwt, arg);
 }
 
+void reconos_hwt_create_reconf(struct reconos_hwt *hwt,
+                               int slot,
+                               struct reconos_configuration *cfg,
+                               void *arg) {
+	hwt_create_reconf(hwt, slot, cfg, NULL, arg);
+}
+
+/*
+ * Structure passed to the startup threads of reconos_hwt_create_many
+ *
+ *   hwt    - hardware thread to start up
+ *   opened - semaphore posted when the OSIF is opened
+ */
+struct hwt_startup {
+	struct reconos_hwt *hwt;
+	sem_t *opened;
+};
+
+static void *hwt_startup(void *arg) {
+	struct hwt_startup *startup = arg;
+	struct reconos_hwt *hwt = startup->hwt;
+	uint64_t t;
+
+	hwt_open(hwt);
+
+	sem_post(startup->opened);
+	free(startup);
+
+	// programming is moved out of the creator, but not deferred until the
+	// first task, since an unprogrammed slot cannot issue its first OSIF
+	// command. The slots are still programmed one after another, since
+	// they share the configuration port.
+	if (hwt->is_reconf) {
+		t = time_us();
+		reconos_slot_reset(hwt->slot, 1);
+		load_partial_bitstream(hwt->cfg->bitstream, hwt->cfg->bitstream_length);
+		hwt->t_program = time_us() - t;
+	}
+
+	hwt->t_ready = time_us();
+
+	// continue as the delegate of the hardware thread
+	return reconos_hwt_delegate(hwt);
+}
+
+void reconos_hwt_create_many(struct reconos_hwt *hwt,
+                             int *slot,
+                             struct reconos_configuration **cfg,
+                             size_t count,
+                             void *arg) {
+	struct hwt_startup *startup;
+	sem_t opened;
+	size_t i;
+
+	sem_init(&opened, 0, 0);
+
+	for (i = 0; i < count; i++) {
+		hwt[i].t_start = time_us();
+		hwt[i].t_program = 0;
+
+		hwt[i].slot = slot[i];
+		hwt[i].vhwt = NULL;
+		hwt[i].state = RECONOS_HWT_STATE_IDLE;
+
+		if (cfg[i]) {
+			hwt[i].is_reconf = 1;
+			hwt[i].cfg = cfg[i];
+		} else {
+			hwt[i].is_reconf = 0;
+		}
+
+		startup = malloc(sizeof(struct hwt_startup));
+		if (!startup)
+			panic("[reconos-core] failed to allocate memory for startup\n");
+
+		startup->hwt = &hwt[i];
+		startup->opened = &opened;
+
+		if (hwt_create_thread(&hwt[i], hwt_startup, startup))
+			panic("[reconos-core] failed to create delegate\n");
+	}
+
+	// the OSIFs must be valid when returning
+	for (i = 0; i < count; i++)
+		sem_wait(&opened);
+
+	sem_destroy(&opened);
+}
+
+void reconos_hwt_print_startup(struct reconos_hwt *hwt, size_t count) {
+	uint64_t t_first = 0, t_last = 0;
+	size_t i;
+
+	printf("[reconos-core] startup: slot   open [us]   program [us]   ready after [us]\n");
+
+	for (i = 0; i < count; i++) {
+		printf("[reconos-core]          %4d %10llu %14llu %18llu\n",
+		       hwt[i].slot,
+		       (unsigned long long)hwt[i].t_open,
+		       (unsigned long long)hwt[i].t_program,
+		       (unsigned long long)(hwt[i].t_ready - hwt[i].t_start));
+
+		if (i == 0 || hwt[i].t_start < t_first)
+			t_first = hwt[i].t_start;
+		if (hwt[i].t_ready > t_last)
+			t_last = hwt[i].t_ready;
+	}
+
+	printf("[reconos-core] startup: all ready after %llu us\n",
+	       (unsigned long long)(t_last - t_first));
+}
+
+
+/* == Virtual HWT functions ============================================ */
+
+/*
+ * Inserts the virtual hardware thread into the ready queue behind all
+ * virtual threads with the same or a higher priority.
+ * Must be called with the vhwt mutex held.
+ */
+static void vhwt_enqueue(struct reconos_vhwt *vhwt) {
+	struct reconos_vhwt **pos = &reconos_runtime.vhwt_control.ready;
+
+	while (*pos && (*pos)->priority >= vhwt->priority)
+		pos = &(*pos)->next;
+
+	vhwt->running = 0;
+	vhwt->next = *pos;
+	*pos = vhwt;
+}
+
+/*
+ * Removes the first virtual hardware thread able to run in the slot with
+ * a priority of at least min_priority from the ready queue.
+ * Must be called with the vhwt mutex held.
+ */
+static struct reconos_vhwt *vhwt_dequeue(int slot, int min_priority) {
+	struct reconos_vhwt **pos = &reconos_runtime.vhwt_control.ready;
+	struct reconos_vhwt *vhwt;
+
+	while (*pos && (*pos)->priority >= min_priority) {
+		vhwt = *pos;
+		if (slot < (int)vhwt->cfg_count && vhwt->cfg[slot]) {
+			*pos = vhwt->next;
+			vhwt->next = NULL;
+			vhwt->running = 1;
+			return vhwt;
+		}
+		pos = &vhwt->next;
+	}
+
+	return NULL;
+}
+
+/*
+ * Exchanges the state stored in the slot with the one of the virtual
+ * hardware thread. The buffers are swapped, so that they are reused.
+ */
+static void vhwt_swap_state(struct reconos_hwt *hwt,
+                            struct reconos_vhwt *vhwt) {
+	struct reconos_hwt_state state = hwt->saved_state;
+
+	hwt->saved_state = vhwt->saved_state;
+	vhwt->saved_state = state;
+}
+
+static struct reconos_configuration *vhwt_schedule(struct reconos_hwt *hwt) {
+	struct vhwt_control *ctrl = &reconos_runtime.vhwt_control;
+	struct reconos_vhwt *cur = hwt->vhwt, *next;
+	struct reconos_configuration *cfg;
+	uint64_t now = time_us();
+
+	pthread_mutex_lock(&ctrl->mutex);
+
+	if (cur) {
+		cur->yields++;
+
+		// keep running until the time quantum expired
+		if (now - cur->slice_start < ctrl->quantum) {
+			pthread_mutex_unlock(&ctrl->mutex);
+			return NULL;
+		}
+	}
+
+	next = vhwt_dequeue(hwt->slot, cur ? cur->priority : INT_MIN);
+	if (!next) {
+		// no competitor, so simply start a new time slice
+		if (cur) {
+			cur->run_time += now - cur->slice_start;
+			cur->slice_start = now;
+			cur->slices++;
+		}
+
+		pthread_mutex_unlock(&ctrl->mutex);
+		return NULL;
+	}
+
+	if (cur) {
+		cur->run_time += now - cur->slice_start;
+		cur->last_cfg = hwt->cfg;
+		vhwt_swap_state(hwt, cur);
+		vhwt_enqueue(cur);
+	}
+
+	// the state moves along, even if the slot changes
+	cfg = next->cfg[hwt->slot];
+	vhwt_swap_state(hwt, next);
+	hwt->saved_state.cfg = cfg;
+	hwt->vhwt = next;
+	next->last_cfg = cfg;
+	next->slices++;
+	hwt->init_data = next->init_data;
+
+	pthread_mutex_unlock(&ctrl->mutex);
+
+	return cfg;
+}
+
+struct reconos_configuration *vhwt_exited(struct reconos_hwt *hwt) {
+	struct vhwt_control *ctrl = &reconos_runtime.vhwt_control;
+	struct reconos_vhwt *cur = hwt->vhwt, *next;
+	struct reconos_configuration *cfg;
+	uint64_t now = time_us();
+
+	pthread_mutex_lock(&ctrl->mutex);
+
+	cur->run_time += now - cur->slice_start;
+	cur->last_cfg = hwt->cfg;
+	cur->running = 0;
+	hwt->vhwt = NULL;
+
+	// the state of the exited virtual thread is dropped
+	hwt->saved_state.length = 0;
+
+	next = vhwt_dequeue(hwt->slot, INT_MIN);
+	if (!next) {
+		pthread_mutex_unlock(&ctrl->mutex);
+		return NULL;
+	}
+
+	cfg = next->cfg[hwt->slot];
+	vhwt_swap_state(hwt, next);
+	hwt->saved_state.cfg = cfg;
+	hwt->vhwt = next;
+	next->last_cfg = cfg;
+	next->slices++;
+	hwt->init_data = next->init_data;
+
+	pthread_mutex_unlock(&ctrl->mutex);
+
+	return cfg;
+}
+
+void vhwt_reconfigured(struct reconos_hwt *hwt, uint64_t start) {
+	struct reconos_vhwt *vhwt = hwt->vhwt;
+	uint64_t now = time_us();
+
+	if (!vhwt)
+		return;
+
+	pthread_mutex_lock(&reconos_runtime.vhwt_control.mutex);
+
+	vhwt->reconfs++;
+	vhwt->reconf_time += now - start;
+	vhwt->slice_start = now;
+
+	pthread_mutex_unlock(&reconos_runtime.vhwt_control.mutex);
+}
+
+void reconos_vhwt_init(unsigned int quantum) {
+	struct vhwt_control *ctrl = &reconos_runtime.vhwt_control;
+
+	pthread_mutex_init(&ctrl->mutex, NULL);
+	ctrl->quantum = quantum;
+	ctrl->ready = NULL;
+
+	reconos_set_scheduler(vhwt_schedule);
+}
+
+void reconos_vhwt_create(struct reconos_vhwt *vhwt,
+                         struct reconos_configuration **cfg,
+                         size_t cfg_count,
+                         int priority,
+                         void *init_data) {
+	vhwt->cfg = cfg;
+	vhwt->cfg_count = cfg_count;
+	vhwt->priority = priority;
+	vhwt->init_data = init_data;
+
+	vhwt->last_cfg = NULL;
+	memset(&vhwt->saved_state, 0, sizeof(struct reconos_hwt_state));
+	vhwt->slice_start = 0;
+	vhwt->next = NULL;
+
+	vhwt->yields = 0;
+	vhwt->slices = 0;
+	vhwt->reconfs = 0;
+	vhwt->run_time = 0;
+	vhwt->reconf_time = 0;
+
+	pthread_mutex_lock(&reconos_runtime.vhwt_control.mutex);
+	vhwt_enqueue(vhwt);
+	pthread_mutex_unlock(&reconos_runtime.vhwt_control.mutex);
+}
+
+int reconos_vhwt_run(struct reconos_hwt *hwt, int slot, void *arg) {
+	struct reconos_vhwt *vhwt;
+	uint64_t start;
+
+	pthread_mutex_lock(&reconos_runtime.vhwt_control.mutex);
+	vhwt = vhwt_dequeue(slot, INT_MIN);
+	if (vhwt) {
+		vhwt->last_cfg = vhwt->cfg[slot];
+		vhwt->slices++;
+	}
+	pthread_mutex_unlock(&reconos_runtime.vhwt_control.mutex);
+
+	if (!vhwt)
+		return -1;
+
+	reconos_hwt_setinitdata(hwt, vhwt->init_data);
+
+	start = time_us();
+	hwt_create_reconf(hwt, slot, vhwt->cfg[slot], vhwt, arg);
+	vhwt_reconfigured(hwt, start);
+
+	return 0;
+}
+
+void reconos_vhwt_print_stats(struct reconos_vhwt *vhwt) {
+	uint64_t run_time;
+
+	pthread_mutex_lock(&reconos_runtime.vhwt_control.mutex);
+
+	run_time = vhwt->run_time;
+	if (vhwt->running)
+		run_time += time_us() - vhwt->slice_start;
+
+	printf("[reconos-core] vhwt %s (priority %d):\n",
+	       vhwt->last_cfg ? vhwt->last_cfg->name : "-", vhwt->priority);
+	printf("  slices:      %u\n", vhwt->slices);
+	printf("  yields:      %u (%.2f per second)\n", vhwt->yields,
+	       run_time ? vhwt->yields * 1000000.0 / run_time : 0.0);
+	printf("  run time:    %llu us\n", (unsigned long long)run_time);
+	printf("  reconfs:     %u (%llu us in total)\n", vhwt->reconfs,
+	       (unsigned long long)vhwt->reconf_time);
+
+	pthread_mutex_unlock(&reconos_runtime.vhwt_control.mutex);
+}
+
 
 /* == General ReconOS functions ========================================= */
 
@@ -167,12 +707,16 @@ void *proc_control_page_fault_handler(void *arg) {
 	struct proc_control *proc_control = arg;
 
 	while (1) {
-		uint32_t *addr;
+		uint32_t fault_addr, *addr;
 
 		// this call blocks until a page fault occurs
-		addr = (uint32_t *)reconos_proc_control_get_fault_addr(proc_control->fd);
+		fault_addr = reconos_proc_control_get_fault_addr(proc_control->fd);
 
-		printf("[reconos_core] page fault occured at address %x\n", (unsigned int)addr);
+		// the mmu faulted on this address of the process, address windows
+		// do not apply since they cannot move memory on these backends
+		addr = (uint32_t *)(uintptr_t)fault_addr;
+
+		printf("[reconos_core] page fault occured at address %x\n", fault_addr);
 
 		proc_control->page_faults++;
 
@@ -211,6 +755,7 @@ int reconos_init() {
 
 	// initialize data structure
 	reconos_runtime.scheduler = NULL;
+	reconos_runtime.addr_window_count = 0;
 
 	reconos_runtime.proc_control.fd = reconos_proc_control_open();
 	if (reconos_runtime.proc_control.fd < 0) {
@@ -265,10 +810,103 @@ void reconos_mmu_stats(int *tlb_hits, int *tlb_misses,
 		*page_faults = reconos_runtime.proc_control.page_faults;
 }
 
+void reconos_mmu_invalidate(void *ptr) {
+	// the MMU translates the addresses used by the hardware threads
+	if (ptr)
+		reconos_proc_control_tlb_invalidate(reconos_runtime.proc_control.fd, reconos_addr_to_hwt(ptr));
+	else
+		reconos_proc_control_tlb_invalidate_all(reconos_runtime.proc_control.fd);
+}
+
+void reconos_memif_qos(int slot, int weight, int priority) {
+	reconos_proc_control_set_memif_qos(reconos_runtime.proc_control.fd, slot, weight, priority);
+}
+
+void reconos_memif_stats(int slot, uint32_t *bytes) {
+	if (bytes)
+		*bytes = reconos_proc_control_get_memif_bytes(reconos_runtime.proc_control.fd, slot);
+}
+
+int reconos_osif_coalescing(int threshold, int timeout) {
+	int num_hwts;
+
+	num_hwts = reconos_proc_control_get_num_hwts(reconos_runtime.proc_control.fd);
+	if (threshold > 1 && (timeout == 0 || threshold > num_hwts)) {
+		whine("[reconos-core] coalescing threshold %d not reachable without timeout\n", threshold);
+		return -1;
+	}
+
+	return reconos_osif_set_coalescing(threshold, timeout);
+}
+
 void reconos_set_scheduler(struct reconos_configuration* (*scheduler)(struct reconos_hwt *hwt)) {
 	reconos_runtime.scheduler = scheduler;
 }
 
+int reconos_addr_window_add(void *host_addr, uint32_t hwt_addr, size_t size) {
+	struct addr_window *window;
+
+	if (reconos_runtime.addr_window_count >= RECONOS_ADDR_WINDOWS)
+		return -1;
+
+#if defined(RECONOS_MMU_true) && (defined(RECONOS_ARCH_zynq) || defined(RECONOS_ARCH_microblaze))
+	// the mmu walks the page tables of the process with the address of the
+	// hardware thread, so a window must not move the memory
+	if ((uintptr_t)host_addr != hwt_addr) {
+		whine("[reconos-core] address window %p at %x not supported with mmu\n",
+		      host_addr, hwt_addr);
+		return -1;
+	}
+#endif
+
+	window = &reconos_runtime.addr_window[reconos_runtime.addr_window_count];
+	window->host_addr = (uintptr_t)host_addr;
+	window->hwt_addr = hwt_addr;
+	window->size = size;
+
+	reconos_runtime.addr_window_count++;
+
+	return 0;
+}
+
+uint32_t reconos_addr_to_hwt(void *ptr) {
+	struct addr_window *window;
+	uintptr_t addr = (uintptr_t)ptr;
+	int i;
+
+	for (i = 0; i < reconos_runtime.addr_window_count; i++) {
+		window = &reconos_runtime.addr_window[i];
+		if (addr >= window->host_addr && addr - window->host_addr < window->size)
+			return window->hwt_addr + (uint32_t)(addr - window->host_addr);
+	}
+
+	if (addr > UINT32_MAX)
+		whine("[reconos-core] pointer %p not visible to hardware threads\n", ptr);
+
+	return (uint32_t)addr;
+}
+
+void *reconos_addr_to_host(uint32_t addr) {
+	struct addr_window *window;
+	int i;
+
+	for (i = 0; i < reconos_runtime.addr_window_count; i++) {
+		window = &reconos_runtime.addr_window[i];
+		if (addr >= window->hwt_addr && addr - window->hwt_addr < window->size)
+			return (void *)(window->host_addr + (addr - window->hwt_addr));
+	}
+
+	return (void *)(uintptr_t)addr;
+}
+
 void reconos_cache_flush() {
 	reconos_proc_control_cache_flush(reconos_runtime.proc_control.fd);
 }
+
+void reconos_cache_flush_range(void *ptr, size_t len) {
+	reconos_proc_control_cache_flush_range(reconos_runtime.proc_control.fd, ptr, len);
+}
+
+void reconos_cache_invalidate_range(void *ptr, size_t len) {
+	reconos_proc_control_cache_invalidate_range(reconos_runtime.proc_control.fd, ptr, len);
+}
@@ -61,6 +61,8 @@ struct reconos_resource {
  *   bitstream_length - length of the bitstream in 32bit-words
  *   slot             - slot number the configuration shoul run in
  *   name             - human readable name to identify the hardwarethread
+ *   resolved         - resource pointers resolved per type by the delegate
+ *   installed        - number of hardware threads using the resolved resources
  */
 struct reconos_configuration {
 	struct reconos_resource *resource;
@@ -72,6 +74,9 @@ struct reconos_configuration {
 	int slot;
 
 	char *name;
+
+	void **resolved;
+	unsigned int installed;
 };
 
 
@@ -93,8 +98,11 @@ void reconos_configuration_init(struct reconos_configuration *cfg, char *name, i
  *   cfg            - pointer to the configuration structure
  *   resource       - pointer to the resource array to use
  *   recource_count - number of resources in the resource array
+ *
+ *   returns 0 on success or -1 if a hardware thread currently runs the
+ *   configuration
  */
-void reconos_configuration_setresources(struct reconos_configuration *cfg,
+int reconos_configuration_setresources(struct reconos_configuration *cfg,
                                         struct reconos_resource *resorce,
                                         size_t resource_count);
 
@@ -120,8 +128,73 @@ void reconos_configuration_loadbitstream(struct reconos_configuration *cfg,
                                          char *filename);
 
 
+/* == Delegate attributes =============================================== */
+
+/*
+ * Structure representing the attributes of delegate threads
+ *
+ *   cpumask    - mask of CPUs the delegate may run on, one bit per CPU
+ *                (RECONOS_DELEGATE_CPUMASK_ANY for no restriction)
+ *   priority   - SCHED_FIFO priority of the delegate
+ *                (RECONOS_DELEGATE_PRIORITY_DEFAULT for SCHED_OTHER)
+ *   stack_size - stack size of the delegate in bytes
+ *                (RECONOS_DELEGATE_STACK_SIZE_DEFAULT for the default)
+ */
+#define RECONOS_DELEGATE_CPUMASK_ANY        0
+#define RECONOS_DELEGATE_PRIORITY_DEFAULT   0
+#define RECONOS_DELEGATE_STACK_SIZE_DEFAULT 0
+
+struct reconos_delegate_attr {
+	unsigned long cpumask;
+	int priority;
+	size_t stack_size;
+};
+
+/*
+ * Initializes the delegate attributes to the defaults.
+ *
+ *   attr - pointer to the delegate attributes
+ */
+void reconos_delegate_attr_init(struct reconos_delegate_attr *attr);
+
+/*
+ * Sets the attributes used for all delegates created afterwards. Single
+ * delegates can be changed by reconos_hwt_setdelegateattr.
+ *
+ *   attr - pointer to the delegate attributes (copied)
+ */
+void reconos_set_delegate_attr(struct reconos_delegate_attr *attr);
+
+/*
+ * Pins all delegates created afterwards to the CPUs not used for
+ * computation, so that the OSIF latency is not affected by computing
+ * threads. If all CPUs are used for computation, the delegates are
+ * pinned to the last CPU. Also sets a small stack size.
+ *
+ *   compute_cpumask - mask of CPUs used for computation
+ *
+ *   returns the mask of CPUs the delegates are pinned to
+ */
+unsigned long reconos_delegate_pin_away(unsigned long compute_cpumask);
+
+
 /* == HWT functions ===================================================== */
 
+/*
+ * Structure holding the state stored by a hardware thread
+ *
+ *   data   - pointer to the stored state
+ *   length - length of the stored state in 32bit-words
+ *   size   - size of the allocated buffer in 32bit-words
+ *   cfg    - configuration the state may be loaded by
+ */
+struct reconos_hwt_state {
+	uint32_t *data;
+	unsigned int length;
+	unsigned int size;
+	struct reconos_configuration *cfg;
+};
+
 /*
  * Structure representing a hardware thread
  *
@@ -134,6 +207,20 @@ void reconos_configuration_loadbitstream(struct reconos_configuration *cfg,
  *               (IDLE, RUNNING, RECONFIGURING, BLOCKING)
  *   cfg       - pointer to the current configuration
  *   init_data - pointer to the initialization data
+ *   osif_lock - lock to serialize replies written to the OSIF
+ *   tagged    - outstanding tagged OSIF calls (managed by the delegate)
+ *   saved_state - state stored by the hardware thread
+ *   vhwt      - virtual hardware thread running in the slot (NULL if none)
+ *   res_table - resolved resources of the current configuration
+ *   res_count - number of resources of the current configuration
+ *   res_cfg   - configuration the resources were installed from
+ *   error     - result of the last call failing due to an invalid handle
+ *               or of the last refused tagged call, cleared when queried
+ *               by the hardware thread
+ *   t_start   - time the creation started in microseconds
+ *   t_open    - time needed to open the OSIF in microseconds
+ *   t_program - time needed to program the slot in microseconds
+ *   t_ready   - time the delegate started in microseconds
  */
 struct reconos_hwt {
 	pthread_t delegate;
@@ -145,6 +232,21 @@ struct reconos_hwt {
 
 	struct reconos_configuration *cfg;
 	void *init_data;
+
+	pthread_mutex_t osif_lock;
+	struct hwt_delegate_tagged *tagged;
+	struct reconos_hwt_state saved_state;
+	struct reconos_vhwt *vhwt;
+
+	void **res_table;
+	uint32_t res_count;
+	struct reconos_configuration *res_cfg;
+	uint32_t error;
+
+	uint64_t t_start;
+	uint64_t t_open;
+	uint64_t t_program;
+	uint64_t t_ready;
 };
 
 /*
@@ -155,6 +257,25 @@ struct reconos_hwt {
 #define RECONOS_HWT_STATE_RECONFIGURING 2
 #define RECONOS_HWT_STATE_BLOCKING 3
 
+/*
+ * Performance counters of the slot of a hardware thread, the byte
+ * counters wrap around at 32 bit
+ *
+ *   cycles        - cycles the slot was out of reset
+ *   osif_wait     - cycles the hardware thread waited for the OSIF
+ *   memif_wait    - cycles the hardware thread waited for read data
+ *                   from the MEMIF
+ *   bytes_read    - bytes read from memory
+ *   bytes_written - bytes written to memory
+ */
+struct reconos_perf_counters {
+	uint64_t cycles;
+	uint64_t osif_wait;
+	uint64_t memif_wait;
+	uint32_t bytes_read;
+	uint32_t bytes_written;
+};
+
 /*
  * Associates a resource array to this hardware thread.
  *
@@ -175,6 +296,42 @@ void reconos_hwt_setresources(struct reconos_hwt *hwt,
 void reconos_hwt_setinitdata(struct reconos_hwt *hwt,
                              void* init_data);
 
+/*
+ * Applies the attributes to the delegate of this hardware thread, which
+ * is created with the global attributes. Must be called after the
+ * hardware thread is created. All attributes are applied, so the
+ * defaults restore an unrestricted affinity and SCHED_OTHER. The stack
+ * size cannot be changed anymore and is ignored.
+ *
+ *   hwt  - pointer to the hardware thread
+ *   attr - pointer to the delegate attributes (applied at once)
+ */
+void reconos_hwt_setdelegateattr(struct reconos_hwt *hwt,
+                                 struct reconos_delegate_attr *attr);
+
+/*
+ * Enables adaptive polling of the OSIF. Before waiting for an interrupt
+ * the delegate polls the OSIF for a number of iterations learned from
+ * recent response times, which reduces the latency of short calls. The
+ * hardware thread must already be created.
+ *
+ *   hwt   - pointer to the hardware thread
+ *   limit - maximum number of polling iterations (0 disables polling)
+ */
+void reconos_hwt_setpolling(struct reconos_hwt *hwt, int limit);
+
+/*
+ * Reads out the performance counters of the slot of the hardware
+ * thread. The counters are only cleared by a system reset, so the
+ * difference of two readouts gives the values of a period. A large
+ * share of osif_wait indicates a synchronization bound hardware thread
+ * and a large share of memif_wait a memory bound one.
+ *
+ *   hwt      - pointer to the hardware thread
+ *   counters - pointer to store the counters in
+ */
+void reconos_hwt_perf(struct reconos_hwt *hwt, struct reconos_perf_counters *counters);
+
 /*
  * Creates a new hardware thread running in the a specific slot. Before
  * executed the slot will be resetted.
@@ -202,6 +359,128 @@ void reconos_hwt_create_reconf(struct reconos_hwt *hwt,
                                struct reconos_configuration *cfg,
                                void *arg);
 
+/*
+ * Creates several hardware threads at once. The OSIFs are opened in
+ * parallel and the slots are programmed by the delegate threads
+ * themselves, so that the call returns as soon as all OSIFs are opened
+ * and the programming does not delay the creation of other threads.
+ * The slots are programmed right away and not on their first task, and
+ * still one after another, since they share the configuration port.
+ *
+ *   hwt   - array of hardware threads
+ *   slot  - array of slot numbers to run the hardware threads in
+ *   cfg   - array of pointers to the configurations
+ *           (NULL creates a non-reconfigurable hardware thread)
+ *   count - number of hardware threads to create
+ *   arg   - arguments for the delegate threads (passed to pthread_create)
+ */
+void reconos_hwt_create_many(struct reconos_hwt *hwt,
+                             int *slot,
+                             struct reconos_configuration **cfg,
+                             size_t count,
+                             void *arg);
+
+/*
+ * Prints the time spent to start up hardware threads, split into opening
+ * the OSIF and programming the slot.
+ *
+ *   hwt   - array of hardware threads
+ *   count - number of hardware threads
+ */
+void reconos_hwt_print_startup(struct reconos_hwt *hwt, size_t count);
+
+
+/* == Virtual HWT functions ============================================ */
+
+/*
+ * Structure representing a virtual hardware thread. Virtual hardware
+ * threads are multiplexed onto the reconfigurable hardware threads, so
+ * that more of them can be created than slots are available.
+ *
+ *   cfg            - array of configurations indexed by the slot number
+ *                    (NULL if the virtual thread cannot run in a slot)
+ *   cfg_count      - number of elements in the configuration array
+ *   priority       - priority of the virtual thread (higher runs first)
+ *   init_data      - initialization data of the virtual thread
+ *   running        - indicates if the virtual thread occupies a slot
+ *   last_cfg       - configuration the virtual thread ran last in
+ *   saved_state    - state stored while not occupying a slot
+ *   slice_start    - start of the current time slice in microseconds
+ *   next           - next virtual thread in the ready queue
+ *   yields         - number of yields of the virtual thread
+ *   slices         - number of time slices the virtual thread got
+ *   reconfs        - number of reconfigurations to run the virtual thread
+ *   run_time       - accumulated time occupying a slot in microseconds
+ *   reconf_time    - accumulated time for reconfigurations in microseconds
+ */
+struct reconos_vhwt {
+	struct reconos_configuration **cfg;
+	size_t cfg_count;
+	int priority;
+	void *init_data;
+
+	int running;
+	struct reconos_configuration *last_cfg;
+	struct reconos_hwt_state saved_state;
+	uint64_t slice_start;
+	struct reconos_vhwt *next;
+
+	unsigned int yields;
+	unsigned int slices;
+	unsigned int reconfs;
+	uint64_t run_time;
+	uint64_t reconf_time;
+};
+
+/*
+ * Initializes the multiplexing of virtual hardware threads and installs
+ * the corresponding scheduler. Whenever a hardware thread yields after
+ * its time quantum expired, it is preempted by the ready virtual thread
+ * with the highest priority not lower than its own. Hardware threads
+ * should store their state before yielding to resume properly. When a
+ * virtual thread exits, its slot is handed to the first ready virtual
+ * thread able to run in it.
+ *
+ *   quantum - time quantum in microseconds
+ */
+void reconos_vhwt_init(unsigned int quantum);
+
+/*
+ * Creates a new virtual hardware thread and puts it into the ready queue.
+ * The configurations must be initialized before and are associated to
+ * the virtual thread.
+ *
+ *   vhwt      - pointer to the virtual hardware thread
+ *   cfg       - array of configurations indexed by the slot number
+ *   cfg_count - number of elements in the configuration array
+ *   priority  - priority of the virtual thread
+ *   init_data - pointer to the initialization data
+ */
+void reconos_vhwt_create(struct reconos_vhwt *vhwt,
+                         struct reconos_configuration **cfg,
+                         size_t cfg_count,
+                         int priority,
+                         void *init_data);
+
+/*
+ * Creates a reconfigurable hardware thread in the specific slot running
+ * the first ready virtual hardware thread fitting into it.
+ *
+ *   hwt  - pointer to the hardware thread
+ *   slot - slot number to run the hardware thread in
+ *   arg  - arguments for the delegate thread (passed to pthread_create)
+ *
+ *   returns 0 on success or -1 if no virtual thread is ready for the slot
+ */
+int reconos_vhwt_run(struct reconos_hwt *hwt, int slot, void *arg);
+
+/*
+ * Prints the statistics of a virtual hardware thread.
+ *
+ *   vhwt - pointer to the virtual hardware thread
+ */
+void reconos_vhwt_print_stats(struct reconos_vhwt *vhwt);
+
 
 /* == General ReconOS functions ========================================= */
 
@@ -229,6 +508,49 @@ int reconos_init();
 void reconos_mmu_stats(int *tlb_hits, int *tlb_misses,
                        int *page_faults);
 
+/*
+ * Invalidates the TLB entry of the MMU translating the page containing
+ * ptr, e.g. after the mapping of the page changed. Passing NULL
+ * invalidates the entire TLB.
+ *
+ *   ptr - address within the page to invalidate or NULL
+ */
+void reconos_mmu_invalidate(void *ptr);
+
+/*
+ * Configures the arbitration of the memory accesses of a slot. Each
+ * turn the slot may transfer weight times the grant size of the memory
+ * arbiter and slots with a higher priority are always served first.
+ *
+ *   slot     - number of the slot
+ *   weight   - weight of the slot (1 to 255)
+ *   priority - priority of the slot (0 to 3)
+ */
+void reconos_memif_qos(int slot, int weight, int priority);
+
+/*
+ * Allows to read out the memory statistics of a slot.
+ *   slot  - number of the slot
+ *   bytes - pointer to store the number of transferred bytes in
+ *           (wraps around at 32 bit)
+ */
+void reconos_memif_stats(int slot, uint32_t *bytes);
+
+/*
+ * Configures the interrupt coalescing of the OSIF interrupt controller.
+ * The interrupt is raised if threshold OSIFs wait for it or if an OSIF
+ * waits for timeout cycles, which reduces the interrupt rate of many
+ * short calls at the cost of latency. The setting is shared by all
+ * slots. A threshold above 1 is refused without a timeout or if it
+ * exceeds the number of slots, since it might never be reached.
+ *
+ *   threshold - number of waiting OSIFs (0 or 1 disables coalescing)
+ *   timeout   - maximum delay in cycles (0 disables the timeout)
+ *
+ *   returns 0 on success or -1 if the setting is refused
+ */
+int reconos_osif_coalescing(int threshold, int timeout);
+
 /*
  * Resets a single hardware thread slot.
  */
@@ -239,13 +561,80 @@ void reconos_slot_reset(int slot, int reset);
  * scheduler will be called when a hardware thread yields. Keep in mind
  * that the scheduler can be called concurrently multiple times and must
  * be synchronized.
+ * The state stored by a hardware thread is kept per hardware thread and
+ * can only be loaded by the configuration which stored it. Hence, a
+ * preempted configuration can resume from its state if it is scheduled
+ * into the same slot again before another configuration stores a state.
+ * Virtual hardware threads take their state along when preempted.
  */
 void reconos_set_scheduler(struct reconos_configuration* (*scheduler)(struct reconos_hwt *hwt));
 
+/*
+ * Registers an address window mapping host memory into the 32bit address
+ * space of the hardware threads. Pointers passed to hardware threads are
+ * translated using the address windows, which allows to use memory
+ * beyond 4GB on 64bit hosts. Without a matching window, addresses are
+ * passed unmodified.
+ *
+ * The translation is done in software only, so windows moving memory are
+ * only valid on the cosim and replay backends, where the runtime serves
+ * the memory requests. On zynq and microblaze with MMU the hardware
+ * threads access the page tables of the process directly and such
+ * windows are refused.
+ *
+ *   host_addr - start of the window in the host address space
+ *   hwt_addr  - start of the window in the hardware thread address space
+ *   size      - size of the window in bytes
+ *
+ *   returns 0 on success or -1 if no more windows can be registered or
+ *   the window is not supported by the backend
+ */
+int reconos_addr_window_add(void *host_addr, uint32_t hwt_addr, size_t size);
+
+/*
+ * Translates a host pointer into an address usable by hardware threads.
+ *
+ *   ptr - pointer in the host address space
+ *
+ *   returns the address in the hardware thread address space
+ */
+uint32_t reconos_addr_to_hwt(void *ptr);
+
+/*
+ * Translates an address of a hardware thread into a host pointer.
+ *
+ *   addr - address in the hardware thread address space
+ *
+ *   returns the pointer in the host address space
+ */
+void *reconos_addr_to_host(uint32_t addr);
+
 /*
  * Flushes the cache of the processor. Consider that this method might not
  * be implemented on all architectures.
  */
 void reconos_cache_flush();
 
+/*
+ * Flushes the cache lines of the processor covering a memory range, so
+ * that hardware threads see the data written by software. Falls back to
+ * a flush of the entire cache if the range exceeds the cache size.
+ *
+ *   ptr - start of the memory range
+ *   len - length of the memory range in bytes
+ */
+void reconos_cache_flush_range(void *ptr, size_t len);
+
+/*
+ * Invalidates the cache lines of the processor covering a memory range,
+ * so that software sees the data written by hardware threads. Lines only
+ * partly covered by the range are flushed instead, to not drop the data
+ * of neighbouring variables, so the range should be line aligned. Falls
+ * back to a flush of the entire cache if the range exceeds the cache size.
+ *
+ *   ptr - start of the memory range
+ *   len - length of the memory range in bytes
+ */
+void reconos_cache_invalidate_range(void *ptr, size_t len);
+
 #endif /* RECONOS_H */
@@ -26,6 +26,8 @@
 #include <stdarg.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <stdint.h>
+#include <time.h>
 
 
 static inline void die() {
@@ -53,4 +55,12 @@ static inline void whine(char *msg, ...) {
 	fflush(stderr);
 }
 
+// monotonic time in microseconds, not affected by changes of the wall clock
+static inline uint64_t time_us() {
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
 #endif /* RECONOS_UTILS_H */
@@ -22,6 +22,86 @@
 
 #define RECONOS_IOC_MAGIC       'k'
 
+/*
+ * Structure passing an address range to the cache maintenance ioctls
+ *
+ *   addr - start address of the range (virtual address of the process)
+ *   len  - length of the range in bytes
+ */
+struct reconos_cache_range {
+	unsigned long addr;
+	unsigned long len;
+};
+
+/*
+ * Address passed to RECONOS_PROC_CONTROL_TLB_INVALIDATE to invalidate
+ * all entries instead of a single page
+ */
+#define RECONOS_TLB_INVALIDATE_ALL (~0UL)
+
+/*
+ * Structure passing the arbitration parameters of a slot to
+ * RECONOS_PROC_CONTROL_SET_MEMIF_QOS
+ *
+ *   slot     - number of the slot
+ *   weight   - bytes per turn in multiples of the grant size
+ *   priority - slots with higher priority are served first (0 to 3)
+ */
+struct reconos_memif_qos {
+	int slot;
+	unsigned int weight;
+	unsigned int priority;
+};
+
+/*
+ * Structure reading out the memory statistics of a slot with
+ * RECONOS_PROC_CONTROL_GET_MEMIF_BYTES
+ *
+ *   slot  - number of the slot
+ *   bytes - bytes transferred by the slot (wraps around)
+ */
+struct reconos_memif_bytes {
+	int slot;
+	unsigned int bytes;
+};
+
+/*
+ * Structure reading out the performance counters of a slot with
+ * RECONOS_PROC_CONTROL_GET_HWT_PERF, the byte counters wrap around at
+ * 32 bit
+ *
+ *   slot          - number of the slot
+ *   cycles        - cycles the slot was out of reset
+ *   osif_wait     - cycles the slot waited for data from the OSIF
+ *   memif_wait    - cycles the slot waited for data from the MEMIF
+ *   bytes_read    - bytes read from memory by the slot
+ *   bytes_written - bytes written to memory by the slot
+ */
+struct reconos_hwt_perf {
+	int slot;
+	unsigned long long cycles;
+	unsigned long long osif_wait;
+	unsigned long long memif_wait;
+	unsigned int bytes_read;
+	unsigned int bytes_written;
+};
+
+/*
+ * Structure passing the interrupt coalescing parameters of the OSIF
+ * interrupt controller to RECONOS_OSIF_SET_INTC_COALESCE, it is shared
+ * by all OSIFs
+ *
+ *   threshold - number of pending OSIFs raising the interrupt
+ *               (0 or 1 raises the interrupt immediately, larger values
+ *               require a timeout and at most one per OSIF)
+ *   timeout   - cycles an OSIF is pending at most before the interrupt
+ *               is raised (0 disables the timeout)
+ */
+struct reconos_osif_coalesce {
+	unsigned int threshold;
+	unsigned int timeout;
+};
+
 #define RECONOS_PROC_CONTROL_GET_NUM_HWTS      _IOR(RECONOS_IOC_MAGIC, 1, int)
 #define RECONOS_PROC_CONTROL_GET_TLB_HITS      _IOR(RECONOS_IOC_MAGIC, 2, int)
 #define RECONOS_PROC_CONTROL_GET_TLB_MISSES    _IOR(RECONOS_IOC_MAGIC, 3, int)
@@ -33,3 +113,15 @@
 #define RECONOS_PROC_CONTROL_CLEAR_HWT_RESET   _IOW(RECONOS_IOC_MAGIC, 9, int)
 #define RECONOS_PROC_CONTROL_DO_PTW            _IOW(RECONOS_IOC_MAGIC, 10, void*)
 #define RECONOS_PROC_CONTROL_CACHE_FLUSH       _IO(RECONOS_IOC_MAGIC, 11)
+#define RECONOS_PROC_CONTROL_CACHE_FLUSH_RANGE _IOW(RECONOS_IOC_MAGIC, 12, struct reconos_cache_range)
+#define RECONOS_PROC_CONTROL_CACHE_INVALIDATE_RANGE _IOW(RECONOS_IOC_MAGIC, 13, struct reconos_cache_range)
+#define RECONOS_PROC_CONTROL_TLB_INVALIDATE    _IOW(RECONOS_IOC_MAGIC, 14, unsigned long)
+#define RECONOS_PROC_CONTROL_SET_MEMIF_QOS     _IOW(RECONOS_IOC_MAGIC, 15, struct reconos_memif_qos)
+#define RECONOS_PROC_CONTROL_GET_MEMIF_BYTES   _IOWR(RECONOS_IOC_MAGIC, 16, struct reconos_memif_bytes)
+#define RECONOS_PROC_CONTROL_GET_HWT_PERF      _IOWR(RECONOS_IOC_MAGIC, 17, struct reconos_hwt_perf)
+
+#define RECONOS_OSIF_SET_POLL_LIMIT            _IOW(RECONOS_IOC_MAGIC, 32, int)
+#define RECONOS_OSIF_GET_POLL_LIMIT            _IOR(RECONOS_IOC_MAGIC, 33, int)
+#define RECONOS_OSIF_GET_MMAP_OFFSET           _IOR(RECONOS_IOC_MAGIC, 34, int)
+#define RECONOS_OSIF_SET_INTC_COALESCE         _IOW(RECONOS_IOC_MAGIC, 35, struct reconos_osif_coalesce)
+#define RECONOS_OSIF_GET_INTC_COALESCE         _IOR(RECONOS_IOC_MAGIC, 36, struct reconos_osif_coalesce)
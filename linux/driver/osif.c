@@ -26,9 +26,11 @@
 
 #include <linux/wait.h>
 #include <linux/sched.h>
+#include <linux/delay.h>
 #include <linux/interrupt.h>
 #include <linux/slab.h>
 #include <linux/fs.h>
+#include <linux/mm.h>
 #include <linux/miscdevice.h>
 #include <linux/ioport.h>
 #include <asm/io.h>
@@ -39,6 +41,10 @@
 #define OSIF_INTC_BASE_ADDR  0x7B400000
 #define OSIF_INTC_MEM_SIZE   0x10000
 
+// the coalescing registers follow the interrupt registers
+#define OSIF_INTC_COALESCE_THRESHOLD_REG(dev) ((dev)->irq_reg_count * 4)
+#define OSIF_INTC_COALESCE_TIMEOUT_REG(dev)   ((dev)->irq_reg_count * 4 + 4)
+
 #ifdef RECONOS_ARCH_zynq
 #define OSIF_INTC_IRQ        90
 #endif
@@ -49,6 +55,17 @@
 
 #define OSIF_FIFO_BASE_ADDR       0x75A00000
 #define OSIF_FIFO_MEM_SIZE        0x10
+
+// distance of the registers of two fifos, must match OSIF_FIFO_STRIDE_LOG2
+// of mhsaddhwts.py, only on zynq every fifo gets its own page to be mapped
+// to user space (designs generated before have the dense layout)
+#ifdef RECONOS_ARCH_zynq
+#define OSIF_FIFO_STRIDE          0x1000
+#endif
+
+#ifdef RECONOS_ARCH_microblaze
+#define OSIF_FIFO_STRIDE          0x10
+#endif
 #define OSIF_FIFO_RECV_REG        0x0
 #define OSIF_FIFO_SEND_REG        0x4
 #define OSIF_FIFO_RECV_STATUS_REG 0x8
@@ -60,6 +77,21 @@
 #define OSIF_FIFO_RECV_STATUS_FILL_MASK 0xFFFF
 #define OSIF_FIFO_SEND_STATUS_REM_MASK  0xFFFF
 
+// the sw2hw fifo has no not-full interrupt, so a writer polls the status
+// register for a bounded number of times before sleeping between polls,
+// starting short and doubling up to the maximum (in us)
+#define OSIF_FIFO_WRITE_SPIN_COUNT      64
+#define OSIF_FIFO_WRITE_SLEEP_MIN_US    10
+#define OSIF_FIFO_WRITE_SLEEP_MAX_US    1000
+
+// number of words transferred between the fifo and user space at once
+#define OSIF_FIFO_BOUNCE_WORDS          32
+
+// adaptive polling of the recv fifo before arming the interrupt, the
+// limit can be changed per fifo by RECONOS_OSIF_SET_POLL_LIMIT
+#define OSIF_FIFO_POLL_LIMIT_DEFAULT    0
+#define OSIF_FIFO_POLL_LIMIT_MAX        65536
+
 
 struct osif_fifo_dev {
 	unsigned int index;
@@ -71,6 +103,7 @@ struct osif_fifo_dev {
 	struct miscdevice mdev;
 	struct osif_intc_dev *irq_dev;
 	unsigned int fifo_fill, fifo_rem;
+	unsigned int poll_limit, poll_budget;
 };
 
 struct osif_intc_dev {
@@ -87,6 +120,8 @@ struct osif_intc_dev {
 
 	unsigned int irq_enable_count;
 
+	struct reconos_osif_coalesce coalesce;
+
 	spinlock_t lock;
 };
 
@@ -130,6 +165,16 @@ static inline void osif_fifo_sw2hw_write(struct osif_fifo_dev *dev,
 	iowrite32(data, dev->mem + OSIF_FIFO_SEND_REG);
 }
 
+static inline void osif_fifo_hw2sw_read_rep(struct osif_fifo_dev *dev,
+                                            uint32_t *data, unsigned int count) {
+	ioread32_rep(dev->mem + OSIF_FIFO_RECV_REG, data, count);
+}
+
+static inline void osif_fifo_sw2hw_write_rep(struct osif_fifo_dev *dev,
+                                             uint32_t *data, unsigned int count) {
+	iowrite32_rep(dev->mem + OSIF_FIFO_SEND_REG, data, count);
+}
+
 static inline void osif_intc_write_irq_enable(struct osif_intc_dev *dev) {
 	int i;
 
@@ -173,12 +218,49 @@ static inline void osif_intc_disable_interrupt(struct osif_intc_dev *dev,
 	spin_unlock_irqrestore(&dev->lock, flags);
 }
 
+static inline void osif_intc_set_coalesce(struct osif_intc_dev *dev,
+                                          struct reconos_osif_coalesce *coalesce) {
+	unsigned long flags;
+
+	spin_lock_irqsave(&dev->lock, flags);
+
+	dev->coalesce = *coalesce;
+	iowrite32(coalesce->threshold, dev->mem + OSIF_INTC_COALESCE_THRESHOLD_REG(dev));
+	iowrite32(coalesce->timeout, dev->mem + OSIF_INTC_COALESCE_TIMEOUT_REG(dev));
+
+	spin_unlock_irqrestore(&dev->lock, flags);
+}
+
 static inline int osif_intc_get_irq(struct osif_intc_dev *dev,
                                     unsigned int irq) {
 	return (dev->irq_reg[irq / 32] >> irq % 32) & 0x1;
 }
 
 
+// polls the recv fifo for a budget learned from recent response times
+// and returns if data arrived without the need to arm the interrupt
+
+static int osif_fifo_poll_fill(struct osif_fifo_dev *dev) {
+	unsigned int spin;
+
+	for (spin = 0; spin < dev->poll_budget; spin++) {
+		dev->fifo_fill = osif_fifo_hw2sw_fill(dev);
+		if (dev->fifo_fill > 0) {
+			// moving average of twice the observed response time
+			dev->poll_budget = min(dev->poll_limit,
+			                       (dev->poll_budget * 7 + spin * 2) / 8 + 1);
+			return 1;
+		}
+
+		cpu_relax();
+	}
+
+	// the hwt responds slowly, so spend less time polling next time
+	dev->poll_budget = max(dev->poll_limit / 16, dev->poll_budget / 2);
+	return 0;
+}
+
+
 // fifo file operations
 
 static int osif_fifo_open(struct inode *inode, struct file *filp) {
@@ -198,8 +280,8 @@ static int osif_fifo_open(struct inode *inode, struct file *filp) {
 
 static ssize_t osif_fifo_read(struct file *filp, char __user *buf,
                               size_t count, loff_t *pos) {
-	int word_count, i;
-	uint32_t data;
+	int word_count, i, batch;
+	uint32_t data[OSIF_FIFO_BOUNCE_WORDS];
 	struct osif_fifo_dev *dev = filp->private_data;
 
 	// only entire words can be read
@@ -222,7 +304,7 @@ static ssize_t osif_fifo_read(struct file *filp, char __user *buf,
 	__printk(KERN_DEBUG "[reconos-osif] ... %s %d word in fifo and trying to read %d words\n", dev->name, dev->fifo_fill, word_count);
 
 	while (i < word_count) {
-		if (dev->fifo_fill == 0) {
+		if (dev->fifo_fill == 0 && !osif_fifo_poll_fill(dev)) {
 			__printk(KERN_DEBUG "[reconos-osif] ... osif empty, enabling interrupt index %d\n", dev->index);
 
 			osif_intc_enable_interrupt(dev->irq_dev, dev->index);
@@ -237,23 +319,73 @@ static ssize_t osif_fifo_read(struct file *filp, char __user *buf,
 		}
 
 		if (dev->fifo_fill > 0) {
-			data = osif_fifo_hw2sw_read(dev);
-			if (copy_to_user(buf + sizeof(uint32_t) * i, &data, sizeof(uint32_t)))
+			// drain as many words as available with a single user copy
+			batch = min3(dev->fifo_fill, (unsigned int)(word_count - i),
+			             (unsigned int)OSIF_FIFO_BOUNCE_WORDS);
+
+			osif_fifo_hw2sw_read_rep(dev, data, batch);
+			if (copy_to_user(buf + sizeof(uint32_t) * i, data, sizeof(uint32_t) * batch))
 				return -EFAULT;
 
-			dev->fifo_fill--;
-			i++;
+			dev->fifo_fill -= batch;
+			i += batch;
 		}
 	}
 
-	__printk(KERN_DEBUG "[reconos-osif] ... %s finished reading: last word: %x\n", dev->name, data);
+	__printk(KERN_DEBUG "[reconos-osif] ... %s finished reading: last word: %x\n", dev->name, data[batch - 1]);
 	return count;
 }
 
+/*
+ * Waits until the sw2hw fifo has free space.
+ *
+ * The AXI FIFO raises no interrupt when words are taken out of the sw2hw
+ * fifo, so there is nothing a wait queue could be woken by. Instead the
+ * writer sleeps on a hrtimer and polls again, doubling the sleep time up
+ * to OSIF_FIFO_WRITE_SLEEP_MAX_US. A writer thus notices free space at
+ * most one sleep late, which is a few us for a hwt that just fell behind
+ * and up to a ms for one that stopped reading, instead of rounding every
+ * wait up to a jiffy (1 to 10 ms).
+ */
+static int osif_fifo_wait_rem(struct osif_fifo_dev *dev, int nonblock) {
+	unsigned int sleep_us = OSIF_FIFO_WRITE_SLEEP_MIN_US;
+	int spin;
+
+	// poll for a short time since the hwt usually drains the fifo quickly
+	for (spin = 0; spin < OSIF_FIFO_WRITE_SPIN_COUNT; spin++) {
+		dev->fifo_rem = osif_fifo_sw2hw_rem(dev);
+		if (dev->fifo_rem > 0)
+			return 0;
+
+		cpu_relax();
+	}
+
+	if (nonblock)
+		return -EAGAIN;
+
+	// sleep instead of burning the cpu if the hwt is slow to drain
+	while (dev->fifo_rem == 0) {
+		__printk(KERN_DEBUG "[reconos-osif] ... osif full, sleeping index %d\n", dev->index);
+
+		usleep_range(sleep_us, sleep_us * 2);
+		sleep_us = min(sleep_us * 2, (unsigned int)OSIF_FIFO_WRITE_SLEEP_MAX_US);
+		if (signal_pending(current)) {
+			__printk(KERN_INFO "[reconos-osif] "
+			                   "interrupted in write, aborting ...\n");
+
+			return -ERESTARTSYS;
+		}
+
+		dev->fifo_rem = osif_fifo_sw2hw_rem(dev);
+	}
+
+	return 0;
+}
+
 static ssize_t osif_fifo_write(struct file *filp, const char __user *buf,
                                size_t count, loff_t *pos) {
-	int word_count, i;
-	uint32_t data;
+	int word_count, i, ret, batch;
+	uint32_t data[OSIF_FIFO_BOUNCE_WORDS];
 	struct osif_fifo_dev *dev = filp->private_data;
 
 	// only entire words can be written
@@ -276,29 +408,116 @@ static ssize_t osif_fifo_write(struct file *filp, const char __user *buf,
 	__printk(KERN_DEBUG "[reconos-osif] ... trying to write %d words into fifo (%d free)\n", word_count, dev->fifo_rem);
 
 	while (i < word_count) {
-		if (dev->fifo_rem > 0) {
-			if (copy_from_user(&data, buf + sizeof(uint32_t) * i, sizeof(uint32_t)))
-				return -EFAULT;
-			osif_fifo_sw2hw_write(dev, data);
-
-			dev->fifo_rem--;
-			i++;
-		} else {
-			// this is busy wait, but since the fifo should not become full
-			// this should not be a drawback
-			dev->fifo_rem = osif_fifo_sw2hw_rem(dev);
+		if (dev->fifo_rem == 0) {
+			ret = osif_fifo_wait_rem(dev, filp->f_flags & O_NONBLOCK);
+			if (ret < 0) {
+				// report partial writes, only fail if nothing was written
+				if (i > 0)
+					return i * sizeof(uint32_t);
+				else
+					return ret;
+			}
 		}
+
+		// fill as many words as fit with a single user copy
+		batch = min3(dev->fifo_rem, (unsigned int)(word_count - i),
+		             (unsigned int)OSIF_FIFO_BOUNCE_WORDS);
+
+		if (copy_from_user(data, buf + sizeof(uint32_t) * i, sizeof(uint32_t) * batch))
+			return -EFAULT;
+		osif_fifo_sw2hw_write_rep(dev, data, batch);
+
+		dev->fifo_rem -= batch;
+		i += batch;
 	}
 
 	__printk(KERN_DEBUG "[reconos-osif] ... after write %d free\n", osif_fifo_sw2hw_rem(dev));
 	return count;
 }
 
+static int osif_fifo_mmap(struct file *filp, struct vm_area_struct *vma) {
+	struct osif_fifo_dev *dev = filp->private_data;
+	unsigned long size = vma->vm_end - vma->vm_start;
+
+	// only map the registers of this fifo, which is impossible if they
+	// share a page with the ones of other fifos
+	if (OSIF_FIFO_STRIDE < PAGE_SIZE)
+		return -ENODEV;
+
+	if (!dev || vma->vm_pgoff != 0 || size != PAGE_SIZE)
+		return -EINVAL;
+
+	vma->vm_page_prot = pgprot_noncached(vma->vm_page_prot);
+
+	return io_remap_pfn_range(vma, vma->vm_start, dev->addr >> PAGE_SHIFT,
+	                          size, vma->vm_page_prot);
+}
+
+static long osif_fifo_ioctl(struct file *filp, unsigned int cmd,
+                            unsigned long arg) {
+	struct osif_fifo_dev *dev = filp->private_data;
+	struct reconos_osif_coalesce coalesce;
+	int data;
+
+	switch (cmd) {
+		case RECONOS_OSIF_SET_POLL_LIMIT:
+			if (copy_from_user(&data, (int *)arg, sizeof(int)))
+				return -EFAULT;
+
+			if (data < 0 || data > OSIF_FIFO_POLL_LIMIT_MAX)
+				return -EINVAL;
+
+			dev->poll_limit = data;
+			dev->poll_budget = data;
+			break;
+
+		case RECONOS_OSIF_GET_POLL_LIMIT:
+			data = dev->poll_limit;
+			if (copy_to_user((int *)arg, &data, sizeof(int)))
+				return -EFAULT;
+			break;
+
+		case RECONOS_OSIF_GET_MMAP_OFFSET:
+			data = dev->addr & ~PAGE_MASK;
+			if (copy_to_user((int *)arg, &data, sizeof(int)))
+				return -EFAULT;
+			break;
+
+		case RECONOS_OSIF_SET_INTC_COALESCE:
+			if (copy_from_user(&coalesce, (struct reconos_osif_coalesce *)arg,
+			                   sizeof(struct reconos_osif_coalesce)))
+				return -EFAULT;
+
+			// a threshold not reached by the waiting OSIFs would hold
+			// back the interrupt forever without a timeout
+			if (coalesce.threshold > 1
+			    && (coalesce.timeout == 0 || coalesce.threshold > NUM_HWTS))
+				return -EINVAL;
+
+			osif_intc_set_coalesce(dev->irq_dev, &coalesce);
+			break;
+
+		case RECONOS_OSIF_GET_INTC_COALESCE:
+			coalesce = dev->irq_dev->coalesce;
+			if (copy_to_user((struct reconos_osif_coalesce *)arg, &coalesce,
+			                 sizeof(struct reconos_osif_coalesce)))
+				return -EFAULT;
+			break;
+
+		default:
+			return -EINVAL;
+	}
+
+	return 0;
+}
+
 static struct file_operations osif_fops = {
-	.owner  = THIS_MODULE,
-	.read   = osif_fifo_read,
-	.write  = osif_fifo_write,
-	.open   = osif_fifo_open,
+	.owner          = THIS_MODULE,
+	.read           = osif_fifo_read,
+	.write          = osif_fifo_write,
+	.open           = osif_fifo_open,
+	.mmap           = osif_fifo_mmap,
+	.unlocked_ioctl = osif_fifo_ioctl,
 };
 
 static int osif_fifo_init(struct osif_fifo_dev *dev) {
@@ -306,8 +525,10 @@ static int osif_fifo_init(struct osif_fifo_dev *dev) {
 	snprintf(dev->name, 25, "reconos-osif-%d", dev->index);
 	dev->fifo_fill = 0;
 	dev->fifo_rem = 0;
+	dev->poll_limit = OSIF_FIFO_POLL_LIMIT_DEFAULT;
+	dev->poll_budget = OSIF_FIFO_POLL_LIMIT_DEFAULT;
 	dev->irq_dev = &osif_intc_dev;
-	dev->addr = OSIF_FIFO_BASE_ADDR + dev->index * OSIF_FIFO_MEM_SIZE;
+	dev->addr = OSIF_FIFO_BASE_ADDR + dev->index * OSIF_FIFO_STRIDE;
 
 
 	// allocation io memory to read the fifo registers
@@ -414,6 +635,8 @@ static int osif_intc_init(struct osif_intc_dev *dev) {
 	dev->fifo = osif_fifo_dev;
 	dev->irq_reg_count = NUM_HWTS / 32 + 1;
 	dev->irq_enable_count = NUM_HWTS;
+	dev->coalesce.threshold = 1;
+	dev->coalesce.timeout = 0;
 
 	spin_lock_init(&dev->lock);
 
@@ -452,6 +675,9 @@ static int osif_intc_init(struct osif_intc_dev *dev) {
 	// disable all interrupts to avoid useless interrupts
 	osif_intc_write_irq_enable(dev);
 
+	// raise the interrupt immediately until coalescing is configured
+	osif_intc_set_coalesce(dev, &dev->coalesce);
+
 
 	// requesting interrupt
 	if(request_irq(dev->irq, osif_intc_interrupt, 0, "reconos-osif", dev)) {
@@ -50,7 +50,19 @@
 #define PROC_CONTROL_TLB_HITS_REG        0x0C
 #define PROC_CONTROL_TLB_MISSES_REG      0x10
 #define PROC_CONTROL_SYS_RESET_REG       0x14
-#define PROC_CONTROL_HWT_RESET_REG       0x18
+#define PROC_CONTROL_TLB_INVALIDATE_REG  0x18
+#define PROC_CONTROL_ARB_SLOT_REG        0x1C
+#define PROC_CONTROL_ARB_QOS_REG         0x20
+#define PROC_CONTROL_ARB_BYTES_REG       0x24
+#define PROC_CONTROL_PERF_CYCLES_REG     0x28
+#define PROC_CONTROL_PERF_OSIF_WAIT_REG  0x2C
+#define PROC_CONTROL_PERF_MEMIF_WAIT_REG 0x30
+#define PROC_CONTROL_PERF_BYTES_RD_REG   0x34
+#define PROC_CONTROL_PERF_BYTES_WR_REG   0x38
+
+// selects the upper halves of the performance counters latched before
+#define PROC_CONTROL_ARB_SLOT_PERF_HI    0x80000000
+#define PROC_CONTROL_HWT_RESET_REG       0x3C
 
 
 struct proc_control_dev {
@@ -143,6 +155,12 @@ out:
 
 static void flush_cache(void) {
 }
+
+static void flush_cache_range(unsigned long addr, unsigned long len) {
+}
+
+static void invalidate_cache_range(unsigned long addr, unsigned long len) {
+}
 #endif
 
 #ifdef RECONOS_ARCH_microblaze
@@ -165,12 +183,66 @@ static void flush_cache(void) {
 	for (i = 0; i < bytesize; i += linelen)
 		asm volatile ("wdc.flush %0, %1;" :: "d" (baseaddr), "d" (i));
 }
+
+// these parameters need to be adjusted to the architecture
+// C_DCACHE_BYTE_SIZE
+#define DCACHE_BYTE_SIZE (64 * 1024)
+// C_DCACHE_LINE_LEN * 4
+#define DCACHE_LINE_LEN  (4 * 4)
+
+static void flush_cache_range(unsigned long addr, unsigned long len) {
+	unsigned long i;
+
+	// walking the whole cache is cheaper for large ranges
+	if (len >= DCACHE_BYTE_SIZE) {
+		flush_cache();
+		return;
+	}
+
+	len += addr & (DCACHE_LINE_LEN - 1);
+	addr &= ~(DCACHE_LINE_LEN - 1);
+
+	for (i = 0; i < len; i += DCACHE_LINE_LEN)
+		asm volatile ("wdc.flush %0, %1;" :: "d" (addr), "d" (i));
+}
+
+static void invalidate_cache_range(unsigned long addr, unsigned long len) {
+	unsigned long i, end;
+
+	// flushing also invalidates the lines
+	if (len >= DCACHE_BYTE_SIZE) {
+		flush_cache();
+		return;
+	}
+
+	end = addr + len;
+
+	// lines only partly covered by the range may hold dirty data of
+	// neighbours, so they are written back instead of dropped
+	if (addr & (DCACHE_LINE_LEN - 1)) {
+		addr &= ~(DCACHE_LINE_LEN - 1);
+		asm volatile ("wdc.flush %0, %1;" :: "d" (addr), "d" (0));
+		addr += DCACHE_LINE_LEN;
+	}
+	if ((end & (DCACHE_LINE_LEN - 1)) && end > addr) {
+		end &= ~(DCACHE_LINE_LEN - 1);
+		asm volatile ("wdc.flush %0, %1;" :: "d" (end), "d" (0));
+	}
+
+	for (i = 0; addr + i < end; i += DCACHE_LINE_LEN)
+		asm volatile ("wdc.clear %0, %1;" :: "d" (addr), "d" (i));
+}
 #endif
 
 
 static long proc_control_ioctl(struct file *filp, unsigned int cmd,
                                unsigned long arg) {
 	struct proc_control_dev *dev = filp->private_data;
+	struct reconos_cache_range range;
+	struct reconos_memif_qos qos;
+	struct reconos_memif_bytes bytes;
+	struct reconos_hwt_perf perf;
+	unsigned long addr;
 	uint32_t data;
 	int i, hwt_num;
 	unsigned long flags;
@@ -279,6 +351,86 @@ static long proc_control_ioctl(struct file *filp, unsigned int cmd,
 			flush_cache();
 			break;
 
+		case RECONOS_PROC_CONTROL_CACHE_FLUSH_RANGE:
+			if (copy_from_user(&range, (struct reconos_cache_range *)arg, sizeof(range)))
+				return -EFAULT;
+			flush_cache_range(range.addr, range.len);
+			break;
+
+		case RECONOS_PROC_CONTROL_CACHE_INVALIDATE_RANGE:
+			if (copy_from_user(&range, (struct reconos_cache_range *)arg, sizeof(range)))
+				return -EFAULT;
+			invalidate_cache_range(range.addr, range.len);
+			break;
+
+		case RECONOS_PROC_CONTROL_TLB_INVALIDATE:
+			if (copy_from_user(&addr, (unsigned long *)arg, sizeof(addr)))
+				return -EFAULT;
+
+			// bit 0 tells the MMU to drop all entries
+			if (addr == RECONOS_TLB_INVALIDATE_ALL)
+				data = 0x1;
+			else
+				data = addr & PAGE_MASK;
+			proc_control_write_reg(dev, PROC_CONTROL_TLB_INVALIDATE_REG, data);
+			break;
+
+		case RECONOS_PROC_CONTROL_SET_MEMIF_QOS:
+			if (copy_from_user(&qos, (struct reconos_memif_qos *)arg, sizeof(qos)))
+				return -EFAULT;
+			if (qos.slot < 0 || qos.slot >= NUM_HWTS)
+				return -EINVAL;
+
+			data = (qos.weight & 0xFF) | (qos.priority & 0x3) << 8;
+
+			// slot select and qos register must be written together
+			spin_lock_irqsave(&dev->lock, flags);
+			proc_control_write_reg(dev, PROC_CONTROL_ARB_SLOT_REG, qos.slot);
+			proc_control_write_reg(dev, PROC_CONTROL_ARB_QOS_REG, data);
+			spin_unlock_irqrestore(&dev->lock, flags);
+			break;
+
+		case RECONOS_PROC_CONTROL_GET_MEMIF_BYTES:
+			if (copy_from_user(&bytes, (struct reconos_memif_bytes *)arg, sizeof(bytes)))
+				return -EFAULT;
+			if (bytes.slot < 0 || bytes.slot >= NUM_HWTS)
+				return -EINVAL;
+
+			spin_lock_irqsave(&dev->lock, flags);
+			proc_control_write_reg(dev, PROC_CONTROL_ARB_SLOT_REG, bytes.slot);
+			bytes.bytes = proc_control_read_reg(dev, PROC_CONTROL_ARB_BYTES_REG);
+			spin_unlock_irqrestore(&dev->lock, flags);
+
+			if (copy_to_user((struct reconos_memif_bytes *)arg, &bytes, sizeof(bytes)))
+				return -EFAULT;
+			break;
+
+		case RECONOS_PROC_CONTROL_GET_HWT_PERF:
+			if (copy_from_user(&perf, (struct reconos_hwt_perf *)arg, sizeof(perf)))
+				return -EFAULT;
+			if (perf.slot < 0 || perf.slot >= NUM_HWTS)
+				return -EINVAL;
+
+			spin_lock_irqsave(&dev->lock, flags);
+			// selecting the slot latches its counters
+			proc_control_write_reg(dev, PROC_CONTROL_ARB_SLOT_REG, perf.slot);
+			perf.cycles = proc_control_read_reg(dev, PROC_CONTROL_PERF_CYCLES_REG);
+			perf.osif_wait = proc_control_read_reg(dev, PROC_CONTROL_PERF_OSIF_WAIT_REG);
+			perf.memif_wait = proc_control_read_reg(dev, PROC_CONTROL_PERF_MEMIF_WAIT_REG);
+			perf.bytes_read = proc_control_read_reg(dev, PROC_CONTROL_PERF_BYTES_RD_REG);
+			perf.bytes_written = proc_control_read_reg(dev, PROC_CONTROL_PERF_BYTES_WR_REG);
+
+			proc_control_write_reg(dev, PROC_CONTROL_ARB_SLOT_REG,
+			                       perf.slot | PROC_CONTROL_ARB_SLOT_PERF_HI);
+			perf.cycles |= (u64)proc_control_read_reg(dev, PROC_CONTROL_PERF_CYCLES_REG) << 32;
+			perf.osif_wait |= (u64)proc_control_read_reg(dev, PROC_CONTROL_PERF_OSIF_WAIT_REG) << 32;
+			perf.memif_wait |= (u64)proc_control_read_reg(dev, PROC_CONTROL_PERF_MEMIF_WAIT_REG) << 32;
+			spin_unlock_irqrestore(&dev->lock, flags);
+
+			if (copy_to_user((struct reconos_hwt_perf *)arg, &perf, sizeof(perf)))
+				return -EFAULT;
+			break;
+
 		default:
 			return -EINVAL;
 	}
@@ -12,6 +12,8 @@
 --   author:       Christoph Rüthing, University of Paderborn
 --   description:  A simple unidirectional FIFO accessible on both sides
 --                 from the hardware via the known FIFO interface.
+--                 FIFO_S_Wait is set while the reader waits for data,
+--                 i.e. sets FIFO_S_RE on an empty FIFO.
 --
 --                 REMARK: Different clocks for FIFO-Rd and FIFO-Wr are
 --                         not supported yet. FIFO_S_Clk is used and
@@ -52,7 +54,8 @@ entity reconos_fifo is
 
 		FIFO_Rst      : in  std_logic;
 
-		FIFO_Has_Data : out std_logic
+		FIFO_Has_Data : out std_logic;
+		FIFO_S_Wait   : out std_logic
 	);
 
 	attribute MAX_FANOUT   : string;
@@ -96,6 +99,7 @@ begin
 	pad_16 <= (others => '0');
 
 	FIFO_Has_Data <= not s_empty;
+	FIFO_S_Wait   <= FIFO_S_RE and s_empty;
 	
 	FIFO_S_Data <= s_dout;
 	m_din <= FIFO_M_Data;
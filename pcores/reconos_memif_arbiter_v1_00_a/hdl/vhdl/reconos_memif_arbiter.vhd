@@ -16,6 +16,25 @@
 --                 further details on how the memory system in ReconOS
 --                 works take a look into the documentation (memory.txt)
 --
+--                 Requests are granted in a weighted round robin
+--                 manner. Each turn a slot may transfer up to its
+--                 weight times C_GRANT_SIZE bytes, larger requests are
+--                 split and continued in the next turn of the slot.
+--                 Slots with a higher priority are always served first.
+--                 The command of the next chunk is written while the
+--                 data of the current one is transferred, so that the
+--                 memory subsystem can prepare the next transfer.
+--                 Weight and priority of each slot are configured and
+--                 the transferred bytes per slot are read through the
+--                 proc control (ARB_* ports):
+--                   ARB_Slot     - slot to configure or read out
+--                   ARB_Qos_Data - weight (7 downto 0) and priority
+--                                  (9 downto 8) to set, written if
+--                                  ARB_Qos_WE is set
+--                   ARB_Qos      - weight and priority of the slot
+--                   ARB_Bytes_Read  - bytes read from memory by the slot
+--                   ARB_Bytes_Write - bytes written to memory by the slot
+--
 -- ======================================================================
 
 
@@ -34,7 +53,11 @@ entity reconos_memif_arbiter is
 		C_MEMIF_FIFO_WIDTH   : integer := 32;
 		C_CTRL_FIFO_WIDTH    : integer := 32;
 		
-		C_MEMIF_LENGTH_WIDTH : integer := 24
+		C_MEMIF_LENGTH_WIDTH : integer := 24;
+
+		-- bytes per turn of a slot with weight 1,
+		-- this MUST be a multiple of 4
+		C_GRANT_SIZE         : integer := 1024
 	);
 	port (
 		-- Input ports from HWTs
@@ -70,6 +93,14 @@ entity reconos_memif_arbiter is
 		CTRL_FIFO_Out_Empty   : out std_logic;
 		CTRL_FIFO_Out_RE      : in  std_logic;
 
+		-- Quality of service ports (via proc control)
+		ARB_Slot     : in  std_logic_vector(31 downto 0);
+		ARB_Qos_Data : in  std_logic_vector(31 downto 0);
+		ARB_Qos_WE   : in  std_logic;
+		ARB_Qos      : out std_logic_vector(31 downto 0);
+		ARB_Bytes_Read  : out std_logic_vector(31 downto 0);
+		ARB_Bytes_Write : out std_logic_vector(31 downto 0);
+
 		-- Transaction control ports
 		TCTRL_Clk : in std_logic;
 		TCTRL_Rst : in std_logic
@@ -98,13 +129,8 @@ architecture implementation of reconos_memif_arbiter is
 	
 	-- Signals to control HWT-MEMIF from this control unit
 	signal hw2mem_data   : std_logic_vector(C_MEMIF_FIFO_WIDTH - 1 downto 0);
-	signal hw2mem_fill   : std_logic_vector(15 downto 0);
 	signal hw2mem_empty  : std_logic;
 	signal hw2mem_re     : std_logic;
-	signal mem2hw_data   : std_logic_vector(C_MEMIF_FIFO_WIDTH - 1 downto 0);
-	signal mem2hw_rem    : std_logic_vector(15 downto 0);
-	signal mem2hw_full   : std_logic;
-	signal mem2hw_we     : std_logic;
 	
 	-- Array which contains all connected MEMIFs for easier handling
 	type memif_t is array(0 to C_NUM_HWTS - 1) of memif_fifo_t;
@@ -114,23 +140,90 @@ architecture implementation of reconos_memif_arbiter is
 	signal memif_empty   : std_logic_vector(0 to C_NUM_HWTS - 1);
 	
 	-- Transaction control signals
-	type STATE_TYPE is (WAIT_REQUEST, READ_CMD, READ_ADDR, SERV_REQUEST);
+	type STATE_TYPE is (WAIT_REQUEST, READ_CMD, READ_ADDR, CALC_CHUNK,
+	                    WRITE_CMD, WRITE_ADDR);
 	signal state : STATE_TYPE;
-	
-	signal ctrl_cmd     : std_logic_vector(C_MEMIF_FIFO_WIDTH - C_MEMIF_LENGTH_WIDTH - 1 downto 0);
-	signal ctrl_length  : std_logic_vector(C_MEMIF_LENGTH_WIDTH - 1 downto 0);
-	signal ctrl_addr    : std_logic_vector(C_MEMIF_FIFO_WIDTH - 1 downto 0);
+
+	-- Data transfer of the chunks in the order of their commands, the
+	-- chunk currently transferred and the one written next
+	signal serv_valid  : std_logic;
+	signal serv_select : integer range 0 to C_NUM_HWTS - 1;
+	signal pend_valid  : std_logic;
+	signal pend_select : integer range 0 to C_NUM_HWTS - 1;
+	signal pend_length : std_logic_vector(C_MEMIF_LENGTH_WIDTH - 1 downto 0);
+
+	-- Request of each slot currently served, remaining length and
+	-- address are updated after every chunk
+	type CMD_ARRAY_T    is array(0 to C_NUM_HWTS - 1) of std_logic_vector(C_MEMIF_FIFO_WIDTH - C_MEMIF_LENGTH_WIDTH - 1 downto 0);
+	type LENGTH_ARRAY_T is array(0 to C_NUM_HWTS - 1) of std_logic_vector(C_MEMIF_LENGTH_WIDTH - 1 downto 0);
+	type WORD_ARRAY_T   is array(0 to C_NUM_HWTS - 1) of std_logic_vector(31 downto 0);
+
+	signal req_active : std_logic_vector(0 to C_NUM_HWTS - 1);
+	signal req_cmd    : CMD_ARRAY_T;
+	signal req_rem    : LENGTH_ARRAY_T;
+	signal req_addr   : WORD_ARRAY_T;
+
+	-- a slot requests access, if a request is pending or its FIFO is not
+	-- empty and contains no data of a chunk still to transfer (busy)
+	signal busy       : std_logic_vector(0 to C_NUM_HWTS - 1);
+	signal request    : std_logic_vector(0 to C_NUM_HWTS - 1);
+
+	-- Quality of service configuration and statistics
+	type WEIGHT_ARRAY_T is array(0 to C_NUM_HWTS - 1) of std_logic_vector(7 downto 0);
+	type PRIO_ARRAY_T   is array(0 to C_NUM_HWTS - 1) of std_logic_vector(1 downto 0);
+
+	signal qos_weight : WEIGHT_ARRAY_T;
+	signal qos_prio   : PRIO_ARRAY_T;
+	signal bytes_read  : WORD_ARRAY_T;
+	signal bytes_write : WORD_ARRAY_T;
+
+	-- bytes left in the turn of the selected slot and size of the chunk
+	signal credit     : std_logic_vector(C_MEMIF_LENGTH_WIDTH - 1 downto 0);
+	signal chunk      : std_logic_vector(C_MEMIF_LENGTH_WIDTH - 1 downto 0);
+
+	signal ctrl_out_data  : std_logic_vector(C_CTRL_FIFO_WIDTH - 1 downto 0);
+	signal ctrl_out_fill  : std_logic_vector(15 downto 0);
+	signal ctrl_out_empty : std_logic;
 
 	signal tctrl_bytes_rem  : std_logic_vector(C_MEMIF_LENGTH_WIDTH - 1 downto 0);
 
+	-- calculates the bytes a slot may transfer per turn
+	function calc_grant (
+		weight : std_logic_vector(7 downto 0)
+	) return std_logic_vector is
+		variable grant : std_logic_vector(C_MEMIF_LENGTH_WIDTH + 7 downto 0);
+	begin
+		if weight = 0 then
+			return CONV_STD_LOGIC_VECTOR(C_GRANT_SIZE, C_MEMIF_LENGTH_WIDTH);
+		end if;
+
+		grant := weight * CONV_STD_LOGIC_VECTOR(C_GRANT_SIZE, C_MEMIF_LENGTH_WIDTH);
+		return grant(C_MEMIF_LENGTH_WIDTH - 1 downto 0);
+	end function calc_grant;
+
 begin
 
+	CTRL_FIFO_Out_Data  <= ctrl_out_data;
+	CTRL_FIFO_Out_Fill  <= ctrl_out_fill;
+	CTRL_FIFO_Out_Empty <= ctrl_out_empty;
+
+	request <= req_active or (memif_empty and not busy);
+
+	busy_proc : process(serv_valid,serv_select,pend_valid,pend_select) is
+	begin
+		for i in 0 to C_NUM_HWTS - 1 loop
+			if (serv_valid = '1' and serv_select = i) or (pend_valid = '1' and pend_select = i) then
+				busy(i) <= '1';
+			else
+				busy(i) <= '0';
+			end if;
+		end loop;
+	end process busy_proc;
+
 	-- This process multiplexes the MEMIFs to the right output
 	-- dependend on the current state
-	mux_proc : process(state,memif,memif_select,
-	                   hw2mem_re,hw2mem_data,
-	                   mem2hw_we,mem2hw_data,
-	                   CTRL_FIFO_Out_RE,
+	mux_proc : process(state,memif,memif_select,serv_valid,serv_select,
+	                   hw2mem_re,
 	                   -- sensitivity list for MEMIF-FIFOs
 	                   -- ## BEGIN GENERATE LOOP ##
 	                   MEMIF_FIFO_In_Hwt2Mem_Data_#i#,MEMIF_FIFO_In_Hwt2Mem_Fill_#i#,MEMIF_FIFO_In_Hwt2Mem_Empty_#i#,
@@ -174,52 +267,57 @@ begin
 		MEMIF_FIFO_Out_Mem2Hwt_Full  <= '1';
 		MEMIF_FIFO_Out_Mem2Hwt_Rem   <= (others => '0');
 		
-		CTRL_FIFO_Out_Empty <= '1';
-		CTRL_FIFO_Out_Fill  <= (others => '0');
-		CTRL_FIFO_Out_Data  <= (others => '0');
-		
-		hw2mem_data <= (others => '0');
-
-
-		case state is
-			when WAIT_REQUEST  =>
-				-- Connect MEMIF-FIFO to this control unit
-				hw2mem_data                     <= memif(memif_select).hw2mem_data;
-				hw2mem_fill                     <= memif(memif_select).hw2mem_fill;
-				hw2mem_empty                    <= memif(memif_select).hw2mem_empty; 
-				memif(memif_select).hw2mem_re   <= hw2mem_re;
-
-				memif(memif_select).mem2hw_data <= mem2hw_data;
-				mem2hw_rem                      <= memif(memif_select).mem2hw_rem;
-				mem2hw_full                     <= memif(memif_select).mem2hw_full;
-				memif(memif_select).mem2hw_we   <= mem2hw_we;
-
-			when READ_CMD | READ_ADDR =>
-				-- Connecting hw2mem that the memory subsystem can read the command
-				CTRL_FIFO_Out_Data              <= memif(memif_select).hw2mem_data;
-				CTRL_FIFO_Out_Fill              <= memif(memif_select).hw2mem_fill;
-				CTRL_FIFO_Out_Empty             <= memif(memif_select).hw2mem_empty;
-				memif(memif_select).hw2mem_re   <= CTRL_FIFO_Out_RE;
-				
-				hw2mem_data <= memif(memif_select).hw2mem_data;
-
-			when others =>
-				-- Connecting selected MEMIF-FIFO to output
-				MEMIF_FIFO_Out_Hwt2Mem_Data      <= memif(memif_select).hw2mem_data;
-				MEMIF_FIFO_Out_Hwt2Mem_Fill      <= memif(memif_select).hw2mem_fill;
-				MEMIF_FIFO_Out_Hwt2Mem_Empty     <= memif(memif_select).hw2mem_empty; 
-				memif(memif_select).hw2mem_re    <= MEMIF_FIFO_Out_Hwt2Mem_RE;
-
-				memif(memif_select).mem2hw_data  <= MEMIF_FIFO_Out_Mem2Hwt_Data;
-				MEMIF_FIFO_Out_Mem2Hwt_Rem       <= memif(memif_select).mem2hw_rem;
-				MEMIF_FIFO_Out_Mem2Hwt_Full      <= memif(memif_select).mem2hw_full;
-				memif(memif_select).mem2hw_we    <= MEMIF_FIFO_Out_Mem2Hwt_WE;
-			end case;
+		hw2mem_data  <= (others => '0');
+		hw2mem_empty <= '1';
+
+
+		if serv_valid = '1' then
+			-- Connecting MEMIF-FIFO of the transferred chunk to output
+			MEMIF_FIFO_Out_Hwt2Mem_Data     <= memif(serv_select).hw2mem_data;
+			MEMIF_FIFO_Out_Hwt2Mem_Fill     <= memif(serv_select).hw2mem_fill;
+			MEMIF_FIFO_Out_Hwt2Mem_Empty    <= memif(serv_select).hw2mem_empty; 
+			memif(serv_select).hw2mem_re    <= MEMIF_FIFO_Out_Hwt2Mem_RE;
+
+			memif(serv_select).mem2hw_data  <= MEMIF_FIFO_Out_Mem2Hwt_Data;
+			MEMIF_FIFO_Out_Mem2Hwt_Rem      <= memif(serv_select).mem2hw_rem;
+			MEMIF_FIFO_Out_Mem2Hwt_Full     <= memif(serv_select).mem2hw_full;
+			memif(serv_select).mem2hw_we    <= MEMIF_FIFO_Out_Mem2Hwt_WE;
+		end if;
+
+		-- a busy slot is never selected to read a new command, so that
+		-- both connections never refer to the same MEMIF
+		if state = READ_CMD or state = READ_ADDR then
+			-- Connecting hw2mem that this control unit can read the command
+			hw2mem_data                     <= memif(memif_select).hw2mem_data;
+			hw2mem_empty                    <= memif(memif_select).hw2mem_empty;
+			memif(memif_select).hw2mem_re   <= hw2mem_re;
+		end if;
 	end process mux_proc;
 
 
+	-- Read out of the quality of service configuration and statistics
+	qos_proc : process(ARB_Slot,qos_weight,qos_prio,bytes_read,bytes_write) is
+		variable slot : integer;
+	begin
+		ARB_Qos   <= (others => '0');
+		ARB_Bytes_Read  <= (others => '0');
+		ARB_Bytes_Write <= (others => '0');
+
+		if ARB_Slot < C_NUM_HWTS then
+			slot := CONV_INTEGER(ARB_Slot(15 downto 0));
+
+			ARB_Qos(7 downto 0) <= qos_weight(slot);
+			ARB_Qos(9 downto 8) <= qos_prio(slot);
+			ARB_Bytes_Read      <= bytes_read(slot);
+			ARB_Bytes_Write     <= bytes_write(slot);
+		end if;
+	end process qos_proc;
+
+
 	schedule_proc : process(TCTRL_Clk,TCTRL_Rst) is
-		variable pos : integer;
+		variable pos    : integer;
+		variable top    : integer;
+		variable length : std_logic_vector(C_MEMIF_LENGTH_WIDTH - 1 downto 0);
 	begin
 		if TCTRL_Rst = '1' then
 			state <= WAIT_REQUEST;
@@ -227,57 +325,164 @@ begin
 			memif_select <= 0;
 			
 			hw2mem_re   <= '0';
-			mem2hw_we   <= '0';
-			mem2hw_data <= (others => '0');
+
+			ctrl_out_empty <= '1';
+			ctrl_out_fill  <= (others => '0');
+			ctrl_out_data  <= (others => '0');
+
+			req_active <= (others => '0');
+			credit     <= (others => '0');
+			chunk      <= (others => '0');
+
+			serv_valid  <= '0';
+			serv_select <= 0;
+			pend_valid  <= '0';
+			pend_select <= 0;
+			pend_length <= (others => '0');
+
+			for i in 0 to C_NUM_HWTS - 1 loop
+				qos_weight(i) <= X"01";
+				qos_prio(i)   <= "00";
+				bytes_read(i)  <= (others => '0');
+				bytes_write(i) <= (others => '0');
+			end loop;
 		elsif rising_edge(TCTRL_Clk) then
+			-- count number of written/read words to find end of transaction
+			-- and continue with the next chunk
+			if serv_valid = '1' and (MEMIF_FIFO_Out_Hwt2Mem_RE = '1' or MEMIF_FIFO_Out_Mem2Hwt_WE = '1') then
+				tctrl_bytes_rem <= tctrl_bytes_rem - 4;
+				if MEMIF_FIFO_Out_Mem2Hwt_WE = '1' then
+					bytes_read(serv_select) <= bytes_read(serv_select) + 4;
+				else
+					bytes_write(serv_select) <= bytes_write(serv_select) + 4;
+				end if;
+
+				if or_reduce(tctrl_bytes_rem - 4) = '0' then
+					serv_valid <= '0';
+				end if;
+			end if;
+
+			if pend_valid = '1' and (serv_valid = '0' or (or_reduce(tctrl_bytes_rem - 4) = '0'
+			   and (MEMIF_FIFO_Out_Hwt2Mem_RE = '1' or MEMIF_FIFO_Out_Mem2Hwt_WE = '1'))) then
+				serv_valid <= '1';
+				serv_select <= pend_select;
+				tctrl_bytes_rem <= pend_length;
+
+				pend_valid <= '0';
+			end if;
+
 			case state is
 				when WAIT_REQUEST =>
 					hw2mem_re <= '0';
-					mem2hw_we <= '0';
-
-					-- a request is present, if a FIFO is not empty
-					if or_reduce(memif_empty) = '1' then
-						-- find out the next request to server with a simple schedule
-						-- start to look at FIFOs after the last position and find the first
-						-- one which is not empty				
-						for i in 1 to C_NUM_HWTS loop
-							pos := (memif_select + i) mod C_NUM_HWTS;
-
-							if memif_empty(pos) = '1' then
-								memif_select <= pos;
-								exit;
+
+					if or_reduce(request) = '1' then
+						-- find out the highest priority of all requests
+						top := 0;
+						for i in 0 to C_NUM_HWTS - 1 loop
+							if request(i) = '1' and CONV_INTEGER(qos_prio(i)) > top then
+								top := CONV_INTEGER(qos_prio(i));
 							end if;
 						end loop;
 
-						state <= READ_CMD;
+						-- the selected slot keeps access until its turn is over or a
+						-- slot with higher priority requests access, otherwise start
+						-- to look at FIFOs after the last position and find the first
+						-- one with the highest priority
+						pos := memif_select;
+						if or_reduce(credit) = '0' or request(memif_select) = '0'
+						   or CONV_INTEGER(qos_prio(memif_select)) < top then
+							for i in 1 to C_NUM_HWTS loop
+								pos := (memif_select + i) mod C_NUM_HWTS;
+
+								if request(pos) = '1' and CONV_INTEGER(qos_prio(pos)) = top then
+									exit;
+								end if;
+							end loop;
+
+							credit <= calc_grant(qos_weight(pos));
+						end if;
+
+						memif_select <= pos;
+
+						if req_active(pos) = '1' then
+							state <= CALC_CHUNK;
+						else
+							hw2mem_re <= '1';
+							state <= READ_CMD;
+						end if;
 					end if;
 
 				when READ_CMD =>
-					if CTRL_FIFO_Out_RE = '1' then
-						ctrl_cmd <= hw2mem_data(31 downto C_MEMIF_LENGTH_WIDTH);
-						ctrl_length <= hw2mem_data(C_MEMIF_LENGTH_WIDTH - 1 downto 0);
+					if hw2mem_empty = '0' then
+						req_cmd(memif_select) <= hw2mem_data(31 downto C_MEMIF_LENGTH_WIDTH);
+						req_rem(memif_select) <= hw2mem_data(C_MEMIF_LENGTH_WIDTH - 1 downto 2) & "00";
 
 						state <= READ_ADDR;
 					end if;
 
 				when READ_ADDR =>
+					if hw2mem_empty = '0' then
+						req_addr(memif_select) <= hw2mem_data;
+						req_active(memif_select) <= '1';
+
+						hw2mem_re <= '0';
+
+						state <= CALC_CHUNK;
+					end if;
+
+				-- at most one chunk waits for its data transfer
+				when CALC_CHUNK =>
+					if pend_valid = '0' then
+						length := req_rem(memif_select);
+						if credit < length then
+							length := credit;
+						end if;
+
+						chunk <= length;
+
+						ctrl_out_empty <= '0';
+						ctrl_out_fill  <= X"0001";
+						ctrl_out_data  <= req_cmd(memif_select) & length;
+
+						state <= WRITE_CMD;
+					end if;
+
+				when WRITE_CMD =>
 					if CTRL_FIFO_Out_RE = '1' then
-						ctrl_addr <= hw2mem_data;
+						ctrl_out_fill <= X"0000";
+						ctrl_out_data <= req_addr(memif_select);
 
-						tctrl_bytes_rem <= ctrl_length(C_MEMIF_LENGTH_WIDTH - 1 downto 2) & "00";
-						state <= SERV_REQUEST;
+						state <= WRITE_ADDR;
 					end if;
 
-				when SERV_REQUEST =>
-					-- count number of written/read words to find end of transaction
-					if MEMIF_FIFO_Out_Hwt2Mem_RE = '1' or MEMIF_FIFO_Out_Mem2Hwt_WE = '1' then
-						tctrl_bytes_rem <= tctrl_bytes_rem - 4;
+				when WRITE_ADDR =>
+					if CTRL_FIFO_Out_RE = '1' then
+						ctrl_out_empty <= '1';
+						ctrl_out_fill  <= X"0000";
+						ctrl_out_data  <= (others => '0');
+
+						req_addr(memif_select) <= req_addr(memif_select) + chunk;
+						req_rem(memif_select)  <= req_rem(memif_select) - chunk;
+						credit <= credit - chunk;
 
-						if or_reduce(tctrl_bytes_rem - 4) = '0' then
-							state <= WAIT_REQUEST;
+						-- the slot stays busy until the data is transferred
+						if req_rem(memif_select) = chunk then
+							req_active(memif_select) <= '0';
 						end if;
+
+						pend_valid  <= '1';
+						pend_select <= memif_select;
+						pend_length <= chunk;
+
+						state <= WAIT_REQUEST;
 					end if;
 			end case;
+
+			-- configuration through the proc control
+			if ARB_Qos_WE = '1' and ARB_Slot < C_NUM_HWTS then
+				qos_weight(CONV_INTEGER(ARB_Slot(15 downto 0))) <= ARB_Qos_Data(7 downto 0);
+				qos_prio(CONV_INTEGER(ARB_Slot(15 downto 0)))   <= ARB_Qos_Data(9 downto 8);
+			end if;
 		end if;
 	end process schedule_proc;
 
@@ -13,6 +13,8 @@
 --   description:  The burst converter splits burst transfers into smaller
 --                 requests which do not go over a page border. This is
 --                 needed because the MMU does not deal with this problem.
+--                 The chunks are written back to back without idle
+--                 cycles in between.
 --
 -- ======================================================================
 
@@ -75,7 +77,7 @@ architecture implementation of reconos_memif_burst_converter is
 	signal ctrl_out_empty   : std_logic;
 
 	-- Burst converter signals
-	type STATE_TYPE is (WAIT_REQUEST, READ_CMD, READ_ADDR, CALC_CHUNK, WRITE_CMD, WRITE_ADDR);
+	type STATE_TYPE is (WAIT_REQUEST, READ_CMD, READ_ADDR, WRITE_CMD, WRITE_ADDR);
 	signal state : STATE_TYPE;
 	
 	-- these signals contain the received request data unchanged
@@ -177,18 +179,14 @@ begin
 
 						bconv_addr := CTRL_FIFO_In_Data;
 						bconv_bytes_rem_page := calc_bytes_rem_page(bconv_addr);
-					
-						state <= CALC_CHUNK;
-					end if;
-
-				when CALC_CHUNK =>
 						bconv_length := calc_chunk_length(bconv_addr, bconv_bytes_rem, bconv_bytes_rem_page);
 
 						ctrl_out_empty <= '0';
 						ctrl_out_data <= bconv_cmd & bconv_length;
 						ctrl_out_fill <= X"0001";
-
+					
 						state <= WRITE_CMD;
+					end if;
 
 				when WRITE_CMD =>
 					if CTRL_FIFO_Out_RE = '1' then
@@ -204,15 +202,24 @@ begin
 						bconv_bytes_rem := bconv_bytes_rem - bconv_length;
 						bconv_bytes_rem_page := calc_bytes_rem_page(bconv_addr);
 
-						ctrl_out_empty <= '1';
-						ctrl_out_fill  <= X"0000";
-						ctrl_out_data  <= (others => '0');
-
 						if or_reduce(bconv_bytes_rem) = '0' then
 							-- last chunk was read and we have nothing more
-							state <= WAIT_REQUEST;
+							ctrl_out_empty <= '1';
+							ctrl_out_fill  <= X"0000";
+							ctrl_out_data  <= (others => '0');
+
+							-- start reading the next request right away
+							ctrl_in_re <= '1';
+
+							state <= READ_CMD;
 						else
-							state <= CALC_CHUNK;
+							-- write the command of the next chunk right away
+							bconv_length := calc_chunk_length(bconv_addr, bconv_bytes_rem, bconv_bytes_rem_page);
+
+							ctrl_out_data <= bconv_cmd & bconv_length;
+							ctrl_out_fill <= X"0001";
+
+							state <= WRITE_CMD;
 						end if;
 					end if;
 			end case;
@@ -13,6 +13,10 @@
 --   description:  The memory controller connects the memory subsystem of
 --                 ReconOS to the memory bus of the system as an AXI
 --                 master.
+--                 The next request is fetched and decoded while the
+--                 current one is transferred, so that it can be issued
+--                 on the bus right after the completion of the current
+--                 one.
 --
 -- ======================================================================
 
@@ -121,13 +125,19 @@ architecture implementation of user_logic is
 
 	constant C_MEMIF_CMD_WIDTH : integer := C_CTRL_FIFO_WIDTH - C_MEMIF_LENGTH_WIDTH;
 
-	type STATE_TYPE is (WAIT_REQUEST,READ_CMD,READ_ADDR,WAIT_FILL,WAIT_REM,
-	                    PERF_WRITE_0,PERF_WRITE_1,PERF_WRITE_2,
-	                    PERF_READ_0,PERF_READ_1,PERF_READ_2,
+	type STATE_TYPE is (WAIT_REQUEST,WAIT_FILL,WAIT_REM,
+	                    PERF_WRITE_1,PERF_WRITE_2,
+	                    PERF_READ_1,PERF_READ_2,
 	                    WAIT_CMPLT);
 	signal state : STATE_TYPE;
+
+	-- fetching of the next request, independent of the transfer
+	type FETCH_STATE_TYPE is (FETCH_WAIT,FETCH_CMD,FETCH_ADDR,FETCH_DONE);
+	signal fetch_state : FETCH_STATE_TYPE;
 	
+	-- port of the current transfer (data) and of the fetched request (ctrl)
 	signal port_select : std_logic;
+	signal cmd_select  : std_logic;
 	
 	signal count : std_logic_vector(C_MEMIF_LENGTH_WIDTH - 1 downto 0);
 	
@@ -150,6 +160,10 @@ architecture implementation of user_logic is
 	signal ctrl_addr        : std_logic_vector(C_CTRL_FIFO_WIDTH - 1 downto 0);
 	signal ctrl_length_fifo : std_logic_vector(15 downto 0);
 
+	signal next_cmd         : std_logic_vector(C_MEMIF_CMD_WIDTH - 1 downto 0);
+	signal next_length      : std_logic_vector(C_MEMIF_LENGTH_WIDTH - 1 downto 0);
+	signal next_addr        : std_logic_vector(C_CTRL_FIFO_WIDTH - 1 downto 0);
+
 	signal axi_read_req   : std_logic;
 	signal axi_write_req  : std_logic;
 	signal axi_addr       : std_logic_vector(31 downto 0);
@@ -222,8 +236,9 @@ begin
 	axi_wr_eof <= '1' when count = ctrl_length - 4 else '0';
 
 
-	-- multiplex port 1 (MMU) and port 2 (HWT)
-	port_mux_proc : process(port_select,
+	-- multiplex port 1 (MMU) and port 2 (HWT), the control FIFOs are
+	-- selected by the request to fetch and the data FIFOs by the transfer
+	port_mux_proc : process(port_select,cmd_select,
 	                        CTRL_FIFO_Mmu_Data,CTRL_FIFO_Hwt_Data,
 	                        CTRL_FIFO_Mmu_Empty,CTRL_FIFO_Hwt_Empty,
 	                        ctrl_fifo_re,memif_fifo_in_re,
@@ -250,20 +265,22 @@ begin
 		MEMIF_FIFO_Mmu_Data     <= (others => '0');
 		MEMIF_FIFO_Mmu_WE       <= '0';
 
-		if port_select = '0' then
+		if cmd_select = '0' then
 			ctrl_fifo_data   <= CTRL_FIFO_Mmu_Data;
 			ctrl_fifo_empty  <= CTRL_FIFO_Mmu_Empty;
 			CTRL_FIFO_Mmu_RE <= ctrl_fifo_re;
+		else
+			ctrl_fifo_data   <= CTRL_FIFO_Hwt_Data;
+			ctrl_fifo_empty  <= CTRL_FIFO_Hwt_Empty;
+			CTRL_FIFO_Hwt_RE <= ctrl_fifo_re;
+		end if;
 
+		if port_select = '0' then
 			memif_fifo_out_rem  <= MEMIF_FIFO_Mmu_Rem;
 			memif_fifo_out_full <= MEMIF_FIFO_Mmu_Full;
 			MEMIF_FIFO_Mmu_Data <= memif_fifo_out_data;
 			MEMIF_FIFO_Mmu_WE   <= memif_fifo_out_we;
 		else
-			ctrl_fifo_data   <= CTRL_FIFO_Hwt_Data;
-			ctrl_fifo_empty  <= CTRL_FIFO_Hwt_Empty;
-			CTRL_FIFO_Hwt_RE <= ctrl_fifo_re;
-
 			memif_fifo_out_rem      <= MEMIF_FIFO_Mem2Hwt_Rem;
 			memif_fifo_out_full     <= MEMIF_FIFO_Mem2Hwt_Full;
 			MEMIF_FIFO_Mem2Hwt_Data <= memif_fifo_out_data;
@@ -304,6 +321,7 @@ begin
 	begin
 		if rst_bus = '1' then
 			state <= WAIT_REQUEST;
+			fetch_state <= FETCH_WAIT;
 
 			axi_read_req  <= '0';
 			axi_write_req <= '0';
@@ -316,94 +334,113 @@ begin
 			ctrl_fifo_re <= '0';
 
 			port_select <= '1';
+			cmd_select  <= '1';
 
 			count <= (others => '0');
 		elsif rising_edge(clk) then
 			if rst = '1' then
 				abort <= '1';
 			end if;
-		
-			case state is
-				when WAIT_REQUEST =>				
+
+			-- fetching the next request
+			case fetch_state is
+				when FETCH_WAIT =>
 					if CTRL_FIFO_Mmu_Empty = '0' AND C_USE_MMU_PORT then
-						port_select <= '0';
+						cmd_select <= '0';
 
 						ctrl_fifo_re <= '1';
 
-						state <= READ_CMD;
+						fetch_state <= FETCH_CMD;
 					elsif CTRL_FIFO_Hwt_Empty = '0' then
-						port_select <= '1';
+						cmd_select <= '1';
 
 						ctrl_fifo_re <= '1';
 
-						state <= READ_CMD;
+						fetch_state <= FETCH_CMD;
 					end if;
 
-					if abort = '1' or rst = '1' then
-						ctrl_fifo_re <= '0';
-						state <= WAIT_REQUEST;
-					end if;
-					abort <= '0';
+				when FETCH_CMD =>
+					next_cmd <= ctrl_fifo_data(31 downto C_MEMIF_LENGTH_WIDTH);
+					next_length <= ctrl_fifo_data(C_MEMIF_LENGTH_WIDTH - 1 downto 0);
 
-				when READ_CMD =>
-					ctrl_cmd <= ctrl_fifo_data(31 downto C_MEMIF_LENGTH_WIDTH);
-					ctrl_length <= ctrl_fifo_data(C_MEMIF_LENGTH_WIDTH - 1 downto 0);
+					fetch_state <= FETCH_ADDR;
 
-					state <= READ_ADDR;
+				when FETCH_ADDR =>
+					if ctrl_fifo_empty = '0' then
+						next_addr <= ctrl_fifo_data;
 
-					if abort = '1' or rst = '1' then
 						ctrl_fifo_re <= '0';
-						state <= WAIT_REQUEST;
+
+						fetch_state <= FETCH_DONE;
 					end if;
 
-				when READ_ADDR =>
-					if ctrl_fifo_empty = '0' then
-						ctrl_addr <= ctrl_fifo_data;
+				when FETCH_DONE =>
+					-- waiting for the transfer to take the request
+					null;
 
-						ctrl_fifo_re <= '0';
-					
-						if ctrl_cmd(C_MEMIF_CMD_WIDTH - 1) = '1' then
+			end case;
+
+			if abort = '1' or rst = '1' then
+				ctrl_fifo_re <= '0';
+				fetch_state <= FETCH_WAIT;
+			end if;
+		
+			case state is
+				when WAIT_REQUEST =>
+					if fetch_state = FETCH_DONE and abort = '0' and rst = '0' then
+						ctrl_cmd <= next_cmd;
+						ctrl_length <= next_length;
+						ctrl_addr <= next_addr;
+
+						port_select <= cmd_select;
+
+						fetch_state <= FETCH_WAIT;
+
+						if next_cmd(C_MEMIF_CMD_WIDTH - 1) = '1' then
 							state <= WAIT_FILL;
 						else
 							state <= WAIT_REM;
 						end if;
 					end if;
 
-					if abort = '1' or rst = '1' then
-						ctrl_fifo_re <= '0';
-						state <= WAIT_REQUEST;
-					end if;
+					abort <= '0';
 
+				-- waiting for data and preparing for transfer
 				when WAIT_FILL =>
 					if memif_fifo_in_empty = '0' and memif_fifo_in_fill >= ctrl_length_fifo then
-						state <= PERF_WRITE_0;
+						axi_addr <= ctrl_addr;
+						axi_length <= ctrl_length(C_LENGTH_WIDTH - 1 downto 2) & "00";
+
+						axi_write_req <= '1';
+
+						count <= (others => '0');
+
+						state <= PERF_WRITE_1;
 					end if;
 
 					if abort = '1' or rst = '1' then
+						axi_write_req <= '0';
 						state <= WAIT_REQUEST;
 					end if;
 
+				-- waiting for space and preparing for transfer
 				when WAIT_REM =>
 					if memif_fifo_out_full = '0' and memif_fifo_out_rem >= ctrl_length_fifo then
-						state <= PERF_READ_0;
+						axi_addr <= ctrl_addr;
+						axi_length <= ctrl_length(C_LENGTH_WIDTH - 1 downto 2) & "00";
+
+						axi_read_req <= '1';
+
+						count <= (others => '0');
+
+						state <= PERF_READ_1;
 					end if;
 
 					if abort = '1' or rst = '1' then
-						ctrl_fifo_re <= '0';
+						axi_read_req <= '0';
 						state <= WAIT_REQUEST;
 					end if;
 
-				-- preparing for transfer
-				when PERF_WRITE_0 =>
-					axi_addr <= ctrl_addr;
-					axi_length <= ctrl_length(C_LENGTH_WIDTH - 1 downto 2) & "00";
-
-					axi_write_req <= '1';
-
-					count <= (others => '0');
-
-					state <= PERF_WRITE_1;
-
 				-- waiting for cmdack
 				when PERF_WRITE_1 =>
 					if axi_cmdack = '1' then
@@ -425,17 +462,6 @@ begin
 						end if;
 					end if;
 
-				-- preparing for transfer
-				when PERF_READ_0 =>
-					axi_addr <= ctrl_addr;
-					axi_length <= ctrl_length(C_LENGTH_WIDTH - 1 downto 2) & "00";
-
-					axi_read_req <= '1';
-
-					count <= (others => '0');
-
-					state <= PERF_READ_1;
-
 				-- waiting for cmdack
 				when PERF_READ_1 =>
 					if axi_cmdack = '1' then
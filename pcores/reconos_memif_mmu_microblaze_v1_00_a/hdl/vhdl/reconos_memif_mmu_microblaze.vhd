@@ -14,6 +14,10 @@
 --                 support. Therefore it performs page table walks,
 --                 manages a TLB for faster translation and handles
 --                 page fault via the proc control unit. 
+--                 Sequential streams are sped up by walking the page
+--                 table for the next page in advance if a request ends
+--                 close to the end of a page and by caching the last
+--                 level 1 descriptor.
 --
 -- ======================================================================
 
@@ -36,7 +40,10 @@ entity reconos_memif_mmu_microblaze is
 		
 		C_MEMIF_LENGTH_WIDTH : integer := 24;
 		
-		C_TLB_SIZE           : integer := 128
+		C_TLB_SIZE           : integer := 128;
+
+		C_USE_PREFETCH       : boolean := true;
+		C_PREFETCH_DISTANCE  : integer := 512
 	);
 	port (
 		-- Input FIFO ports from the HWTs (via burst converter and transaction control)
@@ -69,6 +76,8 @@ entity reconos_memif_mmu_microblaze is
 		MMU_Pgd         : in  std_logic_vector(31 downto 0);
 		MMU_Tlb_Hits    : out std_logic_vector(31 downto 0);
 		MMU_Tlb_Misses  : out std_logic_vector(31 downto 0);
+		MMU_Tlb_Inv     : in  std_logic;
+		MMU_Tlb_Inv_Data : in  std_logic_vector(31 downto 0);
 		
 		MMU_Clk : in std_logic;
 		MMU_Rst : in std_logic;
@@ -107,12 +116,25 @@ architecture implementation of reconos_memif_mmu_microblaze is
 	signal pgf        : std_logic;
 	signal tlb_hits   : std_logic_vector(31 downto 0);
 	signal tlb_misses : std_logic_vector(31 downto 0);
+
+	-- set while walking the page table speculatively for the next page
+	signal prefetch       : std_logic;
+	signal near_page_end  : std_logic;
+
+	-- last valid level 1 descriptor and its address
+	signal l1_cache_valid : std_logic;
+	signal l1_cache_addr  : std_logic_vector(31 downto 0);
+	signal l1_cache_data  : std_logic_vector(31 downto 0);
 	
 	-- these signals contain the received request data unchanged
 	signal ctrl_cmd      : std_logic_vector(C_MEMIF_CMD_WIDTH - 1 downto 0);
 	signal ctrl_length   : std_logic_vector(C_MEMIF_LENGTH_WIDTH - 1 downto 0);
 	signal ctrl_addr     : std_logic_vector(C_CTRL_FIFO_WIDTH - 1 downto 0);
 
+	-- virtual page number to translate, either the one of the request
+	-- or the following one if prefetching
+	signal walk_vpn      : std_logic_vector(19 downto 0);
+
 	signal l1_table_addr       : std_logic_vector(31 downto 0); -- address of the level 1 page table
 	signal l1_descriptor_addr  : std_logic_vector(31 downto 0); -- address of the level 1 page table entry
 	signal l2_table_addr       : std_logic_vector(31 downto 0); -- address of the level 2 page table
@@ -126,6 +148,10 @@ architecture implementation of reconos_memif_mmu_microblaze is
 	signal tlb_di   : std_logic_vector(19 downto 0);
 	signal tlb_we   : std_logic;
 
+	-- set if the TLB is invalidated while walking the page table, the
+	-- result of the walk might be stale and is not written into the TLB
+	signal walk_stale : std_logic;
+
 	signal clk : std_logic;
 	signal rst : std_logic;
 
@@ -174,10 +200,13 @@ begin
 	-- some address calculations based on the page table architecture
 	-- for detailed information look into the TRM on page 80
 	l1_table_addr       <= MMU_Pgd;
-	l1_descriptor_addr  <= "00" & l1_table_addr(29 downto 12) & ctrl_addr(31 downto 22) & "00";
-	l2_descriptor_addr  <= "00" & l2_table_addr(29 downto 12) & ctrl_addr(21 downto 12) & "00";
+	l1_descriptor_addr  <= "00" & l1_table_addr(29 downto 12) & walk_vpn(19 downto 10) & "00";
+	l2_descriptor_addr  <= "00" & l2_table_addr(29 downto 12) & walk_vpn(9 downto 0) & "00";
 	physical_addr       <= small_page_addr(31 downto 12) & ctrl_addr(11 downto 0);
 
+	-- the request ends within the last C_PREFETCH_DISTANCE bytes of the page
+	near_page_end <= '1' when (X"000" & ctrl_addr(11 downto 0)) + ctrl_length >= 4096 - C_PREFETCH_DISTANCE else '0';
+
 
 	mmu_proc : process(clk,rst) is
 	begin
@@ -187,6 +216,7 @@ begin
 			ctrl_cmd       <= (others => '0');
 			ctrl_length    <= (others => '0');
 			ctrl_addr      <= (others => '0');
+			walk_vpn       <= (others => '0');
 
 			ctrl_out_empty <= '1';
 			ctrl_out_fill  <= (others => '0');
@@ -201,6 +231,13 @@ begin
 			pgf            <= '0';
 			tlb_hits       <= (others => '0');
 			tlb_misses     <= (others => '0');
+
+			walk_stale     <= '0';
+
+			prefetch       <= '0';
+			l1_cache_valid <= '0';
+			l1_cache_addr  <= (others => '0');
+			l1_cache_data  <= (others => '0');
 		elsif rising_edge(clk) then
 			tlb_we <= '0';
 
@@ -225,13 +262,19 @@ begin
 					-- read address 
 					if CTRL_FIFO_In_Empty = '0' then
 						ctrl_addr <= CTRL_FIFO_In_Data;
+						walk_vpn <= CTRL_FIFO_In_Data(31 downto 12);
 						ctrl_in_re <= '0';
 
 						state <= READ_L1_ENTRY_0;
 					end if;
 
 				when READ_L1_ENTRY_0 =>
-					if tlb_hit = '1' then
+					if tlb_hit = '1' and prefetch = '1' then
+						-- next page already present
+						prefetch <= '0';
+
+						state <= WAIT_REQUEST;
+					elsif tlb_hit = '1' then
 						small_page_addr(31 downto 12) <= tlb_do;
 
 						ctrl_out_empty <= '0';
@@ -241,6 +284,17 @@ begin
 						tlb_hits <= tlb_hits + 1;
 
 						state <= WRITE_CMD;
+					elsif l1_cache_valid = '1' and l1_cache_addr = l1_descriptor_addr then
+						-- level 1 descriptor known from the previous walk
+						l2_table_addr <= l1_cache_data;
+
+						if prefetch = '0' then
+							tlb_misses <= tlb_misses + 1;
+						end if;
+
+						walk_stale <= '0';
+
+						state <= READ_L2_ENTRY_0;
 					else
 						-- write command to memory controller
 						ctrl_mmu_empty <= '0';
@@ -251,7 +305,11 @@ begin
 							ctrl_mmu_fill <= X"0000";
 							ctrl_mmu_data <= l1_descriptor_addr;
 
-							tlb_misses <= tlb_misses + 1;
+							if prefetch = '0' then
+								tlb_misses <= tlb_misses + 1;
+							end if;
+
+							walk_stale <= '0';
 
 							state <= READ_L1_ENTRY_1;
 						end if;
@@ -270,9 +328,19 @@ begin
 						l2_table_addr <= MEMIF_FIFO_Mmu_Data;
 
 						if or_reduce(MEMIF_FIFO_Mmu_Data) = '0' then
-							pgf <= '1';
-							state <= PAGE_FAULT;
+							if prefetch = '1' then
+								-- speculative walks never raise page faults
+								prefetch <= '0';
+								state <= WAIT_REQUEST;
+							else
+								pgf <= '1';
+								state <= PAGE_FAULT;
+							end if;
 						else
+							l1_cache_valid <= not walk_stale;
+							l1_cache_addr  <= l1_descriptor_addr;
+							l1_cache_data  <= MEMIF_FIFO_Mmu_Data;
+
 							state <= READ_L2_ENTRY_0;
 						end if;
 					end if;
@@ -302,17 +370,28 @@ begin
 						small_page_addr <= MEMIF_FIFO_Mmu_Data;
 						
 						if MEMIF_FIFO_Mmu_Data(1) = '0' then
-							pgf <= '1';
-							state <= PAGE_FAULT;
+							if prefetch = '1' then
+								prefetch <= '0';
+								state <= WAIT_REQUEST;
+							else
+								pgf <= '1';
+								state <= PAGE_FAULT;
+							end if;
 						else
-							ctrl_out_empty <= '0';
-							ctrl_out_fill  <= X"0001";
-							
-							ctrl_out_data <= ctrl_cmd & ctrl_length;
-							
-							tlb_we <= '1';
-
-							state <= WRITE_CMD;
+							tlb_we <= not walk_stale;
+
+							if prefetch = '1' then
+								prefetch <= '0';
+
+								state <= WAIT_REQUEST;
+							else
+								ctrl_out_empty <= '0';
+								ctrl_out_fill  <= X"0001";
+
+								ctrl_out_data <= ctrl_cmd & ctrl_length;
+
+								state <= WRITE_CMD;
+							end if;
 						end if;
 					end if;
 
@@ -330,7 +409,16 @@ begin
 						ctrl_out_empty <= '1';
 						ctrl_out_fill  <= X"0000";
 
-						state <= WAIT_REQUEST;
+						-- the walk is done while the memory controller
+						-- serves the request
+						if C_USE_PREFETCH and near_page_end = '1' then
+							walk_vpn <= ctrl_addr(31 downto 12) + 1;
+							prefetch <= '1';
+
+							state <= READ_L1_ENTRY_0;
+						else
+							state <= WAIT_REQUEST;
+						end if;
 					end if;
 
 				when PAGE_FAULT =>
@@ -342,11 +430,16 @@ begin
 						state <= READ_L1_ENTRY_0;
 					end if; 
 			end case;
+
+			if MMU_Tlb_Inv = '1' then
+				walk_stale <= '1';
+				l1_cache_valid <= '0';
+			end if;
 		end if;
 	end process mmu_proc;
 
 
-	tlb_tag <= ctrl_addr(31 downto 12);
+	tlb_tag <= walk_vpn;
 	tlb_di  <= small_page_addr(31 downto 12);
 
 	tlb_gen : if C_TLB_SIZE > 0 generate
@@ -362,6 +455,9 @@ begin
 				TLB_DO  => tlb_do,
 				TLB_WE  => tlb_we,
 				TLB_Hit => tlb_hit,
+				TLB_Inv     => MMU_Tlb_Inv,
+				TLB_Inv_All => MMU_Tlb_Inv_Data(0),
+				TLB_Inv_Tag => MMU_Tlb_Inv_Data(31 downto 12),
 				TLB_Clk => clk,
 				TLB_Rst => rst
 			);
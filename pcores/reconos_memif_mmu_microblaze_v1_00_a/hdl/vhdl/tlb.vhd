@@ -12,6 +12,12 @@
 --   author:       Christoph Rüthing, University of Paderborn
 --   description:  The TLB (translation lookaside buffer) caches the last
 --                 address translations for faster access.
+--                 New translations are written into an invalid entry
+--                 if available, otherwise the least recently used one
+--                 is replaced according to a tree based pseudo-LRU.
+--                 Therefore, C_TLB_SIZE must be a power of two.
+--                 Entries can be invalidated either all at once or by
+--                 tag (TLB_Inv, TLB_Inv_All and TLB_Inv_Tag).
 --
 -- ======================================================================
 
@@ -38,6 +44,11 @@ entity tlb is
 		TLB_DO  : out std_logic_vector(C_DATA_SIZE - 1 downto 0);
 		TLB_WE  : in  std_logic;
 		TLB_Hit : out std_logic;
+
+		-- invalidation ports
+		TLB_Inv     : in  std_logic;
+		TLB_Inv_All : in  std_logic;
+		TLB_Inv_Tag : in  std_logic_vector(C_TAG_SIZE - 1 downto 0);
 		
 		TLB_Clk : in std_logic;
 		TLB_Rst : in std_logic
@@ -52,11 +63,14 @@ end entity tlb;
 
 architecture implementation of tlb is
 
+	constant C_TLB_DEPTH : integer := clog2(C_TLB_SIZE);
+
 	signal clk : std_logic;
 	signal rst : std_logic;
 	
-	signal do  : std_logic_vector(C_DATA_SIZE - 1 downto 0);
-	signal hit : std_logic;
+	signal do      : std_logic_vector(C_DATA_SIZE - 1 downto 0);
+	signal hit     : std_logic;
+	signal hit_idx : integer range 0 to C_TLB_SIZE - 1;
 
 	type TAG_MEM_T  is array (0 to C_TLB_SIZE - 1) of std_logic_vector(C_TAG_SIZE - 1 downto 0);
 	type DATA_MEM_T  is array (0 to C_TLB_SIZE - 1) of std_logic_vector(C_DATA_SIZE - 1 downto 0);
@@ -64,11 +78,36 @@ architecture implementation of tlb is
 	signal valid    : std_logic_vector(0 to C_TLB_SIZE - 1);
 	signal tag_mem  : TAG_MEM_T;
 	signal data_mem : DATA_MEM_T;
-	
-	signal wrptr : std_logic_vector(clog2(C_TLB_SIZE) - 1 downto 0); 
+
+	-- pseudo-LRU tree stored as heap, node i has the children 2i and 2i+1
+	-- and the entries are the leafs C_TLB_SIZE to 2 * C_TLB_SIZE - 1,
+	-- a node points into the subtree to replace next ('0' left, '1' right)
+	signal plru   : std_logic_vector(1 to C_TLB_SIZE - 1);
+	signal victim : integer range 0 to C_TLB_SIZE - 1;
+
+	-- lets all nodes on the path to the entry point away from it
+	procedure plru_touch (
+		variable tree : inout std_logic_vector(1 to C_TLB_SIZE - 1);
+		idx           : in    integer
+	) is
+		variable node : integer;
+	begin
+		node := idx + C_TLB_SIZE;
+		for i in 0 to C_TLB_DEPTH - 1 loop
+			if node mod 2 = 0 then
+				tree(node / 2) := '1';
+			else
+				tree(node / 2) := '0';
+			end if;
+			node := node / 2;
+		end loop;
+	end procedure plru_touch;
 
 begin
 
+	assert 2 ** C_TLB_DEPTH = C_TLB_SIZE
+		report "C_TLB_SIZE must be a power of two" severity failure;
+
 	clk <= TLB_Clk;
 	rst <= TLB_Rst;
 
@@ -77,37 +116,87 @@ begin
 
 
 	write_proc : process(clk,rst) is
+		variable tree : std_logic_vector(1 to C_TLB_SIZE - 1);
 	begin
 		if rst = '1' then
-			wrptr <= (others => '0');
 			valid <= (others => '0');
+			plru  <= (others => '0');
 		elsif rising_edge(clk) then
+			tree := plru;
+
 			if TLB_WE = '1' then
-				tag_mem(CONV_INTEGER(wrptr)) <= TLB_Tag;
-				data_mem(CONV_INTEGER(wrptr)) <= TLB_DI;
-				
-				valid(CONV_INTEGER(wrptr)) <= '1';
-				
-				wrptr <= wrptr + 1;
+				tag_mem(victim) <= TLB_Tag;
+				data_mem(victim) <= TLB_DI;
+
+				-- a translation invalidated at the same time is dropped
+				if TLB_Inv = '0' or (TLB_Inv_All = '0' and TLB_Inv_Tag /= TLB_Tag) then
+					valid(victim) <= '1';
+				end if;
+
+				plru_touch(tree, victim);
+			elsif hit = '1' then
+				plru_touch(tree, hit_idx);
+			end if;
+
+			if TLB_Inv = '1' then
+				for i in 0 to C_TLB_SIZE - 1 loop
+					if TLB_Inv_All = '1' or tag_mem(i) = TLB_Inv_Tag then
+						valid(i) <= '0';
+					end if;
+				end loop;
 			end if;
+
+			plru <= tree;
 		end if;
 	end process write_proc;
 
 
 	read_proc : process(TLB_Tag,data_mem,valid,tag_mem) is
 	begin
-		hit <= '0';
-		do  <= (others => '0');
+		hit     <= '0';
+		hit_idx <= 0;
+		do      <= (others => '0');
 
 		-- loop over all tlb entries and take the first hit
 		for i in 0 to C_TLB_SIZE - 1 loop
 			if valid(i) = '1' and tag_mem(i) = TLB_Tag then
-				hit <= '1';
-				do  <= data_mem(i);
+				hit     <= '1';
+				hit_idx <= i;
+				do      <= data_mem(i);
 				exit;
 			end if;
 		end loop;
 	end process read_proc;
 
+
+	victim_proc : process(valid,plru) is
+		variable node : integer;
+		variable free : boolean;
+	begin
+		free := False;
+
+		-- prefer invalid entries
+		for i in 0 to C_TLB_SIZE - 1 loop
+			if valid(i) = '0' then
+				victim <= i;
+				free := True;
+				exit;
+			end if;
+		end loop;
+
+		if not free then
+			node := 1;
+			for i in 0 to C_TLB_DEPTH - 1 loop
+				if plru(node) = '0' then
+					node := 2 * node;
+				else
+					node := 2 * node + 1;
+				end if;
+			end loop;
+
+			victim <= node - C_TLB_SIZE;
+		end if;
+	end process victim_proc;
+
 		
 end architecture implementation;
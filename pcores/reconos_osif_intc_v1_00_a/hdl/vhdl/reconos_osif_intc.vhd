@@ -12,7 +12,8 @@
 --   author:       Christoph Rüthing, University of Paderborn
 --   description:  A simple interrupt controller with variable number of
 --                 inputs to connect the RECONOS_AXI_FIFO-interrupts to
---                 the processor.
+--                 the processor. The interrupt can be coalesced (see
+--                 user_logic.vhd).
 --
 -- ======================================================================
 
@@ -113,7 +114,8 @@ architecture implementation of reconos_osif_intc is
 			ZERO_ADDR_PAD & USER_SLV_HIGHADDR   -- user logic slave space high address
 		);
 
-	constant USER_SLV_NUM_REG   : integer   := C_NUM_INTERRUPTS / C_SLV_DWIDTH + 1;
+	-- interrupt registers, coalescing threshold and timeout
+	constant USER_SLV_NUM_REG   : integer   := C_NUM_INTERRUPTS / C_SLV_DWIDTH + 3;
 	constant USER_NUM_REG       : integer   := USER_SLV_NUM_REG;
 	constant TOTAL_IPIF_CE      : integer   := USER_NUM_REG;
 
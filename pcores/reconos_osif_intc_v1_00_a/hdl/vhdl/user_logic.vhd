@@ -14,6 +14,19 @@
 --                 inputs to connect the RECONOS_AXI_FIFO-interrupts to
 --                 the processor.
 --
+--                 To reduce the interrupt rate, the interrupt may be
+--                 coalesced. It is raised if at least threshold enabled
+--                 inputs are pending or if an input is pending for
+--                 timeout cycles. Afterwards it stays raised until no
+--                 enabled input is pending anymore. A threshold of at
+--                 most 1 raises the interrupt immediately. A larger
+--                 threshold needs a timeout, since fewer inputs might
+--                 be pending, which the software refuses otherwise.
+--
+--                   Reg. 0 to N-1: interrupt enable/pending inputs
+--                   Reg. N:        coalescing threshold in inputs
+--                   Reg. N+1:      coalescing timeout in cycles (0 = off)
+--
 -- ======================================================================
 
 
@@ -33,7 +46,7 @@ entity user_logic is
 		C_NUM_INTERRUPTS   : integer := 1;
 	
 		-- Bus protocol parameters
-		C_NUM_REG      : integer   := 1;
+		C_NUM_REG      : integer   := 3;
 		C_SLV_DWIDTH   : integer   := 32
 	);
   port (
@@ -68,14 +81,24 @@ end entity user_logic;
 
 
 architecture implementation of user_logic is
+
+	-- number of registers containing the interrupt bits
+	constant C_NUM_IRQ_REG : integer := C_NUM_REG - 2;
 	
 	-- padding to fill unused interrupts in interrupt_reg
-	signal pad   : std_logic_vector(C_SLV_DWIDTH * C_NUM_REG - C_NUM_INTERRUPTS - 1 downto 0);
+	signal pad   : std_logic_vector(C_SLV_DWIDTH * C_NUM_IRQ_REG - C_NUM_INTERRUPTS - 1 downto 0);
 
 	signal interrupt_masked     : std_logic_vector(C_NUM_INTERRUPTS - 1 downto 0);
 	signal interrupt_enable     : std_logic_vector(C_NUM_INTERRUPTS - 1 downto 0);
-	signal interrupt_reg        : std_logic_vector(C_NUM_REG * 32 - 1 downto 0);
-	signal interrupt_enable_reg : std_logic_vector(C_NUM_REG * 32 - 1 downto 0);
+	signal interrupt_reg        : std_logic_vector(C_NUM_IRQ_REG * 32 - 1 downto 0);
+	signal interrupt_enable_reg : std_logic_vector(C_NUM_IRQ_REG * 32 - 1 downto 0);
+
+	-- interrupt coalescing
+	signal coalesce_threshold : std_logic_vector(C_SLV_DWIDTH - 1 downto 0);
+	signal coalesce_timeout   : std_logic_vector(C_SLV_DWIDTH - 1 downto 0);
+	signal coalesce_count     : std_logic_vector(C_SLV_DWIDTH - 1 downto 0);
+	signal coalesce_timer     : std_logic_vector(C_SLV_DWIDTH - 1 downto 0);
+	signal interrupt_out      : std_logic;
 
 	-- Signals for user logic slave model s/w accessible register example
 	signal slv_reg_write_sel   : std_logic_vector(C_NUM_REG - 1 downto 0);
@@ -98,7 +121,7 @@ begin
 	interrupt_masked <= OSIF_INTC_in and interrupt_enable;
 	-- interrupt register only contains enabled interrupts
 	interrupt_reg <= pad & interrupt_masked;
-	OSIF_INTC_Out <= or_reduce(interrupt_masked);
+	OSIF_INTC_Out <= interrupt_out;
 
 	--    Bus2IP_WrCE/Bus2IP_RdCE   Memory Mapped Register
 	--                     "1000"   C_BASEADDR + 0x0
@@ -123,22 +146,82 @@ begin
 	begin
 		if rst = '1' then
 			interrupt_enable_reg <= (others => '0');
+			coalesce_threshold   <= conv_std_logic_vector(1, C_SLV_DWIDTH);
+			coalesce_timeout     <= (others => '0');
 		elsif rising_edge(clk) then
-			for i in 0 to C_NUM_REG - 1 loop
+			for i in 0 to C_NUM_IRQ_REG - 1 loop
 				if slv_reg_write_sel(C_NUM_REG - 1 - i) = '1' then
 					interrupt_enable_reg(32 * i + 31 downto 32 * i) <= Bus2IP_Data;
 				end if;
 			end loop;
+
+			if slv_reg_write_sel(1) = '1' then
+				coalesce_threshold <= Bus2IP_Data;
+			end if;
+
+			if slv_reg_write_sel(0) = '1' then
+				coalesce_timeout <= Bus2IP_Data;
+			end if;
 		end if;
 	end process int_enable_reg_proc;
 
-	bus_read_reg_proc : process(slv_reg_read_sel) is
+	bus_read_reg_proc : process(slv_reg_read_sel,interrupt_reg,
+	                            coalesce_threshold,coalesce_timeout) is
 	begin
-		for i in 0 to C_NUM_REG - 1 loop
+		slv_ip2bus_data <= (others => '0');
+
+		for i in 0 to C_NUM_IRQ_REG - 1 loop
 			if slv_reg_read_sel(C_NUM_REG - 1 - i) = '1' then
 				slv_ip2bus_data <= interrupt_reg(32 * i + 31 downto 32 * i);
 			end if;
 		end loop;
+
+		if slv_reg_read_sel(1) = '1' then
+			slv_ip2bus_data <= coalesce_threshold;
+		end if;
+
+		if slv_reg_read_sel(0) = '1' then
+			slv_ip2bus_data <= coalesce_timeout;
+		end if;
 	end process bus_read_reg_proc;
 
+	-- counts the pending enabled inputs
+	coalesce_count_proc : process(interrupt_masked) is
+		variable count : integer range 0 to C_NUM_INTERRUPTS;
+	begin
+		count := 0;
+		for i in 0 to C_NUM_INTERRUPTS - 1 loop
+			if interrupt_masked(i) = '1' then
+				count := count + 1;
+			end if;
+		end loop;
+
+		coalesce_count <= conv_std_logic_vector(count, C_SLV_DWIDTH);
+	end process coalesce_count_proc;
+
+	-- raises the interrupt if enough inputs are pending or the first
+	-- pending input waits for timeout cycles
+	coalesce_proc : process(clk,rst) is
+	begin
+		if rst = '1' then
+			interrupt_out  <= '0';
+			coalesce_timer <= (others => '0');
+		elsif rising_edge(clk) then
+			if or_reduce(interrupt_masked) = '0' then
+				interrupt_out  <= '0';
+				coalesce_timer <= (others => '0');
+			else
+				coalesce_timer <= coalesce_timer + 1;
+
+				if coalesce_count >= coalesce_threshold then
+					interrupt_out <= '1';
+				end if;
+
+				if or_reduce(coalesce_timeout) = '1' and coalesce_timer >= coalesce_timeout - 1 then
+					interrupt_out <= '1';
+				end if;
+			end if;
+		end if;
+	end process coalesce_proc;
+
 end implementation;
@@ -44,6 +44,7 @@ entity reconos_osif is
 	generic (
 		C_NUM_FIFOS           : integer         := 1;
 		C_FIFO_WIDTH          : integer         := 32;
+		C_FIFO_STRIDE_LOG2    : integer         := 4;
 
 		-- Bus protocol parameters, do not add to or delete
 		C_S_AXI_DATA_WIDTH   : integer            := 32;
@@ -200,6 +201,7 @@ begin
 		generic map (
 			C_NUM_FIFOS  => C_NUM_FIFOS,
 			C_FIFO_WIDTH => C_FIFO_WIDTH,
+			C_FIFO_STRIDE_LOG2 => C_FIFO_STRIDE_LOG2,
 
 			-- Bus protocol parameters
 			C_SLV_DWIDTH   => USER_SLV_DWIDTH
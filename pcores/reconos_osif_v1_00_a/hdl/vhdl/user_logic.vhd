@@ -16,6 +16,8 @@
 --                   Reg1: Write data
 --                   Reg2: Fill - number of elements in receive-FIFO
 --                   Reg3: Rem - free space in send-FIFO
+--                 The registers of the FIFOs are 2**C_FIFO_STRIDE_LOG2
+--                 bytes apart.
 --
 --                 REMARK: The FIFOs must have the same clock than the
 --                         AXI-Bus.
@@ -37,6 +39,7 @@ entity user_logic is
 	generic (
 		C_NUM_FIFOS    : integer   := 1;
 		C_FIFO_WIDTH   : integer   := 32;
+		C_FIFO_STRIDE_LOG2 : integer := 4;
 
 		-- Bus protocol parameters
 		C_SLV_DWIDTH   : integer   := 32
@@ -140,7 +143,7 @@ begin
 	IP2Bus_RdAck <= slv_read_ack;
 	IP2Bus_Error <= '0';
 
-	fifo_bi_select  <= CONV_INTEGER(slv_addr(19 downto 4));
+	fifo_bi_select  <= CONV_INTEGER(slv_addr(19 downto C_FIFO_STRIDE_LOG2));
 	reg_select      <= CONV_INTEGER(slv_addr(3 downto 2));
 
 
@@ -25,7 +25,23 @@
 --                   Reg4: TLB misses - Read only
 --                   # resets
 --                   Reg5: ReconOS reset (reset everything) - Write only
---                   Reg6: HWT reset (multiple registers) - Write only
+--                   Reg6: TLB invalidate - Write only
+--                         virtual address of the page to invalidate
+--                         or 0x1 to invalidate all entries
+--                   # memory arbiter
+--                   Reg7: Slot - Read / Write
+--                         slot accessed by register 8 to 14
+--                   Reg8: Arbiter QoS of slot - Read / Write
+--                         weight (7 downto 0), priority (9 downto 8)
+--                   Reg9: Arbiter transferred bytes of slot - Read only
+--                   # performance counters of slot (wrap around)
+--                   Reg10: Cycles out of reset - Read only
+--                   Reg11: Cycles waiting for the OSIF - Read only
+--                   Reg12: Cycles waiting for the MEMIF - Read only
+--                   Reg13: Bytes read from memory - Read only
+--                   Reg14: Bytes written to memory - Read only
+--                   # resets
+--                   Reg15: HWT reset (multiple registers) - Write only
 --                         | x , x-1, ... | x-32 , x-33, ... 0 |
 --
 --                   Page fault handling works the following:
@@ -85,6 +101,12 @@ entity reconos_proc_control is
 		PROC_Sys_Rst    : out std_logic;
 		PROC_Pgf_Int    : out std_logic;
 
+		-- performance counter related ports
+		-- BEGIN GENERATE LOOP
+		PROC_Hwt_Osif_Wait_#i#  : in  std_logic;
+		PROC_Hwt_Memif_Wait_#i# : in  std_logic;
+		-- END GENERATE LOOP
+
 		-- MMU related ports
 		MMU_Pgf         : in  std_logic;
 		MMU_Fault_Addr  : in  std_logic_vector(31 downto 0);
@@ -92,6 +114,16 @@ entity reconos_proc_control is
 		MMU_Pgd         : out std_logic_vector(31 downto 0);
 		MMU_Tlb_Hits    : in  std_logic_vector(31 downto 0);
 		MMU_Tlb_Misses  : in  std_logic_vector(31 downto 0);
+		MMU_Tlb_Inv     : out std_logic;
+		MMU_Tlb_Inv_Data : out std_logic_vector(31 downto 0);
+
+		-- Arbiter related ports
+		ARB_Slot        : out std_logic_vector(31 downto 0);
+		ARB_Qos_Data    : out std_logic_vector(31 downto 0);
+		ARB_Qos_WE      : out std_logic;
+		ARB_Qos         : in  std_logic_vector(31 downto 0);
+		ARB_Bytes_Read  : in  std_logic_vector(31 downto 0);
+		ARB_Bytes_Write : in  std_logic_vector(31 downto 0);
 
 		-- Bus protocol ports, do not add to or delete
 		S_AXI_ACLK      : in  std_logic;
@@ -148,7 +180,7 @@ architecture implementation of reconos_proc_control is
 			ZERO_ADDR_PAD & USER_SLV_HIGHADDR   -- user logic slave space high address
 		);
 
-	constant USER_SLV_NUM_REG   : integer   := C_NUM_HWTS / C_SLV_DWIDTH + 7;
+	constant USER_SLV_NUM_REG   : integer   := C_NUM_HWTS / C_SLV_DWIDTH + 16;
 	constant USER_NUM_REG       : integer   := USER_SLV_NUM_REG;
 	constant TOTAL_IPIF_CE      : integer   := USER_NUM_REG;
 
@@ -185,6 +217,8 @@ architecture implementation of reconos_proc_control is
 	signal user_IP2Bus_Error    : std_logic;
 
 	signal hwt_rst : std_logic_vector(C_NUM_HWTS - 1 downto 0);
+	signal hwt_osif_wait  : std_logic_vector(C_NUM_HWTS - 1 downto 0);
+	signal hwt_memif_wait : std_logic_vector(C_NUM_HWTS - 1 downto 0);
 
 begin
 
@@ -251,6 +285,10 @@ begin
 			PROC_Sys_Rst => PROC_Sys_Rst,
 			PROC_Pgf_Int => PROC_Pgf_Int,
 
+			-- performance counter related ports
+			PROC_Hwt_Osif_Wait  => hwt_osif_wait,
+			PROC_Hwt_Memif_Wait => hwt_memif_wait,
+
 			-- MMU related ports
 			MMU_Pgf        => MMU_Pgf,
 			MMU_Fault_Addr => MMU_Fault_Addr,
@@ -258,6 +296,16 @@ begin
 			MMU_Pgd        => MMU_Pgd,
 			MMU_Tlb_Hits   => MMU_Tlb_Hits,
 			MMU_Tlb_Misses => MMU_Tlb_Misses,
+			MMU_Tlb_Inv    => MMU_Tlb_Inv,
+			MMU_Tlb_Inv_Data => MMU_Tlb_Inv_Data,
+
+			-- Arbiter related ports
+			ARB_Slot       => ARB_Slot,
+			ARB_Qos_Data   => ARB_Qos_Data,
+			ARB_Qos_WE     => ARB_Qos_WE,
+			ARB_Qos        => ARB_Qos,
+			ARB_Bytes_Read  => ARB_Bytes_Read,
+			ARB_Bytes_Write => ARB_Bytes_Write,
 
 		
 			-- Bus protocol ports
@@ -284,6 +332,8 @@ begin
 
 	-- BEGIN GENERATE LOOP
 	PROC_Hwt_Rst_#i# <= hwt_rst(#i#);
+	hwt_osif_wait(#i#) <= PROC_Hwt_Osif_Wait_#i#;
+	hwt_memif_wait(#i#) <= PROC_Hwt_Memif_Wait_#i#;
 	-- END GENERATE LOOP
 
 end implementation;
@@ -25,7 +25,26 @@
 --                   Reg4: TLB misses - Read only
 --                   # resets
 --                   Reg5: ReconOS reset (reset everything) - Write only
---                   Reg6: HWT reset (multiple registers) - Write only
+--                   Reg6: TLB invalidate - Write only
+--                         virtual address of the page to invalidate
+--                         or 0x1 to invalidate all entries
+--                   # memory arbiter
+--                   Reg7: Slot - Read / Write
+--                         slot accessed by register 8 to 14, writing
+--                         latches the performance counters of the slot
+--                         read by register 10 to 12, unless bit 31 is
+--                         set, which selects their upper halves instead
+--                   Reg8: Arbiter QoS of slot - Read / Write
+--                         weight (7 downto 0), priority (9 downto 8)
+--                   Reg9: Arbiter transferred bytes of slot - Read only
+--                   # performance counters of slot
+--                   Reg10: Cycles out of reset (64 bit) - Read only
+--                   Reg11: Cycles waiting for the OSIF (64 bit) - Read only
+--                   Reg12: Cycles waiting for the MEMIF (64 bit) - Read only
+--                   Reg13: Bytes read from memory - Read only
+--                   Reg14: Bytes written to memory - Read only
+--                   # resets
+--                   Reg15: HWT reset (multiple registers) - Write only
 --                         | x , x-1, ... | x-32 , x-33, ... 0 |
 --
 --                   Page fault handling works the following:
@@ -67,6 +86,10 @@ entity user_logic is
 		PROC_Sys_Rst    : out std_logic;
 		PROC_Pgf_Int    : out std_logic;
 
+		-- performance counter related ports
+		PROC_Hwt_Osif_Wait  : in  std_logic_vector(C_NUM_HWTS - 1 downto 0);
+		PROC_Hwt_Memif_Wait : in  std_logic_vector(C_NUM_HWTS - 1 downto 0);
+
 		-- MMU related ports
 		MMU_Pgf         : in  std_logic;
 		MMU_Fault_Addr  : in  std_logic_vector(31 downto 0);
@@ -74,6 +97,16 @@ entity user_logic is
 		MMU_Pgd         : out std_logic_vector(31 downto 0);
 		MMU_Tlb_Hits    : in  std_logic_vector(31 downto 0);
 		MMU_Tlb_Misses  : in  std_logic_vector(31 downto 0);
+		MMU_Tlb_Inv     : out std_logic;
+		MMU_Tlb_Inv_Data : out std_logic_vector(31 downto 0);
+
+		-- Arbiter related ports
+		ARB_Slot        : out std_logic_vector(31 downto 0);
+		ARB_Qos_Data    : out std_logic_vector(31 downto 0);
+		ARB_Qos_WE      : out std_logic;
+		ARB_Qos         : in  std_logic_vector(31 downto 0);
+		ARB_Bytes_Read  : in  std_logic_vector(31 downto 0);
+		ARB_Bytes_Write : in  std_logic_vector(31 downto 0);
 
 		-- Bus protocol ports
 		Bus2IP_Clk      : in  std_logic;
@@ -112,7 +145,7 @@ architecture implementation of user_logic is
 	signal sys_reset_counter : std_logic_vector(3 downto 0);
 	
 	-- padding to fill unused resets in hwt_reset_reg
-	signal pad   : std_logic_vector(C_SLV_DWIDTH * (C_NUM_REG - 6) - C_NUM_HWTS - 1 downto 0);
+	signal pad   : std_logic_vector(C_SLV_DWIDTH * (C_NUM_REG - 15) - C_NUM_HWTS - 1 downto 0);
 
 	signal pgd                 : std_logic_vector(31 downto 0);
 	signal fault_addr          : std_logic_vector(31 downto 0);
@@ -120,8 +153,23 @@ architecture implementation of user_logic is
 	signal tlb_misses          : std_logic_vector(31 downto 0);
 	signal sys_reset           : std_logic;
 	signal hwt_reset           : std_logic_vector(C_NUM_HWTS - 1 downto 0);
-
-	signal hwt_reset_reg       : std_logic_vector((C_NUM_REG - 6) * C_SLV_DWIDTH - 1 downto 0);
+	signal arb_slot_reg        : std_logic_vector(31 downto 0);
+	signal arb_bytes           : std_logic_vector(31 downto 0);
+
+	-- performance counters of each slot, latched ones of the selected
+	-- slot and the half of them read
+	type COUNTER_ARRAY_T is array(0 to C_NUM_HWTS - 1) of std_logic_vector(63 downto 0);
+	signal perf_cycles         : COUNTER_ARRAY_T;
+	signal perf_osif_wait      : COUNTER_ARRAY_T;
+	signal perf_memif_wait     : COUNTER_ARRAY_T;
+	signal slot_cycles         : std_logic_vector(63 downto 0);
+	signal slot_osif_wait      : std_logic_vector(63 downto 0);
+	signal slot_memif_wait     : std_logic_vector(63 downto 0);
+	signal slot_cycles_rd      : std_logic_vector(31 downto 0);
+	signal slot_osif_wait_rd   : std_logic_vector(31 downto 0);
+	signal slot_memif_wait_rd  : std_logic_vector(31 downto 0);
+
+	signal hwt_reset_reg       : std_logic_vector((C_NUM_REG - 15) * C_SLV_DWIDTH - 1 downto 0);
 
 	-- Signals for user logic slave model s/w accessible register
 	signal slv_reg_write_sel   : std_logic_vector(C_NUM_REG - 1 downto 0);
@@ -164,6 +212,11 @@ begin
 
 	MMU_Pgd <= pgd;
 
+	-- bit 31 of the slot only selects the half of the counters read
+	ARB_Slot <= '0' & arb_slot_reg(30 downto 0);
+
+	arb_bytes <= ARB_Bytes_Read + ARB_Bytes_Write;
+
 
 	-- page fault handlig (for details see description above)
 	pgf_int_proc : process(clk,rst) is
@@ -206,8 +259,8 @@ begin
 		elsif rising_edge(clk) then
 			-- writing to hwt_reset
 			-- ignoring byte enable
-			for i in 0 to C_NUM_REG - 7 loop
-				if slv_reg_write_sel(C_NUM_REG - 7 - i) = '1' then
+			for i in 0 to C_NUM_REG - 16 loop
+				if slv_reg_write_sel(C_NUM_REG - 16 - i) = '1' then
 					hwt_reset_reg(32 * i + 31 downto 32 * i) <= Bus2IP_Data;
 				end if;
 			end loop;
@@ -244,6 +297,104 @@ begin
 	end process sys_reset_proc;
 
 
+	tlb_inv_proc : process(clk,rst) is
+	begin
+		if rst = '1' or sys_reset = '1' then
+			MMU_Tlb_Inv <= '0';
+			MMU_Tlb_Inv_Data <= (others => '0');
+		elsif rising_edge(clk) then
+			MMU_Tlb_Inv <= '0';
+
+			-- writing to tlb invalidate, signal the MMU for one cycle
+			if slv_reg_write_sel(C_NUM_REG - 7) = '1' then
+				MMU_Tlb_Inv <= '1';
+				MMU_Tlb_Inv_Data <= Bus2IP_Data;
+			end if;
+		end if;
+	end process tlb_inv_proc;
+
+
+	arb_proc : process(clk,rst) is
+	begin
+		if rst = '1' or sys_reset = '1' then
+			arb_slot_reg <= (others => '0');
+			ARB_Qos_WE   <= '0';
+			ARB_Qos_Data <= (others => '0');
+		elsif rising_edge(clk) then
+			ARB_Qos_WE <= '0';
+
+			if slv_reg_write_sel(C_NUM_REG - 8) = '1' then
+				arb_slot_reg <= Bus2IP_Data;
+			end if;
+
+			-- writing to arbiter qos, signal the arbiter for one cycle
+			if slv_reg_write_sel(C_NUM_REG - 9) = '1' then
+				ARB_Qos_WE <= '1';
+				ARB_Qos_Data <= Bus2IP_Data;
+			end if;
+		end if;
+	end process arb_proc;
+
+
+	-- counts the cycles each slot is out of reset and waits for the
+	-- OSIF (reads an empty sw2hw FIFO) or the MEMIF (reads an empty
+	-- mem2hwt FIFO)
+	perf_proc : process(clk,rst) is
+	begin
+		if rst = '1' or sys_reset = '1' then
+			for i in 0 to C_NUM_HWTS - 1 loop
+				perf_cycles(i)     <= (others => '0');
+				perf_osif_wait(i)  <= (others => '0');
+				perf_memif_wait(i) <= (others => '0');
+			end loop;
+		elsif rising_edge(clk) then
+			for i in 0 to C_NUM_HWTS - 1 loop
+				if hwt_reset(i) = '0' then
+					perf_cycles(i) <= perf_cycles(i) + 1;
+
+					if PROC_Hwt_Osif_Wait(i) = '1' then
+						perf_osif_wait(i) <= perf_osif_wait(i) + 1;
+					end if;
+
+					if PROC_Hwt_Memif_Wait(i) = '1' then
+						perf_memif_wait(i) <= perf_memif_wait(i) + 1;
+					end if;
+				end if;
+			end loop;
+		end if;
+	end process perf_proc;
+
+	-- latches the counters of a slot when it is selected, so that both
+	-- halves of a counter and all counters belong to the same cycle
+	perf_slot_proc : process(clk,rst) is
+		variable slot : integer range 0 to C_NUM_HWTS - 1;
+	begin
+		if rst = '1' or sys_reset = '1' then
+			slot_cycles     <= (others => '0');
+			slot_osif_wait  <= (others => '0');
+			slot_memif_wait <= (others => '0');
+		elsif rising_edge(clk) then
+			if slv_reg_write_sel(C_NUM_REG - 8) = '1' and Bus2IP_Data(31) = '0' then
+				slot_cycles     <= (others => '0');
+				slot_osif_wait  <= (others => '0');
+				slot_memif_wait <= (others => '0');
+
+				if Bus2IP_Data < C_NUM_HWTS then
+					slot := CONV_INTEGER(Bus2IP_Data(15 downto 0));
+
+					slot_cycles     <= perf_cycles(slot);
+					slot_osif_wait  <= perf_osif_wait(slot);
+					slot_memif_wait <= perf_memif_wait(slot);
+				end if;
+			end if;
+		end if;
+	end process perf_slot_proc;
+
+	slot_cycles_rd     <= slot_cycles(63 downto 32) when arb_slot_reg(31) = '1' else slot_cycles(31 downto 0);
+	slot_osif_wait_rd  <= slot_osif_wait(63 downto 32) when arb_slot_reg(31) = '1' else slot_osif_wait(31 downto 0);
+	slot_memif_wait_rd <= slot_memif_wait(63 downto 32) when arb_slot_reg(31) = '1' else slot_memif_wait(31 downto 0);
+
+
 	pgd_proc : process(clk,rst) is
 	begin
 		if rst = '1' or sys_reset = '1' then
@@ -256,14 +407,24 @@ begin
 	end process pgd_proc;
 
 
-	bus_reg_read_proc : process(slv_reg_read_sel) is
+	bus_reg_read_proc : process(slv_reg_read_sel,pgd,fault_addr,tlb_hits,tlb_misses,
+	                            arb_slot_reg,ARB_Qos,arb_bytes,slot_cycles_rd,slot_osif_wait_rd,
+	                            slot_memif_wait_rd,ARB_Bytes_Read,ARB_Bytes_Write) is
 	begin
-		case slv_reg_read_sel(C_NUM_REG - 1 downto C_NUM_REG - 6) is
-			when "100000" => slv_ip2bus_data <= CONV_STD_LOGIC_VECTOR(C_NUM_HWTS, C_SLV_DWIDTH);
-			when "010000" => slv_ip2bus_data <= pgd;
-			when "001000" => slv_ip2bus_data <= fault_addr;
-			when "000100" => slv_ip2bus_data <= tlb_hits;
-			when "000010" => slv_ip2bus_data <= tlb_misses;
+		case slv_reg_read_sel(C_NUM_REG - 1 downto C_NUM_REG - 15) is
+			when "100000000000000" => slv_ip2bus_data <= CONV_STD_LOGIC_VECTOR(C_NUM_HWTS, C_SLV_DWIDTH);
+			when "010000000000000" => slv_ip2bus_data <= pgd;
+			when "001000000000000" => slv_ip2bus_data <= fault_addr;
+			when "000100000000000" => slv_ip2bus_data <= tlb_hits;
+			when "000010000000000" => slv_ip2bus_data <= tlb_misses;
+			when "000000010000000" => slv_ip2bus_data <= arb_slot_reg;
+			when "000000001000000" => slv_ip2bus_data <= ARB_Qos;
+			when "000000000100000" => slv_ip2bus_data <= arb_bytes;
+			when "000000000010000" => slv_ip2bus_data <= slot_cycles_rd;
+			when "000000000001000" => slv_ip2bus_data <= slot_osif_wait_rd;
+			when "000000000000100" => slv_ip2bus_data <= slot_memif_wait_rd;
+			when "000000000000010" => slv_ip2bus_data <= ARB_Bytes_Read;
+			when "000000000000001" => slv_ip2bus_data <= ARB_Bytes_Write;
 			when others => slv_ip2bus_data <= (others => '0');
 		end case;
 	end process bus_reg_read_proc;
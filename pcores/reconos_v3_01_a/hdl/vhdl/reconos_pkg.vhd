@@ -32,6 +32,8 @@ package reconos_pkg is
 	-- any request will be split up in multiple requests of size C_CHUNK_SIZE (in words)
 	constant C_CHUNK_SIZE          : integer := 64;
 	constant C_CHUNK_SIZE_BYTES    : integer := C_CHUNK_SIZE * 4;
+	-- data transferred via the OSIF is split up in chunks fitting into the OSIF-FIFOs
+	constant C_OSIF_CHUNK_SIZE     : integer := 16;
 	constant C_MEMIF_LENGTH_WIDTH  : integer := 24;
 	constant C_MEMIF_CMD_WIDTH     : integer := C_MEMIF_WIDTH - C_MEMIF_LENGTH_WIDTH;
 
@@ -41,12 +43,14 @@ package reconos_pkg is
 
 	-- commands
 	constant OSIF_CMD_THREAD_GET_INIT_DATA  : std_logic_vector(C_OSIF_WIDTH - 1 downto 0) := X"000000A0";
-	constant OSIF_CMD_THREAD_DELAY          : std_logic_vector(C_OSIF_WIDTH - 1 downto 0) := X"000000A1"; -- ToDo
+	constant OSIF_CMD_THREAD_DELAY          : std_logic_vector(C_OSIF_WIDTH - 1 downto 0) := X"000000A1";
 	constant OSIF_CMD_THREAD_EXIT           : std_logic_vector(C_OSIF_WIDTH - 1 downto 0) := X"000000A2";
-	constant OSIF_CMD_THREAD_YIELD          : std_logic_vector(C_OSIF_WIDTH - 1 downto 0) := X"000000A3"; -- ToDo
+	constant OSIF_CMD_THREAD_YIELD          : std_logic_vector(C_OSIF_WIDTH - 1 downto 0) := X"000000A3";
 	constant OSIF_CMD_THREAD_RESUME         : std_logic_vector(C_OSIF_WIDTH - 1 downto 0) := X"000000A4"; -- ToDo
-	constant OSIF_CMD_THREAD_LOAD_STATE     : std_logic_vector(C_OSIF_WIDTH - 1 downto 0) := X"000000A5"; -- ToDo
-	constant OSIF_CMD_THREAD_STORE_STATE    : std_logic_vector(C_OSIF_WIDTH - 1 downto 0) := X"000000A6"; -- ToDo
+	constant OSIF_CMD_THREAD_LOAD_STATE     : std_logic_vector(C_OSIF_WIDTH - 1 downto 0) := X"000000A5";
+	constant OSIF_CMD_THREAD_STORE_STATE    : std_logic_vector(C_OSIF_WIDTH - 1 downto 0) := X"000000A6";
+	constant OSIF_CMD_TAGGED_RESULT         : std_logic_vector(C_OSIF_WIDTH - 1 downto 0) := X"000000A7";
+	constant OSIF_CMD_THREAD_GET_ERROR      : std_logic_vector(C_OSIF_WIDTH - 1 downto 0) := X"000000A8";
 
 	constant OSIF_CMD_SEM_POST              : std_logic_vector(C_OSIF_WIDTH - 1 downto 0) := X"000000B0";
 	constant OSIF_CMD_SEM_WAIT              : std_logic_vector(C_OSIF_WIDTH - 1 downto 0) := X"000000B1";
@@ -66,8 +70,26 @@ package reconos_pkg is
 	constant OSIF_CMD_MBOX_PUT              : std_logic_vector(C_OSIF_WIDTH - 1 downto 0) := X"000000F1";
 	constant OSIF_CMD_MBOX_TRYGET           : std_logic_vector(C_OSIF_WIDTH - 1 downto 0) := X"000000F2"; -- ToDo
 	constant OSIF_CMD_MBOX_TRYPUT           : std_logic_vector(C_OSIF_WIDTH - 1 downto 0) := X"000000F3"; -- ToDo
+	constant OSIF_CMD_MBOX_PUT_N            : std_logic_vector(C_OSIF_WIDTH - 1 downto 0) := X"000000F4";
+	constant OSIF_CMD_MBOX_GET_N            : std_logic_vector(C_OSIF_WIDTH - 1 downto 0) := X"000000F5";
 
 	constant OSIF_CMD_YIELD_MASK            : std_logic_vector(C_OSIF_WIDTH - 1 downto 0) := X"80000000";
+	constant OSIF_CMD_TAGGED_MASK           : std_logic_vector(C_OSIF_WIDTH - 1 downto 0) := X"40000000";
+
+	-- result of an osif call if the handle does not specify a resource of the right type,
+	-- calls returning data (e.g. mbox_get) return 0 and report it via osif_get_error
+	constant OSIF_RESULT_BAD_HANDLE         : std_logic_vector(C_OSIF_WIDTH - 1 downto 0) := X"FFFFFFFF";
+
+	-- result of storing a state if it is too long to be kept in software
+	constant OSIF_RESULT_NO_MEMORY          : std_logic_vector(C_OSIF_WIDTH - 1 downto 0) := X"FFFFFFFE";
+
+	-- errors reported via osif_get_error if a tagged call is refused since too many
+	-- tagged calls are outstanding or the call is not supported as tagged call
+	constant OSIF_RESULT_NO_TAG             : std_logic_vector(C_OSIF_WIDTH - 1 downto 0) := X"FFFFFFFD";
+	constant OSIF_RESULT_BAD_CALL           : std_logic_vector(C_OSIF_WIDTH - 1 downto 0) := X"FFFFFFFC";
+
+	-- tags of tagged calls are placed in bits 23 downto 16 of the command
+	constant C_OSIF_TAG_WIDTH       : integer := 8;
 
 
 	constant MEMIF_CMD_READ                 : std_logic_vector(C_MEMIF_CMD_WIDTH - 1 downto 0) := X"00";
@@ -473,6 +495,51 @@ package reconos_pkg is
 	);
 
 
+	-- ONLY FOR INTERNAL USE
+	--
+	-- Issues a tagged system call with one argument but does not wait for
+	-- the result. The result must be read by osif_tagged_result.
+	--
+	--   i_osif  - i_osif_t record
+	--   o_osif  - o_osif_t record
+	--   call_id - id of the system call
+	--   tag     - tag to identify the result of the system call
+	--   arg0    - argument of the system call
+	--   done    - indicates when system call was issued
+	--
+	procedure osif_call_tagged_1 (
+		signal i_osif  : in  i_osif_t;
+		signal o_osif  : out o_osif_t;
+		call_id        : in  std_logic_vector(C_OSIF_WIDTH - 1 downto 0);
+		tag            : in  std_logic_vector(C_OSIF_TAG_WIDTH - 1 downto 0);
+		arg0           : in  std_logic_vector(C_OSIF_WIDTH - 1 downto 0);
+		variable done  : out boolean
+	);
+
+	-- ONLY FOR INTERNAL USE
+	--
+	-- Issues a tagged system call with two arguments but does not wait for
+	-- the result. The result must be read by osif_tagged_result.
+	--
+	--   i_osif  - i_osif_t record
+	--   o_osif  - o_osif_t record
+	--   call_id - id of the system call
+	--   tag     - tag to identify the result of the system call
+	--   arg0    - first argument of the system call
+	--   arg1    - second argument of the system call
+	--   done    - indicates when system call was issued
+	--
+	procedure osif_call_tagged_2 (
+		signal i_osif  : in  i_osif_t;
+		signal o_osif  : out o_osif_t;
+		call_id        : in  std_logic_vector(C_OSIF_WIDTH - 1 downto 0);
+		tag            : in  std_logic_vector(C_OSIF_TAG_WIDTH - 1 downto 0);
+		arg0           : in  std_logic_vector(C_OSIF_WIDTH - 1 downto 0);
+		arg1           : in  std_logic_vector(C_OSIF_WIDTH - 1 downto 0);
+		variable done  : out boolean
+	);
+
+
 	-- osif functions
 
 	-- Yields the hardware thread slots. This causes the scheduler to be called
@@ -687,7 +754,168 @@ package reconos_pkg is
 		signal result2 : out std_logic_vector(C_OSIF_WIDTH - 1 downto 0);
 		variable done  : out boolean
 	);
+
+	-- Puts several words from the local ram into the mbox specified by
+	-- handle in a single call. Blocks until all words are stored.
+	--
+	--   i_ram  - i_ram_t record
+	--   o_ram  - o_ram_t record
+	--   i_osif - i_osif_t record
+	--   o_osif - o_osif_t record
+	--   handle - index representing the resource in the resource array
+	--   addr   - start address to read from the local ram
+	--   len    - number of words to put into the mbox
+	--   result - result of the osif call
+	--   done   - indicates when call finished
+	--
+	procedure osif_mbox_put_n (
+		signal i_ram   : in  i_ram_t;
+		signal o_ram   : out o_ram_t;
+		signal i_osif  : in  i_osif_t;
+		signal o_osif  : out o_osif_t;
+		handle         : in  std_logic_vector(C_OSIF_WIDTH - 1 downto 0);
+		addr           : in  std_logic_vector(31 downto 0);
+		len            : in  std_logic_vector(C_MEMIF_LENGTH_WIDTH - 3 downto 0);
+		signal result  : out std_logic_vector(C_OSIF_WIDTH - 1 downto 0);
+		variable done  : out boolean
+	);
+
+	-- Gets several words from the mbox specified by handle into the local
+	-- ram in a single call. Blocks until all words are read.
+	--
+	--   i_ram  - i_ram_t record
+	--   o_ram  - o_ram_t record
+	--   i_osif - i_osif_t record
+	--   o_osif - o_osif_t record
+	--   handle - index representing the resource in the resource array
+	--   addr   - start address to write into the local ram
+	--   len    - number of words to get from the mbox
+	--   result - result of the osif call
+	--   done   - indicates when call finished
+	--
+	procedure osif_mbox_get_n (
+		signal i_ram   : in  i_ram_t;
+		signal o_ram   : out o_ram_t;
+		signal i_osif  : in  i_osif_t;
+		signal o_osif  : out o_osif_t;
+		handle         : in  std_logic_vector(C_OSIF_WIDTH - 1 downto 0);
+		addr           : in  std_logic_vector(31 downto 0);
+		len            : in  std_logic_vector(C_MEMIF_LENGTH_WIDTH - 3 downto 0);
+		signal result  : out std_logic_vector(C_OSIF_WIDTH - 1 downto 0);
+		variable done  : out boolean
+	);
 	
+	-- Tagged calls allow to have multiple calls in flight, which are completed
+	-- out of order by the delegate. Each of the following procedures only
+	-- issues the call and returns immediately. The results are read by
+	-- osif_tagged_result, which requests them from the delegate. Tagged
+	-- calls do not consider the yield bit. Calls of the same kind on the same
+	-- resource (e.g. puts into one mbox) complete in the order of issue. At
+	-- most 256 calls may be outstanding, further ones are refused and
+	-- reported via osif_get_error.
+
+	-- Issues a tagged call to put a single word into the mbox.
+	--
+	--   i_osif - i_osif_t record
+	--   o_osif - o_osif_t record
+	--   handle - index representing the resource in the resource array
+	--   word   - word to write into the mbox
+	--   tag    - tag to identify the result
+	--   done   - indicates when call was issued
+	--
+	procedure osif_mbox_put_tagged (
+		signal i_osif  : in  i_osif_t;
+		signal o_osif  : out o_osif_t;
+		handle         : in  std_logic_vector(C_OSIF_WIDTH - 1 downto 0);
+		word           : in  std_logic_vector(C_OSIF_WIDTH - 1 downto 0);
+		tag            : in  std_logic_vector(C_OSIF_TAG_WIDTH - 1 downto 0);
+		variable done  : out boolean
+	);
+
+	-- Issues a tagged call to read a single word from the mbox. The word is
+	-- returned as result by osif_tagged_result.
+	--
+	--   i_osif - i_osif_t record
+	--   o_osif - o_osif_t record
+	--   handle - index representing the resource in the resource array
+	--   tag    - tag to identify the result
+	--   done   - indicates when call was issued
+	--
+	procedure osif_mbox_get_tagged (
+		signal i_osif  : in  i_osif_t;
+		signal o_osif  : out o_osif_t;
+		handle         : in  std_logic_vector(C_OSIF_WIDTH - 1 downto 0);
+		tag            : in  std_logic_vector(C_OSIF_TAG_WIDTH - 1 downto 0);
+		variable done  : out boolean
+	);
+
+	-- Issues a tagged call to post the semaphore.
+	--
+	--   i_osif - i_osif_t record
+	--   o_osif - o_osif_t record
+	--   handle - index representing the resource in the resource array
+	--   tag    - tag to identify the result
+	--   done   - indicates when call was issued
+	--
+	procedure osif_sem_post_tagged (
+		signal i_osif  : in  i_osif_t;
+		signal o_osif  : out o_osif_t;
+		handle         : in  std_logic_vector(C_OSIF_WIDTH - 1 downto 0);
+		tag            : in  std_logic_vector(C_OSIF_TAG_WIDTH - 1 downto 0);
+		variable done  : out boolean
+	);
+
+	-- Issues a tagged call to wait for the semaphore.
+	--
+	--   i_osif - i_osif_t record
+	--   o_osif - o_osif_t record
+	--   handle - index representing the resource in the resource array
+	--   tag    - tag to identify the result
+	--   done   - indicates when call was issued
+	--
+	procedure osif_sem_wait_tagged (
+		signal i_osif  : in  i_osif_t;
+		signal o_osif  : out o_osif_t;
+		handle         : in  std_logic_vector(C_OSIF_WIDTH - 1 downto 0);
+		tag            : in  std_logic_vector(C_OSIF_TAG_WIDTH - 1 downto 0);
+		variable done  : out boolean
+	);
+
+	-- Issues a tagged call to delay for a number of microseconds. The
+	-- result is returned by osif_tagged_result when the delay expired.
+	--
+	--   i_osif - i_osif_t record
+	--   o_osif - o_osif_t record
+	--   usec   - number of microseconds to delay
+	--   tag    - tag to identify the result
+	--   done   - indicates when call was issued
+	--
+	procedure osif_thread_delay_tagged (
+		signal i_osif  : in  i_osif_t;
+		signal o_osif  : out o_osif_t;
+		usec           : in  std_logic_vector(C_OSIF_WIDTH - 1 downto 0);
+		tag            : in  std_logic_vector(C_OSIF_TAG_WIDTH - 1 downto 0);
+		variable done  : out boolean
+	);
+
+	-- Requests the result of the next completed tagged call and waits for
+	-- it. The results are returned in the order of completion and not in
+	-- the order of issue.
+	--
+	--   i_osif - i_osif_t record
+	--   o_osif - o_osif_t record
+	--   tag    - tag of the completed call (in the lower bits)
+	--   result - result of the completed call
+	--   done   - indicates when result was read
+	--
+	procedure osif_tagged_result (
+		signal i_osif  : in  i_osif_t;
+		signal o_osif  : out o_osif_t;
+		signal tag     : out std_logic_vector(C_OSIF_WIDTH - 1 downto 0);
+		signal result  : out std_logic_vector(C_OSIF_WIDTH - 1 downto 0);
+		variable done  : out boolean
+	);
+
 	-- NOT IMPLEMENTED YET
 	procedure osif_rq_receive (
 		signal i_osif  : in  i_osif_t;
@@ -728,7 +956,41 @@ package reconos_pkg is
 		signal result  : out std_logic_vector(C_OSIF_WIDTH - 1 downto 0);
 		variable done  : out boolean
 	);
+
+	-- Gets the error of the last call which failed due to an invalid handle
+	-- or of the last refused tagged call and clears it. Needed for calls
+	-- returning data, where every result word is valid, and tagged calls,
+	-- which return no result if refused.
+	--
+	--   i_osif - i_osif_t record
+	--   o_osif - o_osif_t record
+	--   result - OSIF_RESULT_BAD_HANDLE, OSIF_RESULT_NO_TAG,
+	--            OSIF_RESULT_BAD_CALL or 0 if no call failed
+	--   done   - indicated when call finished
+	--
+	procedure osif_get_error (
+		signal i_osif  : in  i_osif_t;
+		signal o_osif  : out o_osif_t;
+		signal result  : out std_logic_vector(C_OSIF_WIDTH - 1 downto 0);
+		variable done  : out boolean
+	);
 	
+	-- Delays the hardware thread for a number of microseconds.
+	--
+	--   i_osif - i_osif_t record
+	--   o_osif - o_osif_t record
+	--   usec   - number of microseconds to delay
+	--   result - result of the osif call
+	--   done   - indicates when call finished
+	--
+	procedure osif_thread_delay (
+		signal i_osif  : in  i_osif_t;
+		signal o_osif  : out o_osif_t;
+		usec           : in  std_logic_vector(C_OSIF_WIDTH - 1 downto 0);
+		signal result  : out std_logic_vector(C_OSIF_WIDTH - 1 downto 0);
+		variable done  : out boolean
+	);
+
 	-- Terminates the current hardware thread and the delegate in software.
 	--
 	--   i_osif - i_osif_t record
@@ -739,6 +1001,68 @@ package reconos_pkg is
 		signal o_osif  : out o_osif_t
 	);
 
+	-- Yields the hardware thread, allowing the scheduler to preempt it. If
+	-- the thread gets preempted, it is reset and resumes in another slot
+	-- or later on. Therefore, the thread should store its state before.
+	--
+	--   i_osif - i_osif_t record
+	--   o_osif - o_osif_t record
+	--   result - result of the yield (always 0 if not preempted)
+	--   done   - indicated when call finished
+	--
+	procedure osif_thread_yield (
+		signal i_osif  : in  i_osif_t;
+		signal o_osif  : out o_osif_t;
+		signal result  : out std_logic_vector(C_OSIF_WIDTH - 1 downto 0);
+		variable done  : out boolean
+	);
+
+	-- Stores the state of the hardware thread from the local ram in
+	-- software, replacing the previously stored state.
+	--
+	--   i_ram  - i_ram_t record
+	--   o_ram  - o_ram_t record
+	--   i_osif - i_osif_t record
+	--   o_osif - o_osif_t record
+	--   addr   - start address to read from the local ram
+	--   len    - number of words to store
+	--   result - 0 on success or OSIF_RESULT_NO_MEMORY if the state was
+	--            too long, in which case no state is stored at all
+	--   done   - indicated when call finished
+	--
+	procedure osif_thread_store_state (
+		signal i_ram   : in  i_ram_t;
+		signal o_ram   : out o_ram_t;
+		signal i_osif  : in  i_osif_t;
+		signal o_osif  : out o_osif_t;
+		addr           : in  std_logic_vector(31 downto 0);
+		len            : in  std_logic_vector(C_MEMIF_LENGTH_WIDTH - 3 downto 0);
+		signal result  : out std_logic_vector(C_OSIF_WIDTH - 1 downto 0);
+		variable done  : out boolean
+	);
+
+	-- Loads the state previously stored by osif_thread_store_state into
+	-- the local ram. The state is consumed by loading it, so that len is
+	-- zero if no state was stored since the last load.
+	--
+	--   i_ram  - i_ram_t record
+	--   o_ram  - o_ram_t record
+	--   i_osif - i_osif_t record
+	--   o_osif - o_osif_t record
+	--   addr   - start address to write into the local ram
+	--   len    - number of words loaded
+	--   done   - indicated when call finished
+	--
+	procedure osif_thread_load_state (
+		signal i_ram   : in  i_ram_t;
+		signal o_ram   : out o_ram_t;
+		signal i_osif  : in  i_osif_t;
+		signal o_osif  : out o_osif_t;
+		addr           : in  std_logic_vector(31 downto 0);
+		signal len     : out std_logic_vector(C_OSIF_WIDTH - 1 downto 0);
+		variable done  : out boolean
+	);
+
 
 	-- memif functions
 
@@ -1278,6 +1602,61 @@ package body reconos_pkg is
 	end procedure osif_call_2;
 
 
+	procedure osif_call_tagged_1 (
+		signal i_osif  : in  i_osif_t;
+		signal o_osif  : out o_osif_t;
+		call_id        : in  std_logic_vector(C_OSIF_WIDTH - 1 downto 0);
+		tag            : in  std_logic_vector(C_OSIF_TAG_WIDTH - 1 downto 0);
+		arg0           : in  std_logic_vector(C_OSIF_WIDTH - 1 downto 0);
+		variable done  : out boolean
+	) is begin
+		-- set done to false, so the user does not have to care about it
+		done := False;
+		fifo_default(o_osif);
+
+		case i_osif.step is
+			when 0 =>
+				-- push call_id with tag into FIFO
+				fifo_push_word(i_osif, o_osif, call_id or OSIF_CMD_TAGGED_MASK or (X"00" & tag & X"0000"), 1);
+			when 1 =>
+				-- push arg0 into FIFO
+				fifo_push_word(i_osif, o_osif, arg0, 2);
+			when others =>
+				done := True;
+				o_osif.step <= 0;
+		end case;
+	end procedure osif_call_tagged_1;
+
+	procedure osif_call_tagged_2 (
+		signal i_osif  : in  i_osif_t;
+		signal o_osif  : out o_osif_t;
+		call_id        : in  std_logic_vector(C_OSIF_WIDTH - 1 downto 0);
+		tag            : in  std_logic_vector(C_OSIF_TAG_WIDTH - 1 downto 0);
+		arg0           : in  std_logic_vector(C_OSIF_WIDTH - 1 downto 0);
+		arg1           : in  std_logic_vector(C_OSIF_WIDTH - 1 downto 0);
+		variable done  : out boolean
+	) is begin
+		-- set done to false, so the user does not have to care about it
+		done := False;
+		fifo_default(o_osif);
+
+		case i_osif.step is
+			when 0 =>
+				-- push call_id with tag into FIFO
+				fifo_push_word(i_osif, o_osif, call_id or OSIF_CMD_TAGGED_MASK or (X"00" & tag & X"0000"), 1);
+			when 1 =>
+				-- push arg0 into FIFO
+				fifo_push_word(i_osif, o_osif, arg0, 2);
+			when 2 =>
+				-- push arg1 into FIFO
+				fifo_push_word(i_osif, o_osif, arg1, 3);
+			when others =>
+				done := True;
+				o_osif.step <= 0;
+		end case;
+	end procedure osif_call_tagged_2;
+
+
 	-- osif functions
 	procedure osif_set_yield (
 		signal i_osif  : in  i_osif_t;
@@ -1409,7 +1788,199 @@ package body reconos_pkg is
 	) is begin
 		osif_call_1_2(i_osif, o_osif, OSIF_CMD_MBOX_TRYGET, handle, result1, result2, done);
 	end procedure osif_mbox_tryget;
+
+	procedure osif_mbox_put_n (
+		signal i_ram   : in  i_ram_t;
+		signal o_ram   : out o_ram_t;
+		signal i_osif  : in  i_osif_t;
+		signal o_osif  : out o_osif_t;
+		handle         : in  std_logic_vector(C_OSIF_WIDTH - 1 downto 0);
+		addr           : in  std_logic_vector(31 downto 0);
+		len            : in  std_logic_vector(C_MEMIF_LENGTH_WIDTH - 3 downto 0);
+		signal result  : out std_logic_vector(C_OSIF_WIDTH - 1 downto 0);
+		variable done  : out boolean
+	) is begin
+		-- set done to false, so the user does not have to care about it
+		done := False;
+		fifo_default(o_osif);
+
+		case i_osif.step is
+			when 0 =>
+				o_ram.addr <= addr;
+				o_ram.remainder <= len;
+
+				o_osif.step <= 1;
+
+			when 1 =>
+				fifo_push_word(i_osif, o_osif, OSIF_CMD_MBOX_PUT_N, 2);
+
+			when 2 =>
+				fifo_push_word(i_osif, o_osif, handle, 3);
+
+			when 3 =>
+				fifo_push_word(i_osif, o_osif, X"00" & "00" & i_ram.remainder, 4);
+
+			when 4 =>
+				if i_ram.remainder = 0 then
+					o_osif.step <= 6;
+				elsif i_ram.remainder > C_OSIF_CHUNK_SIZE then
+					fifo_push(i_osif, o_osif, i_ram, o_ram, CONV_STD_LOGIC_VECTOR(C_OSIF_CHUNK_SIZE, C_MEMIF_LENGTH_WIDTH - 2), 5);
+				else
+					fifo_push(i_osif, o_osif, i_ram, o_ram, i_ram.remainder, 5);
+				end if;
+
+			when 5 =>
+				if i_ram.remainder > C_OSIF_CHUNK_SIZE then
+					o_ram.remainder <= i_ram.remainder - C_OSIF_CHUNK_SIZE;
+					o_ram.addr <= i_ram.addr + 1;
+					o_osif.step <= 4;
+				else
+					o_osif.step <= 6;
+				end if;
+
+			when 6 =>
+				fifo_pull_word(i_osif, o_osif, result, 7, False);
+
+			when others =>
+				done := True;
+				o_osif.step <= 0;
+		end case;
+	end procedure osif_mbox_put_n;
+
+	procedure osif_mbox_get_n (
+		signal i_ram   : in  i_ram_t;
+		signal o_ram   : out o_ram_t;
+		signal i_osif  : in  i_osif_t;
+		signal o_osif  : out o_osif_t;
+		handle         : in  std_logic_vector(C_OSIF_WIDTH - 1 downto 0);
+		addr           : in  std_logic_vector(31 downto 0);
+		len            : in  std_logic_vector(C_MEMIF_LENGTH_WIDTH - 3 downto 0);
+		signal result  : out std_logic_vector(C_OSIF_WIDTH - 1 downto 0);
+		variable done  : out boolean
+	) is begin
+		-- set done to false, so the user does not have to care about it
+		done := False;
+		fifo_default(o_osif);
+
+		case i_osif.step is
+			when 0 =>
+				o_ram.addr <= addr;
+				o_ram.remainder <= len;
+
+				o_osif.step <= 1;
+
+			when 1 =>
+				fifo_push_word(i_osif, o_osif, OSIF_CMD_MBOX_GET_N, 2);
+
+			when 2 =>
+				fifo_push_word(i_osif, o_osif, handle, 3);
+
+			when 3 =>
+				fifo_push_word(i_osif, o_osif, X"00" & "00" & i_ram.remainder, 4);
+
+			when 4 =>
+				if i_ram.remainder = 0 then
+					o_osif.step <= 6;
+				elsif i_ram.remainder > C_OSIF_CHUNK_SIZE then
+					fifo_pull(i_osif, o_osif, i_ram, o_ram, CONV_STD_LOGIC_VECTOR(C_OSIF_CHUNK_SIZE, C_MEMIF_LENGTH_WIDTH - 2), 5);
+				else
+					fifo_pull(i_osif, o_osif, i_ram, o_ram, i_ram.remainder, 5);
+				end if;
+
+			when 5 =>
+				if i_ram.remainder > C_OSIF_CHUNK_SIZE then
+					o_ram.remainder <= i_ram.remainder - C_OSIF_CHUNK_SIZE;
+					o_ram.addr <= i_ram.addr + 1;
+					o_osif.step <= 4;
+				else
+					o_osif.step <= 6;
+				end if;
+
+			when 6 =>
+				fifo_pull_word(i_osif, o_osif, result, 7, False);
+
+			when others =>
+				done := True;
+				o_osif.step <= 0;
+		end case;
+	end procedure osif_mbox_get_n;
 	
+	procedure osif_mbox_put_tagged (
+		signal i_osif  : in  i_osif_t;
+		signal o_osif  : out o_osif_t;
+		handle         : in  std_logic_vector(C_OSIF_WIDTH - 1 downto 0);
+		word           : in  std_logic_vector(C_OSIF_WIDTH - 1 downto 0);
+		tag            : in  std_logic_vector(C_OSIF_TAG_WIDTH - 1 downto 0);
+		variable done  : out boolean
+	) is begin
+		osif_call_tagged_2(i_osif, o_osif, OSIF_CMD_MBOX_PUT, tag, handle, word, done);
+	end procedure osif_mbox_put_tagged;
+
+	procedure osif_mbox_get_tagged (
+		signal i_osif  : in  i_osif_t;
+		signal o_osif  : out o_osif_t;
+		handle         : in  std_logic_vector(C_OSIF_WIDTH - 1 downto 0);
+		tag            : in  std_logic_vector(C_OSIF_TAG_WIDTH - 1 downto 0);
+		variable done  : out boolean
+	) is begin
+		osif_call_tagged_1(i_osif, o_osif, OSIF_CMD_MBOX_GET, tag, handle, done);
+	end procedure osif_mbox_get_tagged;
+
+	procedure osif_sem_post_tagged (
+		signal i_osif  : in  i_osif_t;
+		signal o_osif  : out o_osif_t;
+		handle         : in  std_logic_vector(C_OSIF_WIDTH - 1 downto 0);
+		tag            : in  std_logic_vector(C_OSIF_TAG_WIDTH - 1 downto 0);
+		variable done  : out boolean
+	) is begin
+		osif_call_tagged_1(i_osif, o_osif, OSIF_CMD_SEM_POST, tag, handle, done);
+	end procedure osif_sem_post_tagged;
+
+	procedure osif_sem_wait_tagged (
+		signal i_osif  : in  i_osif_t;
+		signal o_osif  : out o_osif_t;
+		handle         : in  std_logic_vector(C_OSIF_WIDTH - 1 downto 0);
+		tag            : in  std_logic_vector(C_OSIF_TAG_WIDTH - 1 downto 0);
+		variable done  : out boolean
+	) is begin
+		osif_call_tagged_1(i_osif, o_osif, OSIF_CMD_SEM_WAIT, tag, handle, done);
+	end procedure osif_sem_wait_tagged;
+
+	procedure osif_thread_delay_tagged (
+		signal i_osif  : in  i_osif_t;
+		signal o_osif  : out o_osif_t;
+		usec           : in  std_logic_vector(C_OSIF_WIDTH - 1 downto 0);
+		tag            : in  std_logic_vector(C_OSIF_TAG_WIDTH - 1 downto 0);
+		variable done  : out boolean
+	) is begin
+		osif_call_tagged_1(i_osif, o_osif, OSIF_CMD_THREAD_DELAY, tag, usec, done);
+	end procedure osif_thread_delay_tagged;
+
+	procedure osif_tagged_result (
+		signal i_osif  : in  i_osif_t;
+		signal o_osif  : out o_osif_t;
+		signal tag     : out std_logic_vector(C_OSIF_WIDTH - 1 downto 0);
+		signal result  : out std_logic_vector(C_OSIF_WIDTH - 1 downto 0);
+		variable done  : out boolean
+	) is begin
+		-- set done to false, so the user does not have to care about it
+		done := False;
+		fifo_default(o_osif);
+
+		case i_osif.step is
+			when 0 =>
+				-- request the result from the delegate
+				fifo_push_word(i_osif, o_osif, OSIF_CMD_TAGGED_RESULT, 1);
+			when 1 =>
+				fifo_pull_word(i_osif, o_osif, tag, 2, True);
+			when 2 =>
+				fifo_pull_word(i_osif, o_osif, result, 3, False);
+			when others =>
+				done := True;
+				o_osif.step <= 0;
+		end case;
+	end procedure osif_tagged_result;
+
 	procedure osif_rq_receive (
 		signal i_osif  : in  i_osif_t;
 		signal o_osif  : out o_osif_t;
@@ -1446,7 +2017,26 @@ package body reconos_pkg is
 	) is begin
 		osif_call_0(i_osif, o_osif, OSIF_CMD_THREAD_GET_INIT_DATA, result, done);
 	end procedure osif_get_init_data;
+
+	procedure osif_get_error (
+		signal i_osif  : in  i_osif_t;
+		signal o_osif  : out o_osif_t;
+		signal result  : out std_logic_vector(C_OSIF_WIDTH - 1 downto 0);
+		variable done  : out boolean
+	) is begin
+		osif_call_0(i_osif, o_osif, OSIF_CMD_THREAD_GET_ERROR, result, done);
+	end procedure osif_get_error;
 	
+	procedure osif_thread_delay (
+		signal i_osif  : in  i_osif_t;
+		signal o_osif  : out o_osif_t;
+		usec           : in  std_logic_vector(C_OSIF_WIDTH - 1 downto 0);
+		signal result  : out std_logic_vector(C_OSIF_WIDTH - 1 downto 0);
+		variable done  : out boolean
+	) is begin
+		osif_call_1(i_osif, o_osif, OSIF_CMD_THREAD_DELAY, usec, result, done);
+	end procedure osif_thread_delay;
+
 	procedure osif_thread_exit (
 		signal i_osif  : in  i_osif_t;
 		signal o_osif  : out o_osif_t
@@ -1463,6 +2053,146 @@ package body reconos_pkg is
 		end case;
 	end procedure osif_thread_exit;
 
+	procedure osif_thread_yield (
+		signal i_osif  : in  i_osif_t;
+		signal o_osif  : out o_osif_t;
+		signal result  : out std_logic_vector(C_OSIF_WIDTH - 1 downto 0);
+		variable done  : out boolean
+	) is begin
+		-- set done to false, so the user does not have to care about it
+		done := False;
+		fifo_default(o_osif);
+
+		case i_osif.step is
+			when 0 =>
+				-- always set the yield mask to invoke the scheduler
+				fifo_push_word(i_osif, o_osif, OSIF_CMD_THREAD_YIELD or OSIF_CMD_YIELD_MASK, 1);
+			when 1 =>
+				fifo_pull_word(i_osif, o_osif, result, 2, False);
+			when others =>
+				done := True;
+				o_osif.step <= 0;
+		end case;
+	end procedure osif_thread_yield;
+
+	procedure osif_thread_store_state (
+		signal i_ram   : in  i_ram_t;
+		signal o_ram   : out o_ram_t;
+		signal i_osif  : in  i_osif_t;
+		signal o_osif  : out o_osif_t;
+		addr           : in  std_logic_vector(31 downto 0);
+		len            : in  std_logic_vector(C_MEMIF_LENGTH_WIDTH - 3 downto 0);
+		signal result  : out std_logic_vector(C_OSIF_WIDTH - 1 downto 0);
+		variable done  : out boolean
+	) is begin
+		-- set done to false, so the user does not have to care about it
+		done := False;
+		fifo_default(o_osif);
+
+		case i_osif.step is
+			when 0 =>
+				o_ram.addr <= addr;
+				o_ram.remainder <= len;
+
+				o_osif.step <= 1;
+
+			when 1 =>
+				fifo_push_word(i_osif, o_osif, OSIF_CMD_THREAD_STORE_STATE, 2);
+
+			when 2 =>
+				fifo_push_word(i_osif, o_osif, X"00" & "00" & i_ram.remainder, 3);
+
+			when 3 =>
+				if i_ram.remainder = 0 then
+					o_osif.step <= 5;
+				elsif i_ram.remainder > C_OSIF_CHUNK_SIZE then
+					fifo_push(i_osif, o_osif, i_ram, o_ram, CONV_STD_LOGIC_VECTOR(C_OSIF_CHUNK_SIZE, C_MEMIF_LENGTH_WIDTH - 2), 4);
+				else
+					fifo_push(i_osif, o_osif, i_ram, o_ram, i_ram.remainder, 4);
+				end if;
+
+			when 4 =>
+				if i_ram.remainder > C_OSIF_CHUNK_SIZE then
+					o_ram.remainder <= i_ram.remainder - C_OSIF_CHUNK_SIZE;
+					o_ram.addr <= i_ram.addr + 1;
+					o_osif.step <= 3;
+				else
+					o_osif.step <= 5;
+				end if;
+
+			when 5 =>
+				fifo_pull_word(i_osif, o_osif, result, 6, False);
+
+			when others =>
+				done := True;
+				o_osif.step <= 0;
+		end case;
+	end procedure osif_thread_store_state;
+
+	procedure osif_thread_load_state (
+		signal i_ram   : in  i_ram_t;
+		signal o_ram   : out o_ram_t;
+		signal i_osif  : in  i_osif_t;
+		signal o_osif  : out o_osif_t;
+		addr           : in  std_logic_vector(31 downto 0);
+		signal len     : out std_logic_vector(C_OSIF_WIDTH - 1 downto 0);
+		variable done  : out boolean
+	) is begin
+		-- set done to false, so the user does not have to care about it
+		done := False;
+		fifo_default(o_osif);
+
+		case i_osif.step is
+			when 0 =>
+				o_ram.addr <= addr;
+
+				o_osif.step <= 1;
+
+			when 1 =>
+				fifo_push_word(i_osif, o_osif, OSIF_CMD_THREAD_LOAD_STATE, 2);
+
+			when 2 =>
+				-- the length is needed internally as well as by the user
+				o_osif.s_re <= '1';
+				if i_osif.s_empty = '0' and i_osif.s_re = '1' then
+					o_ram.remainder <= i_osif.s_data(C_MEMIF_LENGTH_WIDTH - 3 downto 0);
+					len <= i_osif.s_data;
+					o_osif.s_re <= '0';
+					o_osif.step <= 3;
+				end if;
+
+			when 3 =>
+				if i_ram.remainder = 0 then
+					o_osif.step <= 5;
+				elsif i_ram.remainder > C_OSIF_CHUNK_SIZE then
+					fifo_pull(i_osif, o_osif, i_ram, o_ram, CONV_STD_LOGIC_VECTOR(C_OSIF_CHUNK_SIZE, C_MEMIF_LENGTH_WIDTH - 2), 4);
+				else
+					fifo_pull(i_osif, o_osif, i_ram, o_ram, i_ram.remainder, 4);
+				end if;
+
+			when 4 =>
+				if i_ram.remainder > C_OSIF_CHUNK_SIZE then
+					o_ram.remainder <= i_ram.remainder - C_OSIF_CHUNK_SIZE;
+					o_ram.addr <= i_ram.addr + 1;
+					o_osif.step <= 3;
+				else
+					o_osif.step <= 5;
+				end if;
+
+			when 5 =>
+				-- the result is always 0 and can be discarded
+				o_osif.s_re <= '1';
+				if i_osif.s_empty = '0' and i_osif.s_re = '1' then
+					o_osif.s_re <= '0';
+					o_osif.step <= 6;
+				end if;
+
+			when others =>
+				done := True;
+				o_osif.step <= 0;
+		end case;
+	end procedure osif_thread_load_state;
+
 
 	--memif functions
 	procedure memif_flush (
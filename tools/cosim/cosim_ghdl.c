@@ -0,0 +1,155 @@
+/*
+ *                                                        ____  _____
+ *                            ________  _________  ____  / __ \/ ___/
+ *                           / ___/ _ \/ ___/ __ \/ __ \/ / / /\__ \
+ *                          / /  /  __/ /__/ /_/ / / / / /_/ /___/ /
+ *                         /_/   \___/\___/\____/_/ /_/\____//____/
+ *
+ * ======================================================================
+ *
+ *   title:        Co-simulation - GHDL side
+ *
+ *   project:      ReconOS
+ *   description:  Foreign functions called by reconos_cosim_pkg to
+ *                 access the shared memory segment created by the
+ *                 cosim architecture backend of the runtime.
+ *
+ * ======================================================================
+ */
+
+#include "../../lib/arch/cosim.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <signal.h>
+#include <sys/mman.h>
+
+#define COSIM_FIFO_SW2HW    0
+#define COSIM_FIFO_HW2SW    1
+#define COSIM_FIFO_HWT2MEM  2
+#define COSIM_FIFO_MEM2HWT  3
+
+static struct cosim_shm *cosim_shm;
+
+static struct cosim_fifo *cosim_fifo(int slot, int fifo) {
+	struct cosim_slot *s = &cosim_shm->slot[slot];
+
+	switch (fifo) {
+		case COSIM_FIFO_SW2HW: return &s->sw2hw;
+		case COSIM_FIFO_HW2SW: return &s->hw2sw;
+		case COSIM_FIFO_HWT2MEM: return &s->hwt2mem;
+		default: return &s->mem2hwt;
+	}
+}
+
+/*
+ * Checks if the segment was initialized by a runtime which is still
+ * alive, waiting a second for the initialization.
+ */
+static int cosim_valid() {
+	int i;
+
+	for (i = 0; i < 1000 && cosim_shm->magic != COSIM_SHM_MAGIC; i++)
+		usleep(1000);
+
+	if (cosim_shm->magic != COSIM_SHM_MAGIC)
+		return 0;
+
+	return kill(cosim_shm->pid, 0) == 0 || errno == EPERM;
+}
+
+/*
+ * Waits until the runtime has created the shared memory segment and
+ * maps it. Segments left over by a crashed runtime are skipped until
+ * the runtime is started again. Returns 0 on success.
+ */
+int cosim_attach(int slot) {
+	int fd;
+
+	fprintf(stderr, "[reconos-cosim] waiting for runtime ...\n");
+
+	while (1) {
+		fd = shm_open(COSIM_SHM_NAME, O_RDWR, 0);
+		if (fd < 0) {
+			sleep(1);
+			continue;
+		}
+
+		cosim_shm = mmap(NULL, sizeof(struct cosim_shm), PROT_READ | PROT_WRITE,
+		                 MAP_SHARED, fd, 0);
+		close(fd);
+		if (cosim_shm == MAP_FAILED) {
+			fprintf(stderr, "[reconos-cosim] unable to map shared memory\n");
+			exit(EXIT_FAILURE);
+		}
+
+		if (cosim_valid())
+			break;
+
+		munmap(cosim_shm, sizeof(struct cosim_shm));
+		sleep(1);
+	}
+
+	if (slot < 0 || slot >= cosim_shm->num_slots) {
+		fprintf(stderr, "[reconos-cosim] slot %d not provided by runtime\n", slot);
+		exit(EXIT_FAILURE);
+	}
+
+	cosim_shm->slot[slot].attached = 1;
+
+	fprintf(stderr, "[reconos-cosim] attached to slot %d\n", slot);
+
+	return 0;
+}
+
+int cosim_fill(int slot, int fifo) {
+	return cosim_fifo_fill(cosim_fifo(slot, fifo));
+}
+
+int cosim_rem(int slot, int fifo) {
+	return cosim_fifo_rem(cosim_fifo(slot, fifo));
+}
+
+int cosim_peek(int slot, int fifo) {
+	return (int)cosim_fifo_peek(cosim_fifo(slot, fifo));
+}
+
+void cosim_pop(int slot, int fifo) {
+	cosim_fifo_pop(cosim_fifo(slot, fifo));
+}
+
+void cosim_push(int slot, int fifo, int data) {
+	cosim_fifo_push(cosim_fifo(slot, fifo), (uint32_t)data);
+}
+
+/*
+ * Returns 1 while the slot is in reset. A new reset is reported for at
+ * least one cycle, even if already released by the runtime, and empties
+ * the rings consumed by the hardware thread before acknowledging it.
+ */
+int cosim_reset(int slot) {
+	struct cosim_slot *s = &cosim_shm->slot[slot];
+
+	if (s->reset_ack != s->reset_seq) {
+		s->sw2hw.rd = s->sw2hw.wr;
+		s->mem2hwt.rd = s->mem2hwt.wr;
+		__sync_synchronize();
+		s->reset_ack = s->reset_seq;
+		return 1;
+	}
+
+	return s->reset;
+}
+
+void cosim_count(int slot, int osif_wait, int memif_stall) {
+	struct cosim_slot *s = &cosim_shm->slot[slot];
+
+	s->cycles++;
+	if (osif_wait)
+		s->osif_wait_cycles++;
+	if (memif_stall)
+		s->memif_stall_cycles++;
+}
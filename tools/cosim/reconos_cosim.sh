@@ -0,0 +1,60 @@
+#!/bin/sh
+#
+#                                                        ____  _____
+#                            ________  _________  ____  / __ \/ ___/
+#                           / ___/ _ \/ ___/ __ \/ __ \/ / / /\__ \
+#                          / /  /  __/ /__/ /_/ / / / / /_/ /___/ /
+#                         /_/   \___/\___/\____/_/ /_/\____//____/
+#
+# ======================================================================
+#
+#   project:      ReconOS
+#   description:  Builds and runs a GHDL co-simulation of a hardware
+#                 thread. The software side is the unmodified
+#                 application linked against a runtime built with
+#                 RECONOS_ARCH=cosim, it must be started first:
+#
+#                   RECONOS_COSIM_SLOTS=1 ./sort_demo 1 0 4
+#                   reconos_cosim.sh hwt_sort_demo 0 hw/.../*.vhd
+#
+#                 For more slots start one simulation per slot. The
+#                 Xilinx proc_common library is taken from
+#                 $XILINX_EDK if available.
+#
+# ======================================================================
+
+set -e
+
+if [ $# -lt 3 ]
+then
+	echo "ERROR: You must specify the top entity of the HWT, the slot"
+	echo "       and the VHDL files of the HWT"
+	exit
+fi
+
+hwt=$1
+slot=$2
+shift 2
+
+cosim=${RECONOS}/tools/cosim
+work=.cosim_${hwt}
+ghdl_flags="--ieee=synopsys -fexplicit --workdir=$work -P$work"
+
+mkdir -p $work
+
+# proc_common is used by most of the HWTs
+proc_common=${XILINX_EDK}/hw/XilinxProcessorIPLib/pcores/proc_common_v3_00_a/hdl/vhdl
+if [ -f $proc_common/proc_common_pkg.vhd ]
+then
+	ghdl -a $ghdl_flags --work=proc_common_v3_00_a $proc_common/proc_common_pkg.vhd
+fi
+
+ghdl -a $ghdl_flags --work=reconos_v3_01_a ${RECONOS}/pcores/reconos_v3_01_a/hdl/vhdl/reconos_pkg.vhd
+ghdl -a $ghdl_flags "$@"
+
+# select the HWT in the testbench
+sed "s/entity work.hwt_sort_demo/entity work.$hwt/" $cosim/reconos_cosim_tb.vhd > $work/reconos_cosim_tb.vhd
+ghdl -a $ghdl_flags $cosim/reconos_cosim_pkg.vhd $work/reconos_cosim_tb.vhd
+
+ghdl -e $ghdl_flags -Wl,$cosim/cosim_ghdl.c -Wl,-lrt -o $work/reconos_cosim_tb reconos_cosim_tb
+$work/reconos_cosim_tb -gG_SLOT=$slot
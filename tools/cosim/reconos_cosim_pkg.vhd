@@ -0,0 +1,100 @@
+--                                                        ____  _____
+--                            ________  _________  ____  / __ \/ ___/
+--                           / ___/ _ \/ ___/ __ \/ __ \/ / / /\__ \
+--                          / /  /  __/ /__/ /_/ / / / / /_/ /___/ /
+--                         /_/   \___/\___/\____/_/ /_/\____//____/
+--
+-- ======================================================================
+--
+--   title:        Co-simulation package
+--
+--   project:      ReconOS
+--   description:  Foreign functions implemented in cosim_ghdl.c which
+--                 give the testbench access to the rings shared with
+--                 the cosim architecture backend of the runtime.
+--
+-- ======================================================================
+
+package reconos_cosim_pkg is
+
+	constant COSIM_FIFO_SW2HW   : integer := 0;
+	constant COSIM_FIFO_HW2SW   : integer := 1;
+	constant COSIM_FIFO_HWT2MEM : integer := 2;
+	constant COSIM_FIFO_MEM2HWT : integer := 3;
+
+	function cosim_attach (slot : integer) return integer;
+	attribute foreign of cosim_attach : function is "VHPIDIRECT cosim_attach";
+
+	function cosim_fill (slot : integer; fifo : integer) return integer;
+	attribute foreign of cosim_fill : function is "VHPIDIRECT cosim_fill";
+
+	function cosim_rem (slot : integer; fifo : integer) return integer;
+	attribute foreign of cosim_rem : function is "VHPIDIRECT cosim_rem";
+
+	function cosim_peek (slot : integer; fifo : integer) return integer;
+	attribute foreign of cosim_peek : function is "VHPIDIRECT cosim_peek";
+
+	procedure cosim_pop (slot : integer; fifo : integer);
+	attribute foreign of cosim_pop : procedure is "VHPIDIRECT cosim_pop";
+
+	procedure cosim_push (slot : integer; fifo : integer; data : integer);
+	attribute foreign of cosim_push : procedure is "VHPIDIRECT cosim_push";
+
+	function cosim_reset (slot : integer) return integer;
+	attribute foreign of cosim_reset : function is "VHPIDIRECT cosim_reset";
+
+	procedure cosim_count (slot : integer; osif_wait : integer; memif_stall : integer);
+	attribute foreign of cosim_count : procedure is "VHPIDIRECT cosim_count";
+
+end package reconos_cosim_pkg;
+
+package body reconos_cosim_pkg is
+
+	-- the bodies are never executed but required by VHDL
+
+	function cosim_attach (slot : integer) return integer is
+	begin
+		assert false report "VHPIDIRECT cosim_attach" severity failure;
+		return 0;
+	end function cosim_attach;
+
+	function cosim_fill (slot : integer; fifo : integer) return integer is
+	begin
+		assert false report "VHPIDIRECT cosim_fill" severity failure;
+		return 0;
+	end function cosim_fill;
+
+	function cosim_rem (slot : integer; fifo : integer) return integer is
+	begin
+		assert false report "VHPIDIRECT cosim_rem" severity failure;
+		return 0;
+	end function cosim_rem;
+
+	function cosim_peek (slot : integer; fifo : integer) return integer is
+	begin
+		assert false report "VHPIDIRECT cosim_peek" severity failure;
+		return 0;
+	end function cosim_peek;
+
+	procedure cosim_pop (slot : integer; fifo : integer) is
+	begin
+		assert false report "VHPIDIRECT cosim_pop" severity failure;
+	end procedure cosim_pop;
+
+	procedure cosim_push (slot : integer; fifo : integer; data : integer) is
+	begin
+		assert false report "VHPIDIRECT cosim_push" severity failure;
+	end procedure cosim_push;
+
+	function cosim_reset (slot : integer) return integer is
+	begin
+		assert false report "VHPIDIRECT cosim_reset" severity failure;
+		return 0;
+	end function cosim_reset;
+
+	procedure cosim_count (slot : integer; osif_wait : integer; memif_stall : integer) is
+	begin
+		assert false report "VHPIDIRECT cosim_count" severity failure;
+	end procedure cosim_count;
+
+end package body reconos_cosim_pkg;
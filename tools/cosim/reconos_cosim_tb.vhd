@@ -0,0 +1,208 @@
+--                                                        ____  _____
+--                            ________  _________  ____  / __ \/ ___/
+--                           / ___/ _ \/ ___/ __ \/ __ \/ / / /\__ \
+--                          / /  /  __/ /__/ /_/ / / / / /_/ /___/ /
+--                         /_/   \___/\___/\____/_/ /_/\____//____/
+--
+-- ======================================================================
+--
+--   title:        Co-simulation testbench
+--
+--   project:      ReconOS
+--   description:  Wraps a hardware thread and connects its OSIF and
+--                 MEMIF ports to the rings shared with the runtime.
+--                 The rings are modelled with the timing of
+--                 reconos_fifo: data falls through, status signals
+--                 are registered and RE/WE take effect on the rising
+--                 edge. The hardware thread is selected by
+--                 reconos_cosim.sh which replaces hwt_sort_demo below.
+--
+-- ======================================================================
+
+library ieee;
+use ieee.std_logic_1164.all;
+use ieee.std_logic_arith.all;
+use ieee.std_logic_unsigned.all;
+
+use work.reconos_cosim_pkg.all;
+
+entity reconos_cosim_tb is
+	generic (
+		G_SLOT      : integer := 0;
+		G_CLK_HALF  : time    := 5 ns
+	);
+end entity reconos_cosim_tb;
+
+architecture implementation of reconos_cosim_tb is
+	signal clk : std_logic := '0';
+	signal rst : std_logic := '1';
+
+	signal osif_sw2hw_data    : std_logic_vector(31 downto 0) := (others => '0');
+	signal osif_sw2hw_fill    : std_logic_vector(15 downto 0) := (others => '0');
+	signal osif_sw2hw_empty   : std_logic := '1';
+	signal osif_sw2hw_re      : std_logic;
+
+	signal osif_hw2sw_data    : std_logic_vector(31 downto 0);
+	signal osif_hw2sw_rem     : std_logic_vector(15 downto 0) := (others => '0');
+	signal osif_hw2sw_full    : std_logic := '1';
+	signal osif_hw2sw_we      : std_logic;
+
+	signal memif_hwt2mem_data  : std_logic_vector(31 downto 0);
+	signal memif_hwt2mem_rem   : std_logic_vector(15 downto 0) := (others => '0');
+	signal memif_hwt2mem_full  : std_logic := '1';
+	signal memif_hwt2mem_we    : std_logic;
+
+	signal memif_mem2hwt_data  : std_logic_vector(31 downto 0) := (others => '0');
+	signal memif_mem2hwt_fill  : std_logic_vector(15 downto 0) := (others => '0');
+	signal memif_mem2hwt_empty : std_logic := '1';
+	signal memif_mem2hwt_re    : std_logic;
+
+	signal debug_data : std_logic_vector(5 downto 0);
+begin
+
+	clk <= not clk after G_CLK_HALF;
+
+	hwt : entity work.hwt_sort_demo
+		port map (
+			OSIF_FIFO_Sw2Hw_Data     => osif_sw2hw_data,
+			OSIF_FIFO_Sw2Hw_Fill     => osif_sw2hw_fill,
+			OSIF_FIFO_Sw2Hw_Empty    => osif_sw2hw_empty,
+			OSIF_FIFO_Sw2Hw_RE       => osif_sw2hw_re,
+
+			OSIF_FIFO_Hw2Sw_Data     => osif_hw2sw_data,
+			OSIF_FIFO_Hw2Sw_Rem      => osif_hw2sw_rem,
+			OSIF_FIFO_Hw2Sw_Full     => osif_hw2sw_full,
+			OSIF_FIFO_Hw2Sw_WE       => osif_hw2sw_we,
+
+			MEMIF_FIFO_Hwt2Mem_Data  => memif_hwt2mem_data,
+			MEMIF_FIFO_Hwt2Mem_Rem   => memif_hwt2mem_rem,
+			MEMIF_FIFO_Hwt2Mem_Full  => memif_hwt2mem_full,
+			MEMIF_FIFO_Hwt2Mem_WE    => memif_hwt2mem_we,
+
+			MEMIF_FIFO_Mem2Hwt_Data  => memif_mem2hwt_data,
+			MEMIF_FIFO_Mem2Hwt_Fill  => memif_mem2hwt_fill,
+			MEMIF_FIFO_Mem2Hwt_Empty => memif_mem2hwt_empty,
+			MEMIF_FIFO_Mem2Hwt_RE    => memif_mem2hwt_re,
+
+			HWT_Clk    => clk,
+			HWT_Rst    => rst,
+
+			DEBUG_DATA => debug_data
+		);
+
+	-- connects the hardware thread to the shared rings
+	--
+	--   Reads and writes requested in the previous cycle are applied
+	--   first, afterwards the status seen by the hardware thread in the
+	--   next cycle is calculated from the rings.
+	--
+	cosim_proc : process is
+		variable attached    : integer;
+		variable fill, free  : integer;
+		variable osif_wait   : integer;
+		variable memif_stall : integer;
+
+		-- Fill and Rem of reconos_fifo are one less than the actual value
+		function fifo_count (count : integer) return std_logic_vector is
+		begin
+			if count > 0 then
+				return conv_std_logic_vector(count - 1, 16);
+			else
+				return X"0000";
+			end if;
+		end function fifo_count;
+	begin
+		attached := cosim_attach(G_SLOT);
+
+		loop
+			wait until rising_edge(clk);
+
+			if cosim_reset(G_SLOT) /= 0 then
+				rst <= '1';
+
+				osif_sw2hw_empty    <= '1';
+				osif_hw2sw_full     <= '1';
+				memif_hwt2mem_full  <= '1';
+				memif_mem2hwt_empty <= '1';
+			else
+				rst <= '0';
+
+				osif_wait := 0;
+				memif_stall := 0;
+
+				-- requests of the hardware thread
+				if rst = '0' then
+					if osif_sw2hw_re = '1' then
+						if osif_sw2hw_empty = '0' then
+							cosim_pop(G_SLOT, COSIM_FIFO_SW2HW);
+						else
+							osif_wait := 1;
+						end if;
+					end if;
+
+					if osif_hw2sw_we = '1' then
+						if osif_hw2sw_full = '0' then
+							cosim_push(G_SLOT, COSIM_FIFO_HW2SW, conv_integer(signed(osif_hw2sw_data)));
+						else
+							osif_wait := 1;
+						end if;
+					end if;
+
+					if memif_hwt2mem_we = '1' then
+						if memif_hwt2mem_full = '0' then
+							cosim_push(G_SLOT, COSIM_FIFO_HWT2MEM, conv_integer(signed(memif_hwt2mem_data)));
+						else
+							memif_stall := 1;
+						end if;
+					end if;
+
+					if memif_mem2hwt_re = '1' then
+						if memif_mem2hwt_empty = '0' then
+							cosim_pop(G_SLOT, COSIM_FIFO_MEM2HWT);
+						else
+							memif_stall := 1;
+						end if;
+					end if;
+
+					cosim_count(G_SLOT, osif_wait, memif_stall);
+				end if;
+
+				-- status for the next cycle
+				fill := cosim_fill(G_SLOT, COSIM_FIFO_SW2HW);
+				osif_sw2hw_fill <= fifo_count(fill);
+				if fill > 0 then
+					osif_sw2hw_empty <= '0';
+					osif_sw2hw_data  <= conv_std_logic_vector(cosim_peek(G_SLOT, COSIM_FIFO_SW2HW), 32);
+				else
+					osif_sw2hw_empty <= '1';
+				end if;
+
+				free := cosim_rem(G_SLOT, COSIM_FIFO_HW2SW);
+				osif_hw2sw_rem <= fifo_count(free);
+				if free > 0 then
+					osif_hw2sw_full <= '0';
+				else
+					osif_hw2sw_full <= '1';
+				end if;
+
+				free := cosim_rem(G_SLOT, COSIM_FIFO_HWT2MEM);
+				memif_hwt2mem_rem <= fifo_count(free);
+				if free > 0 then
+					memif_hwt2mem_full <= '0';
+				else
+					memif_hwt2mem_full <= '1';
+				end if;
+
+				fill := cosim_fill(G_SLOT, COSIM_FIFO_MEM2HWT);
+				memif_mem2hwt_fill <= fifo_count(fill);
+				if fill > 0 then
+					memif_mem2hwt_empty <= '0';
+					memif_mem2hwt_data  <= conv_std_logic_vector(cosim_peek(G_SLOT, COSIM_FIFO_MEM2HWT), 32);
+				else
+					memif_mem2hwt_empty <= '1';
+				end if;
+			end if;
+		end loop;
+	end process cosim_proc;
+
+end architecture implementation;
@@ -0,0 +1,196 @@
+#!/usr/bin/env python
+# coding: utf8
+
+#                                                        ____  _____
+#                            ________  _________  ____  / __ \/ ___/
+#                           / ___/ _ \/ ___/ __ \/ __ \/ / / /\__ \
+#                          / /  /  __/ /__/ /_/ / / / / /_/ /___/ /
+#                         /_/   \___/\___/\____/_/ /_/\____//____/
+#
+# ======================================================================
+#
+#   project:      ReconOS
+#   description:  Generates the address streams the MMU sees for the
+#                 sort and matrixmul demos, alone and running side by
+#                 side on six slots, as input for the GHDL
+#                 testbenches in this directory. The memif requests
+#                 of the hardware threads are split into chunks of
+#                 C_GRANT_SIZE and interleaved between the slots like
+#                 the arbiter does, the chunks are split into bursts
+#                 by the burst converter (at most C_MAX_BURST_SIZE, not
+#                 crossing a page). Sizes are the ones mhsaddhwts.py
+#                 generates systems with.
+#
+#                 Each line of a stream holds the virtual page of a
+#                 burst. The first line holds the number of lookups
+#                 and the hits expected from a model of the TLB with
+#                 pseudo-LRU replacement and, for comparison, with
+#                 the former round-robin replacement.
+#
+#                   gen_streams.py <tlb size> <directory>
+#
+# ======================================================================
+
+from __future__ import print_function
+
+import os
+import sys
+
+PAGE_SIZE = 4096
+GRANT_SIZE = 1024
+MAX_BURST_SIZE = 256
+
+
+def bursts(addr, length):
+	"""Splits a memif request into the bursts of the burst converter."""
+	while length > 0:
+		n = min(length, MAX_BURST_SIZE, PAGE_SIZE - addr % PAGE_SIZE)
+		yield addr
+		addr += n
+		length -= n
+
+
+def chunks(requests):
+	"""Splits the requests of a slot into the chunks of the arbiter."""
+	for addr, length in requests:
+		while length > 0:
+			n = min(length, GRANT_SIZE)
+			yield addr, n
+			addr += n
+			length -= n
+
+
+def interleave(slots):
+	"""Interleaves the chunks of the slots one by one."""
+	slots = [iter(s) for s in slots]
+	while slots:
+		for s in list(slots):
+			try:
+				yield next(s)
+			except StopIteration:
+				slots.remove(s)
+
+
+def stream(slots):
+	"""Addresses of the bursts the MMU sees for the requests of the slots."""
+	for addr, length in interleave([chunks(s) for s in slots]):
+		for a in bursts(addr, length):
+			yield a
+
+
+def sort_slot(base, blocks):
+	"""hwt_sort_demo reads a block of 8 KB, sorts it and writes it back."""
+	for block in blocks:
+		addr = base + block * 8192
+		yield addr, 8192
+		yield addr, 8192
+
+
+def sort_slots(slots=4, size=2 * 1024 * 1024):
+	base = 0x10000000
+	blocks = size // 8192
+	return [sort_slot(base, range(i, blocks, slots)) for i in range(slots)]
+
+
+def matrixmul_slot(ptr, a, b, c, jobs, line=128):
+	"""hwt_matrixmul reads the matrix pointers and B, then A by row while
+	writing C by row."""
+	for _ in range(jobs):
+		for i in range(3):
+			yield ptr + 4 * i, 4
+		yield b, 4 * line * line
+		for row in range(line):
+			yield a + 4 * line * row, 4 * line
+			yield c + 4 * line * row, 4 * line
+
+
+def matrixmul_slots(slots=2, jobs=2, line=128, base=0x10000000):
+	ptr = base + 3 * slots * 4 * line * line
+	size = 4 * line * line
+	return [matrixmul_slot(ptr + 12 * i,
+	                       base + (3 * i) * size,
+	                       base + (3 * i + 1) * size,
+	                       base + (3 * i + 2) * size,
+	                       jobs, line) for i in range(slots)]
+
+
+class PlruTlb(object):
+	"""Model of tlb.vhd, a tree based pseudo-LRU preferring invalid entries."""
+
+	def __init__(self, size):
+		self.size = size
+		self.tags = [None] * size
+		self.tree = [0] * size
+
+	def touch(self, idx):
+		node = idx + self.size
+		while node > 1:
+			self.tree[node // 2] = 1 if node % 2 == 0 else 0
+			node //= 2
+
+	def victim(self):
+		if None in self.tags:
+			return self.tags.index(None)
+		node = 1
+		while node < self.size:
+			node = 2 * node + self.tree[node]
+		return node - self.size
+
+	def lookup(self, tag):
+		if tag in self.tags:
+			self.touch(self.tags.index(tag))
+			return True
+		idx = self.victim()
+		self.tags[idx] = tag
+		self.touch(idx)
+		return False
+
+
+class RoundRobinTlb(object):
+	"""Model of the former tlb.vhd, overwriting the entries in turn."""
+
+	def __init__(self, size):
+		self.size = size
+		self.tags = [None] * size
+		self.wrptr = 0
+
+	def lookup(self, tag):
+		if tag in self.tags:
+			return True
+		self.tags[self.wrptr] = tag
+		self.wrptr = (self.wrptr + 1) % self.size
+		return False
+
+
+def write_stream(path, addrs, tlb_size):
+	pages = [a // PAGE_SIZE for a in addrs]
+	plru = PlruTlb(tlb_size)
+	rr = RoundRobinTlb(tlb_size)
+	plru_hits = sum(plru.lookup(p) for p in pages)
+	rr_hits = sum(rr.lookup(p) for p in pages)
+
+	with open(path, "w") as f:
+		f.write("%d %d %d\n" % (len(pages), plru_hits, rr_hits))
+		for p in pages:
+			f.write("%d\n" % p)
+
+
+def main():
+	if len(sys.argv) < 3:
+		print("usage: gen_streams.py <tlb size> <directory>")
+		sys.exit(1)
+
+	tlb_size = int(sys.argv[1])
+	directory = sys.argv[2]
+
+	# sort_demo on four and matrixmul on two slots at the same time, the
+	# working sets of both together exceed the TLB
+	mixed = sort_slots() + matrixmul_slots(jobs=4, base=0x20000000)
+
+	write_stream(os.path.join(directory, "sort.txt"), list(stream(sort_slots())), tlb_size)
+	write_stream(os.path.join(directory, "matrixmul.txt"), list(stream(matrixmul_slots())), tlb_size)
+	write_stream(os.path.join(directory, "mixed.txt"), list(stream(mixed)), tlb_size)
+
+
+if __name__ == "__main__":
+	main()
@@ -0,0 +1,464 @@
+--                                                        ____  _____
+--                            ________  _________  ____  / __ \/ ___/
+--                           / ___/ _ \/ ___/ __ \/ __ \/ / / /\__ \
+--                          / /  /  __/ /__/ /_/ / / / / /_/ /___/ /
+--                         /_/   \___/\___/\____/_/ /_/\____//____/
+--
+-- ======================================================================
+--
+--   title:        Testbench - MEMIF Arbiter
+--
+--   project:      ReconOS
+--   description:  Four slots issue requests of mixed size through the
+--                 arbiter (generated for four slots by preproc.py):
+--                 8 KB reads, 64 byte reads, 8 KB writes and 256 byte
+--                 writes. The memory controller is modelled
+--                 behaviourally, it fetches the next command while
+--                 transferring the data of the current one, so that
+--                 the arbiter always has a chunk pending.
+--
+--                 The test runs in three phases of G_WINDOW cycles:
+--                   1. all slots weight 1 and priority 0
+--                   2. weight 3 for the 8 KB reads
+--                   3. priority 1 for the 64 byte reads
+--                 For each phase the bytes of every slot, the
+--                 throughput and the maximum latency of a request are
+--                 reported and checked against the bounds chunking
+--                 promises. Data is checked on every word, the byte
+--                 counters of the arbiter at the end.
+--
+-- ======================================================================
+
+library ieee;
+use ieee.std_logic_1164.all;
+use ieee.std_logic_arith.all;
+use ieee.std_logic_unsigned.all;
+
+entity tb_arbiter is
+	generic (
+		G_WINDOW      : integer := 50000;
+		G_MEM_LATENCY : integer := 20;
+		G_CLK_HALF    : time    := 5 ns
+	);
+end entity tb_arbiter;
+
+architecture implementation of tb_arbiter is
+	constant C_NUM_SLOTS  : integer := 4;
+	constant C_GRANT_SIZE : integer := 1024;
+
+	type INT_ARRAY_T  is array(0 to C_NUM_SLOTS - 1) of integer;
+	type BOOL_ARRAY_T is array(0 to C_NUM_SLOTS - 1) of boolean;
+	type WORD_ARRAY_T is array(0 to C_NUM_SLOTS - 1) of std_logic_vector(31 downto 0);
+
+	-- request size and direction of the slots
+	constant C_LEN   : INT_ARRAY_T  := (8192, 64, 8192, 256);
+	constant C_WRITE : BOOL_ARRAY_T := (false, false, true, true);
+
+	signal clk   : std_logic := '0';
+	signal rst   : std_logic := '1';
+	signal done  : boolean := False;
+	signal cycle : integer := 0;
+
+	-- slots run until run is cleared, phase selects the latency to track
+	signal run   : boolean := True;
+	signal phase : integer := 1;
+	signal idle  : BOOL_ARRAY_T := (others => False);
+
+	signal h2m_data  : WORD_ARRAY_T := (others => (others => '0'));
+	signal h2m_empty : std_logic_vector(0 to C_NUM_SLOTS - 1) := (others => '1');
+	signal h2m_re    : std_logic_vector(0 to C_NUM_SLOTS - 1);
+	signal m2h_data  : WORD_ARRAY_T;
+	signal m2h_we    : std_logic_vector(0 to C_NUM_SLOTS - 1);
+
+	signal out_h2m_data  : std_logic_vector(31 downto 0);
+	signal out_h2m_fill  : std_logic_vector(15 downto 0);
+	signal out_h2m_empty : std_logic;
+	signal out_h2m_re    : std_logic := '0';
+	signal out_m2h_data  : std_logic_vector(31 downto 0) := (others => '0');
+	signal out_m2h_rem   : std_logic_vector(15 downto 0);
+	signal out_m2h_full  : std_logic;
+	signal out_m2h_we    : std_logic := '0';
+
+	signal ctrl_data  : std_logic_vector(31 downto 0);
+	signal ctrl_fill  : std_logic_vector(15 downto 0);
+	signal ctrl_empty : std_logic;
+	signal ctrl_re    : std_logic := '0';
+
+	signal arb_slot        : std_logic_vector(31 downto 0) := (others => '0');
+	signal arb_qos_data    : std_logic_vector(31 downto 0) := (others => '0');
+	signal arb_qos_we      : std_logic := '0';
+	signal arb_qos         : std_logic_vector(31 downto 0);
+	signal arb_bytes_read  : std_logic_vector(31 downto 0);
+	signal arb_bytes_write : std_logic_vector(31 downto 0);
+
+	-- results of the slots
+	signal bytes       : INT_ARRAY_T := (others => 0);
+	signal lat_max     : INT_ARRAY_T := (others => 0);
+	signal slot_errors : INT_ARRAY_T := (others => 0);
+
+	-- command fetched by the memory controller and not yet transferred
+	signal fetched     : integer := 0;
+	signal taken       : integer := 0;
+	signal next_cmd    : std_logic_vector(31 downto 0) := (others => '0');
+	signal next_addr   : std_logic_vector(31 downto 0) := (others => '0');
+	signal busy_cycles : integer := 0;
+	signal mem_errors  : integer := 0;
+begin
+
+	clk <= not clk after G_CLK_HALF when not done else clk;
+
+	cycle_proc : process(clk) is
+	begin
+		if rising_edge(clk) then
+			cycle <= cycle + 1;
+		end if;
+	end process cycle_proc;
+
+	dut : entity work.reconos_memif_arbiter
+		generic map (
+			C_NUM_HWTS           => C_NUM_SLOTS,
+			C_MEMIF_FIFO_WIDTH   => 32,
+			C_CTRL_FIFO_WIDTH    => 32,
+			C_MEMIF_LENGTH_WIDTH => 24,
+			C_GRANT_SIZE         => C_GRANT_SIZE
+		)
+		port map (
+			MEMIF_FIFO_In_Hwt2Mem_Data_0  => h2m_data(0),
+			MEMIF_FIFO_In_Hwt2Mem_Fill_0  => X"0000",
+			MEMIF_FIFO_In_Hwt2Mem_Empty_0 => h2m_empty(0),
+			MEMIF_FIFO_In_Hwt2Mem_RE_0    => h2m_re(0),
+			MEMIF_FIFO_In_Mem2Hwt_Data_0  => m2h_data(0),
+			MEMIF_FIFO_In_Mem2Hwt_Rem_0   => X"07FF",
+			MEMIF_FIFO_In_Mem2Hwt_Full_0  => '0',
+			MEMIF_FIFO_In_Mem2Hwt_WE_0    => m2h_we(0),
+
+			MEMIF_FIFO_In_Hwt2Mem_Data_1  => h2m_data(1),
+			MEMIF_FIFO_In_Hwt2Mem_Fill_1  => X"0000",
+			MEMIF_FIFO_In_Hwt2Mem_Empty_1 => h2m_empty(1),
+			MEMIF_FIFO_In_Hwt2Mem_RE_1    => h2m_re(1),
+			MEMIF_FIFO_In_Mem2Hwt_Data_1  => m2h_data(1),
+			MEMIF_FIFO_In_Mem2Hwt_Rem_1   => X"07FF",
+			MEMIF_FIFO_In_Mem2Hwt_Full_1  => '0',
+			MEMIF_FIFO_In_Mem2Hwt_WE_1    => m2h_we(1),
+
+			MEMIF_FIFO_In_Hwt2Mem_Data_2  => h2m_data(2),
+			MEMIF_FIFO_In_Hwt2Mem_Fill_2  => X"0000",
+			MEMIF_FIFO_In_Hwt2Mem_Empty_2 => h2m_empty(2),
+			MEMIF_FIFO_In_Hwt2Mem_RE_2    => h2m_re(2),
+			MEMIF_FIFO_In_Mem2Hwt_Data_2  => m2h_data(2),
+			MEMIF_FIFO_In_Mem2Hwt_Rem_2   => X"07FF",
+			MEMIF_FIFO_In_Mem2Hwt_Full_2  => '0',
+			MEMIF_FIFO_In_Mem2Hwt_WE_2    => m2h_we(2),
+
+			MEMIF_FIFO_In_Hwt2Mem_Data_3  => h2m_data(3),
+			MEMIF_FIFO_In_Hwt2Mem_Fill_3  => X"0000",
+			MEMIF_FIFO_In_Hwt2Mem_Empty_3 => h2m_empty(3),
+			MEMIF_FIFO_In_Hwt2Mem_RE_3    => h2m_re(3),
+			MEMIF_FIFO_In_Mem2Hwt_Data_3  => m2h_data(3),
+			MEMIF_FIFO_In_Mem2Hwt_Rem_3   => X"07FF",
+			MEMIF_FIFO_In_Mem2Hwt_Full_3  => '0',
+			MEMIF_FIFO_In_Mem2Hwt_WE_3    => m2h_we(3),
+
+			MEMIF_FIFO_Out_Hwt2Mem_Data  => out_h2m_data,
+			MEMIF_FIFO_Out_Hwt2Mem_Fill  => out_h2m_fill,
+			MEMIF_FIFO_Out_Hwt2Mem_Empty => out_h2m_empty,
+			MEMIF_FIFO_Out_Hwt2Mem_RE    => out_h2m_re,
+
+			MEMIF_FIFO_Out_Mem2Hwt_Data  => out_m2h_data,
+			MEMIF_FIFO_Out_Mem2Hwt_Rem   => out_m2h_rem,
+			MEMIF_FIFO_Out_Mem2Hwt_Full  => out_m2h_full,
+			MEMIF_FIFO_Out_Mem2Hwt_WE    => out_m2h_we,
+
+			CTRL_FIFO_Out_Data  => ctrl_data,
+			CTRL_FIFO_Out_Fill  => ctrl_fill,
+			CTRL_FIFO_Out_Empty => ctrl_empty,
+			CTRL_FIFO_Out_RE    => ctrl_re,
+
+			ARB_Slot        => arb_slot,
+			ARB_Qos_Data    => arb_qos_data,
+			ARB_Qos_WE      => arb_qos_we,
+			ARB_Qos         => arb_qos,
+			ARB_Bytes_Read  => arb_bytes_read,
+			ARB_Bytes_Write => arb_bytes_write,
+
+			TCTRL_Clk => clk,
+			TCTRL_Rst => rst
+		);
+
+	-- hardware threads, one request at a time like memif_read and
+	-- memif_write, the data of a word is its address
+	slot_gen : for i in 0 to C_NUM_SLOTS - 1 generate
+		slot_proc : process is
+			variable addr, word       : std_logic_vector(31 downto 0);
+			variable start, lat, max  : integer;
+			variable cur_phase        : integer;
+			variable cmd              : std_logic_vector(7 downto 0);
+
+			procedure push (data : in std_logic_vector(31 downto 0)) is
+			begin
+				h2m_data(i)  <= data;
+				h2m_empty(i) <= '0';
+				wait until rising_edge(clk) and h2m_re(i) = '1';
+			end procedure push;
+		begin
+			addr := conv_std_logic_vector(i * 16#01000000#, 32);
+			max := 0;
+			cur_phase := 1;
+
+			if C_WRITE(i) then
+				cmd := X"F0";
+			else
+				cmd := X"00";
+			end if;
+
+			wait until falling_edge(clk) and rst = '0';
+
+			while run loop
+				if phase /= cur_phase then
+					cur_phase := phase;
+					max := 0;
+				end if;
+
+				start := cycle;
+				push(cmd & conv_std_logic_vector(C_LEN(i), 24));
+				push(addr);
+
+				if C_WRITE(i) then
+					for w in 0 to C_LEN(i) / 4 - 1 loop
+						push(addr + conv_std_logic_vector(4 * w, 32));
+						bytes(i) <= bytes(i) + 4;
+					end loop;
+					h2m_empty(i) <= '1';
+				else
+					h2m_empty(i) <= '1';
+					for w in 0 to C_LEN(i) / 4 - 1 loop
+						wait until rising_edge(clk) and m2h_we(i) = '1';
+						word := m2h_data(i);
+						if word /= addr + conv_std_logic_vector(4 * w, 32) then
+							report "slot " & integer'image(i) & ": wrong data" severity error;
+							slot_errors(i) <= slot_errors(i) + 1;
+						end if;
+						bytes(i) <= bytes(i) + 4;
+					end loop;
+				end if;
+
+				lat := cycle - start;
+				if lat > max then
+					max := lat;
+				end if;
+				lat_max(i)  <= max;
+
+				addr := addr + conv_std_logic_vector(C_LEN(i), 32);
+				addr(23 downto 20) := X"0";
+
+				wait until falling_edge(clk);
+			end loop;
+
+			idle(i) <= True;
+			wait;
+		end process slot_proc;
+	end generate slot_gen;
+
+	-- fetch of the memory controller, reads the next command while the
+	-- current one is transferred
+	fetch_proc : process is
+		variable cmd : std_logic_vector(31 downto 0);
+	begin
+		loop
+			wait until falling_edge(clk);
+
+			if ctrl_empty = '0' and fetched = taken then
+				ctrl_re <= '1';
+				wait until rising_edge(clk);
+				cmd := ctrl_data;
+				wait until rising_edge(clk);
+				next_addr <= ctrl_data;
+				next_cmd  <= cmd;
+				fetched   <= fetched + 1;
+				wait until falling_edge(clk);
+				ctrl_re <= '0';
+			end if;
+		end loop;
+	end process fetch_proc;
+
+	-- transfer of the memory controller, one word per cycle after
+	-- G_MEM_LATENCY cycles
+	xfer_proc : process is
+		variable cmd, addr : std_logic_vector(31 downto 0);
+		variable words, w  : integer;
+	begin
+		loop
+			wait until falling_edge(clk);
+
+			if fetched /= taken then
+				cmd  := next_cmd;
+				addr := next_addr;
+				taken <= taken + 1;
+
+				words := conv_integer(cmd(23 downto 0)) / 4;
+				for k in 1 to G_MEM_LATENCY loop
+					wait until falling_edge(clk);
+				end loop;
+
+				w := 0;
+				while w < words loop
+					if cmd(31) = '1' then
+						out_h2m_re <= not out_h2m_empty;
+					else
+						out_m2h_we   <= not out_m2h_full;
+						out_m2h_data <= addr + conv_std_logic_vector(4 * w, 32);
+					end if;
+
+					wait until rising_edge(clk);
+					if cmd(31) = '1' and out_h2m_re = '1' then
+						if out_h2m_data /= addr + conv_std_logic_vector(4 * w, 32) then
+							report "wrong data written" severity error;
+							mem_errors <= mem_errors + 1;
+						end if;
+						w := w + 1;
+						busy_cycles <= busy_cycles + 1;
+					elsif cmd(31) = '0' and out_m2h_we = '1' then
+						w := w + 1;
+						busy_cycles <= busy_cycles + 1;
+					end if;
+
+					wait until falling_edge(clk);
+					out_h2m_re <= '0';
+					out_m2h_we <= '0';
+				end loop;
+			end if;
+		end loop;
+	end process xfer_proc;
+
+	stim_proc : process is
+		variable start_bytes : INT_ARRAY_T;
+		variable start, start_busy, total, errors : integer;
+		variable res : INT_ARRAY_T;
+
+		procedure set_qos (slot : in integer; weight : in integer; prio : in integer) is
+		begin
+			wait until falling_edge(clk);
+			arb_slot     <= conv_std_logic_vector(slot, 32);
+			arb_qos_data <= conv_std_logic_vector(prio, 24) & conv_std_logic_vector(weight, 8);
+			arb_qos_we   <= '1';
+			wait until falling_edge(clk);
+			arb_qos_we   <= '0';
+			wait until falling_edge(clk);
+
+			if conv_integer(arb_qos(7 downto 0)) /= weight or conv_integer(arb_qos(9 downto 8)) /= prio then
+				report "wrong quality of service read back" severity error;
+				errors := errors + 1;
+			end if;
+		end procedure set_qos;
+
+		procedure check (cond : in boolean; msg : in string) is
+		begin
+			if not cond then
+				report msg severity error;
+				errors := errors + 1;
+			end if;
+		end procedure check;
+
+		-- runs a phase and reports its results, res holds the bytes
+		procedure measure is
+		begin
+			start := cycle;
+			start_busy := busy_cycles;
+			start_bytes := bytes;
+
+			for k in 1 to G_WINDOW loop
+				wait until rising_edge(clk);
+			end loop;
+
+			total := 0;
+			for i in 0 to C_NUM_SLOTS - 1 loop
+				res(i) := bytes(i) - start_bytes(i);
+				total := total + res(i);
+				report "phase " & integer'image(phase) & ", slot " & integer'image(i)
+				       & " (" & integer'image(C_LEN(i)) & " byte): "
+				       & integer'image(res(i)) & " bytes, max latency "
+				       & integer'image(lat_max(i)) & " cycles";
+			end loop;
+
+			report "phase " & integer'image(phase) & ": " & integer'image(total) & " bytes in "
+			       & integer'image(cycle - start) & " cycles, memory busy "
+			       & integer'image(100 * (busy_cycles - start_busy) / (cycle - start)) & "%";
+
+			for i in 0 to C_NUM_SLOTS - 1 loop
+				check(res(i) > 0, "slot " & integer'image(i) & " starved");
+			end loop;
+		end procedure measure;
+
+		-- cycles a chunk of the given size occupies the memory
+		function chunk_cycles (len : integer) return integer is
+		begin
+			return G_MEM_LATENCY + len / 4 + 8;
+		end function chunk_cycles;
+	begin
+		errors := 0;
+
+		wait for 4 * G_CLK_HALF;
+		wait until falling_edge(clk);
+		rst <= '0';
+
+		-- 1. round robin, a small request waits for the chunks
+		--    transferred and pending and one turn of every other slot,
+		--    which is less than a single 8 KB request without chunking
+		measure;
+		check(4 * res(0) >= 3 * res(2) and 4 * res(2) >= 3 * res(0),
+		      "8 KB reads and writes not served alike");
+		check(lat_max(1) <= 5 * chunk_cycles(C_GRANT_SIZE) + chunk_cycles(64),
+		      "small request waited for more than one turn");
+
+		-- 2. weight 3 for the 8 KB reads
+		set_qos(0, 3, 0);
+		phase <= 2;
+		measure;
+		check(4 * res(0) >= 9 * res(2) and 4 * res(0) <= 15 * res(2),
+		      "bytes do not follow the weights");
+
+		-- 3. priority for the small reads, they wait for the chunks
+		--    transferred and pending and the one being calculated only
+		set_qos(0, 1, 0);
+		set_qos(1, 1, 1);
+		phase <= 3;
+		measure;
+		check(lat_max(1) <= 3 * chunk_cycles(C_GRANT_SIZE) + chunk_cycles(64),
+		      "request with priority not served first");
+
+		-- the byte counters of the arbiter match the slots
+		run <= False;
+		for i in 0 to C_NUM_SLOTS - 1 loop
+			while not idle(i) loop
+				wait until rising_edge(clk);
+			end loop;
+		end loop;
+
+		for i in 0 to C_NUM_SLOTS - 1 loop
+			wait until falling_edge(clk);
+			arb_slot <= conv_std_logic_vector(i, 32);
+			wait until falling_edge(clk);
+
+			if C_WRITE(i) then
+				check(conv_integer(arb_bytes_write(30 downto 0)) = bytes(i) and conv_integer(arb_bytes_read(30 downto 0)) = 0,
+				      "wrong byte counters of slot " & integer'image(i));
+			else
+				check(conv_integer(arb_bytes_read(30 downto 0)) = bytes(i) and conv_integer(arb_bytes_write(30 downto 0)) = 0,
+				      "wrong byte counters of slot " & integer'image(i));
+			end if;
+
+			errors := errors + slot_errors(i);
+		end loop;
+
+		errors := errors + mem_errors;
+		if errors = 0 then
+			report "tb_arbiter: PASSED";
+		else
+			report "tb_arbiter: FAILED (" & integer'image(errors) & " errors)" severity failure;
+		end if;
+
+		done <= True;
+		wait;
+	end process stim_proc;
+
+end architecture implementation;
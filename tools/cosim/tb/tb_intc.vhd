@@ -0,0 +1,347 @@
+--                                                        ____  _____
+--                            ________  _________  ____  / __ \/ ___/
+--                           / ___/ _ \/ ___/ __ \/ __ \/ / / /\__ \
+--                          / /  /  __/ /__/ /_/ / / / / /_/ /___/ /
+--                         /_/   \___/\___/\____/_/ /_/\____//____/
+--
+-- ======================================================================
+--
+--   title:        Testbench - OSIF interrupt controller
+--
+--   project:      ReconOS
+--   description:  Checks the interrupt coalescing of the OSIF interrupt
+--                 controller and measures the interrupt rate it saves.
+--
+--                 First the threshold, the timeout and the masking are
+--                 checked directly. Afterwards G_NUM_HWTS threads raise
+--                 their OSIF input G_REQUESTS times each, and the
+--                 processor handles the interrupt like osif.c: after
+--                 G_IRQ_LATENCY cycles it reads the pending inputs,
+--                 disables them, lets the delegates drain them in
+--                 G_SERVICE cycles each and enables them again. This is
+--                 repeated without coalescing, with a threshold and a
+--                 timeout and with a timeout only. The coalesced runs
+--                 must take fewer interrupts and no request may wait
+--                 longer than the timeout plus two handler runs.
+--
+-- ======================================================================
+
+library ieee;
+use ieee.std_logic_1164.all;
+use ieee.std_logic_arith.all;
+use ieee.std_logic_unsigned.all;
+
+library reconos_osif_intc_v1_00_a;
+
+entity tb_intc is
+	generic (
+		G_NUM_HWTS    : integer := 8;
+		G_REQUESTS    : integer := 64;
+		G_IRQ_LATENCY : integer := 100;
+		G_SERVICE     : integer := 20;
+		G_CLK_HALF    : time    := 5 ns
+	);
+end entity tb_intc;
+
+architecture implementation of tb_intc is
+	-- interrupt, threshold and timeout register
+	constant C_NUM_REG : integer := 3;
+
+	type INT_ARRAY_T is array(0 to G_NUM_HWTS - 1) of integer;
+
+	signal clk   : std_logic := '0';
+	signal rstn  : std_logic := '0';
+	signal done  : boolean := False;
+	signal cycle : integer := 0;
+
+	signal intc_in  : std_logic_vector(G_NUM_HWTS - 1 downto 0);
+	signal intc_out : std_logic;
+
+	signal bus_data  : std_logic_vector(31 downto 0) := (others => '0');
+	signal bus_rdce  : std_logic_vector(C_NUM_REG - 1 downto 0) := (others => '0');
+	signal bus_wrce  : std_logic_vector(C_NUM_REG - 1 downto 0) := (others => '0');
+	signal bus_rd    : std_logic_vector(31 downto 0);
+	signal bus_rdack : std_logic;
+	signal bus_wrack : std_logic;
+	signal bus_error : std_logic;
+
+	-- inputs raised directly by the stimulus and by the threads
+	signal force_in : std_logic_vector(G_NUM_HWTS - 1 downto 0) := (others => '0');
+	signal hwt_in   : std_logic_vector(G_NUM_HWTS - 1 downto 0) := (others => '0');
+
+	-- run of the threads started by the stimulus
+	signal go         : integer := 0;
+	signal hwt_done   : INT_ARRAY_T := (others => 0);
+	signal pend_since : INT_ARRAY_T := (others => 0);
+	signal drain      : std_logic_vector(G_NUM_HWTS - 1 downto 0) := (others => '0');
+begin
+
+	clk <= not clk after G_CLK_HALF when not done else clk;
+
+	intc_in <= hwt_in or force_in;
+
+	cycle_proc : process(clk) is
+	begin
+		if rising_edge(clk) then
+			cycle <= cycle + 1;
+		end if;
+	end process cycle_proc;
+
+	dut : entity reconos_osif_intc_v1_00_a.user_logic
+		generic map (
+			C_NUM_INTERRUPTS => G_NUM_HWTS,
+			C_NUM_REG        => C_NUM_REG,
+			C_SLV_DWIDTH     => 32
+		)
+		port map (
+			OSIF_INTC_Rst => '0',
+
+			OSIF_INTC_in  => intc_in,
+			OSIF_INTC_out => intc_out,
+
+			Bus2IP_Clk    => clk,
+			Bus2IP_Resetn => rstn,
+			Bus2IP_Data   => bus_data,
+			Bus2IP_BE     => X"F",
+			Bus2IP_RdCE   => bus_rdce,
+			Bus2IP_WrCE   => bus_wrce,
+			IP2Bus_Data   => bus_rd,
+			IP2Bus_RdAck  => bus_rdack,
+			IP2Bus_WrAck  => bus_wrack,
+			IP2Bus_Error  => bus_error
+		);
+
+	-- hardware threads, each raises its input after some computation
+	-- and waits until the delegate drained the OSIF
+	hwt_gen : for i in 0 to G_NUM_HWTS - 1 generate
+		hwt_proc : process is
+		begin
+			loop
+				wait until go > hwt_done(i);
+
+				for r in 0 to G_REQUESTS - 1 loop
+					for k in 1 to 40 + (i * 53 + r * 29) mod 200 loop
+						wait until falling_edge(clk);
+					end loop;
+
+					hwt_in(i)     <= '1';
+					pend_since(i) <= cycle;
+					wait until rising_edge(clk) and drain(i) = '1';
+					hwt_in(i)     <= '0';
+				end loop;
+
+				hwt_done(i) <= go;
+			end loop;
+		end process hwt_proc;
+	end generate hwt_gen;
+
+	stim_proc : process is
+		variable errors, irqs, served, lat, lat_max, n : integer;
+		variable data, pending, enable                 : std_logic_vector(31 downto 0);
+		variable irqs_base                             : integer;
+
+		procedure write_reg (reg : in integer; value : in std_logic_vector(31 downto 0)) is
+		begin
+			wait until falling_edge(clk);
+			bus_data <= value;
+			bus_wrce(C_NUM_REG - 1 - reg) <= '1';
+			wait until falling_edge(clk);
+			bus_wrce <= (others => '0');
+		end procedure write_reg;
+
+		procedure read_reg (reg : in integer; value : out std_logic_vector(31 downto 0)) is
+		begin
+			wait until falling_edge(clk);
+			bus_rdce(C_NUM_REG - 1 - reg) <= '1';
+			wait until rising_edge(clk);
+			value := bus_rd;
+			wait until falling_edge(clk);
+			bus_rdce <= (others => '0');
+		end procedure read_reg;
+
+		procedure check (cond : in boolean; msg : in string) is
+		begin
+			if not cond then
+				report msg severity error;
+				errors := errors + 1;
+			end if;
+		end procedure check;
+
+		-- cycles until the interrupt is raised, at most limit
+		procedure raise_time (limit : in integer; cycles : out integer) is
+		begin
+			cycles := 0;
+			while intc_out = '0' and cycles < limit loop
+				wait until rising_edge(clk);
+				wait until falling_edge(clk);
+				cycles := cycles + 1;
+			end loop;
+		end procedure raise_time;
+
+		-- runs the threads and handles their interrupts like osif.c
+		procedure measure (threshold, timeout : in integer; name : in string) is
+			variable start : integer;
+		begin
+			write_reg(1, conv_std_logic_vector(threshold, 32));
+			write_reg(2, conv_std_logic_vector(timeout, 32));
+			enable := conv_std_logic_vector(2 ** G_NUM_HWTS - 1, 32);
+			write_reg(0, enable);
+
+			irqs    := 0;
+			served  := 0;
+			lat_max := 0;
+			start   := cycle;
+			go <= go + 1;
+			wait until falling_edge(clk);
+
+			while served < G_NUM_HWTS * G_REQUESTS loop
+				wait until falling_edge(clk);
+
+				if intc_out = '1' then
+					irqs := irqs + 1;
+					for k in 1 to G_IRQ_LATENCY loop
+						wait until falling_edge(clk);
+					end loop;
+
+					read_reg(0, pending);
+					pending := pending and enable;
+					enable  := enable and not pending;
+					write_reg(0, enable);
+
+					for i in 0 to G_NUM_HWTS - 1 loop
+						if pending(i) = '1' then
+							for k in 1 to G_SERVICE loop
+								wait until falling_edge(clk);
+							end loop;
+
+							lat := cycle - pend_since(i);
+							if lat > lat_max then
+								lat_max := lat;
+							end if;
+
+							drain(i) <= '1';
+							wait until falling_edge(clk);
+							drain(i) <= '0';
+							served := served + 1;
+						end if;
+					end loop;
+
+					-- the delegates wait for the next request
+					enable := conv_std_logic_vector(2 ** G_NUM_HWTS - 1, 32);
+					write_reg(0, enable);
+				end if;
+			end loop;
+
+			for i in 0 to G_NUM_HWTS - 1 loop
+				while hwt_done(i) /= go loop
+					wait until falling_edge(clk);
+				end loop;
+			end loop;
+
+			report name & ": " & integer'image(served) & " requests, " & integer'image(irqs)
+			       & " interrupts (" & integer'image(100 * served / irqs) & " requests per 100 interrupts), "
+			       & integer'image(cycle - start) & " cycles, maximum latency "
+			       & integer'image(lat_max) & " cycles";
+
+			check(lat_max <= timeout + 2 * (G_IRQ_LATENCY + G_NUM_HWTS * (G_SERVICE + 1) + 8),
+			      name & ": request waited too long");
+		end procedure measure;
+	begin
+		errors := 0;
+
+		wait for 4 * G_CLK_HALF;
+		wait until falling_edge(clk);
+		rstn <= '1';
+
+		-- reset values keep the interrupt uncoalesced
+		read_reg(1, data);
+		check(data = 1, "threshold is not 1 after reset");
+		read_reg(2, data);
+		check(data = 0, "timeout is not 0 after reset");
+
+		write_reg(1, X"00000003");
+		write_reg(2, X"00000040");
+		read_reg(1, data);
+		check(data = 3, "threshold not written");
+		read_reg(2, data);
+		check(data = 64, "timeout not written");
+
+		-- a disabled input is ignored
+		write_reg(1, X"00000001");
+		write_reg(2, X"00000000");
+		write_reg(0, X"00000001");
+		force_in(1) <= '1';
+		raise_time(50, n);
+		check(n = 50, "interrupt raised by a disabled input");
+		read_reg(0, data);
+		check(data = 0, "disabled input reported as pending");
+
+		-- without coalescing the interrupt follows the input
+		force_in(0) <= '1';
+		raise_time(50, n);
+		check(n = 1, "interrupt not raised in the next cycle");
+		read_reg(0, data);
+		check(data = 1, "pending input not reported");
+		force_in <= (others => '0');
+		wait until rising_edge(clk);
+		wait until falling_edge(clk);
+		check(intc_out = '0', "interrupt not released without pending input");
+
+		-- the threshold waits for enough pending inputs
+		write_reg(0, X"000000FF");
+		write_reg(1, X"00000003");
+		force_in(1 downto 0) <= "11";
+		raise_time(100, n);
+		check(n = 100, "interrupt raised below the threshold");
+		force_in(2) <= '1';
+		raise_time(100, n);
+		check(n = 1, "interrupt not raised at the threshold");
+
+		-- and stays raised until no input is pending
+		force_in(0) <= '0';
+		wait until rising_edge(clk);
+		wait until falling_edge(clk);
+		check(intc_out = '1', "interrupt released with pending inputs");
+		force_in(2 downto 1) <= "00";
+		wait until rising_edge(clk);
+		wait until falling_edge(clk);
+		check(intc_out = '0', "interrupt not released without pending input");
+
+		-- the timeout raises a single pending input
+		write_reg(1, conv_std_logic_vector(G_NUM_HWTS + 1, 32));
+		write_reg(2, X"00000032");
+		force_in(5) <= '1';
+		raise_time(100, n);
+		check(n = 50, "interrupt raised after " & integer'image(n) & " instead of 50 cycles");
+		force_in(5) <= '0';
+		wait until rising_edge(clk);
+		wait until falling_edge(clk);
+
+		-- the timer restarts once no input is pending
+		force_in(5) <= '1';
+		raise_time(100, n);
+		check(n = 50, "timer not restarted");
+		force_in(5) <= '0';
+		write_reg(0, X"00000000");
+
+		-- interrupt rate of the threads
+		measure(1, 0, "uncoalesced");
+		irqs_base := irqs;
+
+		measure(G_NUM_HWTS / 2, 256, "threshold " & integer'image(G_NUM_HWTS / 2) & ", timeout 256");
+		check(irqs < irqs_base, "threshold and timeout do not reduce the interrupts");
+
+		measure(G_NUM_HWTS + 1, 128, "timeout 128");
+		check(irqs < irqs_base, "timeout does not reduce the interrupts");
+
+		if errors = 0 then
+			report "tb_intc: PASSED";
+		else
+			report "tb_intc: FAILED (" & integer'image(errors) & " errors)" severity failure;
+		end if;
+
+		done <= True;
+		wait;
+	end process stim_proc;
+
+end architecture implementation;
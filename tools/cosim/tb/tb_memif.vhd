@@ -0,0 +1,555 @@
+--                                                        ____  _____
+--                            ________  _________  ____  / __ \/ ___/
+--                           / ___/ _ \/ ___/ __ \/ __ \/ / / /\__ \
+--                          / /  /  __/ /__/ /_/ / / / / /_/ /___/ /
+--                         /_/   \___/\___/\____/_/ /_/\____//____/
+--
+-- ======================================================================
+--
+--   title:        Testbench - MEMIF bandwidth
+--
+--   project:      ReconOS
+--   description:  Measures the bandwidth of the memory subsystem without
+--                 MMU, arbiter, burst converter and memory controller,
+--                 for requests from 16 byte to 8 KB. Two slots issue
+--                 requests of the same size one at a time, first reads
+--                 and then writes. The IPIC of axi_master_burst is
+--                 modelled behaviourally: a command is acknowledged
+--                 after G_CMD_LATENCY cycles, read data follows after
+--                 G_RD_LATENCY cycles and a write completes
+--                 G_WR_LATENCY cycles after its last word, one command
+--                 at a time.
+--
+--                 The bandwidth must not drop with growing requests.
+--                 Every bus command is checked to not exceed
+--                 C_MAX_BURST_SIZE and to not cross a page, every word
+--                 to carry its address.
+--
+-- ======================================================================
+
+library ieee;
+use ieee.std_logic_1164.all;
+use ieee.std_logic_arith.all;
+use ieee.std_logic_unsigned.all;
+
+library reconos_memif_memory_controller_v1_00_a;
+
+entity tb_memif is
+	generic (
+		G_BYTES       : integer := 32768;
+		G_MAX_BURST   : integer := 256;
+		G_CMD_LATENCY : integer := 4;
+		G_RD_LATENCY  : integer := 16;
+		G_WR_LATENCY  : integer := 8;
+		G_CLK_HALF    : time    := 5 ns
+	);
+end entity tb_memif;
+
+architecture implementation of tb_memif is
+	-- the arbiter is generated for four slots, two of them are idle
+	constant C_NUM_SLOTS : integer := 4;
+	constant C_ACTIVE    : integer := 2;
+
+	-- request sizes measured
+	constant C_NUM_SIZES : integer := 6;
+	type SIZE_ARRAY_T is array(0 to C_NUM_SIZES - 1) of integer;
+	constant C_SIZES : SIZE_ARRAY_T := (16, 64, 256, 1024, 4096, 8192);
+
+	type INT_ARRAY_T  is array(0 to C_NUM_SLOTS - 1) of integer;
+	type WORD_ARRAY_T is array(0 to C_NUM_SLOTS - 1) of std_logic_vector(31 downto 0);
+	type HALF_ARRAY_T is array(0 to C_NUM_SLOTS - 1) of std_logic_vector(15 downto 0);
+
+	signal clk   : std_logic := '0';
+	signal rst   : std_logic := '1';
+	signal rstn  : std_logic;
+	signal done  : boolean := False;
+	signal cycle : integer := 0;
+
+	-- measurement started by the stimulus and finished by the slots
+	signal go        : integer := 0;
+	signal req_size  : integer := 16;
+	signal req_write : boolean := False;
+	signal slot_done : INT_ARRAY_T := (others => 0);
+
+	signal h2m_data  : WORD_ARRAY_T := (others => (others => '0'));
+	signal h2m_fill  : HALF_ARRAY_T := (others => (others => '0'));
+	signal h2m_empty : std_logic_vector(0 to C_NUM_SLOTS - 1) := (others => '1');
+	signal h2m_re    : std_logic_vector(0 to C_NUM_SLOTS - 1);
+	signal m2h_data  : WORD_ARRAY_T;
+	signal m2h_we    : std_logic_vector(0 to C_NUM_SLOTS - 1);
+
+	-- arbiter to memory controller
+	signal h2m_out_data  : std_logic_vector(31 downto 0);
+	signal h2m_out_fill  : std_logic_vector(15 downto 0);
+	signal h2m_out_empty : std_logic;
+	signal h2m_out_re    : std_logic;
+	signal m2h_out_data  : std_logic_vector(31 downto 0);
+	signal m2h_out_rem   : std_logic_vector(15 downto 0);
+	signal m2h_out_full  : std_logic;
+	signal m2h_out_we    : std_logic;
+
+	-- arbiter to burst converter to memory controller
+	signal arb_ctrl_data   : std_logic_vector(31 downto 0);
+	signal arb_ctrl_fill   : std_logic_vector(15 downto 0);
+	signal arb_ctrl_empty  : std_logic;
+	signal arb_ctrl_re     : std_logic;
+	signal bconv_ctrl_data  : std_logic_vector(31 downto 0);
+	signal bconv_ctrl_fill  : std_logic_vector(15 downto 0);
+	signal bconv_ctrl_empty : std_logic;
+	signal bconv_ctrl_re    : std_logic;
+
+	-- IPIC
+	signal mstrd_req       : std_logic;
+	signal mstwr_req       : std_logic;
+	signal mst_addr        : std_logic_vector(31 downto 0);
+	signal mst_be          : std_logic_vector(3 downto 0);
+	signal mst_length      : std_logic_vector(11 downto 0);
+	signal mst_type        : std_logic;
+	signal mst_lock        : std_logic;
+	signal mst_reset       : std_logic;
+	signal mst_cmdack      : std_logic := '0';
+	signal mst_cmplt       : std_logic := '0';
+	signal mstrd_d         : std_logic_vector(31 downto 0) := (others => '0');
+	signal mstrd_sof_n     : std_logic := '1';
+	signal mstrd_eof_n     : std_logic := '1';
+	signal mstrd_src_rdy_n : std_logic := '1';
+	signal mstrd_dst_rdy_n : std_logic;
+	signal mstrd_dst_dsc_n : std_logic;
+	signal mstwr_d         : std_logic_vector(31 downto 0);
+	signal mstwr_rem       : std_logic_vector(3 downto 0);
+	signal mstwr_src_rdy_n : std_logic;
+	signal mstwr_src_dsc_n : std_logic;
+	signal mstwr_sof_n     : std_logic;
+	signal mstwr_eof_n     : std_logic;
+	signal mstwr_dst_rdy_n : std_logic := '1';
+
+	signal arb_qos         : std_logic_vector(31 downto 0);
+	signal arb_bytes_read  : std_logic_vector(31 downto 0);
+	signal arb_bytes_write : std_logic_vector(31 downto 0);
+
+	signal bus_words   : integer := 0;
+	signal bus_cmds    : integer := 0;
+	signal bus_errors  : integer := 0;
+	signal slot_errors : INT_ARRAY_T := (others => 0);
+begin
+
+	clk  <= not clk after G_CLK_HALF when not done else clk;
+	rstn <= not rst;
+
+	cycle_proc : process(clk) is
+	begin
+		if rising_edge(clk) then
+			cycle <= cycle + 1;
+		end if;
+	end process cycle_proc;
+
+	arbiter : entity work.reconos_memif_arbiter
+		generic map (
+			C_NUM_HWTS           => C_NUM_SLOTS,
+			C_MEMIF_FIFO_WIDTH   => 32,
+			C_CTRL_FIFO_WIDTH    => 32,
+			C_MEMIF_LENGTH_WIDTH => 24,
+			C_GRANT_SIZE         => 1024
+		)
+		port map (
+			MEMIF_FIFO_In_Hwt2Mem_Data_0  => h2m_data(0),
+			MEMIF_FIFO_In_Hwt2Mem_Fill_0  => h2m_fill(0),
+			MEMIF_FIFO_In_Hwt2Mem_Empty_0 => h2m_empty(0),
+			MEMIF_FIFO_In_Hwt2Mem_RE_0    => h2m_re(0),
+			MEMIF_FIFO_In_Mem2Hwt_Data_0  => m2h_data(0),
+			MEMIF_FIFO_In_Mem2Hwt_Rem_0   => X"007F",
+			MEMIF_FIFO_In_Mem2Hwt_Full_0  => '0',
+			MEMIF_FIFO_In_Mem2Hwt_WE_0    => m2h_we(0),
+
+			MEMIF_FIFO_In_Hwt2Mem_Data_1  => h2m_data(1),
+			MEMIF_FIFO_In_Hwt2Mem_Fill_1  => h2m_fill(1),
+			MEMIF_FIFO_In_Hwt2Mem_Empty_1 => h2m_empty(1),
+			MEMIF_FIFO_In_Hwt2Mem_RE_1    => h2m_re(1),
+			MEMIF_FIFO_In_Mem2Hwt_Data_1  => m2h_data(1),
+			MEMIF_FIFO_In_Mem2Hwt_Rem_1   => X"007F",
+			MEMIF_FIFO_In_Mem2Hwt_Full_1  => '0',
+			MEMIF_FIFO_In_Mem2Hwt_WE_1    => m2h_we(1),
+
+			MEMIF_FIFO_In_Hwt2Mem_Data_2  => h2m_data(2),
+			MEMIF_FIFO_In_Hwt2Mem_Fill_2  => h2m_fill(2),
+			MEMIF_FIFO_In_Hwt2Mem_Empty_2 => h2m_empty(2),
+			MEMIF_FIFO_In_Hwt2Mem_RE_2    => h2m_re(2),
+			MEMIF_FIFO_In_Mem2Hwt_Data_2  => m2h_data(2),
+			MEMIF_FIFO_In_Mem2Hwt_Rem_2   => X"007F",
+			MEMIF_FIFO_In_Mem2Hwt_Full_2  => '0',
+			MEMIF_FIFO_In_Mem2Hwt_WE_2    => m2h_we(2),
+
+			MEMIF_FIFO_In_Hwt2Mem_Data_3  => h2m_data(3),
+			MEMIF_FIFO_In_Hwt2Mem_Fill_3  => h2m_fill(3),
+			MEMIF_FIFO_In_Hwt2Mem_Empty_3 => h2m_empty(3),
+			MEMIF_FIFO_In_Hwt2Mem_RE_3    => h2m_re(3),
+			MEMIF_FIFO_In_Mem2Hwt_Data_3  => m2h_data(3),
+			MEMIF_FIFO_In_Mem2Hwt_Rem_3   => X"007F",
+			MEMIF_FIFO_In_Mem2Hwt_Full_3  => '0',
+			MEMIF_FIFO_In_Mem2Hwt_WE_3    => m2h_we(3),
+
+			MEMIF_FIFO_Out_Hwt2Mem_Data  => h2m_out_data,
+			MEMIF_FIFO_Out_Hwt2Mem_Fill  => h2m_out_fill,
+			MEMIF_FIFO_Out_Hwt2Mem_Empty => h2m_out_empty,
+			MEMIF_FIFO_Out_Hwt2Mem_RE    => h2m_out_re,
+
+			MEMIF_FIFO_Out_Mem2Hwt_Data  => m2h_out_data,
+			MEMIF_FIFO_Out_Mem2Hwt_Rem   => m2h_out_rem,
+			MEMIF_FIFO_Out_Mem2Hwt_Full  => m2h_out_full,
+			MEMIF_FIFO_Out_Mem2Hwt_WE    => m2h_out_we,
+
+			CTRL_FIFO_Out_Data  => arb_ctrl_data,
+			CTRL_FIFO_Out_Fill  => arb_ctrl_fill,
+			CTRL_FIFO_Out_Empty => arb_ctrl_empty,
+			CTRL_FIFO_Out_RE    => arb_ctrl_re,
+
+			ARB_Slot        => X"00000000",
+			ARB_Qos_Data    => X"00000000",
+			ARB_Qos_WE      => '0',
+			ARB_Qos         => arb_qos,
+			ARB_Bytes_Read  => arb_bytes_read,
+			ARB_Bytes_Write => arb_bytes_write,
+
+			TCTRL_Clk => clk,
+			TCTRL_Rst => rst
+		);
+
+	burst_converter : entity work.reconos_memif_burst_converter
+		generic map (
+			C_CTRL_FIFO_WIDTH    => 32,
+			C_MEMIF_LENGTH_WIDTH => 24,
+			C_PAGE_SIZE          => 4096,
+			C_MAX_BURST_SIZE     => G_MAX_BURST
+		)
+		port map (
+			CTRL_FIFO_In_Data   => arb_ctrl_data,
+			CTRL_FIFO_In_Fill   => arb_ctrl_fill,
+			CTRL_FIFO_In_Empty  => arb_ctrl_empty,
+			CTRL_FIFO_In_RE     => arb_ctrl_re,
+
+			CTRL_FIFO_Out_Data  => bconv_ctrl_data,
+			CTRL_FIFO_Out_Fill  => bconv_ctrl_fill,
+			CTRL_FIFO_Out_Empty => bconv_ctrl_empty,
+			CTRL_FIFO_Out_RE    => bconv_ctrl_re,
+
+			BCONV_Clk => clk,
+			BCONV_Rst => rst
+		);
+
+	memory_controller : entity reconos_memif_memory_controller_v1_00_a.user_logic
+		generic map (
+			C_MEMIF_FIFO_WIDTH      => 32,
+			C_CTRL_FIFO_WIDTH       => 32,
+			C_MEMIF_LENGTH_WIDTH    => 24,
+			C_USE_MMU_PORT          => false,
+			C_MST_NATIVE_DATA_WIDTH => 32,
+			C_LENGTH_WIDTH          => 12,
+			C_MST_AWIDTH            => 32
+		)
+		port map (
+			MEMIF_FIFO_Hwt2Mem_Data  => h2m_out_data,
+			MEMIF_FIFO_Hwt2Mem_Fill  => h2m_out_fill,
+			MEMIF_FIFO_Hwt2Mem_Empty => h2m_out_empty,
+			MEMIF_FIFO_Hwt2Mem_RE    => h2m_out_re,
+
+			MEMIF_FIFO_Mem2Hwt_Data  => m2h_out_data,
+			MEMIF_FIFO_Mem2Hwt_Rem   => m2h_out_rem,
+			MEMIF_FIFO_Mem2Hwt_Full  => m2h_out_full,
+			MEMIF_FIFO_Mem2Hwt_WE    => m2h_out_we,
+
+			CTRL_FIFO_Hwt_Data       => bconv_ctrl_data,
+			CTRL_FIFO_Hwt_Fill       => bconv_ctrl_fill,
+			CTRL_FIFO_Hwt_Empty      => bconv_ctrl_empty,
+			CTRL_FIFO_Hwt_RE         => bconv_ctrl_re,
+
+			MEMIF_FIFO_Mmu_Data      => open,
+			MEMIF_FIFO_Mmu_Rem       => X"0000",
+			MEMIF_FIFO_Mmu_Full      => '1',
+			MEMIF_FIFO_Mmu_WE        => open,
+
+			CTRL_FIFO_Mmu_Data       => X"00000000",
+			CTRL_FIFO_Mmu_Fill       => X"0000",
+			CTRL_FIFO_Mmu_Empty      => '1',
+			CTRL_FIFO_Mmu_RE         => open,
+
+			MEMCTRL_Clk => clk,
+			MEMCTRL_Rst => rst,
+
+			Bus2IP_Clk             => clk,
+			Bus2IP_Resetn          => rstn,
+			ip2bus_mstrd_req       => mstrd_req,
+			ip2bus_mstwr_req       => mstwr_req,
+			ip2bus_mst_addr        => mst_addr,
+			ip2bus_mst_be          => mst_be,
+			ip2bus_mst_length      => mst_length,
+			ip2bus_mst_type        => mst_type,
+			ip2bus_mst_lock        => mst_lock,
+			ip2bus_mst_reset       => mst_reset,
+			bus2ip_mst_cmdack      => mst_cmdack,
+			bus2ip_mst_cmplt       => mst_cmplt,
+			bus2ip_mst_error       => '0',
+			bus2ip_mst_rearbitrate => '0',
+			bus2ip_mst_cmd_timeout => '0',
+			bus2ip_mstrd_d         => mstrd_d,
+			bus2ip_mstrd_rem       => X"0",
+			bus2ip_mstrd_sof_n     => mstrd_sof_n,
+			bus2ip_mstrd_eof_n     => mstrd_eof_n,
+			bus2ip_mstrd_src_rdy_n => mstrd_src_rdy_n,
+			bus2ip_mstrd_src_dsc_n => '1',
+			ip2bus_mstrd_dst_rdy_n => mstrd_dst_rdy_n,
+			ip2bus_mstrd_dst_dsc_n => mstrd_dst_dsc_n,
+			ip2bus_mstwr_d         => mstwr_d,
+			ip2bus_mstwr_rem       => mstwr_rem,
+			ip2bus_mstwr_src_rdy_n => mstwr_src_rdy_n,
+			ip2bus_mstwr_src_dsc_n => mstwr_src_dsc_n,
+			ip2bus_mstwr_sof_n     => mstwr_sof_n,
+			ip2bus_mstwr_eof_n     => mstwr_eof_n,
+			bus2ip_mstwr_dst_rdy_n => mstwr_dst_rdy_n,
+			bus2ip_mstwr_dst_dsc_n => '1'
+		);
+
+	-- hardware threads, one request at a time like memif_read and
+	-- memif_write, the data of a word is its address
+	--
+	--   A writing thread fills its FIFO (128 words) ahead of the
+	--   transfer, so that the fill reported is the one of a full FIFO
+	--   until the last words of the measurement are pushed.
+	--
+	slot_gen : for i in 0 to C_ACTIVE - 1 generate
+		slot_proc : process is
+			variable addr     : std_logic_vector(31 downto 0);
+			variable cmd      : std_logic_vector(7 downto 0);
+			variable left     : integer;
+			variable requests : integer;
+
+			procedure push (data : in std_logic_vector(31 downto 0)) is
+			begin
+				h2m_data(i)  <= data;
+				h2m_empty(i) <= '0';
+				if left < 128 then
+					h2m_fill(i) <= conv_std_logic_vector(left - 1, 16);
+				else
+					h2m_fill(i) <= X"007F";
+				end if;
+				wait until rising_edge(clk) and h2m_re(i) = '1';
+				left := left - 1;
+			end procedure push;
+		begin
+			wait until falling_edge(clk) and rst = '0';
+
+			loop
+				wait until go > slot_done(i);
+
+				addr := conv_std_logic_vector(i * 16#01000000#, 32);
+				requests := G_BYTES / req_size;
+
+				if req_write then
+					cmd  := X"F0";
+					left := requests * (2 + req_size / 4);
+				else
+					cmd  := X"00";
+					left := 2 * requests;
+				end if;
+
+				for r in 1 to requests loop
+					push(cmd & conv_std_logic_vector(req_size, 24));
+					push(addr);
+
+					if req_write then
+						for w in 0 to req_size / 4 - 1 loop
+							push(addr + conv_std_logic_vector(4 * w, 32));
+						end loop;
+						h2m_empty(i) <= '1';
+					else
+						h2m_empty(i) <= '1';
+						for w in 0 to req_size / 4 - 1 loop
+							wait until rising_edge(clk) and m2h_we(i) = '1';
+							if m2h_data(i) /= addr + conv_std_logic_vector(4 * w, 32) then
+								report "slot " & integer'image(i) & ": wrong data" severity error;
+								slot_errors(i) <= slot_errors(i) + 1;
+							end if;
+						end loop;
+					end if;
+
+					addr := addr + conv_std_logic_vector(req_size, 32);
+				end loop;
+
+				slot_done(i) <= go;
+			end loop;
+		end process slot_proc;
+	end generate slot_gen;
+
+	-- IPIC of axi_master_burst, one command at a time
+	bus_proc : process is
+		variable addr   : std_logic_vector(31 downto 0);
+		variable words  : integer;
+		variable w      : integer;
+		variable length : integer;
+		variable read   : boolean;
+	begin
+		loop
+			wait until rising_edge(clk);
+
+			if mstrd_req = '1' or mstwr_req = '1' then
+				read   := mstrd_req = '1';
+				addr   := mst_addr;
+				length := conv_integer(mst_length);
+				words  := length / 4;
+
+				if length = 0 or length > G_MAX_BURST or length mod 4 /= 0
+				   or conv_integer(addr(11 downto 0)) + length > 4096 then
+					report "invalid bus command of " & integer'image(length) & " bytes" severity error;
+					bus_errors <= bus_errors + 1;
+				end if;
+				bus_cmds <= bus_cmds + 1;
+
+				for k in 1 to G_CMD_LATENCY loop
+					wait until falling_edge(clk);
+				end loop;
+				mst_cmdack <= '1';
+				wait until falling_edge(clk);
+				mst_cmdack <= '0';
+
+				if read then
+					for k in 1 to G_RD_LATENCY loop
+						wait until falling_edge(clk);
+					end loop;
+
+					w := 0;
+					while w < words loop
+						mstrd_src_rdy_n <= '0';
+						mstrd_d <= addr + conv_std_logic_vector(4 * w, 32);
+						if w = 0 then
+							mstrd_sof_n <= '0';
+						else
+							mstrd_sof_n <= '1';
+						end if;
+						if w = words - 1 then
+							mstrd_eof_n <= '0';
+						else
+							mstrd_eof_n <= '1';
+						end if;
+
+						wait until rising_edge(clk);
+						if mstrd_dst_rdy_n = '0' then
+							w := w + 1;
+							bus_words <= bus_words + 1;
+						end if;
+						wait until falling_edge(clk);
+					end loop;
+
+					mstrd_src_rdy_n <= '1';
+					mstrd_sof_n <= '1';
+					mstrd_eof_n <= '1';
+				else
+					mstwr_dst_rdy_n <= '0';
+
+					w := 0;
+					while w < words loop
+						wait until rising_edge(clk);
+						if mstwr_src_rdy_n = '0' then
+							if mstwr_d /= addr + conv_std_logic_vector(4 * w, 32) then
+								report "wrong data written" severity error;
+								bus_errors <= bus_errors + 1;
+							end if;
+							w := w + 1;
+							bus_words <= bus_words + 1;
+						end if;
+					end loop;
+
+					wait until falling_edge(clk);
+					mstwr_dst_rdy_n <= '1';
+
+					for k in 1 to G_WR_LATENCY loop
+						wait until falling_edge(clk);
+					end loop;
+				end if;
+
+				mst_cmplt <= '1';
+				wait until falling_edge(clk);
+				mst_cmplt <= '0';
+			end if;
+		end loop;
+	end process bus_proc;
+
+	stim_proc : process is
+		variable start, cycles, bw, last, errors : integer;
+	begin
+		errors := 0;
+
+		wait for 4 * G_CLK_HALF;
+		wait until falling_edge(clk);
+		rst <= '0';
+
+		for dir in 0 to 1 loop
+			last := 0;
+
+			for s in 0 to C_NUM_SIZES - 1 loop
+				req_size  <= C_SIZES(s);
+				req_write <= dir = 1;
+				wait until falling_edge(clk);
+
+				start := cycle;
+				go <= go + 1;
+				wait until falling_edge(clk);
+
+				for i in 0 to C_ACTIVE - 1 loop
+					while slot_done(i) /= go loop
+						wait until falling_edge(clk);
+					end loop;
+				end loop;
+
+				-- the last write completes on the bus after the data is taken
+				if dir = 1 then
+					for k in 1 to G_WR_LATENCY + 2 loop
+						wait until falling_edge(clk);
+					end loop;
+				end if;
+
+				cycles := cycle - start;
+
+				-- bandwidth in bytes per 100 cycles
+				bw := 100 * C_ACTIVE * G_BYTES / cycles;
+
+				if dir = 1 then
+					report "write " & integer'image(C_SIZES(s)) & " byte: " & integer'image(cycles)
+					       & " cycles, " & integer'image(bw) & " bytes per 100 cycles ("
+					       & integer'image(bw / 4) & "% of the bus)";
+				else
+					report "read " & integer'image(C_SIZES(s)) & " byte: " & integer'image(cycles)
+					       & " cycles, " & integer'image(bw) & " bytes per 100 cycles ("
+					       & integer'image(bw / 4) & "% of the bus)";
+				end if;
+
+				-- allow for the rounding of the last request
+				if 100 * bw < 95 * last then
+					report "bandwidth drops with larger requests" severity error;
+					errors := errors + 1;
+				end if;
+				last := bw;
+			end loop;
+		end loop;
+
+		if bus_words /= 2 * C_NUM_SIZES * C_ACTIVE * G_BYTES / 4 then
+			report "wrong number of words on the bus" severity error;
+			errors := errors + 1;
+		end if;
+
+		report integer'image(bus_cmds) & " bus commands";
+
+		errors := errors + bus_errors;
+		for i in 0 to C_ACTIVE - 1 loop
+			errors := errors + slot_errors(i);
+		end loop;
+
+		if errors = 0 then
+			report "tb_memif: PASSED";
+		else
+			report "tb_memif: FAILED (" & integer'image(errors) & " errors)" severity failure;
+		end if;
+
+		done <= True;
+		wait;
+	end process stim_proc;
+
+end architecture implementation;
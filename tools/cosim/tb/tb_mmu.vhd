@@ -0,0 +1,389 @@
+--                                                        ____  _____
+--                            ________  _________  ____  / __ \/ ___/
+--                           / ___/ _ \/ ___/ __ \/ __ \/ / / /\__ \
+--                          / /  /  __/ /__/ /_/ / / / / /_/ /___/ /
+--                         /_/   \___/\___/\____/_/ /_/\____//____/
+--
+-- ======================================================================
+--
+--   title:        Testbench - MEMIF MMU - Page table walks
+--
+--   project:      ReconOS
+--   description:  Feeds a sequential or a strided trace of read
+--                 requests into the zynq MMU and measures the latency
+--                 of the translation, from reading the address of a
+--                 request until the memory controller takes the
+--                 physical one. The memory controller is modelled
+--                 behaviourally, it serves the walks of the MMU first
+--                 and all requests one after another with a fixed
+--                 latency. The page table maps a window of 512 pages,
+--                 the page behind it is unmapped.
+--
+--                 Afterwards the page table entry of a page is changed
+--                 while it is being walked, followed by an invalidation
+--                 of the TLB. The stale translation must not be kept.
+--
+-- ======================================================================
+
+library ieee;
+use ieee.std_logic_1164.all;
+use ieee.std_logic_arith.all;
+use ieee.std_logic_unsigned.all;
+
+library reconos_memif_mmu_zynq_v1_00_a;
+
+entity tb_mmu is
+	generic (
+		G_TRACE        : string  := "seq";
+		G_USE_PREFETCH : boolean := true;
+		G_MEM_LATENCY  : integer := 20;
+		G_CLK_HALF     : time    := 5 ns
+	);
+end entity tb_mmu;
+
+architecture implementation of tb_mmu is
+	constant C_PGD       : std_logic_vector(31 downto 0) := X"00004000";
+	constant C_L2_TABLES : std_logic_vector(7 downto 0)  := X"01";
+
+	-- mapped window of virtual pages
+	constant C_MAP_FIRST : integer := 16#10000#;
+	constant C_MAP_PAGES : integer := 512;
+
+	constant C_KEY_OLD : std_logic_vector(19 downto 0) := X"0A5A5";
+	constant C_KEY_NEW : std_logic_vector(19 downto 0) := X"05A5A";
+
+	signal clk   : std_logic := '0';
+	signal rst   : std_logic := '1';
+	signal done  : boolean := False;
+	signal cycle : integer := 0;
+
+	signal ctrl_in_data  : std_logic_vector(31 downto 0) := (others => '0');
+	signal ctrl_in_empty : std_logic := '1';
+	signal ctrl_in_re    : std_logic;
+
+	signal ctrl_out_data  : std_logic_vector(31 downto 0);
+	signal ctrl_out_fill  : std_logic_vector(15 downto 0);
+	signal ctrl_out_empty : std_logic;
+	signal ctrl_out_re    : std_logic := '0';
+
+	signal ctrl_mmu_data  : std_logic_vector(31 downto 0);
+	signal ctrl_mmu_fill  : std_logic_vector(15 downto 0);
+	signal ctrl_mmu_empty : std_logic;
+	signal ctrl_mmu_re    : std_logic := '0';
+
+	signal memif_mmu_data : std_logic_vector(31 downto 0) := (others => '0');
+	signal memif_mmu_rem  : std_logic_vector(15 downto 0);
+	signal memif_mmu_full : std_logic;
+	signal memif_mmu_we   : std_logic := '0';
+
+	signal mmu_pgf        : std_logic;
+	signal mmu_fault_addr : std_logic_vector(31 downto 0);
+	signal mmu_tlb_hits   : std_logic_vector(31 downto 0);
+	signal mmu_tlb_misses : std_logic_vector(31 downto 0);
+	signal mmu_tlb_inv    : std_logic := '0';
+	signal mmu_tlb_inv_data : std_logic_vector(31 downto 0) := (others => '0');
+
+	-- current page table, selected by the key of the mapping
+	signal pt_key : std_logic_vector(19 downto 0) := C_KEY_OLD;
+
+	-- request read by the MMU last and its expected translation
+	signal req_cycle  : integer := 0;
+	signal req_expect : std_logic_vector(31 downto 0) := (others => '0');
+
+	-- results of the memory controller
+	signal served     : integer := 0;
+	signal walk_reads : integer := 0;
+	signal lat_sum    : integer := 0;
+	signal lat_max    : integer := 0;
+	signal mem_errors : integer := 0;
+	signal l2_pending : std_logic := '0';
+	signal pgf_seen   : std_logic := '0';
+
+	function translate (addr : std_logic_vector(31 downto 0);
+	                    key  : std_logic_vector(19 downto 0)) return std_logic_vector is
+	begin
+		return (addr(31 downto 12) xor key) & addr(11 downto 0);
+	end function translate;
+begin
+
+	clk <= not clk after G_CLK_HALF when not done else clk;
+
+	cycle_proc : process(clk) is
+	begin
+		if rising_edge(clk) then
+			cycle <= cycle + 1;
+
+			if mmu_pgf = '1' then
+				pgf_seen <= '1';
+			end if;
+		end if;
+	end process cycle_proc;
+
+	dut : entity reconos_memif_mmu_zynq_v1_00_a.reconos_memif_mmu_zynq
+		generic map (
+			C_CTRL_FIFO_WIDTH    => 32,
+			C_MEMIF_LENGTH_WIDTH => 24,
+			C_TLB_SIZE           => 16,
+			C_USE_PREFETCH       => G_USE_PREFETCH,
+			C_PREFETCH_DISTANCE  => 512
+		)
+		port map (
+			CTRL_FIFO_In_Data   => ctrl_in_data,
+			CTRL_FIFO_In_Fill   => X"0000",
+			CTRL_FIFO_In_Empty  => ctrl_in_empty,
+			CTRL_FIFO_In_RE     => ctrl_in_re,
+
+			CTRL_FIFO_Out_Data  => ctrl_out_data,
+			CTRL_FIFO_Out_Fill  => ctrl_out_fill,
+			CTRL_FIFO_Out_Empty => ctrl_out_empty,
+			CTRL_FIFO_Out_RE    => ctrl_out_re,
+
+			CTRL_FIFO_Mmu_Data  => ctrl_mmu_data,
+			CTRL_FIFO_Mmu_Fill  => ctrl_mmu_fill,
+			CTRL_FIFO_Mmu_Empty => ctrl_mmu_empty,
+			CTRL_FIFO_Mmu_RE    => ctrl_mmu_re,
+
+			MEMIF_FIFO_Mmu_Data => memif_mmu_data,
+			MEMIF_FIFO_Mmu_Rem  => memif_mmu_rem,
+			MEMIF_FIFO_Mmu_Full => memif_mmu_full,
+			MEMIF_FIFO_Mmu_WE   => memif_mmu_we,
+
+			MMU_Pgf          => mmu_pgf,
+			MMU_Fault_addr   => mmu_fault_addr,
+			MMU_Retry        => '0',
+			MMU_Pgd          => C_PGD,
+			MMU_Tlb_Hits     => mmu_tlb_hits,
+			MMU_Tlb_Misses   => mmu_tlb_misses,
+			MMU_Tlb_Inv      => mmu_tlb_inv,
+			MMU_Tlb_Inv_Data => mmu_tlb_inv_data,
+
+			MMU_Clk => clk,
+			MMU_Rst => rst,
+
+			DEBUG_DATA => open
+		);
+
+	-- memory controller serving walks and translated requests
+	--
+	--   Both control FIFOs are read like the fetch of the memory
+	--   controller does, walks first. A descriptor is looked up when
+	--   its address is read and returned after G_MEM_LATENCY cycles,
+	--   a request occupies the memory for G_MEM_LATENCY cycles and
+	--   one cycle per word.
+	--
+	mem_proc : process is
+		variable cmd, addr, data : std_logic_vector(31 downto 0);
+		variable vpn             : std_logic_vector(19 downto 0);
+		variable walk            : boolean;
+		variable lat             : integer;
+	begin
+		loop
+			wait until falling_edge(clk);
+
+			if ctrl_mmu_empty = '0' then
+				walk := True;
+				ctrl_mmu_re <= '1';
+			elsif ctrl_out_empty = '0' then
+				walk := False;
+				ctrl_out_re <= '1';
+			else
+				next;
+			end if;
+
+			wait until rising_edge(clk);
+			if walk then
+				cmd := ctrl_mmu_data;
+			else
+				cmd := ctrl_out_data;
+			end if;
+
+			wait until rising_edge(clk);
+			if walk then
+				addr := ctrl_mmu_data;
+			else
+				addr := ctrl_out_data;
+			end if;
+
+			wait until falling_edge(clk);
+			ctrl_mmu_re <= '0';
+			ctrl_out_re <= '0';
+
+			if walk then
+				if cmd /= X"00000004" then
+					report "walk with wrong command" severity error;
+					mem_errors <= mem_errors + 1;
+				end if;
+
+				if addr(31 downto 14) = C_PGD(31 downto 14) then
+					-- level 1 descriptor, one level 2 table per entry
+					data := C_L2_TABLES & "00" & addr(13 downto 2) & "0000000001";
+				elsif addr(31 downto 24) = C_L2_TABLES then
+					-- level 2 descriptor, a small page if mapped
+					vpn := addr(21 downto 10) & addr(9 downto 2);
+					if conv_integer(vpn) >= C_MAP_FIRST and conv_integer(vpn) < C_MAP_FIRST + C_MAP_PAGES then
+						data := (vpn xor pt_key) & X"002";
+					else
+						data := (others => '0');
+					end if;
+					l2_pending <= '1';
+				else
+					report "walk outside of the page table" severity error;
+					mem_errors <= mem_errors + 1;
+					data := (others => '0');
+				end if;
+
+				for i in 1 to G_MEM_LATENCY loop
+					wait until falling_edge(clk);
+				end loop;
+
+				memif_mmu_data <= data;
+				memif_mmu_we   <= '1';
+				wait until falling_edge(clk);
+				memif_mmu_we   <= '0';
+				l2_pending     <= '0';
+
+				walk_reads <= walk_reads + 1;
+			else
+				if addr /= req_expect then
+					report "wrong translation of request " & integer'image(served) severity error;
+					mem_errors <= mem_errors + 1;
+				end if;
+
+				lat := cycle - req_cycle;
+				lat_sum <= lat_sum + lat;
+				if lat > lat_max then
+					lat_max <= lat;
+				end if;
+				served <= served + 1;
+
+				for i in 1 to G_MEM_LATENCY + conv_integer(cmd(23 downto 0)) / 4 loop
+					wait until falling_edge(clk);
+				end loop;
+			end if;
+		end loop;
+	end process mem_proc;
+
+	stim_proc : process is
+		variable requests, pages, misses : integer;
+		variable start, errors           : integer;
+
+		-- hands a read request to the MMU like the burst converter
+		procedure request (addr : in std_logic_vector(31 downto 0); len : in integer) is
+		begin
+			ctrl_in_data  <= X"00" & conv_std_logic_vector(len, 24);
+			ctrl_in_empty <= '0';
+			wait until rising_edge(clk) and ctrl_in_re = '1';
+
+			ctrl_in_data  <= addr;
+			wait until rising_edge(clk) and ctrl_in_re = '1';
+
+			ctrl_in_empty <= '1';
+			req_cycle     <= cycle;
+			req_expect    <= translate(addr, pt_key);
+		end procedure request;
+
+		procedure wait_served (count : in integer) is
+		begin
+			while served < count loop
+				wait until rising_edge(clk);
+			end loop;
+
+			-- a walk for the next page might still be running
+			for i in 1 to 4 * G_MEM_LATENCY loop
+				wait until rising_edge(clk);
+			end loop;
+		end procedure wait_served;
+
+		procedure invalidate_all is
+		begin
+			wait until falling_edge(clk);
+			mmu_tlb_inv_data <= X"00000001";
+			mmu_tlb_inv      <= '1';
+			wait until falling_edge(clk);
+			mmu_tlb_inv      <= '0';
+		end procedure invalidate_all;
+
+		procedure check (cond : in boolean; msg : in string) is
+		begin
+			if not cond then
+				report msg severity error;
+				errors := errors + 1;
+			end if;
+		end procedure check;
+	begin
+		errors := 0;
+
+		wait for 4 * G_CLK_HALF;
+		wait until falling_edge(clk);
+		rst <= '0';
+
+		start := cycle;
+
+		if G_TRACE = "seq" then
+			-- sort_demo like, 2 MB read in bursts of 1 KB
+			requests := 2048;
+			pages    := 512;
+			for k in 0 to requests - 1 loop
+				request(X"10000000" + conv_std_logic_vector(k * 1024, 32), 1024);
+			end loop;
+		else
+			-- one request of 128 byte at the end of every other page, the
+			-- translation walked in advance is never used
+			requests := 256;
+			pages    := 256;
+			for k in 0 to requests - 1 loop
+				request(X"10000F80" + conv_std_logic_vector(k * 8192, 32), 128);
+			end loop;
+		end if;
+
+		wait_served(requests);
+
+		misses := conv_integer(mmu_tlb_misses(30 downto 0));
+
+		report G_TRACE & ", prefetch " & boolean'image(G_USE_PREFETCH) & ": "
+		       & integer'image(requests) & " requests in " & integer'image(cycle - start)
+		       & " cycles, translation latency avg " & integer'image(lat_sum / requests)
+		       & " max " & integer'image(lat_max) & " cycles, "
+		       & integer'image(misses) & " misses, " & integer'image(walk_reads)
+		       & " descriptor reads";
+
+		-- only the first page is walked on demand if walked in advance
+		if G_USE_PREFETCH and G_TRACE = "seq" then
+			check(misses = 1, "pages not walked in advance");
+		else
+			check(misses = pages, "wrong number of misses");
+		end if;
+
+		check(conv_integer(mmu_tlb_hits(30 downto 0)) + misses = requests, "hits and misses do not add up");
+		check(pgf_seen = '0', "page fault raised by a walk in advance");
+
+		-- the page table entry changes while it is walked
+		invalidate_all;
+		misses := conv_integer(mmu_tlb_misses(30 downto 0));
+
+		request(X"10000000", 64);
+		wait until l2_pending = '1';
+		pt_key <= C_KEY_NEW;
+		invalidate_all;
+		wait_served(requests + 1);
+
+		request(X"10000040", 64);
+		wait_served(requests + 2);
+		check(conv_integer(mmu_tlb_misses(30 downto 0)) = misses + 2, "stale translation kept in the TLB");
+
+		request(X"10000080", 64);
+		wait_served(requests + 3);
+		check(conv_integer(mmu_tlb_misses(30 downto 0)) = misses + 2, "translation not kept in the TLB");
+
+		errors := errors + mem_errors;
+		if errors = 0 then
+			report G_TRACE & ": PASSED";
+		else
+			report G_TRACE & ": FAILED (" & integer'image(errors) & " errors)" severity failure;
+		end if;
+
+		done <= True;
+		wait;
+	end process stim_proc;
+
+end architecture implementation;
@@ -0,0 +1,482 @@
+--                                                        ____  _____
+--                            ________  _________  ____  / __ \/ ___/
+--                           / ___/ _ \/ ___/ __ \/ __ \/ / / /\__ \
+--                          / /  /  __/ /__/ /_/ / / / / /_/ /___/ /
+--                         /_/   \___/\___/\____/_/ /_/\____//____/
+--
+-- ======================================================================
+--
+--   title:        Testbench - Performance counters of proc control
+--
+--   project:      ReconOS
+--   description:  Checks the per-slot performance counters of proc
+--                 control together with the wait output of
+--                 reconos_fifo. Each of the two slots has a sw2hw OSIF
+--                 FIFO and a mem2hwt MEMIF FIFO, from which the thread
+--                 reads words that are written a known number of cycles
+--                 after it started waiting, or before.
+--
+--                 The counters must match these cycles exactly, only
+--                 count while the slot is out of reset, keep their
+--                 values over a reset of the thread and be cleared by a
+--                 system reset. The byte counters of the arbiter are
+--                 checked to be read through the slot select register.
+--
+--                 The 64 bit counters are latched when the slot is
+--                 selected, so they must not change until the slot is
+--                 selected again, and their upper halves must read as
+--                 zero with bit 31 of the slot select register set,
+--                 which must not change the slot seen by the arbiter.
+--
+-- ======================================================================
+
+library ieee;
+use ieee.std_logic_1164.all;
+use ieee.std_logic_arith.all;
+use ieee.std_logic_unsigned.all;
+
+library reconos_proc_control_v1_00_a;
+
+entity tb_perf is
+	generic (
+		G_READS    : integer := 16;
+		G_CLK_HALF : time    := 5 ns
+	);
+end entity tb_perf;
+
+architecture implementation of tb_perf is
+	constant C_NUM_HWTS : integer := 2;
+	constant C_NUM_REG  : integer := C_NUM_HWTS / 32 + 16;
+
+	-- registers of proc control
+	constant C_REG_NUM_HWTS     : integer := 0;
+	constant C_REG_SYS_RESET    : integer := 5;
+	constant C_REG_SLOT         : integer := 7;
+	constant C_REG_BYTES        : integer := 9;
+	constant C_REG_CYCLES       : integer := 10;
+	constant C_REG_OSIF_WAIT    : integer := 11;
+	constant C_REG_MEMIF_WAIT   : integer := 12;
+	constant C_REG_BYTES_READ   : integer := 13;
+	constant C_REG_BYTES_WRITE  : integer := 14;
+	constant C_REG_HWT_RESET    : integer := 15;
+
+	-- what the slots do in a run
+	constant C_MODE_READ  : integer := 1;
+	constant C_MODE_STALL : integer := 2;
+
+	type INT_ARRAY_T  is array(0 to C_NUM_HWTS - 1) of integer;
+	type WORD_ARRAY_T is array(0 to C_NUM_HWTS - 1) of std_logic_vector(31 downto 0);
+
+	signal clk   : std_logic := '0';
+	signal rst   : std_logic := '1';
+	signal rstn  : std_logic;
+	signal done  : boolean := False;
+	signal cycle : integer := 0;
+
+	signal bus_data  : std_logic_vector(31 downto 0) := (others => '0');
+	signal bus_rdce  : std_logic_vector(C_NUM_REG - 1 downto 0) := (others => '0');
+	signal bus_wrce  : std_logic_vector(C_NUM_REG - 1 downto 0) := (others => '0');
+	signal bus_rd    : std_logic_vector(31 downto 0);
+	signal bus_rdack : std_logic;
+	signal bus_wrack : std_logic;
+	signal bus_error : std_logic;
+
+	signal hwt_rst    : std_logic_vector(C_NUM_HWTS - 1 downto 0);
+	signal sys_rst    : std_logic;
+	signal osif_wait  : std_logic_vector(C_NUM_HWTS - 1 downto 0);
+	signal memif_wait : std_logic_vector(C_NUM_HWTS - 1 downto 0);
+
+	signal arb_slot        : std_logic_vector(31 downto 0);
+	signal arb_bytes_read  : std_logic_vector(31 downto 0);
+	signal arb_bytes_write : std_logic_vector(31 downto 0);
+
+	-- FIFOs of the slots
+	signal osif_data   : WORD_ARRAY_T;
+	signal osif_empty  : std_logic_vector(C_NUM_HWTS - 1 downto 0);
+	signal osif_re     : std_logic_vector(C_NUM_HWTS - 1 downto 0) := (others => '0');
+	signal osif_we     : std_logic_vector(C_NUM_HWTS - 1 downto 0) := (others => '0');
+	signal memif_data  : WORD_ARRAY_T;
+	signal memif_empty : std_logic_vector(C_NUM_HWTS - 1 downto 0);
+	signal memif_re    : std_logic_vector(C_NUM_HWTS - 1 downto 0) := (others => '0');
+	signal memif_we    : std_logic_vector(C_NUM_HWTS - 1 downto 0) := (others => '0');
+	signal fifo_in     : WORD_ARRAY_T := (others => (others => '0'));
+
+	-- run of the slots started by the stimulus
+	signal go        : integer := 0;
+	signal mode      : INT_ARRAY_T := (others => 0);
+	signal slot_done : INT_ARRAY_T := (others => 0);
+
+	-- wait cycles caused by the slots, accumulated over all runs
+	signal exp_osif_wait  : INT_ARRAY_T := (others => 0);
+	signal exp_memif_wait : INT_ARRAY_T := (others => 0);
+
+	signal slot_errors : INT_ARRAY_T := (others => 0);
+begin
+
+	clk  <= not clk after G_CLK_HALF when not done else clk;
+	rstn <= not rst;
+
+	cycle_proc : process(clk) is
+	begin
+		if rising_edge(clk) then
+			cycle <= cycle + 1;
+		end if;
+	end process cycle_proc;
+
+	dut : entity reconos_proc_control_v1_00_a.user_logic
+		generic map (
+			C_NUM_HWTS   => C_NUM_HWTS,
+			C_NUM_REG    => C_NUM_REG,
+			C_SLV_DWIDTH => 32
+		)
+		port map (
+			PROC_Clk     => clk,
+			PROC_Rst     => rst,
+			PROC_Hwt_Rst => hwt_rst,
+			PROC_Sys_Rst => sys_rst,
+			PROC_Pgf_Int => open,
+
+			PROC_Hwt_Osif_Wait  => osif_wait,
+			PROC_Hwt_Memif_Wait => memif_wait,
+
+			MMU_Pgf          => '0',
+			MMU_Fault_Addr   => X"00000000",
+			MMU_Retry        => open,
+			MMU_Pgd          => open,
+			MMU_Tlb_Hits     => X"00000000",
+			MMU_Tlb_Misses   => X"00000000",
+			MMU_Tlb_Inv      => open,
+			MMU_Tlb_Inv_Data => open,
+
+			ARB_Slot        => arb_slot,
+			ARB_Qos_Data    => open,
+			ARB_Qos_WE      => open,
+			ARB_Qos         => X"00000000",
+			ARB_Bytes_Read  => arb_bytes_read,
+			ARB_Bytes_Write => arb_bytes_write,
+
+			Bus2IP_Clk    => clk,
+			Bus2IP_Resetn => rstn,
+			Bus2IP_Data   => bus_data,
+			Bus2IP_BE     => X"F",
+			Bus2IP_RdCE   => bus_rdce,
+			Bus2IP_WrCE   => bus_wrce,
+			IP2Bus_Data   => bus_rd,
+			IP2Bus_RdAck  => bus_rdack,
+			IP2Bus_WrAck  => bus_wrack,
+			IP2Bus_Error  => bus_error
+		);
+
+	-- byte counters of the arbiter, distinct for each slot
+	arb_proc : process(arb_slot) is
+	begin
+		arb_bytes_read  <= (others => '0');
+		arb_bytes_write <= (others => '0');
+
+		if arb_slot < C_NUM_HWTS then
+			arb_bytes_read  <= conv_std_logic_vector(4096 * (conv_integer(arb_slot(15 downto 0)) + 1), 32);
+			arb_bytes_write <= conv_std_logic_vector(256 * (conv_integer(arb_slot(15 downto 0)) + 1), 32);
+		end if;
+	end process arb_proc;
+
+	slot_gen : for i in 0 to C_NUM_HWTS - 1 generate
+		osif_fifo : entity work.reconos_fifo
+			generic map (
+				C_FIFO_DEPTH => 32,
+				C_FIFO_WIDTH => 32
+			)
+			port map (
+				FIFO_S_Clk    => clk,
+				FIFO_S_Data   => osif_data(i),
+				FIFO_S_Fill   => open,
+				FIFO_S_Empty  => osif_empty(i),
+				FIFO_S_RE     => osif_re(i),
+				FIFO_M_Clk    => clk,
+				FIFO_M_Data   => fifo_in(i),
+				FIFO_M_Rem    => open,
+				FIFO_M_Full   => open,
+				FIFO_M_WE     => osif_we(i),
+				FIFO_Rst      => rst,
+				FIFO_Has_Data => open,
+				FIFO_S_Wait   => osif_wait(i)
+			);
+
+		memif_fifo : entity work.reconos_fifo
+			generic map (
+				C_FIFO_DEPTH => 32,
+				C_FIFO_WIDTH => 32
+			)
+			port map (
+				FIFO_S_Clk    => clk,
+				FIFO_S_Data   => memif_data(i),
+				FIFO_S_Fill   => open,
+				FIFO_S_Empty  => memif_empty(i),
+				FIFO_S_RE     => memif_re(i),
+				FIFO_M_Clk    => clk,
+				FIFO_M_Data   => fifo_in(i),
+				FIFO_M_Rem    => open,
+				FIFO_M_Full   => open,
+				FIFO_M_WE     => memif_we(i),
+				FIFO_Rst      => rst,
+				FIFO_Has_Data => open,
+				FIFO_S_Wait   => memif_wait(i)
+			);
+
+		-- the hardware thread reading the FIFOs and the delegate and
+		-- the memory writing them
+		slot_proc : process is
+			variable word, delay : integer;
+
+			-- reads a word written delay cycles after the thread set RE,
+			-- so that the thread waits delay + 1 cycles
+			procedure read_late (signal re    : out std_logic;
+			                     signal we    : out std_logic;
+			                     signal empty : in  std_logic;
+			                     signal data  : in  std_logic_vector(31 downto 0);
+			                     delay        : in  integer) is
+			begin
+				wait until falling_edge(clk);
+				re <= '1';
+				for k in 1 to delay loop
+					wait until falling_edge(clk);
+				end loop;
+				fifo_in(i) <= conv_std_logic_vector(word, 32);
+				we <= '1';
+				wait until falling_edge(clk);
+				we <= '0';
+
+				wait until rising_edge(clk) and empty = '0';
+				if data /= word then
+					report "slot " & integer'image(i) & ": wrong word read" severity error;
+					slot_errors(i) <= slot_errors(i) + 1;
+				end if;
+				wait until falling_edge(clk);
+				re <= '0';
+				word := word + 1;
+			end procedure read_late;
+
+			-- reads a word written before, the thread does not wait
+			procedure read_early (signal re    : out std_logic;
+			                      signal we    : out std_logic;
+			                      signal empty : in  std_logic) is
+			begin
+				wait until falling_edge(clk);
+				fifo_in(i) <= conv_std_logic_vector(word, 32);
+				we <= '1';
+				wait until falling_edge(clk);
+				we <= '0';
+				for k in 1 to 3 loop
+					wait until falling_edge(clk);
+				end loop;
+				re <= '1';
+				wait until falling_edge(clk);
+				re <= '0';
+				word := word + 1;
+			end procedure read_early;
+		begin
+			word := 0;
+
+			loop
+				wait until go > slot_done(i);
+
+				if mode(i) = C_MODE_READ then
+					for k in 0 to G_READS - 1 loop
+						delay := (7 * k + 5 * i) mod 23;
+						read_late(osif_re(i), osif_we(i), osif_empty(i), osif_data(i), delay);
+						exp_osif_wait(i) <= exp_osif_wait(i) + delay + 1;
+
+						delay := (11 * k + 3 * i) mod 31;
+						read_late(memif_re(i), memif_we(i), memif_empty(i), memif_data(i), delay);
+						exp_memif_wait(i) <= exp_memif_wait(i) + delay + 1;
+
+						read_early(osif_re(i), osif_we(i), osif_empty(i));
+						read_early(memif_re(i), memif_we(i), memif_empty(i));
+
+						-- computation without waiting
+						for c in 0 to 4 * k loop
+							wait until falling_edge(clk);
+						end loop;
+					end loop;
+				else
+					-- a thread held in reset waiting on its FIFOs
+					wait until falling_edge(clk);
+					osif_re(i)  <= '1';
+					memif_re(i) <= '1';
+					for k in 1 to 50 loop
+						wait until falling_edge(clk);
+					end loop;
+					osif_re(i)  <= '0';
+					memif_re(i) <= '0';
+				end if;
+
+				slot_done(i) <= go;
+			end loop;
+		end process slot_proc;
+	end generate slot_gen;
+
+	stim_proc : process is
+		variable errors, last_write : integer;
+		variable start              : integer;
+		variable data, latched      : std_logic_vector(31 downto 0);
+		variable exp_cycles         : INT_ARRAY_T;
+
+		procedure write_reg (reg : in integer; value : in std_logic_vector(31 downto 0)) is
+		begin
+			wait until falling_edge(clk);
+			last_write := cycle;
+			bus_data <= value;
+			bus_wrce(C_NUM_REG - 1 - reg) <= '1';
+			wait until falling_edge(clk);
+			bus_wrce <= (others => '0');
+		end procedure write_reg;
+
+		procedure read_reg (reg : in integer; value : out std_logic_vector(31 downto 0)) is
+		begin
+			wait until falling_edge(clk);
+			bus_rdce(C_NUM_REG - 1 - reg) <= '1';
+			wait until rising_edge(clk);
+			value := bus_rd;
+			wait until falling_edge(clk);
+			bus_rdce <= (others => '0');
+		end procedure read_reg;
+
+		procedure expect (reg : in integer; exp : in integer; msg : in string) is
+			variable value : std_logic_vector(31 downto 0);
+		begin
+			read_reg(reg, value);
+			if value /= exp then
+				report msg & ": " & integer'image(conv_integer(value(30 downto 0))) & " instead of "
+				       & integer'image(exp) severity error;
+				errors := errors + 1;
+			end if;
+		end procedure expect;
+
+		-- runs the slots in the modes given, the slots out of reset are
+		-- released for the run and the cycles they count are recorded
+		procedure run (mode0, mode1 : in integer; resets : in std_logic_vector(31 downto 0)) is
+			variable start : integer;
+		begin
+			write_reg(C_REG_HWT_RESET, resets);
+			start := last_write;
+
+			mode <= (mode0, mode1);
+			go <= go + 1;
+			wait until falling_edge(clk);
+
+			for i in 0 to C_NUM_HWTS - 1 loop
+				while slot_done(i) /= go loop
+					wait until falling_edge(clk);
+				end loop;
+			end loop;
+
+			write_reg(C_REG_HWT_RESET, X"FFFFFFFF");
+			for i in 0 to C_NUM_HWTS - 1 loop
+				if resets(i) = '0' then
+					exp_cycles(i) := exp_cycles(i) + last_write - start;
+				end if;
+			end loop;
+		end procedure run;
+
+		procedure check_slot (slot : in integer) is
+			constant name : string := "slot " & integer'image(slot);
+		begin
+			write_reg(C_REG_SLOT, conv_std_logic_vector(slot, 32));
+			expect(C_REG_CYCLES, exp_cycles(slot), name & " cycles");
+			expect(C_REG_OSIF_WAIT, exp_osif_wait(slot), name & " osif wait");
+			expect(C_REG_MEMIF_WAIT, exp_memif_wait(slot), name & " memif wait");
+			expect(C_REG_BYTES_READ, 4096 * (slot + 1), name & " bytes read");
+			expect(C_REG_BYTES_WRITE, 256 * (slot + 1), name & " bytes written");
+			expect(C_REG_BYTES, 4352 * (slot + 1), name & " bytes transferred");
+
+			-- the counters are far from 32 bit and the arbiter still
+			-- sees the slot
+			write_reg(C_REG_SLOT, conv_std_logic_vector(slot, 32) or X"80000000");
+			expect(C_REG_CYCLES, 0, name & " cycles upper half");
+			expect(C_REG_OSIF_WAIT, 0, name & " osif wait upper half");
+			expect(C_REG_MEMIF_WAIT, 0, name & " memif wait upper half");
+			expect(C_REG_BYTES_READ, 4096 * (slot + 1), name & " bytes read with upper half");
+
+			report name & ": " & integer'image(exp_cycles(slot)) & " cycles, "
+			       & integer'image(exp_osif_wait(slot)) & " osif wait, "
+			       & integer'image(exp_memif_wait(slot)) & " memif wait";
+		end procedure check_slot;
+	begin
+		errors := 0;
+		exp_cycles := (others => 0);
+
+		wait for 4 * G_CLK_HALF;
+		wait until falling_edge(clk);
+		rst <= '0';
+
+		-- the system reset after power on takes 16 cycles
+		for k in 1 to 20 loop
+			wait until falling_edge(clk);
+		end loop;
+
+		expect(C_REG_NUM_HWTS, C_NUM_HWTS, "number of hwts");
+
+		-- nothing is counted while all slots are held in reset
+		for k in 1 to 100 loop
+			wait until falling_edge(clk);
+		end loop;
+		check_slot(0);
+		check_slot(1);
+
+		-- slot 0 runs, slot 1 waits on its FIFOs while in reset
+		run(C_MODE_READ, C_MODE_STALL, X"FFFFFFFE");
+		check_slot(0);
+		check_slot(1);
+
+		-- both slots run, the counters keep their values over the reset
+		-- of the thread
+		run(C_MODE_READ, C_MODE_READ, X"FFFFFFFC");
+		check_slot(0);
+		check_slot(1);
+
+		-- a slot out of range reads as zero
+		write_reg(C_REG_SLOT, conv_std_logic_vector(C_NUM_HWTS, 32));
+		expect(C_REG_CYCLES, 0, "cycles of a slot out of range");
+		expect(C_REG_OSIF_WAIT, 0, "osif wait of a slot out of range");
+		expect(C_REG_MEMIF_WAIT, 0, "memif wait of a slot out of range");
+
+		-- the counters of a running slot stay latched until the slot is
+		-- selected again
+		write_reg(C_REG_HWT_RESET, X"FFFFFFFE");
+		write_reg(C_REG_SLOT, X"00000000");
+		start := last_write;
+		read_reg(C_REG_CYCLES, latched);
+		for k in 1 to 50 loop
+			wait until falling_edge(clk);
+		end loop;
+		expect(C_REG_CYCLES, conv_integer(latched), "cycles changed while latched");
+		write_reg(C_REG_SLOT, X"00000000");
+		expect(C_REG_CYCLES, conv_integer(latched) + last_write - start, "cycles latched again");
+		write_reg(C_REG_HWT_RESET, X"FFFFFFFF");
+
+		-- the system reset clears all counters
+		write_reg(C_REG_SYS_RESET, X"00000000");
+		for k in 1 to 20 loop
+			wait until falling_edge(clk);
+		end loop;
+		for i in 0 to C_NUM_HWTS - 1 loop
+			write_reg(C_REG_SLOT, conv_std_logic_vector(i, 32));
+			expect(C_REG_CYCLES, 0, "cycles after system reset");
+			expect(C_REG_OSIF_WAIT, 0, "osif wait after system reset");
+			expect(C_REG_MEMIF_WAIT, 0, "memif wait after system reset");
+		end loop;
+
+		for i in 0 to C_NUM_HWTS - 1 loop
+			errors := errors + slot_errors(i);
+		end loop;
+
+		if errors = 0 then
+			report "tb_perf: PASSED";
+		else
+			report "tb_perf: FAILED (" & integer'image(errors) & " errors)" severity failure;
+		end if;
+
+		done <= True;
+		wait;
+	end process stim_proc;
+
+end architecture implementation;
@@ -0,0 +1,367 @@
+--                                                        ____  _____
+--                            ________  _________  ____  / __ \/ ___/
+--                           / ___/ _ \/ ___/ __ \/ __ \/ / / /\__ \
+--                          / /  /  __/ /__/ /_/ / / / / /_/ /___/ /
+--                         /_/   \___/\___/\____/_/ /_/\____//____/
+--
+-- ======================================================================
+--
+--   title:        Testbench - Sort demo sorters
+--
+--   project:      ReconOS
+--   description:  Runs bitonic_sorter and bubble_sorter of the sort demo
+--                 side by side on the 8 KB block of hwt_sort_demo, each
+--                 on a local RAM modelled like in hwt_sort_demo.vhd, and
+--                 reports the cycles per block. Both must leave the
+--                 same ascending permutation of the input.
+--
+--                 The RAM accesses of the bitonic sorter are followed
+--                 compare by compare against the index walk of the
+--                 network (stage k, step j, element i and its partner
+--                 i + j, descending if bit k of i is set), including the
+--                 decision to swap, and its cycles must be three per
+--                 compare and two per swap.
+--
+-- ======================================================================
+
+library ieee;
+use ieee.std_logic_1164.all;
+use ieee.std_logic_arith.all;
+use ieee.std_logic_unsigned.all;
+
+entity tb_sort is
+	generic (
+		G_LEN      : integer := 2048;
+		G_AWIDTH   : integer := 11;
+		G_CLK_HALF : time    := 5 ns
+	);
+end entity tb_sort;
+
+architecture implementation of tb_sort is
+	-- data sets sorted
+	constant C_NUM_SETS : integer := 5;
+	constant C_RANDOM   : integer := 0;
+	constant C_SORTED   : integer := 1;
+	constant C_REVERSED : integer := 2;
+	constant C_CONSTANT : integer := 3;
+	constant C_FEW      : integer := 4;
+
+	type SET_NAMES_T is array(0 to C_NUM_SETS - 1) of string(1 to 8);
+	constant C_SET_NAMES : SET_NAMES_T := ("random  ", "sorted  ", "reversed", "constant", "few     ");
+
+	type MEM_T   is array(0 to G_LEN - 1) of std_logic_vector(0 to 31);
+	type MODEL_T is array(0 to G_LEN - 1) of integer;
+
+	-- word idx of a data set, below 2^31 to compare as integers
+	function gen (set : integer; idx : integer) return integer is
+	begin
+		case set is
+			when C_RANDOM   => return ((idx * 7919 + 104729) * 31) mod 1000003;
+			when C_SORTED   => return idx;
+			when C_REVERSED => return G_LEN - idx;
+			when C_CONSTANT => return 42;
+			when others     => return (idx * 5) mod 7;
+		end case;
+	end function gen;
+
+	signal clk   : std_logic := '0';
+	signal rst   : std_logic := '1';
+	signal done  : boolean := False;
+
+	signal set   : integer := 0;
+	signal init  : std_logic := '0';
+	signal start : std_logic := '0';
+
+	signal bit_addr  : std_logic_vector(0 to G_AWIDTH - 1);
+	signal bit_wdata : std_logic_vector(0 to 31);
+	signal bit_rdata : std_logic_vector(0 to 31) := (others => '0');
+	signal bit_we    : std_logic;
+	signal bit_done  : std_logic;
+	signal bit_mem   : MEM_T;
+
+	signal bub_addr  : std_logic_vector(0 to G_AWIDTH - 1);
+	signal bub_wdata : std_logic_vector(0 to 31);
+	signal bub_rdata : std_logic_vector(0 to 31) := (others => '0');
+	signal bub_we    : std_logic;
+	signal bub_done  : std_logic;
+	signal bub_mem   : MEM_T;
+
+	-- results of following the index walk of the bitonic sorter
+	signal walk_compares : integer := 0;
+	signal walk_swaps    : integer := 0;
+	signal walk_errors   : integer := 0;
+	signal walk_done     : integer := 0;
+begin
+
+	clk <= not clk after G_CLK_HALF when not done else clk;
+
+	bitonic : entity work.bitonic_sorter
+		generic map (
+			G_LEN    => G_LEN,
+			G_AWIDTH => G_AWIDTH,
+			G_DWIDTH => 32
+		)
+		port map (
+			clk       => clk,
+			reset     => rst,
+			o_RAMAddr => bit_addr,
+			o_RAMData => bit_wdata,
+			i_RAMData => bit_rdata,
+			o_RAMWE   => bit_we,
+			start     => start,
+			done      => bit_done
+		);
+
+	bubble : entity work.bubble_sorter
+		generic map (
+			G_LEN    => G_LEN,
+			G_AWIDTH => G_AWIDTH,
+			G_DWIDTH => 32
+		)
+		port map (
+			clk       => clk,
+			reset     => rst,
+			o_RAMAddr => bub_addr,
+			o_RAMData => bub_wdata,
+			i_RAMData => bub_rdata,
+			o_RAMWE   => bub_we,
+			start     => start,
+			done      => bub_done
+		);
+
+	-- local RAMs like in hwt_sort_demo, a write does not read
+	bit_ram_proc : process(clk) is
+	begin
+		if rising_edge(clk) then
+			if init = '1' then
+				for x in 0 to G_LEN - 1 loop
+					bit_mem(x) <= conv_std_logic_vector(gen(set, x), 32);
+				end loop;
+			elsif bit_we = '1' then
+				bit_mem(conv_integer(bit_addr)) <= bit_wdata;
+			else
+				bit_rdata <= bit_mem(conv_integer(bit_addr));
+			end if;
+		end if;
+	end process bit_ram_proc;
+
+	bub_ram_proc : process(clk) is
+	begin
+		if rising_edge(clk) then
+			if init = '1' then
+				for x in 0 to G_LEN - 1 loop
+					bub_mem(x) <= conv_std_logic_vector(gen(set, x), 32);
+				end loop;
+			elsif bub_we = '1' then
+				bub_mem(conv_integer(bub_addr)) <= bub_wdata;
+			else
+				bub_rdata <= bub_mem(conv_integer(bub_addr));
+			end if;
+		end if;
+	end process bub_ram_proc;
+
+	-- follows the bitonic sorter compare by compare on its RAM port,
+	-- sampling each cycle at the rising edge that ends it
+	--
+	--   LOAD_WAIT_B: address i, LOAD_A and LOAD_B: address i + j,
+	--   on a swap WRITE_A: B to i and WRITE_B: A to i + j
+	--
+	walk_proc : process is
+		variable model            : MODEL_T;
+		variable k, j, p, tmp     : integer;
+		variable compares, swaps  : integer;
+		variable errors           : integer;
+		variable asc, swap        : boolean;
+
+		procedure expect (addr : in integer; we : in std_logic; data : in integer) is
+		begin
+			wait until rising_edge(clk);
+			if conv_integer(bit_addr) /= addr or bit_we /= we
+			   or (we = '1' and conv_integer(bit_wdata(1 to 31)) /= data) then
+				if errors < 10 then
+					report "bitonic sorter left the index walk at compare "
+					       & integer'image(compares) & " (k = " & integer'image(k)
+					       & ", j = " & integer'image(j) & ")" severity error;
+				end if;
+				errors := errors + 1;
+			end if;
+		end procedure expect;
+	begin
+		loop
+			wait until rising_edge(clk) and start = '1';
+
+			for x in 0 to G_LEN - 1 loop
+				model(x) := gen(set, x);
+			end loop;
+			compares := 0;
+			swaps    := 0;
+			errors   := 0;
+
+			k := 2;
+			while k <= G_LEN loop
+				j := k / 2;
+				while j >= 1 loop
+					for i in 0 to G_LEN - 1 loop
+						if (i / j) mod 2 = 0 then
+							p   := i + j;
+							asc := (i / k) mod 2 = 0;
+
+							expect(i, '0', 0);
+							expect(p, '0', 0);
+							expect(p, '0', 0);
+
+							if asc then
+								swap := model(i) > model(p);
+							else
+								swap := model(i) < model(p);
+							end if;
+
+							if swap then
+								expect(i, '1', model(p));
+								expect(p, '1', model(i));
+								tmp      := model(i);
+								model(i) := model(p);
+								model(p) := tmp;
+								swaps    := swaps + 1;
+							end if;
+
+							compares := compares + 1;
+						end if;
+					end loop;
+					j := j / 2;
+				end loop;
+				k := k * 2;
+			end loop;
+
+			wait until falling_edge(clk);
+			if bit_done /= '1' then
+				report "bitonic sorter not done after the last compare" severity error;
+				errors := errors + 1;
+			end if;
+
+			for x in 0 to G_LEN - 1 loop
+				if conv_integer(bit_mem(x)(1 to 31)) /= model(x) then
+					report "bitonic sorter result differs from the network" severity error;
+					errors := errors + 1;
+					exit;
+				end if;
+			end loop;
+
+			walk_compares <= compares;
+			walk_swaps    <= swaps;
+			walk_errors   <= walk_errors + errors;
+			walk_done     <= walk_done + 1;
+		end loop;
+	end process walk_proc;
+
+	stim_proc : process is
+		variable errors                 : integer;
+		variable cycles, bit_cycles     : integer;
+		variable bub_cycles, runs       : integer;
+		variable bit_finished           : boolean;
+		variable bub_finished           : boolean;
+		variable sum_in, sum_out        : integer;
+	begin
+		errors := 0;
+		runs   := 0;
+
+		wait for 4 * G_CLK_HALF;
+		wait until falling_edge(clk);
+		rst <= '0';
+
+		for s in 0 to C_NUM_SETS - 1 loop
+			wait until falling_edge(clk);
+			set  <= s;
+			init <= '1';
+			wait until falling_edge(clk);
+			init <= '0';
+			wait until falling_edge(clk);
+
+			start <= '1';
+			wait until falling_edge(clk);
+			start <= '0';
+
+			-- the start edge is not counted
+			cycles       := 1;
+			bit_finished := False;
+			bub_finished := False;
+			while not (bit_finished and bub_finished) loop
+				if bit_done = '1' and not bit_finished then
+					bit_cycles   := cycles;
+					bit_finished := True;
+				end if;
+				if bub_done = '1' and not bub_finished then
+					bub_cycles   := cycles;
+					bub_finished := True;
+				end if;
+				wait until falling_edge(clk);
+				cycles := cycles + 1;
+			end loop;
+
+			runs := runs + 1;
+			while walk_done /= runs loop
+				wait until falling_edge(clk);
+			end loop;
+
+			report C_SET_NAMES(s) & ": bitonic " & integer'image(bit_cycles) & " cycles ("
+			       & integer'image(walk_compares) & " compares, " & integer'image(walk_swaps)
+			       & " swaps), bubble " & integer'image(bub_cycles) & " cycles per "
+			       & integer'image(4 * G_LEN) & " byte block";
+
+			-- both leave the same ascending permutation of the input
+			sum_in  := 0;
+			sum_out := 0;
+			for x in 0 to G_LEN - 1 loop
+				sum_in  := (sum_in + gen(s, x)) mod 1000003;
+				sum_out := (sum_out + conv_integer(bit_mem(x)(1 to 31))) mod 1000003;
+
+				if bit_mem(x) /= bub_mem(x) then
+					report C_SET_NAMES(s) & ": sorters differ at word " & integer'image(x) severity error;
+					errors := errors + 1;
+					exit;
+				end if;
+
+				if x > 0 and bit_mem(x - 1) > bit_mem(x) then
+					report C_SET_NAMES(s) & ": not sorted at word " & integer'image(x) severity error;
+					errors := errors + 1;
+					exit;
+				end if;
+			end loop;
+
+			if sum_in /= sum_out then
+				report C_SET_NAMES(s) & ": result is no permutation of the input" severity error;
+				errors := errors + 1;
+			end if;
+
+			-- compares of the network and cycles per compare and swap
+			if walk_compares /= G_LEN / 2 * G_AWIDTH * (G_AWIDTH + 1) / 2 then
+				report C_SET_NAMES(s) & ": wrong number of compares" severity error;
+				errors := errors + 1;
+			end if;
+
+			if bit_cycles /= 3 * walk_compares + 2 * walk_swaps then
+				report C_SET_NAMES(s) & ": bitonic sorter takes " & integer'image(bit_cycles)
+				       & " instead of " & integer'image(3 * walk_compares + 2 * walk_swaps)
+				       & " cycles" severity error;
+				errors := errors + 1;
+			end if;
+
+			if (s = C_RANDOM or s = C_REVERSED) and bit_cycles >= bub_cycles then
+				report C_SET_NAMES(s) & ": bitonic sorter not faster than bubble sorter" severity error;
+				errors := errors + 1;
+			end if;
+		end loop;
+
+		errors := errors + walk_errors;
+
+		if errors = 0 then
+			report "tb_sort: PASSED";
+		else
+			report "tb_sort: FAILED (" & integer'image(errors) & " errors)" severity failure;
+		end if;
+
+		done <= True;
+		wait;
+	end process stim_proc;
+
+end architecture implementation;
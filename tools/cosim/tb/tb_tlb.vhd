@@ -0,0 +1,218 @@
+--                                                        ____  _____
+--                            ________  _________  ____  / __ \/ ___/
+--                           / ___/ _ \/ ___/ __ \/ __ \/ / / /\__ \
+--                          / /  /  __/ /__/ /_/ / / / / /_/ /___/ /
+--                         /_/   \___/\___/\____/_/ /_/\____//____/
+--
+-- ======================================================================
+--
+--   title:        Testbench - MEMIF MMU - TLB
+--
+--   project:      ReconOS
+--   description:  Replays an address stream of gen_streams.py on the
+--                 TLB like the MMU does: a miss is followed by a write
+--                 of the translation in the next cycle. The hits must
+--                 match the pseudo-LRU model of gen_streams.py and are
+--                 reported together with the hits of the former
+--                 round-robin replacement. Afterwards the invalidation
+--                 by tag and of all entries is checked.
+--
+-- ======================================================================
+
+library ieee;
+use ieee.std_logic_1164.all;
+use ieee.std_logic_arith.all;
+use ieee.std_logic_unsigned.all;
+
+library std;
+use std.textio.all;
+
+entity tb_tlb is
+	generic (
+		G_STREAM   : string  := "sort.txt";
+		G_TLB_SIZE : integer := 16;
+		G_CLK_HALF : time    := 5 ns
+	);
+end entity tb_tlb;
+
+architecture implementation of tb_tlb is
+	signal clk  : std_logic := '0';
+	signal rst  : std_logic := '1';
+	signal done : boolean := False;
+
+	signal tlb_tag     : std_logic_vector(19 downto 0) := (others => '0');
+	signal tlb_di      : std_logic_vector(31 downto 0) := (others => '0');
+	signal tlb_do      : std_logic_vector(31 downto 0);
+	signal tlb_we      : std_logic := '0';
+	signal tlb_hit     : std_logic;
+	signal tlb_inv     : std_logic := '0';
+	signal tlb_inv_all : std_logic := '0';
+	signal tlb_inv_tag : std_logic_vector(19 downto 0) := (others => '0');
+
+	-- translation written for a page, distinct for every page
+	function translation (page : integer) return std_logic_vector is
+	begin
+		return (conv_std_logic_vector(page, 20) xor X"5A5A5") & X"A5A";
+	end function translation;
+begin
+
+	clk <= not clk after G_CLK_HALF when not done else clk;
+
+	dut : entity work.tlb
+		generic map (
+			C_TLB_SIZE  => G_TLB_SIZE,
+			C_TAG_SIZE  => 20,
+			C_DATA_SIZE => 32
+		)
+		port map (
+			TLB_Tag     => tlb_tag,
+			TLB_DI      => tlb_di,
+			TLB_DO      => tlb_do,
+			TLB_WE      => tlb_we,
+			TLB_Hit     => tlb_hit,
+
+			TLB_Inv     => tlb_inv,
+			TLB_Inv_All => tlb_inv_all,
+			TLB_Inv_Tag => tlb_inv_tag,
+
+			TLB_Clk     => clk,
+			TLB_Rst     => rst
+		);
+
+	stim_proc : process is
+		file stream : text open read_mode is G_STREAM;
+		variable l  : line;
+
+		variable lookups, plru_hits, rr_hits : integer;
+		variable page, hits, errors          : integer;
+
+		-- looks up a page and writes the translation on a miss,
+		-- returns whether the lookup hit
+		procedure lookup (page : in integer; hit : out boolean) is
+		begin
+			wait until falling_edge(clk);
+			tlb_tag <= conv_std_logic_vector(page, 20);
+			wait until rising_edge(clk);
+
+			if tlb_hit = '1' then
+				hit := True;
+				if tlb_do /= translation(page) then
+					report "wrong translation of page " & integer'image(page) severity error;
+					errors := errors + 1;
+				end if;
+			else
+				hit := False;
+				wait until falling_edge(clk);
+				tlb_di <= translation(page);
+				tlb_we <= '1';
+				wait until falling_edge(clk);
+				tlb_we <= '0';
+			end if;
+		end procedure lookup;
+
+		procedure invalidate (page : in integer; all_entries : in std_logic) is
+		begin
+			wait until falling_edge(clk);
+			tlb_inv_tag <= conv_std_logic_vector(page, 20);
+			tlb_inv_all <= all_entries;
+			tlb_inv     <= '1';
+			wait until falling_edge(clk);
+			tlb_inv     <= '0';
+			tlb_inv_all <= '0';
+		end procedure invalidate;
+
+		procedure expect (page : in integer; exp : in boolean; msg : in string) is
+		begin
+			wait until falling_edge(clk);
+			tlb_tag <= conv_std_logic_vector(page, 20);
+			wait until rising_edge(clk);
+
+			if (tlb_hit = '1') /= exp then
+				report msg & " (page " & integer'image(page) & ")" severity error;
+				errors := errors + 1;
+			end if;
+		end procedure expect;
+
+		variable hit : boolean;
+	begin
+		errors := 0;
+		hits   := 0;
+
+		wait for 4 * G_CLK_HALF;
+		rst <= '0';
+
+		-- replay of the stream
+		readline(stream, l);
+		read(l, lookups);
+		read(l, plru_hits);
+		read(l, rr_hits);
+
+		for i in 1 to lookups loop
+			readline(stream, l);
+			read(l, page);
+			lookup(page, hit);
+			if hit then
+				hits := hits + 1;
+			end if;
+		end loop;
+
+		report G_STREAM & ": " & integer'image(lookups) & " lookups, "
+		       & integer'image(hits) & " hits (" & integer'image(100 * hits / lookups)
+		       & "%), round-robin " & integer'image(rr_hits) & " hits ("
+		       & integer'image(100 * rr_hits / lookups) & "%)";
+
+		if hits /= plru_hits then
+			report "hits differ from the pseudo-LRU model (" & integer'image(plru_hits) & ")"
+				severity error;
+			errors := errors + 1;
+		end if;
+
+		-- invalidation of all entries
+		invalidate(0, '1');
+		for i in 0 to G_TLB_SIZE - 1 loop
+			expect(16#FFF00# + i, False, "hit after invalidation of all entries");
+			lookup(16#FFF00# + i, hit);
+		end loop;
+
+		-- a full TLB hits on all pages written
+		for i in 0 to G_TLB_SIZE - 1 loop
+			expect(16#FFF00# + i, True, "miss on a full TLB");
+		end loop;
+
+		-- invalidation by tag only affects the page given
+		invalidate(16#FFF00# + 3, '0');
+		for i in 0 to G_TLB_SIZE - 1 loop
+			expect(16#FFF00# + i, i /= 3, "wrong entry invalidated by tag");
+		end loop;
+
+		-- the invalid entry is reused before any valid one
+		lookup(16#FFFF0#, hit);
+		for i in 0 to G_TLB_SIZE - 1 loop
+			expect(16#FFF00# + i, i /= 3, "valid entry replaced instead of the invalid one");
+		end loop;
+		expect(16#FFFF0#, True, "miss on the page written last");
+
+		-- a translation invalidated while being written is dropped
+		invalidate(16#FFFF0#, '0');
+		wait until falling_edge(clk);
+		tlb_tag     <= conv_std_logic_vector(16#FFFF1#, 20);
+		tlb_di      <= translation(16#FFFF1#);
+		tlb_we      <= '1';
+		tlb_inv_tag <= conv_std_logic_vector(16#FFFF1#, 20);
+		tlb_inv     <= '1';
+		wait until falling_edge(clk);
+		tlb_we      <= '0';
+		tlb_inv     <= '0';
+		expect(16#FFFF1#, False, "translation invalidated while written is valid");
+
+		if errors = 0 then
+			report G_STREAM & ": PASSED";
+		else
+			report G_STREAM & ": FAILED (" & integer'image(errors) & " errors)" severity failure;
+		end if;
+
+		done <= True;
+		wait;
+	end process stim_proc;
+
+end architecture implementation;
@@ -0,0 +1,153 @@
+/*
+ *                                                        ____  _____
+ *                            ________  _________  ____  / __ \/ ___/
+ *                           / ___/ _ \/ ___/ __ \/ __ \/ / / /\__ \
+ *                          / /  /  __/ /__/ /_/ / / / / /_/ /___/ /
+ *                         /_/   \___/\___/\____/_/ /_/\____//____/
+ *
+ * ======================================================================
+ *
+ *   title:        Test - Ranged cache maintenance
+ *
+ *   project:      ReconOS
+ *   description:  Checks the line operations counted by the cosim
+ *                 backend for reconos_cache_flush_range and
+ *                 reconos_cache_invalidate_range against the number of
+ *                 lines a range covers, including unaligned ranges and
+ *                 the fallback to a flush of the entire cache. An
+ *                 invalidation must flush the partly covered lines at
+ *                 the ends of the range to keep the data of neighbours.
+ *
+ * ======================================================================
+ */
+
+#include "reconos.h"
+#include "cosim.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+
+// data cache emulated by the cosim backend
+#define DCACHE_BYTE_SIZE (64 * 1024)
+#define DCACHE_LINE_LEN  (4 * 4)
+
+#define RANDOM_RANGES    10000
+
+static struct cosim_shm *shm;
+static int errors;
+
+/*
+ * Number of lines covered by the range, computed from the first and
+ * last line instead of the range math of the backend.
+ */
+static uint64_t lines_covered(uintptr_t addr, size_t len) {
+	if (len == 0)
+		return 0;
+
+	return (addr + len - 1) / DCACHE_LINE_LEN - addr / DCACHE_LINE_LEN + 1;
+}
+
+/*
+ * Number of lines lying fully inside the range. Only these may be
+ * invalidated, the partly covered ones are flushed instead.
+ */
+static uint64_t lines_inside(uintptr_t addr, size_t len) {
+	uintptr_t first = (addr + DCACHE_LINE_LEN - 1) / DCACHE_LINE_LEN;
+	uintptr_t last = (addr + len) / DCACHE_LINE_LEN;
+
+	return last > first ? last - first : 0;
+}
+
+static void check_range(int invalidate, uintptr_t addr, size_t len) {
+	uint64_t flushes, flushed, invalidated;
+	uint64_t exp_flushes = 0, exp_flushed = 0, exp_invalidated = 0;
+
+	flushes = shm->cache_flushes;
+	flushed = shm->cache_lines_flushed;
+	invalidated = shm->cache_lines_invalidated;
+
+	if (invalidate)
+		reconos_cache_invalidate_range((void *)addr, len);
+	else
+		reconos_cache_flush_range((void *)addr, len);
+
+	if (len >= DCACHE_BYTE_SIZE) {
+		exp_flushes = 1;
+		exp_flushed = DCACHE_BYTE_SIZE / DCACHE_LINE_LEN;
+	} else if (invalidate) {
+		exp_invalidated = lines_inside(addr, len);
+		exp_flushed = lines_covered(addr, len) - exp_invalidated;
+	} else {
+		exp_flushed = lines_covered(addr, len);
+	}
+
+	if (shm->cache_flushes - flushes != exp_flushes
+	    || shm->cache_lines_flushed - flushed != exp_flushed
+	    || shm->cache_lines_invalidated - invalidated != exp_invalidated) {
+		fprintf(stderr, "%s of 0x%lx, %zu bytes: %llu/%llu/%llu instead of %llu/%llu/%llu\n",
+		        invalidate ? "invalidate" : "flush", (unsigned long)addr, len,
+		        (unsigned long long)(shm->cache_flushes - flushes),
+		        (unsigned long long)(shm->cache_lines_flushed - flushed),
+		        (unsigned long long)(shm->cache_lines_invalidated - invalidated),
+		        (unsigned long long)exp_flushes,
+		        (unsigned long long)exp_flushed,
+		        (unsigned long long)exp_invalidated);
+		errors++;
+	}
+}
+
+int main(int argc, char **argv) {
+	uint64_t ranged, full;
+	unsigned int seed = 1;
+	int fd, i, inv;
+
+	setenv("RECONOS_COSIM_SLOTS", "1", 1);
+	reconos_init();
+
+	fd = shm_open(COSIM_SHM_NAME, O_RDWR, 0);
+	if (fd < 0) {
+		fprintf(stderr, "unable to open shared memory\n");
+		return EXIT_FAILURE;
+	}
+	shm = mmap(NULL, sizeof(struct cosim_shm), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	close(fd);
+	if (shm == MAP_FAILED) {
+		fprintf(stderr, "unable to map shared memory\n");
+		return EXIT_FAILURE;
+	}
+
+	// the backend only counts, so the addresses need not be mapped
+	for (inv = 0; inv < 2; inv++) {
+		check_range(inv, 0x1000, 0);
+		check_range(inv, 0x1000, 1);
+		check_range(inv, 0x1000, DCACHE_LINE_LEN);
+		check_range(inv, 0x1000, DCACHE_LINE_LEN + 1);
+		check_range(inv, 0x100F, 2);
+		check_range(inv, 0x1001, DCACHE_LINE_LEN);
+		check_range(inv, 0x1001, DCACHE_BYTE_SIZE - 1);
+		check_range(inv, 0x1000, DCACHE_BYTE_SIZE);
+		check_range(inv, 0x1000, 8 * 1024 * 1024);
+
+		for (i = 0; i < RANDOM_RANGES; i++)
+			check_range(inv, rand_r(&seed), rand_r(&seed) % (2 * DCACHE_BYTE_SIZE));
+	}
+
+	// what sort_demo saves by flushing a block instead of the cache
+	ranged = lines_covered(0x1000, 8 * 1024);
+	full = DCACHE_BYTE_SIZE / DCACHE_LINE_LEN;
+
+	printf("cache_test: %d ranges, 8 KB block flushes %llu instead of %llu lines\n",
+	       2 * (RANDOM_RANGES + 9), (unsigned long long)ranged, (unsigned long long)full);
+
+	if (errors) {
+		printf("cache_test: FAILED (%d errors)\n", errors);
+		return EXIT_FAILURE;
+	}
+
+	printf("cache_test: PASSED\n");
+	return EXIT_SUCCESS;
+}
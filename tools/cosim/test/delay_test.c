@@ -0,0 +1,266 @@
+/*
+ *                                                        ____  _____
+ *                            ________  _________  ____  / __ \/ ___/
+ *                           / ___/ _ \/ ___/ __ \/ __ \/ / / /\__ \
+ *                          / /  /  __/ /__/ /_/ / / / / /_/ /___/ /
+ *                         /_/   \___/\___/\____/_/ /_/\____//____/
+ *
+ * ======================================================================
+ *
+ *   title:        Test - OSIF_CMD_THREAD_DELAY
+ *
+ *   project:      ReconOS
+ *   description:  Runs the runtime on the cosim backend and replaces the
+ *                 GHDL simulation by software stubs, one per slot, which
+ *                 write OSIF commands into the shared memory rings. The
+ *                 stubs check that delays never expire early, that the
+ *                 results of tagged delays are delivered once each and
+ *                 that the delegates keep answering other calls while
+ *                 many delays are pending on all slots. The lateness
+ *                 depends on the load of the host and is only reported.
+ *
+ * ======================================================================
+ */
+
+#include "reconos.h"
+#include "cosim.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <time.h>
+#include <pthread.h>
+#include <sys/mman.h>
+
+#define OSIF_CMD_THREAD_GET_INIT_DATA  0x000000A0
+#define OSIF_CMD_THREAD_DELAY          0x000000A1
+#define OSIF_CMD_THREAD_EXIT           0x000000A2
+#define OSIF_CMD_TAGGED_RESULT         0x000000A7
+#define OSIF_CMD_TAGGED_MASK           0x40000000
+#define OSIF_CMD_TAG_SHIFT             16
+
+#define NUM_SLOTS        8
+
+// untagged delays per slot and their maximum length
+#define SYNC_DELAYS      20
+#define SYNC_DELAY_MAX   20000
+
+// tagged delays per slot, all pending at the same time
+#define TAGGED_DELAYS    128
+#define TAGGED_DELAY_MIN 100000
+#define TAGGED_DELAY_MAX 300000
+
+// calls issued while the tagged delays are pending
+#define PROBE_CALLS      50
+
+static struct cosim_shm *shm;
+static struct reconos_hwt hwt[NUM_SLOTS];
+static uint32_t init_data[NUM_SLOTS];
+
+/*
+ * Results of a stub
+ *
+ *   late_max  - maximum lateness of a delay
+ *   late_sum  - sum of the lateness of all delays
+ *   probe_max - maximum response time of a call while delays are pending
+ *   errors    - number of failed checks
+ */
+struct stub_result {
+	uint64_t late_max;
+	uint64_t late_sum;
+	uint64_t probe_max;
+	int errors;
+};
+
+static struct stub_result result[NUM_SLOTS];
+
+static uint64_t now() {
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+static void hw_write(int slot, uint32_t data) {
+	struct cosim_fifo *fifo = &shm->slot[slot].hw2sw;
+
+	while (cosim_fifo_rem(fifo) == 0)
+		usleep(10);
+
+	cosim_fifo_push(fifo, data);
+}
+
+static uint32_t hw_read(int slot) {
+	struct cosim_fifo *fifo = &shm->slot[slot].sw2hw;
+	uint32_t data;
+
+	while (cosim_fifo_fill(fifo) == 0)
+		usleep(10);
+
+	data = cosim_fifo_peek(fifo);
+	cosim_fifo_pop(fifo);
+
+	return data;
+}
+
+static void check(struct stub_result *res, int cond, int slot, char *msg) {
+	if (cond)
+		return;
+
+	fprintf(stderr, "slot %d: %s\n", slot, msg);
+	res->errors++;
+}
+
+static void account(struct stub_result *res, int slot,
+                    uint64_t deadline, uint64_t done) {
+	check(res, done >= deadline, slot, "delay expired early");
+	if (done < deadline)
+		return;
+
+	res->late_sum += done - deadline;
+	if (done - deadline > res->late_max)
+		res->late_max = done - deadline;
+}
+
+/*
+ * Checks that the delegate answers a call while delays are pending.
+ */
+static void probe(struct stub_result *res, int slot) {
+	uint64_t start, t;
+	uint32_t data;
+
+	start = now();
+	hw_write(slot, OSIF_CMD_THREAD_GET_INIT_DATA);
+	data = hw_read(slot);
+	t = now() - start;
+
+	check(res, data == reconos_addr_to_hwt(&init_data[slot]), slot, "wrong init data");
+	if (t > res->probe_max)
+		res->probe_max = t;
+}
+
+static void *stub_thread(void *arg) {
+	int slot = (long)arg;
+	struct stub_result *res = &result[slot];
+	uint64_t deadline[TAGGED_DELAYS], start, last = 0;
+	uint32_t delay, tag, seen[TAGGED_DELAYS];
+	unsigned int seed = slot;
+	int i;
+
+	memset(seen, 0, sizeof(seen));
+
+	// the delegate resets the slot before reading the first command
+	while (hwt[slot].state != RECONOS_HWT_STATE_RUNNING)
+		usleep(1000);
+
+	// untagged delays, the reply is written on expiration
+	for (i = 0; i < SYNC_DELAYS; i++) {
+		delay = 1000 + rand_r(&seed) % SYNC_DELAY_MAX;
+
+		start = now();
+		hw_write(slot, OSIF_CMD_THREAD_DELAY);
+		hw_write(slot, delay);
+		check(res, hw_read(slot) == 0, slot, "wrong result of delay");
+		account(res, slot, start + delay, now());
+	}
+
+	// tagged delays, all pending at once
+	for (i = 0; i < TAGGED_DELAYS; i++) {
+		delay = TAGGED_DELAY_MIN + rand_r(&seed) % (TAGGED_DELAY_MAX - TAGGED_DELAY_MIN);
+
+		deadline[i] = now() + delay;
+		if (deadline[i] > last)
+			last = deadline[i];
+		hw_write(slot, OSIF_CMD_THREAD_DELAY | OSIF_CMD_TAGGED_MASK | i << OSIF_CMD_TAG_SHIFT);
+		hw_write(slot, delay);
+	}
+
+	for (i = 0; i < PROBE_CALLS; i++)
+		probe(res, slot);
+
+	// a delegate sleeping for the delays would answer the first probe only
+	// after all of them expired one after another
+	check(res, now() < last, slot, "delegate not available while delays are pending");
+
+	// results are delivered in order of expiration
+	for (i = 0; i < TAGGED_DELAYS; i++) {
+		hw_write(slot, OSIF_CMD_TAGGED_RESULT);
+		tag = hw_read(slot);
+		check(res, hw_read(slot) == 0, slot, "wrong result of tagged delay");
+
+		check(res, tag < TAGGED_DELAYS, slot, "invalid tag");
+		if (tag >= TAGGED_DELAYS)
+			continue;
+
+		check(res, !seen[tag], slot, "tag delivered twice");
+		seen[tag] = 1;
+
+		account(res, slot, deadline[tag], now());
+	}
+
+	hw_write(slot, OSIF_CMD_THREAD_EXIT);
+
+	return NULL;
+}
+
+int main(int argc, char **argv) {
+	pthread_t stub[NUM_SLOTS];
+	uint64_t late_max = 0, late_sum = 0, probe_max = 0;
+	int fd, i, errors = 0;
+
+	setenv("RECONOS_COSIM_SLOTS", "8", 1);
+	reconos_init();
+
+	// take the place of the simulator, but without attaching to the slots
+	fd = shm_open(COSIM_SHM_NAME, O_RDWR, 0);
+	if (fd < 0) {
+		fprintf(stderr, "unable to open shared memory\n");
+		return EXIT_FAILURE;
+	}
+	shm = mmap(NULL, sizeof(struct cosim_shm), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	close(fd);
+	if (shm == MAP_FAILED) {
+		fprintf(stderr, "unable to map shared memory\n");
+		return EXIT_FAILURE;
+	}
+
+	// the init data must be visible to the stubs on 64bit hosts as well
+	reconos_addr_window_add(init_data, 0x10000000, sizeof(init_data));
+
+	for (i = 0; i < NUM_SLOTS; i++) {
+		reconos_hwt_setinitdata(&hwt[i], &init_data[i]);
+		reconos_hwt_create(&hwt[i], i, NULL);
+	}
+
+	for (i = 0; i < NUM_SLOTS; i++)
+		pthread_create(&stub[i], NULL, stub_thread, (void *)(long)i);
+
+	for (i = 0; i < NUM_SLOTS; i++) {
+		pthread_join(stub[i], NULL);
+
+		errors += result[i].errors;
+		late_sum += result[i].late_sum;
+		if (result[i].late_max > late_max)
+			late_max = result[i].late_max;
+		if (result[i].probe_max > probe_max)
+			probe_max = result[i].probe_max;
+	}
+
+	late_sum /= NUM_SLOTS * (SYNC_DELAYS + TAGGED_DELAYS);
+
+	printf("delay_test: %d delays on %d slots, lateness avg %llu us, max %llu us, "
+	       "calls answered within %llu us\n",
+	       NUM_SLOTS * (SYNC_DELAYS + TAGGED_DELAYS), NUM_SLOTS,
+	       (unsigned long long)late_sum, (unsigned long long)late_max,
+	       (unsigned long long)probe_max);
+
+	if (errors) {
+		printf("delay_test: FAILED (%d errors)\n", errors);
+		return EXIT_FAILURE;
+	}
+
+	printf("delay_test: PASSED\n");
+	return EXIT_SUCCESS;
+}
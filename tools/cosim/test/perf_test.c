@@ -0,0 +1,247 @@
+/*
+ *                                                        ____  _____
+ *                            ________  _________  ____  / __ \/ ___/
+ *                           / ___/ _ \/ ___/ __ \/ __ \/ / / /\__ \
+ *                          / /  /  __/ /__/ /_/ / / / / /_/ /___/ /
+ *                         /_/   \___/\___/\____/_/ /_/\____//____/
+ *
+ * ======================================================================
+ *
+ *   title:        Test - Performance counters of a slot
+ *
+ *   project:      ReconOS
+ *   description:  Checks reconos_hwt_perf on the cosim backend. Software
+ *                 stubs take the place of the simulator: they set the
+ *                 cycle counters of their slot and write and read back
+ *                 a buffer through the MEMIF rings with requests of
+ *                 different sizes. The byte counters must match the
+ *                 requests of the slot, the cycle counters the 64 bit
+ *                 values set by the stub, and slots out of range must
+ *                 read as zero.
+ *
+ * ======================================================================
+ */
+
+#include "reconos.h"
+#include "cosim.h"
+#include "arch.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <sys/mman.h>
+
+#define OSIF_CMD_THREAD_EXIT  0x000000A2
+
+#define MEMIF_CMD_READ        0x00000000
+#define MEMIF_CMD_WRITE       0xF0000000
+
+#define NUM_SLOTS             2
+
+// buffer of each slot and the part read twice
+#define BUF_WORDS             4096
+#define REREAD_BYTES          1024
+
+// time to wait for the memif server to count the last words
+#define SETTLE_US             1000000
+
+static struct cosim_shm *shm;
+static struct reconos_hwt hwt[NUM_SLOTS];
+static uint32_t buf[NUM_SLOTS][BUF_WORDS];
+static int errors[NUM_SLOTS];
+
+// request sizes in bytes, not aligned to bursts or pages on purpose
+static const uint32_t write_sizes[] = {4, 60, 256, 1024, 4096, 12};
+static const uint32_t read_sizes[] = {8192, 4, 1020, 128, 2048};
+
+static void hw_push(struct cosim_fifo *fifo, uint32_t data) {
+	while (cosim_fifo_rem(fifo) == 0)
+		usleep(10);
+
+	cosim_fifo_push(fifo, data);
+}
+
+static uint32_t hw_pop(struct cosim_fifo *fifo) {
+	uint32_t data;
+
+	while (cosim_fifo_fill(fifo) == 0)
+		usleep(10);
+
+	data = cosim_fifo_peek(fifo);
+	cosim_fifo_pop(fifo);
+
+	return data;
+}
+
+static uint32_t pattern(int slot, unsigned int word) {
+	return (slot + 1) << 24 | word;
+}
+
+static uint64_t cycles(int slot) {
+	return (1ULL << 32) + 100000 * (slot + 1);
+}
+
+static uint64_t osif_wait(int slot) {
+	return (1ULL << 33) + 3000 * (slot + 1);
+}
+
+static uint64_t memif_wait(int slot) {
+	return 2000 * (slot + 1);
+}
+
+static void check(int cond, int slot, char *msg) {
+	if (cond)
+		return;
+
+	fprintf(stderr, "slot %d: %s\n", slot, msg);
+	errors[slot]++;
+}
+
+/*
+ * Writes or reads len bytes from word offset of the buffer of the slot
+ * with requests of the sizes given, cycling through them.
+ */
+static void transfer(int slot, int write, unsigned int offset, uint32_t len,
+                     const uint32_t *sizes, int num_sizes) {
+	struct cosim_slot *s = &shm->slot[slot];
+	uint32_t addr, size;
+	unsigned int word;
+	int i = 0;
+
+	addr = reconos_addr_to_hwt(&buf[slot][offset]);
+	word = offset;
+
+	while (len > 0) {
+		size = sizes[i++ % num_sizes];
+		if (size > len)
+			size = len;
+
+		hw_push(&s->hwt2mem, (write ? MEMIF_CMD_WRITE : MEMIF_CMD_READ) | size);
+		hw_push(&s->hwt2mem, addr);
+
+		for (; size > 0; size -= 4, addr += 4, len -= 4, word++) {
+			if (write)
+				hw_push(&s->hwt2mem, pattern(slot, word));
+			else if (hw_pop(&s->mem2hwt) != pattern(slot, word))
+				check(0, slot, "wrong data read");
+		}
+	}
+}
+
+static void *stub_thread(void *arg) {
+	int slot = (long)arg;
+	struct cosim_slot *s = &shm->slot[slot];
+
+	// the delegate resets the slot before reading the first command
+	while (hwt[slot].state != RECONOS_HWT_STATE_RUNNING)
+		usleep(1000);
+
+	// the simulator counts the cycles while the thread runs
+	s->cycles = cycles(slot);
+	s->osif_wait_cycles = osif_wait(slot);
+	s->memif_stall_cycles = memif_wait(slot);
+
+	transfer(slot, 1, 0, sizeof(buf[slot]), write_sizes,
+	         sizeof(write_sizes) / sizeof(write_sizes[0]));
+	transfer(slot, 0, 0, sizeof(buf[slot]), read_sizes,
+	         sizeof(read_sizes) / sizeof(read_sizes[0]));
+	transfer(slot, 0, BUF_WORDS / 2, REREAD_BYTES, read_sizes,
+	         sizeof(read_sizes) / sizeof(read_sizes[0]));
+
+	hw_push(&s->hw2sw, OSIF_CMD_THREAD_EXIT);
+
+	return NULL;
+}
+
+int main(int argc, char **argv) {
+	pthread_t stub[NUM_SLOTS];
+	struct reconos_perf_counters perf;
+	uint32_t bytes_read, bytes_written;
+	int fd, i, t, total = 0;
+
+	setenv("RECONOS_COSIM_SLOTS", "2", 1);
+	reconos_init();
+
+	// take the place of the simulator, but without attaching to the slots
+	fd = shm_open(COSIM_SHM_NAME, O_RDWR, 0);
+	if (fd < 0) {
+		fprintf(stderr, "unable to open shared memory\n");
+		return EXIT_FAILURE;
+	}
+	shm = mmap(NULL, sizeof(struct cosim_shm), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	close(fd);
+	if (shm == MAP_FAILED) {
+		fprintf(stderr, "unable to map shared memory\n");
+		return EXIT_FAILURE;
+	}
+
+	// the buffers must be reachable by the memif server on 64bit hosts
+	reconos_addr_window_add(buf, 0x10000000, sizeof(buf));
+
+	for (i = 0; i < NUM_SLOTS; i++)
+		reconos_hwt_create(&hwt[i], i, NULL);
+
+	for (i = 0; i < NUM_SLOTS; i++)
+		pthread_create(&stub[i], NULL, stub_thread, (void *)(long)i);
+
+	bytes_written = sizeof(buf[0]);
+	bytes_read = sizeof(buf[0]) + REREAD_BYTES;
+
+	for (i = 0; i < NUM_SLOTS; i++) {
+		pthread_join(stub[i], NULL);
+
+		// the server counts a word after handing it to the stub
+		for (t = 0; t < SETTLE_US / 1000; t++) {
+			reconos_hwt_perf(&hwt[i], &perf);
+			if (perf.bytes_read == bytes_read && perf.bytes_written == bytes_written)
+				break;
+			usleep(1000);
+		}
+
+		check(perf.bytes_read == bytes_read, i, "wrong number of bytes read");
+		check(perf.bytes_written == bytes_written, i, "wrong number of bytes written");
+		check(perf.cycles == cycles(i), i, "cycles cut to 32 bit");
+		check(perf.osif_wait == osif_wait(i), i, "wrong osif wait cycles");
+		check(perf.memif_wait == memif_wait(i), i, "wrong memif wait cycles");
+		check(reconos_proc_control_get_memif_bytes(0, i) == bytes_read + bytes_written,
+		      i, "transferred bytes differ from the read and written bytes");
+
+		for (t = 0; t < BUF_WORDS; t++) {
+			if (buf[i][t] != pattern(i, t)) {
+				check(0, i, "wrong data written");
+				break;
+			}
+		}
+
+		printf("perf_test: slot %d: %llu cycles, %llu osif wait, %llu memif wait, "
+		       "%u bytes read, %u bytes written\n",
+		       i, (unsigned long long)perf.cycles, (unsigned long long)perf.osif_wait,
+		       (unsigned long long)perf.memif_wait, perf.bytes_read, perf.bytes_written);
+
+		total += errors[i];
+	}
+
+	// slots without a hardware thread read as zero
+	reconos_proc_control_get_hwt_perf(0, NUM_SLOTS, &perf);
+	if (perf.cycles || perf.osif_wait || perf.memif_wait
+	    || perf.bytes_read || perf.bytes_written) {
+		fprintf(stderr, "counters of a slot out of range are not zero\n");
+		total++;
+	}
+	reconos_proc_control_get_hwt_perf(0, -1, &perf);
+	if (perf.cycles || perf.bytes_read || perf.bytes_written) {
+		fprintf(stderr, "counters of a negative slot are not zero\n");
+		total++;
+	}
+
+	if (total) {
+		printf("perf_test: FAILED (%d errors)\n", total);
+		return EXIT_FAILURE;
+	}
+
+	printf("perf_test: PASSED\n");
+	return EXIT_SUCCESS;
+}
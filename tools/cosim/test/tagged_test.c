@@ -0,0 +1,228 @@
+/*
+ *                                                        ____  _____
+ *                            ________  _________  ____  / __ \/ ___/
+ *                           / ___/ _ \/ ___/ __ \/ __ \/ / / /\__ \
+ *                          / /  /  __/ /__/ /_/ / / / / /_/ /___/ /
+ *                         /_/   \___/\___/\____/_/ /_/\____//____/
+ *
+ * ======================================================================
+ *
+ *   title:        Test - Tagged OSIF calls
+ *
+ *   project:      ReconOS
+ *   description:  Checks the tagged calls of the delegate on the cosim
+ *                 backend with a software stub in place of the hardware
+ *                 thread. Tagged puts into a small mbox, drained slowly
+ *                 by the main thread, must arrive in the order of issue
+ *                 even if the mbox has room again for a later put while
+ *                 earlier ones still wait. More outstanding calls than
+ *                 tags and commands not supported as tagged calls must
+ *                 be refused with an error instead of corrupting the
+ *                 queues or terminating the process.
+ *
+ * ======================================================================
+ */
+
+#include "reconos.h"
+#include "mbox.h"
+#include "cosim.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <semaphore.h>
+#include <sys/mman.h>
+
+#define OSIF_CMD_THREAD_EXIT           0x000000A2
+#define OSIF_CMD_TAGGED_RESULT         0x000000A7
+#define OSIF_CMD_THREAD_GET_ERROR      0x000000A8
+#define OSIF_CMD_SEM_POST              0x000000B0
+#define OSIF_CMD_MUTEX_LOCK            0x000000C0
+#define OSIF_CMD_MBOX_PUT              0x000000F1
+#define OSIF_CMD_TAGGED_MASK           0x40000000
+#define OSIF_CMD_TAG_SHIFT             16
+
+#define OSIF_RESULT_NO_TAG             0xFFFFFFFD
+#define OSIF_RESULT_BAD_CALL           0xFFFFFFFC
+
+// number of tags of the delegate
+#define TAGGED_CALLS     256
+
+// puts into the mbox, much more than it holds
+#define MBOX_SIZE        4
+#define PUTS             64
+
+// time between two puts and two gets in microseconds
+#define PUT_INTERVAL     200
+#define GET_INTERVAL     500
+
+static struct cosim_shm *shm;
+static struct reconos_hwt hwt;
+static struct mbox mb;
+static sem_t sem;
+static int errors;
+
+static void hw_write(uint32_t data) {
+	struct cosim_fifo *fifo = &shm->slot[0].hw2sw;
+
+	while (cosim_fifo_rem(fifo) == 0)
+		usleep(10);
+
+	cosim_fifo_push(fifo, data);
+}
+
+static uint32_t hw_read() {
+	struct cosim_fifo *fifo = &shm->slot[0].sw2hw;
+	uint32_t data;
+
+	while (cosim_fifo_fill(fifo) == 0)
+		usleep(10);
+
+	data = cosim_fifo_peek(fifo);
+	cosim_fifo_pop(fifo);
+
+	return data;
+}
+
+static void check(int cond, char *msg) {
+	if (cond)
+		return;
+
+	fprintf(stderr, "%s\n", msg);
+	errors++;
+}
+
+/*
+ * Collects the results of count tagged calls, which must all be 0 and
+ * carry distinct tags below count.
+ */
+static void collect(int count, char *name) {
+	char seen[TAGGED_CALLS];
+	uint32_t tag, result;
+	int i, bad = 0;
+
+	memset(seen, 0, sizeof(seen));
+
+	for (i = 0; i < count; i++) {
+		hw_write(OSIF_CMD_TAGGED_RESULT);
+		tag = hw_read();
+		result = hw_read();
+
+		if (tag >= count || seen[tag] || result != 0)
+			bad++;
+		else
+			seen[tag] = 1;
+	}
+
+	if (bad) {
+		fprintf(stderr, "%s: %d wrong tagged results\n", name, bad);
+		errors++;
+	}
+}
+
+static void *stub_thread(void *arg) {
+	int i;
+
+	// the delegate resets the slot before reading the first command
+	while (hwt.state != RECONOS_HWT_STATE_RUNNING)
+		usleep(1000);
+
+	// puts are issued faster than the mbox is drained, so later puts find
+	// room in the mbox while earlier ones wait for a worker
+	for (i = 0; i < PUTS; i++) {
+		hw_write(OSIF_CMD_MBOX_PUT | OSIF_CMD_TAGGED_MASK | i << OSIF_CMD_TAG_SHIFT);
+		hw_write(0);
+		hw_write(i);
+		usleep(PUT_INTERVAL);
+	}
+	collect(PUTS, "mbox put");
+
+	// posts complete at once, but their results are never collected
+	for (i = 0; i < TAGGED_CALLS; i++) {
+		hw_write(OSIF_CMD_SEM_POST | OSIF_CMD_TAGGED_MASK | i << OSIF_CMD_TAG_SHIFT);
+		hw_write(1);
+	}
+
+	hw_write(OSIF_CMD_SEM_POST | OSIF_CMD_TAGGED_MASK);
+	hw_write(1);
+	hw_write(OSIF_CMD_THREAD_GET_ERROR);
+	check(hw_read() == OSIF_RESULT_NO_TAG, "call beyond the tags not refused");
+
+	collect(TAGGED_CALLS, "sem post");
+
+	// the delegate must survive a command it cannot handle tagged
+	hw_write(OSIF_CMD_MUTEX_LOCK | OSIF_CMD_TAGGED_MASK);
+	hw_write(OSIF_CMD_THREAD_GET_ERROR);
+	check(hw_read() == OSIF_RESULT_BAD_CALL, "unsupported tagged call not refused");
+
+	hw_write(OSIF_CMD_THREAD_GET_ERROR);
+	check(hw_read() == 0, "error not cleared");
+
+	hw_write(OSIF_CMD_THREAD_EXIT);
+
+	return NULL;
+}
+
+int main(int argc, char **argv) {
+	struct reconos_resource res[2];
+	pthread_t stub;
+	uint32_t word;
+	int fd, i, posts;
+
+	setenv("RECONOS_COSIM_SLOTS", "1", 1);
+	reconos_init();
+
+	// take the place of the simulator, but without attaching to the slots
+	fd = shm_open(COSIM_SHM_NAME, O_RDWR, 0);
+	if (fd < 0) {
+		fprintf(stderr, "unable to open shared memory\n");
+		return EXIT_FAILURE;
+	}
+	shm = mmap(NULL, sizeof(struct cosim_shm), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	close(fd);
+	if (shm == MAP_FAILED) {
+		fprintf(stderr, "unable to map shared memory\n");
+		return EXIT_FAILURE;
+	}
+
+	mbox_init(&mb, MBOX_SIZE);
+	sem_init(&sem, 0, 0);
+
+	res[0].type = RECONOS_RESOURCE_TYPE_MBOX;
+	res[0].ptr = &mb;
+	res[1].type = RECONOS_RESOURCE_TYPE_SEM;
+	res[1].ptr = &sem;
+
+	reconos_hwt_setresources(&hwt, res, 2);
+	reconos_hwt_create(&hwt, 0, NULL);
+
+	pthread_create(&stub, NULL, stub_thread, NULL);
+
+	for (i = 0; i < PUTS; i++) {
+		usleep(GET_INTERVAL);
+		word = mbox_get(&mb);
+		if (word != i) {
+			fprintf(stderr, "mbox put %d arrived as word %d\n", word, i);
+			errors++;
+			break;
+		}
+	}
+
+	pthread_join(stub, NULL);
+
+	for (posts = 0; sem_trywait(&sem) == 0; posts++);
+	check(posts == TAGGED_CALLS, "refused post executed");
+
+	printf("tagged_test: %d ordered puts, %d posts\n", i, posts);
+
+	if (errors) {
+		printf("tagged_test: FAILED (%d errors)\n", errors);
+		return EXIT_FAILURE;
+	}
+
+	printf("tagged_test: PASSED\n");
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,203 @@
+/*
+ *                                                        ____  _____
+ *                            ________  _________  ____  / __ \/ ___/
+ *                           / ___/ _ \/ ___/ __ \/ __ \/ / / /\__ \
+ *                          / /  /  __/ /__/ /_/ / / / / /_/ /___/ /
+ *                         /_/   \___/\___/\____/_/ /_/\____//____/
+ *
+ * ======================================================================
+ *
+ *   title:        Test - Virtual hardware threads
+ *
+ *   project:      ReconOS
+ *   description:  Runs more virtual hardware threads than slots on the
+ *                 cosim backend, with a software stub per slot in place
+ *                 of the hardware thread. Each virtual thread identifies
+ *                 itself by its init data and exits right away. The slot
+ *                 must be handed to the next ready virtual thread on
+ *                 every exit, so that all of them run exactly once.
+ *
+ * ======================================================================
+ */
+
+#include "reconos.h"
+#include "cosim.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <sys/mman.h>
+
+#define OSIF_CMD_THREAD_GET_INIT_DATA  0x000000A0
+#define OSIF_CMD_THREAD_EXIT           0x000000A2
+
+#define NUM_SLOTS        2
+#define NUM_VHWTS        8
+
+// time to wait for all virtual threads in microseconds
+#define TIMEOUT_US       10000000
+
+static struct cosim_shm *shm;
+static struct reconos_hwt hwt[NUM_SLOTS];
+static struct reconos_vhwt vhwt[NUM_VHWTS];
+static uint32_t init_data[NUM_VHWTS];
+static int runs[NUM_VHWTS];
+static int completed;
+
+static void hw_write(int slot, uint32_t data) {
+	struct cosim_fifo *fifo = &shm->slot[slot].hw2sw;
+
+	while (cosim_fifo_rem(fifo) == 0)
+		usleep(10);
+
+	cosim_fifo_push(fifo, data);
+}
+
+static uint32_t hw_read(int slot) {
+	struct cosim_fifo *fifo = &shm->slot[slot].sw2hw;
+	uint32_t data;
+
+	while (cosim_fifo_fill(fifo) == 0)
+		usleep(10);
+
+	data = cosim_fifo_peek(fifo);
+	cosim_fifo_pop(fifo);
+
+	return data;
+}
+
+static void *stub_thread(void *arg) {
+	int slot = (long)arg;
+	struct cosim_slot *s = &shm->slot[slot];
+	uint32_t addr, seq;
+	int i;
+
+	// the delegate resets the slot before reading the first command
+	while (hwt[slot].state != RECONOS_HWT_STATE_RUNNING)
+		usleep(1000);
+
+	while (1) {
+		// the slot stays in reset once no virtual thread is left for it
+		while (s->reset) {
+			if (__sync_fetch_and_add(&completed, 0) == NUM_VHWTS)
+				return NULL;
+			usleep(1000);
+		}
+
+		hw_write(slot, OSIF_CMD_THREAD_GET_INIT_DATA);
+		addr = hw_read(slot);
+
+		for (i = 0; i < NUM_VHWTS; i++) {
+			if (addr == reconos_addr_to_hwt(&init_data[i]))
+				break;
+		}
+
+		if (i < NUM_VHWTS) {
+			__sync_fetch_and_add(&runs[i], 1);
+		} else {
+			fprintf(stderr, "slot %d: unknown init data %x\n", slot, addr);
+		}
+		__sync_fetch_and_add(&completed, 1);
+
+		// the delegate resets the slot on exit, whether it is reconfigured
+		// for the next virtual thread or not
+		seq = s->reset_seq;
+		hw_write(slot, OSIF_CMD_THREAD_EXIT);
+		while (s->reset_seq == seq)
+			usleep(100);
+	}
+}
+
+int main(int argc, char **argv) {
+	struct reconos_configuration cfg[NUM_VHWTS][NUM_SLOTS];
+	struct reconos_configuration *cfg_ptr[NUM_VHWTS][NUM_SLOTS];
+	pthread_t stub[NUM_SLOTS];
+	int fd, i, t, errors = 0;
+
+	setenv("RECONOS_COSIM_SLOTS", "2", 1);
+	reconos_init();
+
+	// take the place of the simulator, but without attaching to the slots
+	fd = shm_open(COSIM_SHM_NAME, O_RDWR, 0);
+	if (fd < 0) {
+		fprintf(stderr, "unable to open shared memory\n");
+		return EXIT_FAILURE;
+	}
+	shm = mmap(NULL, sizeof(struct cosim_shm), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	close(fd);
+	if (shm == MAP_FAILED) {
+		fprintf(stderr, "unable to map shared memory\n");
+		return EXIT_FAILURE;
+	}
+
+	// the init data must be visible to the stubs on 64bit hosts as well
+	reconos_addr_window_add(init_data, 0x10000000, sizeof(init_data));
+
+	reconos_vhwt_init(1000);
+
+	for (i = 0; i < NUM_VHWTS; i++) {
+		for (t = 0; t < NUM_SLOTS; t++) {
+			reconos_configuration_init(&cfg[i][t], "vhwt", t);
+			cfg_ptr[i][t] = &cfg[i][t];
+		}
+
+		reconos_vhwt_create(&vhwt[i], cfg_ptr[i], NUM_SLOTS, 0, &init_data[i]);
+	}
+
+	for (i = 0; i < NUM_SLOTS; i++) {
+		if (reconos_vhwt_run(&hwt[i], i, NULL) < 0) {
+			fprintf(stderr, "no virtual thread ready for slot %d\n", i);
+			return EXIT_FAILURE;
+		}
+	}
+
+	for (i = 0; i < NUM_SLOTS; i++)
+		pthread_create(&stub[i], NULL, stub_thread, (void *)(long)i);
+
+	// queued virtual threads starve if exits do not hand on the slot
+	for (t = 0; t < TIMEOUT_US / 1000; t++) {
+		if (__sync_fetch_and_add(&completed, 0) == NUM_VHWTS)
+			break;
+		usleep(1000);
+	}
+
+	if (completed != NUM_VHWTS) {
+		fprintf(stderr, "only %d of %d virtual threads completed\n", completed, NUM_VHWTS);
+		printf("vhwt_test: FAILED\n");
+		return EXIT_FAILURE;
+	}
+
+	for (i = 0; i < NUM_SLOTS; i++)
+		pthread_join(stub[i], NULL);
+
+	for (i = 0; i < NUM_VHWTS; i++) {
+		if (runs[i] != 1) {
+			fprintf(stderr, "virtual thread %d ran %d times\n", i, runs[i]);
+			errors++;
+		}
+		if (vhwt[i].running) {
+			fprintf(stderr, "virtual thread %d still marked as running\n", i);
+			errors++;
+		}
+	}
+
+	for (i = 0; i < NUM_SLOTS; i++) {
+		if (hwt[i].vhwt) {
+			fprintf(stderr, "slot %d still runs a virtual thread\n", i);
+			errors++;
+		}
+	}
+
+	printf("vhwt_test: %d virtual threads on %d slots\n", NUM_VHWTS, NUM_SLOTS);
+
+	if (errors) {
+		printf("vhwt_test: FAILED (%d errors)\n", errors);
+		return EXIT_FAILURE;
+	}
+
+	printf("vhwt_test: PASSED\n");
+	return EXIT_SUCCESS;
+}
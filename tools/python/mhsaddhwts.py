@@ -65,6 +65,8 @@ def osif_fifo(num, direction):
         instance.addEntry("BUS_INTERFACE", "FIFO_S", "reconos_osif_fifo_%d_" % num + direction + "_FIFO_S")
 	if direction == "hw2sw":
 		instance.addEntry("PORT", "FIFO_Has_Data", "reconos_osif_fifo_%d_" % num + direction + "_FIFO_Has_Data")
+	if direction == "sw2hw":
+		instance.addEntry("PORT", "FIFO_S_Wait", "reconos_osif_fifo_%d_" % num + direction + "_FIFO_S_Wait")
 	instance.addEntry("PORT", "FIFO_Rst", "reconos_proc_control_0_PROC_Hwt_Rst_%d" % num)
 	instance.addEntry("PORT", "FIFO_S_Clk", DEFAULT_CLK)
 	return instance
@@ -72,14 +74,20 @@ def osif_fifo(num, direction):
 
 
 # HW_VER, C_FIFO_WIDTH, OSIF_FIFO_BASE_ADDR, OSIF_FIFO_MEM_SIZE
+# OSIF_FIFO_STRIDE_LOG2 must match OSIF_FIFO_STRIDE of the driver and lib
 def osif(num_hwts):
+	mem_size = OSIF_FIFO_MEM_SIZE
+	while mem_size < num_hwts << OSIF_FIFO_STRIDE_LOG2:
+		mem_size *= 2
+
 	instance = mhstools.MHSPCore("reconos_osif")
 	instance.addEntry("PARAMETER", "INSTANCE", "reconos_osif_0")
 	instance.addEntry("PARAMETER", "HW_VER", "1.00.a")
 	instance.addEntry("PARAMETER", "C_BASEADDR", "0x%x" % OSIF_FIFO_BASE_ADDR)
-	instance.addEntry("PARAMETER", "C_HIGHADDR", "0x%x" % (OSIF_FIFO_BASE_ADDR + OSIF_FIFO_MEM_SIZE - 1))
+	instance.addEntry("PARAMETER", "C_HIGHADDR", "0x%x" % (OSIF_FIFO_BASE_ADDR + mem_size - 1))
 	instance.addEntry("PARAMETER", "C_NUM_FIFOS", num_hwts)
 	instance.addEntry("PARAMETER", "C_FIFO_WIDTH", "32")
+	instance.addEntry("PARAMETER", "C_FIFO_STRIDE_LOG2", OSIF_FIFO_STRIDE_LOG2)
 	for i in range(num_hwts):
 		instance.addEntry("BUS_INTERFACE", "FIFO_S_%d" % i, "reconos_osif_fifo_%d_hw2sw_FIFO_S" % i)
 		instance.addEntry("BUS_INTERFACE", "FIFO_M_%d" % i, "reconos_osif_fifo_%d_sw2hw_FIFO_M" % i)
@@ -111,12 +119,14 @@ def memif_fifo(num, direction):
 	instance.addEntry("PARAMETER", "C_FIFO_DEPTH", DEFAULT_MEMIF_FIFO_DEPTH)
 	instance.addEntry("BUS_INTERFACE", "FIFO_M", "reconos_memif_fifo_%d_" % num + direction + "_FIFO_M")
 	instance.addEntry("BUS_INTERFACE", "FIFO_S", "reconos_memif_fifo_%d_" % num + direction + "_FIFO_S")
+	if direction == "mem2hwt":
+		instance.addEntry("PORT", "FIFO_S_Wait", "reconos_memif_fifo_%d_" % num + direction + "_FIFO_S_Wait")
 	instance.addEntry("PORT", "FIFO_Rst", "reconos_proc_control_0_PROC_Hwt_Rst_%d" % num)
 	instance.addEntry("PORT", "FIFO_S_Clk", DEFAULT_CLK)
 	return instance
 
 # HW_VER, PROC_CONTROL_BASE_ADDR, PROC_CONTROL_MEM_SIZE
-def proc_control(num_hwts, use_mmu):
+def proc_control(num_hwts, use_mmu, use_mem):
 	instance = mhstools.MHSPCore("reconos_proc_control")
 	instance.addEntry("PARAMETER", "INSTANCE", "reconos_proc_control_0")
 	instance.addEntry("PARAMETER", "HW_VER", "1.00.a")
@@ -129,6 +139,9 @@ def proc_control(num_hwts, use_mmu):
 	instance.addEntry("PORT", "PROC_Rst", DEFAULT_RST)
 	for i in range(num_hwts):
 		instance.addEntry("PORT", "PROC_Hwt_Rst_%d" % i, "reconos_proc_control_0_PROC_Hwt_Rst_%d" % i)
+		instance.addEntry("PORT", "PROC_Hwt_Osif_Wait_%d" % i, "reconos_osif_fifo_%d_sw2hw_FIFO_S_Wait" % i)
+		if use_mem:
+			instance.addEntry("PORT", "PROC_Hwt_Memif_Wait_%d" % i, "reconos_memif_fifo_%d_mem2hwt_FIFO_S_Wait" % i)
 	instance.addEntry("PORT", "PROC_Sys_Rst", "reconos_proc_control_0_PROC_Sys_Rst")
 	if use_mmu:
 		instance.addEntry("PORT", "PROC_Pgf_Int", "reconos_proc_control_0_PROC_Pgf_Int")
@@ -138,6 +151,15 @@ def proc_control(num_hwts, use_mmu):
 		instance.addEntry("PORT", "MMU_Pgd", "reconos_proc_control_0_MMU_Pgd")
 		instance.addEntry("PORT", "MMU_Tlb_Hits", "reconos_memif_mmu_0_MMU_Tlb_Hits")
 		instance.addEntry("PORT", "MMU_Tlb_Misses", "reconos_memif_mmu_0_MMU_Tlb_Misses")
+		instance.addEntry("PORT", "MMU_Tlb_Inv", "reconos_proc_control_0_MMU_Tlb_Inv")
+		instance.addEntry("PORT", "MMU_Tlb_Inv_Data", "reconos_proc_control_0_MMU_Tlb_Inv_Data")
+	if use_mem:
+		instance.addEntry("PORT", "ARB_Slot", "reconos_proc_control_0_ARB_Slot")
+		instance.addEntry("PORT", "ARB_Qos_Data", "reconos_proc_control_0_ARB_Qos_Data")
+		instance.addEntry("PORT", "ARB_Qos_WE", "reconos_proc_control_0_ARB_Qos_WE")
+		instance.addEntry("PORT", "ARB_Qos", "reconos_memif_arbiter_0_ARB_Qos")
+		instance.addEntry("PORT", "ARB_Bytes_Read", "reconos_memif_arbiter_0_ARB_Bytes_Read")
+		instance.addEntry("PORT", "ARB_Bytes_Write", "reconos_memif_arbiter_0_ARB_Bytes_Write")
 	return instance
 
 # HW_VER
@@ -152,6 +174,12 @@ def arbiter(num_hwts):
 	instance.addEntry("BUS_INTERFACE", "MEMIF_FIFO_Out_Mem2Hwt", "reconos_memif_arbiter_0_MEMIF_FIFO_Out_Mem2Hwt")
 	instance.addEntry("BUS_INTERFACE", "MEMIF_FIFO_Out_Hwt2Mem", "reconos_memif_arbiter_0_MEMIF_FIFO_Out_Hwt2Mem")
 	instance.addEntry("BUS_INTERFACE", "CTRL_FIFO_Out", "reconos_memif_arbiter_0_CTRL_FIFO_Out")
+	instance.addEntry("PORT", "ARB_Slot", "reconos_proc_control_0_ARB_Slot")
+	instance.addEntry("PORT", "ARB_Qos_Data", "reconos_proc_control_0_ARB_Qos_Data")
+	instance.addEntry("PORT", "ARB_Qos_WE", "reconos_proc_control_0_ARB_Qos_WE")
+	instance.addEntry("PORT", "ARB_Qos", "reconos_memif_arbiter_0_ARB_Qos")
+	instance.addEntry("PORT", "ARB_Bytes_Read", "reconos_memif_arbiter_0_ARB_Bytes_Read")
+	instance.addEntry("PORT", "ARB_Bytes_Write", "reconos_memif_arbiter_0_ARB_Bytes_Write")
 	instance.addEntry("PORT", "TCTRL_Clk", DEFAULT_CLK)
 	instance.addEntry("PORT", "TCTRL_Rst", "reconos_proc_control_0_PROC_Sys_Rst")
 	return instance
@@ -185,6 +213,8 @@ def mmu(arch):
 	instance.addEntry("PORT", "MMU_Pgd", "reconos_proc_control_0_MMU_Pgd")
 	instance.addEntry("PORT", "MMU_Tlb_Hits", "reconos_memif_mmu_0_MMU_Tlb_Hits")
 	instance.addEntry("PORT", "MMU_Tlb_Misses", "reconos_memif_mmu_0_MMU_Tlb_Misses")
+	instance.addEntry("PORT", "MMU_Tlb_Inv", "reconos_proc_control_0_MMU_Tlb_Inv")
+	instance.addEntry("PORT", "MMU_Tlb_Inv_Data", "reconos_proc_control_0_MMU_Tlb_Inv_Data")
 	instance.addEntry("PORT", "MMU_Clk", DEFAULT_CLK)
 	instance.addEntry("PORT", "MMU_Rst", "reconos_proc_control_0_PROC_Sys_Rst")
 	return instance
@@ -318,6 +348,9 @@ if arch == "zynq":
 	DEFAULT_CLK = "processing_system7_0_FCLK_CLK0"
 	DEFAULT_RST = "processing_system7_0_FCLK_RESET0_N_0"
 	DEFAULT_RST_POLARITY = 0 # 0 for egative, 1 for positive
+
+	# every fifo gets its own page so that the driver can map it to user space
+	OSIF_FIFO_STRIDE_LOG2 = 12
 elif arch == "microblaze":
 	HWT_BUS = "axi_sys"
 	MEMORY_BUS = "axi_mem"
@@ -325,6 +358,9 @@ elif arch == "microblaze":
 	DEFAULT_CLK = "clk_100_0000MHzMMCM0"
 	DEFAULT_RST = "proc_sys_reset_0_Peripheral_aresetn"
 	DEFAULT_RST_POLARITY = 0 # 0 for egative, 1 for positive
+
+	# the fifos are not mapped to user space, so keep the dense layout
+	OSIF_FIFO_STRIDE_LOG2 = 4
 else:
 	sys.stderr.write("ERROR: Architecture not supported\n")
 	sys.exit(1)
@@ -383,7 +419,7 @@ mhs.addPCore(osif(num_hwts))
 mhs.addPCore(osif_intc(num_hwts))
 
 # insert proc control
-mhs.addPCore(proc_control(num_hwts, use_mmu))
+mhs.addPCore(proc_control(num_hwts, use_mmu, use_mem))
 
 # add memory subsystem
 if use_mem:
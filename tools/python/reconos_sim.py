@@ -0,0 +1,515 @@
+#!/usr/bin/env python
+# coding: utf8
+
+#                                                        ____  _____
+#                            ________  _________  ____  / __ \/ ___/
+#                           / ___/ _ \/ ___/ __ \/ __ \/ / / /\__ \
+#                          / /  /  __/ /__/ /_/ / / / / /_/ /___/ /
+#                         /_/   \___/\___/\____/_/ /_/\____//____/
+#
+# ======================================================================
+#
+#   project:      ReconOS
+#   description:  Discrete-event model of a ReconOS system to predict
+#                 how an application scales with the number of slots,
+#                 the reconfiguration latency and the scheduler.
+#
+#                 The model consists of slots running hardware threads,
+#                 the delegate threads sharing the cores of the CPU,
+#                 a single reconfiguration port and mailboxes. A
+#                 hardware thread repeatedly gets a message, computes
+#                 and puts a result, the put carries the yield bit
+#                 and invokes the scheduler just like the delegate
+#                 does. Applications are modelled on top of this, see
+#                 demos/reconf_sort_matrix/sim for an example.
+#
+#                 All times are in microseconds. Service times can be
+#                 calibrated from OSIF recordings (RECONOS_OSIF_RECORD).
+#
+# ======================================================================
+
+from __future__ import print_function
+
+import collections
+import heapq
+import json
+import random
+import struct
+
+
+# == Simulation kernel =================================================
+
+class Simulator:
+	"""
+Event queue of the simulation. Callbacks are executed in the order of
+their time, callbacks scheduled for the same time in the order they were
+scheduled.
+	"""
+
+	def __init__(self, seed = 0):
+		self.now = 0.0
+		self.random = random.Random(seed)
+		self._queue = []
+		self._seq = 0
+
+	def at(self, delay, fn, *args):
+		heapq.heappush(self._queue, (self.now + delay, self._seq, fn, args))
+		self._seq += 1
+
+	def run(self, until):
+		while self._queue and self._queue[0][0] <= until:
+			self.now, _, fn, args = heapq.heappop(self._queue)
+			fn(*args)
+		self.now = until
+
+
+class Resource:
+	"""
+A number of identical servers with a common FIFO queue, used for the
+cores executing the delegates and for the reconfiguration port.
+	"""
+
+	def __init__(self, sim, servers):
+		self.sim = sim
+		self.servers = servers
+		self.busy = 0
+		self.busy_time = 0.0
+		self._queue = collections.deque()
+
+	def use(self, duration, done, *args):
+		if self.busy < self.servers:
+			self._start(duration, done, args)
+		else:
+			self._queue.append((duration, done, args))
+
+	def _start(self, duration, done, args):
+		self.busy += 1
+		self.busy_time += duration
+		self.sim.at(duration, self._finish, done, args)
+
+	def _finish(self, done, args):
+		self.busy -= 1
+		if self._queue:
+			self._start(*self._queue.popleft())
+		done(*args)
+
+	def utilization(self):
+		if self.sim.now == 0:
+			return 0.0
+		return self.busy_time / (self.sim.now * self.servers)
+
+
+class Mbox:
+	"""
+Bounded mailbox with blocking get and put as implemented in mbox.c.
+Waiting getters and putters are served in FIFO order.
+	"""
+
+	def __init__(self, sim, size):
+		self.sim = sim
+		self.size = size
+		self._items = collections.deque()
+		self._getters = collections.deque()
+		self._putters = collections.deque()
+		self._selectors = []
+
+	def __len__(self):
+		return len(self._items)
+
+	def get(self, done):
+		if self._items:
+			value = self._items.popleft()
+			if self._putters:
+				put_value, put_done = self._putters.popleft()
+				self._items.append(put_value)
+				self.sim.at(0, put_done)
+			self.sim.at(0, done, value)
+		else:
+			self._getters.append(done)
+
+	def put(self, value, done):
+		if self._getters:
+			self.sim.at(0, self._getters.popleft(), value)
+			self.sim.at(0, done)
+		elif len(self._items) < self.size:
+			self._items.append(value)
+			self.sim.at(0, done)
+			self._notify()
+		else:
+			self._putters.append((value, done))
+
+	def _notify(self):
+		selectors, self._selectors = self._selectors, []
+		for selector in selectors:
+			selector()
+
+
+def mbox_select(mboxes, done):
+	"""
+Calls done with the index of the first mailbox holding a message, like
+mbox_select in mbox.c.
+	"""
+
+	state = {"fired": False}
+
+	def check():
+		if state["fired"]:
+			return
+		for i, mbox in enumerate(mboxes):
+			if len(mbox):
+				state["fired"] = True
+				done(i)
+				return
+		for mbox in mboxes:
+			mbox._selectors.append(check)
+
+	check()
+
+
+# == Service time distributions ========================================
+
+class Constant:
+	def __init__(self, value):
+		self.value = float(value)
+
+	def sample(self, rng):
+		return self.value
+
+	def mean(self):
+		return self.value
+
+	def scaled(self, factor):
+		return Constant(self.value * factor)
+
+
+class Empirical:
+	"""
+Resamples the values observed in a recording.
+	"""
+
+	def __init__(self, samples):
+		self.samples = [float(s) for s in samples]
+
+	def sample(self, rng):
+		return rng.choice(self.samples)
+
+	def mean(self):
+		return sum(self.samples) / len(self.samples)
+
+	def scaled(self, factor):
+		return Empirical([s * factor for s in self.samples])
+
+
+def distribution(value):
+	if isinstance(value, list):
+		return Empirical(value)
+	return Constant(value)
+
+
+# == ReconOS system ====================================================
+
+class Configuration:
+	"""
+A hardware thread which can be loaded into a slot, corresponds to
+struct reconos_configuration.
+	"""
+
+	def __init__(self, name, recv, send, service, process = None):
+		self.name = name
+		self.recv = recv
+		self.send = send
+		self.service = service
+		self.process = process
+
+
+class Slot:
+	def __init__(self, num, cfg):
+		self.num = num
+		self.cfg = cfg
+		self.data = None
+		self.jobs = 0
+		self.reconfs = 0
+
+
+class System:
+	"""
+Slots, delegates and the reconfiguration port.
+
+  cores     - number of cores executing the delegates
+  delegate  - distribution of the CPU time per OSIF call
+  reconf    - distribution of the reconfiguration latency
+  scheduler - function(system, slot) returning a Configuration or None,
+              like the function passed to reconos_set_scheduler
+	"""
+
+	def __init__(self, sim, cores, delegate, reconf, scheduler):
+		self.sim = sim
+		self.cpu = Resource(sim, cores)
+		self.port = Resource(sim, 1)
+		self.delegate = delegate
+		self.reconf = reconf
+		self.scheduler = scheduler
+		self.slots = []
+		self.jobs = collections.Counter()
+		self.reconfs = 0
+
+	def create(self, cfg):
+		slot = Slot(len(self.slots), cfg)
+		self.slots.append(slot)
+		self.sim.at(0, self._get, slot)
+		return slot
+
+	def call(self, done, *args):
+		self.cpu.use(self.delegate.sample(self.sim.random), done, *args)
+
+	def _get(self, slot):
+		self.call(lambda: slot.cfg.recv.get(lambda value: self._compute(slot, value)))
+
+	def _compute(self, slot, value):
+		slot.data = value
+		self.sim.at(slot.cfg.service.sample(self.sim.random), self._put, slot)
+
+	def _put(self, slot):
+		cfg = slot.cfg
+		if cfg.process:
+			value = cfg.process(slot, slot.data)
+		else:
+			value = slot.data
+
+		self.call(lambda: cfg.send.put(value, lambda: self._yield(slot)))
+
+	def _yield(self, slot):
+		slot.jobs += 1
+		self.jobs[slot.cfg.name] += 1
+
+		cfg = self.scheduler(self, slot)
+		if cfg is None:
+			self._get(slot)
+			return
+
+		slot.reconfs += 1
+		self.reconfs += 1
+		self.port.use(self.reconf.sample(self.sim.random), self._reconfigured, slot, cfg)
+
+	def _reconfigured(self, slot, cfg):
+		slot.cfg = cfg
+		self._get(slot)
+
+
+# == Calibration from OSIF recordings ==================================
+
+OSIF_RECORD_MAGIC = 0x524f5352
+OSIF_RECORD_HW2SW = 1
+OSIF_RECORD_SW2HW = 0
+OSIF_RECORD_RESET = 2
+
+OSIF_CMD_MASK = 0xFF
+OSIF_CMD_TAGGED_MASK = 0x40000000
+
+# number of argument words of the OSIF calls, see hwt_delegate.c
+OSIF_CMD_ARGS = {
+	0xA0: 0, 0xA1: 1, 0xA2: 0, 0xA3: 0, 0xA5: 0, 0xA6: 1, 0xA7: 0, 0xA8: 0,
+	0xB0: 1, 0xB1: 1,
+	0xC0: 1, 0xC1: 1, 0xC2: 1,
+	0xD0: 2, 0xD1: 1, 0xD2: 1,
+	0xE0: 2, 0xE1: 2,
+	0xF0: 1, 0xF1: 2, 0xF2: 1, 0xF3: 2, 0xF4: 2, 0xF5: 2
+}
+
+# calls which start and finish the computation of a hardware thread
+OSIF_CMD_GETS = (0xB1, 0xE0, 0xF0, 0xF5)
+OSIF_CMD_PUTS = (0xB0, 0xE1, 0xF1, 0xF4)
+
+
+def read_recording(filename):
+	"""
+Returns a list of (time, slot, dir, words) tuples of a recording.
+	"""
+
+	with open(filename, "rb") as f:
+		data = f.read()
+
+	magic, version, start = struct.unpack_from("=IIQ", data, 0)
+	if magic != OSIF_RECORD_MAGIC:
+		raise ValueError("%s is no osif recording" % filename)
+
+	entries = []
+	pos = struct.calcsize("=IIQ")
+	time = 0
+	while pos + 8 <= len(data):
+		delta, slot, direction, count = struct.unpack_from("=IBBH", data, pos)
+		pos += 8
+		words = struct.unpack_from("=%dI" % count, data, pos)
+		pos += 4 * count
+		time += delta
+		entries.append((time, slot, direction, words))
+
+	return entries
+
+
+class _SlotParser:
+	def __init__(self, result):
+		self.result = result
+		self.cmd = None
+		self.args = 0
+		self.extra = 0
+		self.args_done = None
+		self.compute_start = None
+		self.reset_start = None
+		self.seen = False
+
+	def hw2sw(self, time, word):
+		if self.cmd is None:
+			self._command(time, word)
+		elif self.args > 0:
+			self.args -= 1
+			if self.args == 0:
+				self._arguments(time, word)
+		elif self.extra > 0:
+			self.extra -= 1
+			if self.extra == 0:
+				self.args_done = time
+
+	def _command(self, time, word):
+		op = word & OSIF_CMD_MASK
+		if op in OSIF_CMD_PUTS and self.compute_start is not None:
+			self.result["service"].append(time - self.compute_start)
+		self.compute_start = None
+
+		self.seen = True
+		self.cmd = word
+		self.args = OSIF_CMD_ARGS.get(op, 0)
+		if word & OSIF_CMD_TAGGED_MASK and op == 0xF1:
+			self.args = 2
+		elif word & OSIF_CMD_TAGGED_MASK:
+			self.args = 1
+		self.extra = 0
+		self.args_done = time if self.args == 0 else None
+		if self.args == 0:
+			self._complete()
+
+	def _arguments(self, time, word):
+		op = self.cmd & OSIF_CMD_MASK
+		if op == 0xA6 or op == 0xF4:
+			self.extra = word
+		elif op == 0xE1:
+			self.extra = word // 4
+		if self.extra == 0:
+			self.args_done = time
+			self._complete()
+
+	def _complete(self):
+		# tagged calls and delays are answered asynchronously
+		op = self.cmd & OSIF_CMD_MASK
+		if self.cmd & OSIF_CMD_TAGGED_MASK or op == 0xA1:
+			self.cmd = None
+
+	def sw2hw(self, time):
+		if self.cmd is not None and self.args == 0 and self.extra == 0:
+			op = self.cmd & OSIF_CMD_MASK
+			if op in OSIF_CMD_GETS:
+				self.compute_start = time
+			elif self.args_done is not None:
+				self.result["delegate"].append(time - self.args_done)
+			self.cmd = None
+		elif self.compute_start is not None:
+			# further words of a reply, e.g. of mbox_get_n
+			self.compute_start = time
+
+	def reset(self, time, value):
+		if value:
+			if self.cmd is not None and self.args_done is not None:
+				self.result["delegate"].append(time - self.args_done)
+			self.reset_start = time
+		elif self.reset_start is not None:
+			if self.seen:
+				self.result["reconf"].append(time - self.reset_start)
+			self.reset_start = None
+
+		self.cmd = None
+		self.compute_start = None
+
+
+def _cluster(samples, k, iterations = 50):
+	"""
+One dimensional k-means, returns the clusters sorted by their mean.
+	"""
+
+	samples = sorted(samples)
+	if k <= 1 or len(samples) < k:
+		return [samples]
+
+	centers = [samples[(2 * i + 1) * len(samples) // (2 * k)] for i in range(k)]
+	for _ in range(iterations):
+		clusters = [[] for _ in range(k)]
+		for s in samples:
+			i = min(range(k), key = lambda i: abs(s - centers[i]))
+			clusters[i].append(s)
+		new = [sum(c) / len(c) if c else centers[i] for i, c in enumerate(clusters)]
+		if new == centers:
+			break
+		centers = new
+
+	clusters = [c for c in clusters if c]
+	return sorted(clusters, key = lambda c: sum(c) / len(c))
+
+
+def calibrate(filename, configurations = 1):
+	"""
+Extracts the model parameters from an OSIF recording:
+
+  service  - time between the reply to a get (mbox, sem, rq) and the
+             next put of the same slot, split into one cluster per
+             configuration ordered by the mean service time
+  reconf   - time a slot was held in reset for reconfiguration
+  delegate - time between the last argument of a call and its reply,
+             only for calls which do not block
+	"""
+
+	result = {"service": [], "reconf": [], "delegate": []}
+	parsers = {}
+
+	for time, slot, direction, words in read_recording(filename):
+		parser = parsers.setdefault(slot, _SlotParser(result))
+
+		if direction == OSIF_RECORD_HW2SW:
+			for word in words:
+				parser.hw2sw(time, word)
+		elif direction == OSIF_RECORD_SW2HW:
+			parser.sw2hw(time)
+		elif direction == OSIF_RECORD_RESET:
+			parser.reset(time, words[0])
+
+	result["service"] = _cluster(result["service"], configurations)
+	return result
+
+
+def save_calibration(params, filename):
+	with open(filename, "w") as f:
+		json.dump(params, f)
+
+
+def load_calibration(filename):
+	with open(filename) as f:
+		return json.load(f)
+
+
+# == Statistics ========================================================
+
+def percentile(values, p):
+	if not values:
+		return 0.0
+	values = sorted(values)
+	return values[min(len(values) - 1, int(p * len(values)))]
+
+
+def mean(values):
+	if not values:
+		return 0.0
+	return sum(values) / len(values)
+
+
+def print_table(header, rows):
+	print("#" + "\t".join(header))
+	for row in rows:
+		print("\t".join(("%.2f" % v) if isinstance(v, float) else str(v) for v in row))